@@ -587,6 +587,17 @@ typedef struct {
 	int attmode;       ///<     0=rotation, 1=translation
 } ENGINESTATUS;
 
+/**
+ * \brief Frame profiler zone summary
+ * \sa oapiGetProfilerSummary
+ */
+typedef struct {
+	const char *name;  ///<     zone name
+	double t;          ///<     mean time per frame spent in the zone [s]
+	double tmax;       ///<     max. time per frame spent in the zone [s]
+	double count;      ///<     mean number of zone calls per frame
+} PROFILERZONE;
+
 /**
  * \ingroup defines
  * \defgroup exhaustflag Bitflags for EXHAUSTSPEC flags field.
@@ -2884,6 +2895,44 @@ OAPIFUNC OBJHANDLE oapiCreateVesselEx (const char *name, const char *classname,
  * \sa oapiCreateVessel, oapiCreateVesselEx
  */
 OAPIFUNC bool oapiDeleteVessel (OBJHANDLE hVessel, OBJHANDLE hAlternativeCameraTarget = 0);
+
+/**
+ * \brief Creates a batch of new vessels via a VESSELSTATUSx (x >= 2) interface.
+ * \param n number of vessels
+ * \param name list of \e n vessel names
+ * \param classname list of \e n vessel class names
+ * \param status list of \e n pointers to VESSELSTATUSx structures
+ * \param hVessel list of \e n vessel handles, filled by the function
+ * \return Number of vessels created.
+ * \note Equivalent to calling \ref oapiCreateVesselEx for each vessel, but
+ *   the vessels are inserted into the simulation as a single batch. This
+ *   is more efficient when many vessels are spawned at once (e.g. debris
+ *   or jettisoned stages).
+ * \note Plugins and the graphics client are notified of each new vessel
+ *   as usual, after all vessels of the batch have been added. Every vessel
+ *   of the batch receives its clbkNewVessel notifications before any
+ *   vessel's clbkPostCreation is called.
+ * \note Open dialogs receive a single MSG_CREATEVESSEL message per batch,
+ *   carrying the last vessel of the batch.
+ * \sa oapiCreateVesselEx, oapiDeleteVessels
+ */
+OAPIFUNC DWORD oapiCreateVessels (DWORD n, const char *const *name, const char *const *classname, const void *const *status, OBJHANDLE *hVessel);
+
+/**
+ * \brief Deletes a batch of existing vessels.
+ * \param n number of vessels
+ * \param hVessel list of \e n vessel handles
+ * \return Number of vessels marked for deletion.
+ * \note Invalid handles in the list are ignored.
+ * \note As for \ref oapiDeleteVessel, the vessels are destroyed at the end
+ *   of the current frame, together with any other vessels deleted in this
+ *   frame, as a single batch.
+ * \note Plugins and the graphics client receive clbkDeleteVessel for each
+ *   vessel of the batch. Open dialogs receive a single MSG_KILLVESSEL
+ *   message per batch, carrying the last vessel of the batch.
+ * \sa oapiDeleteVessel, oapiCreateVessels
+ */
+OAPIFUNC DWORD oapiDeleteVessels (DWORD n, const OBJHANDLE *hVessel);
 //@}
 
 /**
@@ -4327,6 +4376,34 @@ OAPIFUNC void oapiSetTimeAcceleration (double warp);
 	*/
 OAPIFUNC double oapiGetFrameRate ();
 
+	/**
+	* \brief Returns the frame profiler timing of the simulation subsystems.
+	* \param zone array of zone summaries to be filled (or NULL)
+	* \param nzone size of the zone array
+	* \param nframe number of recent frames to evaluate (0: all frames
+	*   buffered by the profiler, up to 256)
+	* \return Number of zones recorded in the interval. If this is larger
+	*   than nzone, only the first nzone entries are written.
+	* \note The profiler must be enabled with the FrameProfiler option in
+	*   Orbiter.cfg. Otherwise the function returns 0.
+	* \note The zone names remain valid for the lifetime of the process.
+	* \note The "Frame" zone contains the total frame time.
+	* \sa PROFILERZONE, oapiProfilerCapture
+	*/
+OAPIFUNC DWORD oapiGetProfilerSummary (PROFILERZONE *zone, DWORD nzone, DWORD nframe = 0);
+
+	/**
+	* \brief Records the profiler zone events of the next frames to a trace file.
+	* \param fname trace file name
+	* \param nframe number of frames to record
+	* \return \e false if the profiler is disabled or a capture is already in
+	*   progress, \e true otherwise.
+	* \note The file is written in Chrome trace event format once the frames
+	*   are recorded. It can be viewed with chrome://tracing or ui.perfetto.dev.
+	* \sa oapiGetProfilerSummary
+	*/
+OAPIFUNC bool oapiProfilerCapture (const char *fname, DWORD nframe);
+
 	/**
 	* \brief Returns the current simulation pause state.
 	* \return \e true if simulation is currently paused, \e false if it is running.
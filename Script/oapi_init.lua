@@ -24,13 +24,14 @@ ktable = {Q=0x10, W=0x11, E=0x12, R=0x13, T=0x14, Y=0x15, U=0x16, I=0x17,
 
 
 -- execute a script in the 'Script' folder (.lua extension is assumed)
+-- (loadfile instead of dofile, so that the script can yield in coroutine mode)
 function run (script)
-  dofile('./Script/'..script..'.lua')
+  return assert(loadfile('./Script/'..script..'.lua'))()
 end
 
 -- execute a script in the Orbiter root folder
 function run_global (script)
-  dofile(script)
+  return assert(loadfile(script))()
 end
 
 -- -------------------------------------------------
@@ -97,10 +98,13 @@ end
 
 -- Time skip: branches yield, the main trunk resumes all
 -- coroutines for a single cycle, then calls proc.Frameskip
--- to pass control back to orbiter for a new simulation cycle
+-- to pass control back to orbiter for a new simulation cycle.
+-- In coroutine mode, the main trunk is coroutine _trunk, and
+-- proc.Frameskip yields it until the next cycle.
 
 function proc.skip ()
-	if coroutine.running() == nil then  -- we are in the main trunk
+	local co = coroutine.running()
+	if co == nil or co == _trunk then  -- we are in the main trunk
 		for i=1,branch.nslot do
 			if branch[i] ~= nil then
 				coroutine.resume (branch[i])
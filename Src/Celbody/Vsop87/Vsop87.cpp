@@ -2,6 +2,7 @@
 // Licensed under the MIT License
 
 #include "Vsop87.h"
+#include "VsopSeries.h"
 #include <stdio.h>
 
 #define DLLCLBK extern "C" __declspec(dllexport)
@@ -25,7 +26,7 @@ VSOPOBJ::VSOPOBJ (OBJHANDLE hCBody): CELBODY2 (hCBody)
 	prec = 1e-6;            // default precision
 	termidx = 0;
 	termlen = 0;
-	term = 0;
+	termA = termB = termC = 0;
 	sp[0].t = sp[1].t = -1e20; // invalidate
 	SetSeries ('B');        // default series: spherical, J2000
 }
@@ -34,7 +35,9 @@ VSOPOBJ::~VSOPOBJ ()
 {
 	if (termidx) delete []termidx;
 	if (termlen) delete []termlen;
-	if (term) delete []term;
+	if (termA) delete []termA;
+	if (termB) delete []termB;
+	if (termC) delete []termC;
 }
 
 bool VSOPOBJ::bEphemeris () const
@@ -99,12 +102,20 @@ bool VSOPOBJ::ReadData (const char *name)
 		}
 		termlen[alpha][cooidx] = 0;
 	}
-	// now copy everything into a single array
-	term = new TERM3[nused];
+	// now copy everything into separate A, B, C arrays
+	termA = new double[nused];
+	termB = new double[nused];
+	termC = new double[nused];
 	for (cooidx = 0; cooidx < 3; cooidx++) {
 		for (alpha = 0; alpha <= nalpha; alpha++) {
-			memcpy (term+termidx[alpha][cooidx], ppterm[cooidx*(nalpha+1)+alpha], termlen[alpha][cooidx]*sizeof(TERM3));
-			delete []ppterm[cooidx*(nalpha+1)+alpha];
+			pterm = ppterm[cooidx*(nalpha+1)+alpha];
+			int ofs = termidx[alpha][cooidx];
+			for (i = 0; i < termlen[alpha][cooidx]; i++) {
+				termA[ofs+i] = pterm[i][0];
+				termB[ofs+i] = pterm[i][1];
+				termC[ofs+i] = pterm[i][2];
+			}
+			delete []pterm;
 		}
 	}
 	delete []ppterm;
@@ -150,10 +161,8 @@ void VSOPOBJ::VsopEphem (double mjd, double *ret)
 	static const double pscl = AU;            // convert AU -> m
 	static const double vscl = AU*rsec;       // convert AU/millenium -> m/s
 
-	TERM3 *pterm;
-
-	double a, b, c, arg, tm, termdot;
-	int i, cooidx, alpha;
+	double tm, termdot;
+	int i, cooidx, alpha, ofs;
 
 	// zero result array
 	for (i = 0; i < 6; i++) ret[i] = 0.0;
@@ -169,16 +178,8 @@ void VSOPOBJ::VsopEphem (double mjd, double *ret)
 
 		for (alpha = 0; termlen[alpha][cooidx]; ++alpha) { // loop over powers of time
 
-			pterm = term+termidx[alpha][cooidx];
-			tm = termdot = 0.0;
-		    for (i = 0; i < termlen[alpha][cooidx]; ++i) {
-				a        = pterm[i][0];
-				b        = pterm[i][1];
-				c        = pterm[i][2];
-				arg      = b + c * t[1];
-				tm      += a * cos(arg);
-				termdot -= c * a * sin(arg);
-			}
+			ofs = termidx[alpha][cooidx];
+			VsopSeriesSum (termA+ofs, termB+ofs, termC+ofs, termlen[alpha][cooidx], t[1], tm, termdot);
 			ret[cooidx] += t[alpha] * tm;
 			ret[cooidx+3] += t[alpha] * termdot +
 				(alpha > 0 ? alpha * t[alpha - 1] * tm : 0.0);
@@ -46,7 +46,9 @@ protected:
 	int nalpha;      // order of time polynomials
 	IDX3 *termidx;   // term index list
 	IDX3 *termlen;   // term list lengths
-	TERM3 *term;     // term list
+	double *termA;   // term list: amplitudes
+	double *termB;   // term list: phases
+	double *termC;   // term list: frequencies
 	Sample sp[2];
 
 private:
@@ -0,0 +1,175 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ===========================================================
+// VSOP87 series summation kernels
+// ===========================================================
+
+#include "VsopSeries.h"
+#include <math.h>
+
+// Term arguments B+C*t must be rounded identically in all kernels, otherwise
+// the high-frequency terms differ by up to ulp(C*t)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define VSOP_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VSOP_AVX2_FUNC
+#else
+#define VSOP_AVX2_FUNC __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+typedef void (*SUMFUNC)(const double*, const double*, const double*, int, double, double&, double&);
+
+// ===========================================================
+
+void VsopSeriesSum_Scalar (const double *A, const double *B, const double *C, int n, double t, double &tm, double &termdot)
+{
+	double arg;
+	tm = termdot = 0.0;
+	for (int i = 0; i < n; ++i) {
+		arg      = B[i] + C[i] * t;
+		tm      += A[i] * cos(arg);
+		termdot -= C[i] * A[i] * sin(arg);
+	}
+}
+
+#ifdef VSOP_AVX2
+
+// ===========================================================
+// Simultaneous sine and cosine of 4 arguments.
+// Cody-Waite reduction to [-pi/4,pi/4] by multiples of pi/2,
+// followed by the minimax polynomials from the Cephes library.
+// Relative error ~1e-16 for |x| < 1e6.
+// ===========================================================
+
+VSOP_AVX2_FUNC static inline void sincos4 (__m256d x, __m256d &s, __m256d &c)
+{
+	const __m256d twoopi = _mm256_set1_pd (0.63661977236758134308);    // 2/pi
+	const __m256d pio2_1 = _mm256_set1_pd (1.57079632673412561417e+00); // first 33 bits of pi/2
+	const __m256d pio2_2 = _mm256_set1_pd (6.07710050630396597660e-11); // next 33 bits
+	const __m256d pio2_3 = _mm256_set1_pd (2.02226624879595063154e-21); // remainder
+
+	__m256d q = _mm256_round_pd (_mm256_mul_pd (x, twoopi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256d r = _mm256_fnmadd_pd (q, pio2_1, x);
+	r = _mm256_fnmadd_pd (q, pio2_2, r);
+	r = _mm256_fnmadd_pd (q, pio2_3, r);
+	__m256d r2 = _mm256_mul_pd (r, r);
+
+	// sin(r) = r + r^3 P(r^2)
+	__m256d ps = _mm256_set1_pd (1.58962301576546568060e-10);
+	ps = _mm256_fmadd_pd (ps, r2, _mm256_set1_pd (-2.50507477628578072866e-8));
+	ps = _mm256_fmadd_pd (ps, r2, _mm256_set1_pd ( 2.75573136213857245213e-6));
+	ps = _mm256_fmadd_pd (ps, r2, _mm256_set1_pd (-1.98412698295895385996e-4));
+	ps = _mm256_fmadd_pd (ps, r2, _mm256_set1_pd ( 8.33333333332211858878e-3));
+	ps = _mm256_fmadd_pd (ps, r2, _mm256_set1_pd (-1.66666666666666307295e-1));
+	ps = _mm256_fmadd_pd (_mm256_mul_pd (ps, r2), r, r);
+
+	// cos(r) = 1 - r^2/2 + r^4 Q(r^2)
+	__m256d pc = _mm256_set1_pd (-1.13585365213876817300e-11);
+	pc = _mm256_fmadd_pd (pc, r2, _mm256_set1_pd ( 2.08757008419747316778e-9));
+	pc = _mm256_fmadd_pd (pc, r2, _mm256_set1_pd (-2.75573141792967388112e-7));
+	pc = _mm256_fmadd_pd (pc, r2, _mm256_set1_pd ( 2.48015872888517045348e-5));
+	pc = _mm256_fmadd_pd (pc, r2, _mm256_set1_pd (-1.38888888888730564116e-3));
+	pc = _mm256_fmadd_pd (pc, r2, _mm256_set1_pd ( 4.16666666666665929218e-2));
+	pc = _mm256_fmadd_pd (_mm256_mul_pd (pc, r2), r2, _mm256_fnmadd_pd (_mm256_set1_pd (0.5), r2, _mm256_set1_pd (1.0)));
+
+	// map back to the quadrant of x
+	__m256i qi   = _mm256_cvtepi32_epi64 (_mm256_cvtpd_epi32 (q));
+	__m256i one  = _mm256_set1_epi64x (1);
+	__m256i bit0 = _mm256_and_si256 (qi, one);
+	__m256i bit1 = _mm256_and_si256 (_mm256_srli_epi64 (qi, 1), one);
+	__m256d swap = _mm256_castsi256_pd (_mm256_cmpeq_epi64 (bit0, one));
+	__m256d ssgn = _mm256_castsi256_pd (_mm256_slli_epi64 (bit1, 63));
+	__m256d csgn = _mm256_castsi256_pd (_mm256_slli_epi64 (_mm256_xor_si256 (bit0, bit1), 63));
+	s = _mm256_xor_pd (_mm256_blendv_pd (ps, pc, swap), ssgn);
+	c = _mm256_xor_pd (_mm256_blendv_pd (pc, ps, swap), csgn);
+}
+
+// ===========================================================
+
+VSOP_AVX2_FUNC static void VsopSeriesSum_AVX2 (const double *A, const double *B, const double *C, int n, double t, double &tm, double &termdot)
+{
+	__m256d vt   = _mm256_set1_pd (t);
+	__m256d vtm  = _mm256_setzero_pd();
+	__m256d vdot = _mm256_setzero_pd();
+	__m256d vs, vc;
+	int i;
+
+	for (i = 0; i+4 <= n; i += 4) {
+		__m256d a = _mm256_loadu_pd (A+i);
+		__m256d c = _mm256_loadu_pd (C+i);
+		__m256d arg = _mm256_add_pd (_mm256_loadu_pd (B+i), _mm256_mul_pd (c, vt)); // no fma here (see above)
+		sincos4 (arg, vs, vc);
+		vtm  = _mm256_fmadd_pd (a, vc, vtm);
+		vdot = _mm256_fnmadd_pd (_mm256_mul_pd (c, a), vs, vdot);
+	}
+
+	double buf[4];
+	_mm256_storeu_pd (buf, vtm);
+	tm = (buf[0] + buf[1]) + (buf[2] + buf[3]);
+	_mm256_storeu_pd (buf, vdot);
+	termdot = (buf[0] + buf[1]) + (buf[2] + buf[3]);
+
+	if (i < n) { // remaining terms
+		double tm_r, termdot_r;
+		VsopSeriesSum_Scalar (A+i, B+i, C+i, n-i, t, tm_r, termdot_r);
+		tm += tm_r;
+		termdot += termdot_r;
+	}
+}
+
+// ===========================================================
+
+static bool CpuHasAVX2 ()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid (info, 0);
+	if (info[0] < 7) return false;
+	__cpuid (info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool fma     = (info[2] & (1 << 12)) != 0;
+	if (!osxsave || !fma) return false;
+	if ((_xgetbv (0) & 6) != 6) return false; // OS saves YMM registers
+	__cpuidex (info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init ();
+	return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma");
+#endif
+}
+
+#endif // VSOP_AVX2
+
+// ===========================================================
+
+static SUMFUNC SelectSumFunc ()
+{
+#ifdef VSOP_AVX2
+	if (CpuHasAVX2()) return VsopSeriesSum_AVX2;
+#endif
+	return VsopSeriesSum_Scalar;
+}
+
+static SUMFUNC SumFunc ()
+{
+	static const SUMFUNC func = SelectSumFunc();
+	return func;
+}
+
+void VsopSeriesSum (const double *A, const double *B, const double *C, int n, double t, double &tm, double &termdot)
+{
+	SumFunc() (A, B, C, n, t, tm, termdot);
+}
+
+bool VsopSeriesVectorised ()
+{
+	return SumFunc() != VsopSeriesSum_Scalar;
+}
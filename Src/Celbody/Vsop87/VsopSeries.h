@@ -0,0 +1,25 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ===========================================================
+// VSOP87 series summation kernels
+// Terms are stored as separate amplitude (A), phase (B) and
+// frequency (C) arrays, so that the summation can process
+// several terms per instruction.
+// ===========================================================
+
+#ifndef __VSOPSERIES_H
+#define __VSOPSERIES_H
+
+// Sum a block of n terms A cos(B + C t) at time t [millenia since J2000].
+// Returns the series value in tm and its time derivative in termdot.
+// Uses an AVX2 kernel if supported by the CPU, otherwise the scalar version.
+void VsopSeriesSum (const double *A, const double *B, const double *C, int n, double t, double &tm, double &termdot);
+
+// Scalar reference implementation
+void VsopSeriesSum_Scalar (const double *A, const double *B, const double *C, int n, double t, double &tm, double &termdot);
+
+// Returns true if VsopSeriesSum uses the vectorised kernel on this CPU
+bool VsopSeriesVectorised ();
+
+#endif // !__VSOPSERIES_H
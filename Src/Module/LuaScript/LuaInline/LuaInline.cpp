@@ -30,12 +30,12 @@
 // ==============================================================
 // class InterpreterList::Environment: implementation
 
-InterpreterList::Environment::Environment()
+InterpreterList::Environment::Environment(bool coroutine)
 {
 	cmd = NULL;
 	singleCmd = false;
 	hThread = NULL;
-	interp = CreateInterpreter ();
+	interp = CreateInterpreter (coroutine);
 }
 
 InterpreterList::Environment::~Environment()
@@ -56,16 +56,32 @@ InterpreterList::Environment::~Environment()
 	}
 }
 
-Interpreter *InterpreterList::Environment::CreateInterpreter ()
+Interpreter *InterpreterList::Environment::CreateInterpreter (bool coroutine)
 {
 	unsigned id;
 	termInterp = false;
 	interp = new Interpreter ();
+	interp->SetCoroutineMode (coroutine);
 	interp->Initialise();
-	hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
+	if (!coroutine)
+		hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
 	return interp;
 }
 
+void InterpreterList::Environment::Step ()
+{
+	// same sequence as InterpreterThreadProc, one cycle per call
+	if (interp->Status() == 1) return;
+	if (cmd && !interp->IsBusy()) {
+		char *str = cmd;
+		cmd = 0; // commands issued by the script are queued for the next cycle
+		interp->RunChunk (str, strlen (str));
+		delete []str;
+	} else {
+		interp->RunChunk ("", 0); // continue command, or idle loop
+	}
+}
+
 unsigned int WINAPI InterpreterList::Environment::InterpreterThreadProc (LPVOID context)
 {
 	InterpreterList::Environment *env = (InterpreterList::Environment*)context;
@@ -97,6 +113,7 @@ unsigned int WINAPI InterpreterList::Environment::InterpreterThreadProc (LPVOID
 InterpreterList::InterpreterList (HINSTANCE hDLL): Module (hDLL)
 {
 	nlist = nbuf = 0;
+	bCoroutine = false;
 }
 
 InterpreterList::~InterpreterList ()
@@ -121,8 +138,12 @@ void InterpreterList::clbkPostStep (double simt, double simdt, double mjd)
 
 	for (i = 0; i < nlist; i++) { // let the interpreter do some work
 		if (list[i]->interp->IsBusy() || list[i]->cmd || list[i]->interp->nJobs()) {
-			list[i]->interp->EndExec();
-			list[i]->interp->WaitExec();
+			if (list[i]->hThread) {
+				list[i]->interp->EndExec();
+				list[i]->interp->WaitExec();
+			} else {
+				list[i]->Step();
+			}
 		}
 	}
 }
@@ -143,7 +164,7 @@ InterpreterList::Environment *InterpreterList::AddInterpreter ()
 		list = tmp;
 	}
 
-	Environment *env = new Environment;
+	Environment *env = new Environment (bCoroutine);
 	list[nlist++] = env;
 	return env;
 }
@@ -184,6 +205,12 @@ DLLCLBK void ExitModule (HINSTANCE hDLL)
 }
 
 // interpreter-specific callback functions
+DLLCLBK void opcSetCoroutineMode (bool coroutine)
+{
+	if (g_IList)
+		g_IList->bCoroutine = coroutine;
+}
+
 DLLCLBK INTERPRETERHANDLE opcNewInterpreter ()
 {
 	if (g_IList) {
@@ -237,6 +264,14 @@ DLLCLBK bool opcAsyncScriptCmd (INTERPRETERHANDLE hInterp, const char *cmd)
 DLLCLBK bool opcExecScriptCmd (INTERPRETERHANDLE hInterp, const char *cmd)
 {
 	InterpreterList::Environment *env = (InterpreterList::Environment*)hInterp;
+	if (!env->hThread) {
+		// coroutine mode: run the command directly on the calling thread, until
+		// it finishes or waits. If a previous command is still running, queue it.
+		if (env->interp->IsBusy())
+			return opcAsyncScriptCmd (hInterp, cmd);
+		env->interp->RunChunk (cmd, strlen (cmd));
+		return true;
+	}
 	char *str = new char[strlen(cmd)+1];
 	char *cmd_async = 0;
 	strcpy (str, cmd);
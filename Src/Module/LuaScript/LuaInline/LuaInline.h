@@ -31,11 +31,12 @@
 class InterpreterList: public oapi::Module {
 public:
 	struct Environment {    // interpreter environment
-		Environment();
+		Environment(bool coroutine);
 		~Environment();
-		Interpreter *CreateInterpreter ();
+		Interpreter *CreateInterpreter (bool coroutine);
+		void Step ();         // coroutine mode: run command or background jobs for one cycle
 		Interpreter *interp;  // interpreter instance
-		HANDLE hThread;       // interpreter thread
+		HANDLE hThread;       // interpreter thread (NULL in coroutine mode)
 		bool termInterp;      // interpreter kill flag
 		bool singleCmd;       // terminate after single command
 		char *cmd;            // interpreter command
@@ -53,6 +54,8 @@ public:
 	Environment *AddInterpreter ();
 	int DelInterpreter (Environment *env);
 
+	bool bCoroutine;        // new interpreters run scripts as coroutines on the simulation thread
+
 private:
 
 	Environment **list;     // interpreter list
@@ -36,8 +36,24 @@ int OpenHelp (void *context);
 // ============================================================================
 // nonmember functions
 
+// VECTOR3/MATRIX3 userdata at stack position idx, or NULL if the entry
+// is of a different type (see Interpreter::luaL_tryudata)
+static void *lua_tovaluetype (lua_State *L, int idx, const char *tname)
+{
+	if (lua_type (L, idx) != LUA_TUSERDATA) return NULL;
+	void *p = lua_touserdata (L, idx);
+	if (!lua_getmetatable (L, idx)) return NULL;
+	lua_getfield (L, LUA_REGISTRYINDEX, tname);
+	if (!lua_rawequal (L, -1, -2)) p = NULL;
+	lua_pop (L, 2);
+	return p;
+}
+
 VECTOR3 lua_tovector (lua_State *L, int idx)
 {
+	const VECTOR3 *v = (const VECTOR3*)lua_tovaluetype (L, idx, "VECTOR3");
+	if (v) return *v;
+
 	VECTOR3 vec;
 	lua_getfield (L, idx, "x");
 	vec.x = lua_tonumber (L, -1); lua_pop (L,1);
@@ -58,6 +74,8 @@ Interpreter::Interpreter ()
 	is_term = false;      // no attached terminal by default
 	bExecLocal = false;   // flag for locally created mutexes
 	bWaitLocal = false;
+	bCoroutine = false;   // threaded execution mode by default
+	trunk = NULL;
 	jobs = 0;             // background jobs
 	status = 0;           // normal
 	term_verbose = 0;     // verbosity level
@@ -95,19 +113,24 @@ int Interpreter::LuaCall(lua_State *L, int narg, int nres)
 	int res = lua_pcall(L, narg, nres, base);
 	lua_remove(L, base);
 	if(res != 0) {
-		const char *msg = lua_tostring(L, -1);
-		// Lua "threads" that are terminated when the scenario ends generate "Lua thread terminated" errors
-		// This is expected and should not generate logs/notifications
-		// Warning: the string must match with the one in oapi_init.lua: proc.skip ()
-		// strstr may be heavy but it's only an error path
-		if(strstr(msg, "Lua thread terminated") == NULL) {
-			oapiWriteLogError("%s", msg);
-			oapiAddNotification(OAPINOTIF_ERROR, "Lua error", msg);
-		}
+		ErrorMsg(lua_tostring(L, -1));
 	}
 	return res;
 }
 
+void Interpreter::ErrorMsg (const char *msg)
+{
+	if (!msg) return;
+	// Lua "threads" that are terminated when the scenario ends generate "Lua thread terminated" errors
+	// This is expected and should not generate logs/notifications
+	// Warning: the string must match with the one in oapi_init.lua: proc.skip ()
+	// strstr may be heavy but it's only an error path
+	if(strstr(msg, "Lua thread terminated") == NULL) {
+		oapiWriteLogError("%s", msg);
+		oapiAddNotification(OAPINOTIF_ERROR, "Lua error", msg);
+	}
+}
+
 Interpreter::~Interpreter ()
 {
 	lua_close (L);
@@ -402,17 +425,16 @@ const char *Interpreter::lua_tostringex (lua_State *L, int idx, char *cbuf)
 
 void Interpreter::lua_pushvector (lua_State *L, const VECTOR3 &vec)
 {
-	lua_createtable (L, 0, 3);
-	lua_pushnumber (L, vec.x);
-	lua_setfield (L, -2, "x");
-	lua_pushnumber (L, vec.y);
-	lua_setfield (L, -2, "y");
-	lua_pushnumber (L, vec.z);
-	lua_setfield (L, -2, "z");
+	VECTOR3 *v = (VECTOR3*)lua_newuserdata (L, sizeof(VECTOR3));
+	*v = vec;
+	luaL_getmetatable (L, "VECTOR3");
+	lua_setmetatable (L, -2);
 }
 
 int Interpreter::lua_isvector (lua_State *L, int idx)
 {
+	if (lua_type (L, idx) == LUA_TUSERDATA)
+		return lua_tovaluetype (L, idx, "VECTOR3") != NULL;
 	if (!lua_istable (L, idx)) return 0;
 	static char fieldname[3] = {'x','y','z'};
 	static char field[2] = "x";
@@ -440,20 +462,17 @@ int Interpreter::lua_isvector (lua_State *L, int idx)
 
 void Interpreter::lua_pushmatrix (lua_State *L, const MATRIX3 &mat)
 {
-	lua_createtable(L,0,9);
-	lua_pushnumber(L,mat.m11);  lua_setfield(L,-2,"m11");
-	lua_pushnumber(L,mat.m12);  lua_setfield(L,-2,"m12");
-	lua_pushnumber(L,mat.m13);  lua_setfield(L,-2,"m13");
-	lua_pushnumber(L,mat.m21);  lua_setfield(L,-2,"m21");
-	lua_pushnumber(L,mat.m22);  lua_setfield(L,-2,"m22");
-	lua_pushnumber(L,mat.m23);  lua_setfield(L,-2,"m23");
-	lua_pushnumber(L,mat.m31);  lua_setfield(L,-2,"m31");
-	lua_pushnumber(L,mat.m32);  lua_setfield(L,-2,"m32");
-	lua_pushnumber(L,mat.m33);  lua_setfield(L,-2,"m33");
+	MATRIX3 *m = (MATRIX3*)lua_newuserdata (L, sizeof(MATRIX3));
+	*m = mat;
+	luaL_getmetatable (L, "MATRIX3");
+	lua_setmetatable (L, -2);
 }
 
 MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 {
+	const MATRIX3 *m = (const MATRIX3*)lua_tovaluetype (L, idx, "MATRIX3");
+	if (m) return *m;
+
 	MATRIX3 mat;
 	lua_getfield (L, idx, "m11");  mat.m11 = lua_tonumber (L, -1);  lua_pop (L,1);
 	lua_getfield (L, idx, "m12");  mat.m12 = lua_tonumber (L, -1);  lua_pop (L,1);
@@ -469,6 +488,8 @@ MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 
 int Interpreter::lua_ismatrix (lua_State *L, int idx)
 {
+	if (lua_type (L, idx) == LUA_TUSERDATA)
+		return lua_tovaluetype (L, idx, "MATRIX3") != NULL;
 	if (!lua_istable (L, idx)) return 0;
 	static const char *fieldname[9] = {"m11","m12","m13","m21","m22","m23","m31","m32","m33"};
 	int i, ii, n;
@@ -688,15 +709,23 @@ void Interpreter::EndExec ()
 	ReleaseMutex (hExecMutex);
 }
 
-void Interpreter::frameskip (lua_State *L)
+int Interpreter::frameskip (lua_State *L)
 {
 	if (status == 1) { // termination request
 		lua_pushboolean(L, 1);
 		lua_setfield (L, LUA_GLOBALSINDEX, "wait_exit");
+	} else if (bCoroutine) {
+		return lua_yield (L, 0); // resumed by the next RunChunk call
 	} else {
 		EndExec();
 		WaitExec();
 	}
+	return 0;
+}
+
+void Interpreter::SetCoroutineMode (bool coroutine)
+{
+	bCoroutine = coroutine;
 }
 
 int Interpreter::ProcessChunk (const char *chunk, int n)
@@ -709,6 +738,7 @@ int Interpreter::ProcessChunk (const char *chunk, int n)
 
 int Interpreter::RunChunk (const char *chunk, int n)
 {
+	if (bCoroutine) return RunCoroutine (chunk, n);
 	int res = 0;
 	if (chunk[0]) {
 		is_busy = true;
@@ -743,6 +773,72 @@ int Interpreter::RunChunk (const char *chunk, int n)
 	return res;
 }
 
+int Interpreter::RunCoroutine (const char *chunk, int n)
+{
+	int res;
+	if (chunk[0]) {
+		// a coroutine that has finished without error can be reused
+		if (!trunk || lua_status (trunk) != 0 || lua_gettop (trunk)) {
+			trunk = lua_newthread (L);
+			lua_setfield (L, LUA_GLOBALSINDEX, "_trunk"); // keep the reference, see proc.skip
+		}
+		is_busy = true;
+		if (luaL_loadbuffer (trunk, chunk, n, "line")) {
+			const char *error = lua_tostring (trunk, -1);
+			ErrorMsg (error);
+			if (is_term) term_strout (error, true);
+			lua_settop (trunk, 0);
+			is_busy = false;
+			return LUA_ERRSYNTAX;
+		}
+		res = ResumeTrunk ();
+	} else if (is_busy) {
+		// continue the command for one cycle
+		res = ResumeTrunk ();
+	} else {
+		// idle loop: execute background jobs
+		lua_getfield (L, LUA_GLOBALSINDEX, "_idle");
+		LuaCall (L, 0, 1);
+		jobs = lua_tointeger (L, -1);
+		lua_pop (L, 1);
+		res = -1;
+	}
+	return res;
+}
+
+int Interpreter::ResumeTrunk ()
+{
+	int res = lua_resume (trunk, 0);
+	if (res == LUA_YIELD) return 0; // waiting for the next frame
+	if (res) {
+		// error: add a traceback of the coroutine stack to the message
+		lua_getfield (L, LUA_GLOBALSINDEX, "debug");
+		lua_getfield (L, -1, "traceback");
+		lua_remove (L, -2);
+		lua_pushthread (trunk);
+		lua_xmove (trunk, L, 1); // thread
+		lua_xmove (trunk, L, 1); // error message
+		lua_pushinteger (L, 0);
+		lua_pcall (L, 3, 1, 0);
+		const char *error = lua_tostring (L, -1);
+		ErrorMsg (error);
+		if (is_term && error) term_strout (error, true);
+		lua_pop (L, 1);
+		trunk = NULL; // a coroutine stopped by an error can't be reused
+		lua_pushnil (L);
+		lua_setfield (L, LUA_GLOBALSINDEX, "_trunk");
+	} else {
+		lua_settop (trunk, 0);
+	}
+	// check for leftover background jobs
+	lua_getfield (L, LUA_GLOBALSINDEX, "_nbranch");
+	LuaCall (L, 0, 1);
+	jobs = lua_tointeger (L, -1);
+	lua_pop (L, 1);
+	is_busy = false;
+	return res;
+}
+
 void Interpreter::term_out (lua_State *L, bool iserr)
 {
 	const char *str = lua_tostringex (L,-1);
@@ -788,6 +884,35 @@ void Interpreter::LoadAPI ()
 	};
 	luaL_openlib (L, "mat", matLib, 0);
 
+	// Vector and matrix value types
+	static const struct luaL_reg vecMtd[] = {
+		{"__index", vec_get},
+		{"__newindex", vec_setfield},
+		{"__add", vec_add},
+		{"__sub", vec_sub},
+		{"__mul", vec_mul},
+		{"__div", vec_div},
+		{"__unm", vec_unm},
+		{"__eq", vec_eq},
+		{"__tostring", vec_tostring},
+		{NULL, NULL}
+	};
+	luaL_newmetatable (L, "VECTOR3");
+	luaL_openlib (L, NULL, vecMtd, 0);
+	lua_pop (L, 1);
+
+	static const struct luaL_reg matMtd[] = {
+		{"__index", mat_get},
+		{"__newindex", mat_setfield},
+		{"__mul", mat_op_mul},
+		{"__eq", mat_eq},
+		{"__tostring", vec_tostring},
+		{NULL, NULL}
+	};
+	luaL_newmetatable (L, "MATRIX3");
+	luaL_openlib (L, NULL, matMtd, 0);
+	lua_pop (L, 1);
+
 	// Load the process library
 	static const struct luaL_reg procLib[] = {
 		{"Frameskip", procFrameskip},
@@ -1803,6 +1928,10 @@ int Interpreter::AssertPrmType(lua_State *L, int idx, int prmno, int tp, const c
 		if (lua_isvector(L, idx))
 			return 1;
 
+	if (tp & PRMTP_MATRIX)
+		if (lua_ismatrix(L, idx))
+			return 1;
+
 	if (tp & PRMTP_USERDATA)
 		if (lua_isuserdata(L, idx))
 			return 1;
@@ -1826,6 +1955,8 @@ int Interpreter::AssertPrmType(lua_State *L, int idx, int prmno, int tp, const c
 		strcat(cbuf, " table or");
 	if (tp & PRMTP_VECTOR)
 		strcat(cbuf, " vector or");
+	if (tp & PRMTP_MATRIX)
+		strcat(cbuf, " matrix or");
 	if (tp & PRMTP_USERDATA)
 		strcat(cbuf, " userdata or");
 
@@ -2479,6 +2610,60 @@ int Interpreter::vec_unit (lua_State *L)
 	return 1;
 }
 
+// ============================================================================
+// vector value type metamethods
+
+// Component index of vector field name, or -1
+static int vec_fieldidx (lua_State *L, int idx)
+{
+	size_t len;
+	const char *key = lua_tolstring (L, idx, &len);
+	if (!key || len != 1 || key[0] < 'x' || key[0] > 'z') return -1;
+	return key[0]-'x';
+}
+
+// v.x, v.y, v.z
+int Interpreter::vec_get (lua_State *L)
+{
+	VECTOR3 *v = (VECTOR3*)lua_touserdata (L, 1);
+	int i = vec_fieldidx (L, 2);
+	if (i >= 0) lua_pushnumber (L, v->data[i]);
+	else        lua_pushnil (L);
+	return 1;
+}
+
+// v.x = value etc.
+int Interpreter::vec_setfield (lua_State *L)
+{
+	VECTOR3 *v = (VECTOR3*)lua_touserdata (L, 1);
+	int i = vec_fieldidx (L, 2);
+	ASSERT_SYNTAX (i >= 0, "vector: invalid field (expected x, y or z)");
+	v->data[i] = luaL_checknumber (L, 3);
+	return 0;
+}
+
+// -v
+int Interpreter::vec_unm (lua_State *L)
+{
+	lua_pushvector (L, -lua_tovector (L, 1));
+	return 1;
+}
+
+// a == b (called for two vector userdata only)
+int Interpreter::vec_eq (lua_State *L)
+{
+	VECTOR3 a = lua_tovector (L, 1), b = lua_tovector (L, 2);
+	lua_pushboolean (L, a.x == b.x && a.y == b.y && a.z == b.z);
+	return 1;
+}
+
+// tostring(v), tostring(m)
+int Interpreter::vec_tostring (lua_State *L)
+{
+	lua_pushstring (L, lua_tostringex (L, 1));
+	return 1;
+}
+
 /***
 Matrix library functions.
 @module mat
@@ -2567,6 +2752,66 @@ int Interpreter::mat_rotm (lua_State *L) {
 	return 1;
 }
 
+// ============================================================================
+// matrix value type metamethods
+
+// Element index of matrix field name ("m11" ... "m33"), or -1
+static int mat_fieldidx (lua_State *L, int idx)
+{
+	size_t len;
+	const char *key = lua_tolstring (L, idx, &len);
+	if (!key || len != 3 || key[0] != 'm' || key[1] < '1' || key[1] > '3' || key[2] < '1' || key[2] > '3') return -1;
+	return (key[1]-'1')*3 + key[2]-'1';
+}
+
+// m.m11 ... m.m33
+int Interpreter::mat_get (lua_State *L)
+{
+	MATRIX3 *m = (MATRIX3*)lua_touserdata (L, 1);
+	int i = mat_fieldidx (L, 2);
+	if (i >= 0) lua_pushnumber (L, m->data[i]);
+	else        lua_pushnil (L);
+	return 1;
+}
+
+// m.m11 = value etc.
+int Interpreter::mat_setfield (lua_State *L)
+{
+	MATRIX3 *m = (MATRIX3*)lua_touserdata (L, 1);
+	int i = mat_fieldidx (L, 2);
+	ASSERT_SYNTAX (i >= 0, "matrix: invalid field (expected m11 ... m33)");
+	m->data[i] = luaL_checknumber (L, 3);
+	return 0;
+}
+
+// A*B (matrix product), M*v (matrix-vector product), M*f and f*M
+int Interpreter::mat_op_mul (lua_State *L)
+{
+	if (lua_ismatrix (L, 1)) {
+		if (lua_ismatrix (L, 2))
+			return mat_mmul (L);
+		if (lua_isvector (L, 2))
+			return mat_mul (L);
+		ASSERT_SYNTAX (lua_isnumber (L, 2), "Argument 2: expected matrix, vector or number");
+		lua_pushmatrix (L, lua_tomatrix (L, 1) * lua_tonumber (L, 2));
+	} else {
+		ASSERT_SYNTAX (lua_isnumber (L, 1), "Argument 1: expected matrix or number");
+		lua_pushmatrix (L, lua_tomatrix (L, 2) * lua_tonumber (L, 1));
+	}
+	return 1;
+}
+
+// A == B (called for two matrix userdata only)
+int Interpreter::mat_eq (lua_State *L)
+{
+	MATRIX3 a = lua_tomatrix (L, 1), b = lua_tomatrix (L, 2);
+	bool eq = true;
+	for (int i = 0; i < 9 && eq; i++)
+		eq = (a.data[i] == b.data[i]);
+	lua_pushboolean (L, eq);
+	return 1;
+}
+
 // ============================================================================
 // process library functions
 
@@ -2576,8 +2821,7 @@ int Interpreter::procFrameskip (lua_State *L)
 	// This should be called in the loop of any "wait"-type function
 
 	Interpreter *interp = GetInterpreter(L);
-	interp->frameskip (L);
-	return 0;
+	return interp->frameskip (L);
 }
 
 // ============================================================================
@@ -153,6 +153,28 @@ public:
 	 */
 	virtual void EndExec ();
 
+	/**
+	 * \brief Select the execution mode for commands.
+	 * \param coroutine execution mode (see notes)
+	 * \note In the default (threaded) mode, RunChunk runs a command to
+	 *   completion. Waiting functions (proc.skip etc.) hand control back to
+	 *   the orbiter thread with EndExec/WaitExec, so the client must call
+	 *   RunChunk from a separate interpreter thread.
+	 * \note In coroutine mode, RunChunk runs a command as a Lua coroutine
+	 *   until it finishes or calls a waiting function, which suspends the
+	 *   coroutine. Subsequent RunChunk calls with an empty chunk resume it
+	 *   for one cycle. No thread synchronisation is required. Commands
+	 *   can't wait inside pcall or inside code loaded by require.
+	 * \note The mode must be set before the first command is executed.
+	 */
+	void SetCoroutineMode (bool coroutine);
+
+	/**
+	 * \brief Returns the execution mode.
+	 * \return \e true in coroutine mode, \e false in threaded mode.
+	 */
+	inline bool CoroutineMode () const { return bCoroutine; }
+
 	/**
 	 * \brief Define functions for interfacing with Orbiter API
 	 */
@@ -185,6 +207,10 @@ public:
 	 * \param chunk command line string
 	 * \param n string length
 	 * \return Execution status as returned by lua_pcall (0=no error)
+	 * \note In coroutine mode, the command may still be suspended on return
+	 *   (IsBusy() returns true). Call RunChunk with an empty chunk once per
+	 *   frame to continue the command, or the background jobs after the
+	 *   command has finished.
 	 */
 	virtual int RunChunk (const char *chunk, int n);
 
@@ -266,8 +292,9 @@ protected:
 	static int AssertMtdNumber(lua_State *L, int idx, const char *funcname);
 	static int AssertMtdHandle(lua_State *L, int idx, const char *funcname);
 
-	// suspend script execution for one cycle
-	void frameskip (lua_State *L);
+	// suspend script execution for one cycle (returns the number of
+	// results of proc.Frameskip, or a yield in coroutine mode)
+	int frameskip (lua_State *L);
 
 	// extract interpreter pointer from lua state
 	static Interpreter *GetInterpreter (lua_State *L);
@@ -276,19 +303,21 @@ protected:
 	// This also handles vector and nil entries.
 	static const char *lua_tostringex (lua_State *L, int idx, char *cbuf = 0);
 
-	// pushes vector 'vec' into a table on top of the stack
+	// pushes vector 'vec' as a VECTOR3 userdata on top of the stack
 	static void lua_pushvector (lua_State *L, const VECTOR3 &vec);
 
-	// returns 1 if stack entry idx is a vector, 0 otherwise
+	// returns 1 if stack entry idx is a vector (VECTOR3 userdata or
+	// table with fields x, y, z), 0 otherwise
 	static int lua_isvector (lua_State *L, int idx);
 
-	// pushes matrix 'mat' into a table on top of the stack
+	// pushes matrix 'mat' as a MATRIX3 userdata on top of the stack
 	static void lua_pushmatrix (lua_State *L, const MATRIX3 &mat);
 
 	// converts the matrix at stack position 'idx' into a MATRIX3
 	static MATRIX3 lua_tomatrix (lua_State *L, int idx);
 
-	// returns 1 if stack entry idx is a matrix, 0 otherwise
+	// returns 1 if stack entry idx is a matrix (MATRIX3 userdata or
+	// table with fields m11 ... m33), 0 otherwise
 	static int lua_ismatrix (lua_State *L, int idx);
 
 	static COLOUR4 lua_torgba (lua_State *L, int idx);
@@ -366,6 +395,17 @@ protected:
 	static int mat_mmul (lua_State *L);
 	static int mat_rotm (lua_State *L);
 
+	// vector and matrix value type metamethods
+	static int vec_get (lua_State *L);
+	static int vec_setfield (lua_State *L);
+	static int vec_unm (lua_State *L);
+	static int vec_eq (lua_State *L);
+	static int vec_tostring (lua_State *L);
+	static int mat_get (lua_State *L);
+	static int mat_setfield (lua_State *L);
+	static int mat_op_mul (lua_State *L);
+	static int mat_eq (lua_State *L);
+
 	// bit manipulations
 	static int bit_anyset(lua_State* L);
 	static int bit_allset(lua_State* L);
@@ -1155,6 +1195,17 @@ private:
 
 	bool bExecLocal;   // flag for locally created mutexes
 	bool bWaitLocal;
+	bool bCoroutine;   // coroutine execution mode
+	lua_State *trunk;  // command coroutine in coroutine mode (stored in global _trunk)
+
+	int RunCoroutine (const char *chunk, int n);
+	// RunChunk in coroutine mode
+
+	int ResumeTrunk ();
+	// Run the command coroutine until it yields or finishes
+
+	static void ErrorMsg (const char *msg);
+	// Log and display a script error
 
 	int status;              // interpreter status
 	bool is_busy;            // interpreter busy (running a script)
@@ -9,11 +9,18 @@
 -- Any 3-D vectors passed into or returned from Orbiter API script functions conform to the following convention:
 -- A vector is defined as a table containing three numerical fields with keys "x", "y" and "z". (Vectors passed as arguments to API functions can have additional fields, which are ignored by the interpreter).
 -- Vectors can be defined and initialised by normal Lua syntax, or with the _V(x, y, z) function to mimic C++ syntax.
+--
+-- Vectors returned from API functions (and from vec.set) are vector objects rather than tables. They provide the
+-- same x, y and z fields, which can be read and assigned, and support the arithmetic operators +, -, * and /
+-- (elementwise, as in the vec library), unary minus, == and tostring. Vector objects and tables can be used
+-- interchangeably as arguments to API functions. Vector objects are cheaper to create than tables, but they can't
+-- hold additional fields and can't be traversed with pairs().
 -- @usage
 -- V1 = {x=1,y=0,z=-1}
 -- V2 = {}; V2.x=0; V2.y=1.1; V2.z=-16
 -- V3 = {}; V3["x"]=15; V3["y"]=-3.145; V3["z"]=1e3
 -- V4 = _V(1, 0, -1)
+-- V5 = vec.set(1, 0, -1)*2 + V4
 -- @field x x-component [m]
 -- @field y y-component [m]
 -- @field z z-component [m]
@@ -31,6 +38,10 @@
 -- "m21", "m22", "m23", "m31", "m32", "m33".
 -- (Matrices passed as arguments to API functions can have additional fields, which are ignored by the interpreter).
 -- Matrices can be defined and initialised by normal Lua syntax, or with the _M(...) function to mimic C++ syntax.
+--
+-- Matrices returned from API functions are matrix objects rather than tables. They provide the same fields m11 ... m33,
+-- which can be read and assigned, and support the * operator (matrix product, matrix-vector product or scaling),
+-- == and tostring. Matrix objects and tables can be used interchangeably as arguments to API functions.
 -- @usage
 -- M1 = {m11=1,m12=0,m13=0,m21=0,m22=1,m23=0,m31=0,m32=0,m33=1}
 -- M2 = {}
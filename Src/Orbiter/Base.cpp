@@ -12,6 +12,7 @@
 #include "Log.h"
 #include "Util.h"
 #include "GraphicsAPI.h"
+#include "CfgFile.h"
 #include <fstream>
 
 using namespace std;
@@ -48,7 +49,8 @@ Base::Base (char *fname, Planet *_planet, double _lng, double _lat)
 
 	InitDeviceObjects ();
 
-	ifstream ifs (g_pOrbiter->ConfigPath(fname));
+	CfgFile ifs;
+	g_pOrbiter->preload.OpenConfig (ifs, g_pOrbiter->ConfigPath(fname));
 
 	// read location information from file, if available
 	if (ifs && GetItemString (ifs, "LOCATION", cbuf)) {
@@ -65,6 +65,9 @@ public:
 	inline double Elevation() const { return elev; }
 	// Return mean base elevation
 
+	inline const Vector &LocalPos () const { return rpos; }
+	// Return base position in local planet frame
+
 	void Rel_EquPos (const Vector &relpos, double &_lng, double &_lat) const;
 	// converts a base-relative position into longitude/latitude
 
@@ -0,0 +1,69 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// BlockPool.cpp
+// Pool allocator for objects of a fixed maximum size.
+// =======================================================================
+
+#include "BlockPool.h"
+#include <new>
+
+static const size_t BLOCKALIGN = 16; // alignment of the blocks [bytes]
+
+// =======================================================================
+
+BlockPool::BlockPool (size_t _blocksize, size_t _chunkblocks)
+{
+	if (_blocksize < sizeof(FreeBlock)) _blocksize = sizeof(FreeBlock);
+	blocksize = (_blocksize + BLOCKALIGN-1) & ~(BLOCKALIGN-1);
+	chunkblocks = (_chunkblocks ? _chunkblocks : 1);
+	nblock = nused = 0;
+	freelist = 0;
+}
+
+// =======================================================================
+
+BlockPool::~BlockPool ()
+{
+	for (size_t i = 0; i < chunk.size(); i++)
+		::operator delete (chunk[i]);
+}
+
+// =======================================================================
+
+void *BlockPool::Alloc (size_t size)
+{
+	if (size > blocksize)
+		return ::operator new (size);
+
+	if (!freelist) { // get a new chunk and put its blocks on the free list
+		char *c = (char*)::operator new (blocksize*chunkblocks);
+		chunk.push_back (c);
+		for (size_t i = chunkblocks; i > 0; i--) {
+			FreeBlock *b = (FreeBlock*)(c + (i-1)*blocksize);
+			b->next = freelist;
+			freelist = b;
+		}
+		nblock += chunkblocks;
+	}
+	FreeBlock *b = freelist;
+	freelist = b->next;
+	nused++;
+	return b;
+}
+
+// =======================================================================
+
+void BlockPool::Free (void *p, size_t size)
+{
+	if (!p) return;
+	if (size > blocksize) {
+		::operator delete (p);
+		return;
+	}
+	FreeBlock *b = (FreeBlock*)p;
+	b->next = freelist;
+	freelist = b;
+	nused--;
+}
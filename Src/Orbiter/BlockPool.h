@@ -0,0 +1,55 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// BlockPool.h
+// Pool allocator for objects of a fixed maximum size. Memory is taken
+// from the system in chunks of several blocks, and released blocks are
+// kept on a free list for reuse, so that creating and destroying many
+// objects in quick succession (e.g. spawning debris) doesn't go through
+// the general-purpose heap for each object.
+// Not thread-safe.
+// =======================================================================
+
+#ifndef __BLOCKPOOL_H
+#define __BLOCKPOOL_H
+
+#include <vector>
+#include <stddef.h>
+
+class BlockPool {
+public:
+	BlockPool (size_t blocksize, size_t chunkblocks = 64);
+	// blocksize: size of a block [bytes]
+	// chunkblocks: number of blocks allocated from the system at a time
+
+	~BlockPool ();
+	// Releases all chunks. Blocks must no longer be in use.
+
+	void *Alloc (size_t size);
+	// Allocate a block for an object of the given size. Objects larger
+	// than the block size are allocated from the heap.
+
+	void Free (void *p, size_t size);
+	// Release a block allocated with Alloc. size must be the value passed
+	// to Alloc.
+
+	inline size_t BlockSize () const { return blocksize; }
+	inline size_t nBlocks () const { return nblock; }
+	// block size, and total number of blocks held by the pool
+
+	inline size_t nUsed () const { return nused; }
+	// number of blocks currently allocated
+
+private:
+	struct FreeBlock { FreeBlock *next; };
+
+	size_t blocksize;          // block size [bytes], multiple of the alignment
+	size_t chunkblocks;        // blocks per chunk
+	size_t nblock;             // total number of blocks
+	size_t nused;              // blocks in use
+	FreeBlock *freelist;       // list of free blocks
+	std::vector<void*> chunk;  // chunks allocated from the system
+};
+
+#endif // !__BLOCKPOOL_H
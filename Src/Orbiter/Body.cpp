@@ -9,6 +9,7 @@
 #include <fstream>
 #include "Orbiter.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include "Psys.h"
 #include "Body.h"
 #include "Element.h"
@@ -55,7 +56,7 @@ Body::Body(char* fname)
 	//g_pOrbiter->OutputLoadStatus (fname, 0);
 	g_pOrbiter->OutputLoadStatus (cpath, 1);
 
-	ifstream ifs (cpath);
+	CfgFile ifs (cpath);
 	if (!ifs) return;
 	
 	filename = cpath;
@@ -44,108 +44,13 @@
 #include "Rigidbody.h"
 #include "Element.h"
 #include "Log.h"
+#include "RKCoeff.h"
 #include <stdio.h>
+#include <algorithm>
 
 extern TimeData td;
 extern char DBG_MSG[256];
 
-// ===========================================================================
-// Runge-Kutta integration parameters (RK5-RK8)
-// Used by the driver routines below
-// (Note that RK2 and RK4 are implemented directly without using the driver
-// routines)
-// ===========================================================================
-
-// ---------------------------------------------------------------------------
-// RK5 6-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK5_n = 6;
-static const double RK5_alpha[RK5_n-1] = {
-	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0
-};
-static const double RK5_beta[(RK5_n-1)*(RK5_n-1)] = {
-	1.0/5.0, 0, 0, 0, 0,
-	3.0/40.0, 9.0/40.0, 0, 0, 0,
-	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0,
-	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0,
-	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0
-};
-static const double RK5_gamma[RK5_n] = {
-	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
-};
-
-// ---------------------------------------------------------------------------
-// RK6 8-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK6_n = 8;
-static const double RK6_alpha[RK6_n-1] = {
-	1.0/6.0, 4.0/15.0, 2.0/3.0, 5.0/6.0, 1.0, 1.0/15.0, 1.0
-};
-static const double RK6_beta[(RK6_n-1)*(RK6_n-1)] = {
-	1.0/6.0, 0, 0, 0, 0, 0, 0,
-	4.0/75.0, 16.0/75.0, 0, 0, 0, 0, 0,
-	5.0/6.0, -8.0/3.0, 5.0/2.0, 0, 0, 0, 0,
-	-165.0/64.0, 55.0/6.0, -425.0/64.0, 85.0/96.0, 0, 0, 0,
-	12.0/5.0, -8.0, 4015.0/612.0, -11.0/36.0, 88.0/255.0, 0, 0,
-	-8263.0/15000.0, 124.0/75.0, -643.0/680.0, -81.0/250.0, 2484.0/10625.0, 0, 0,
-	3501.0/1720.0, -300.0/43.0, 297275.0/52632.0, -319.0/2322.0, 24068.0/84065.0, 0, 3850.0/26703.0
-};
-static const double RK6_gamma[RK6_n] = {
-	3.0/40.0, 0, 875.0/2244.0, 23.0/72.0, 264.0/1955.0, 0, 125.0/11592.0, 43.0/616.0
-};
-
-// ---------------------------------------------------------------------------
-// RK7 11-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK7_n = 11;
-static const double RK7_alpha[RK7_n-1] = {
-	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0
-};
-static const double RK7_beta[(RK7_n-1)*(RK7_n-1)] = {
-	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0,
-	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0,
-	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0,
-	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0,
-	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0,
-	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0,
-	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0,
-	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0
-};
-static const double RK7_gamma[RK7_n] = {
-	41.0/840.0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 41.0/840.0
-};
-
-// ---------------------------------------------------------------------------
-// RK8 13-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK8_n = 13;
-static const double RK8_alpha[RK8_n-1] = {
-	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0, 0, 1.0
-};
-static const double RK8_beta[(RK8_n-1)*(RK8_n-1)] = {
-	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0, 0, 0,
-	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0, 0, 0,
-	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0, 0, 0,
-	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0, 0, 0,
-	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0, 0, 0,
-	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0, 0, 0,
-	3.0/205.0, 0, 0, 0, 0, -6.0/41.0, -3.0/205.0, -3.0/41.0, 3.0/41.0, 6.0/41.0, 0, 0,
-	-1777.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -289.0/82.0, 2193.0/4100.0, 51.0/82.0, 33.0/164.0, 12.0/41.0, 0, 1.0
-};
-static const double RK8_gamma[RK8_n] = {
-	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
-};
-
 // ===========================================================================
 // Propagators for linear and angular state vectors combined
 // ===========================================================================
@@ -213,17 +118,17 @@ void RigidBody::RK4_LinAng (double h, int nsub, int isub)
 
 // ---------------------------------------------------------------------------
 // Driver routine for Runge-Kutta solvers RK5-RK8 (linear+angular)
-// Note: NOT THREADSAFE
+// Note: work buffers are per thread
 // ---------------------------------------------------------------------------
 
 void RigidBody::RKdrv_LinAng (double h, int nsub, int isub, int n, const double *alpha, const double *beta, const double *gamma)
 {
 	int i, j;
 	double bh;
-	static int nbuf = 8;
-	static StateVectors *s = new StateVectors[nbuf]; TRACENEW
-	static Vector *a       = new Vector[nbuf]; TRACENEW  // linear acceleration
-	static Vector *d       = new Vector[nbuf]; TRACENEW  // angular acceleration
+	static thread_local int nbuf = 8;
+	static thread_local StateVectors *s = new StateVectors[nbuf]; TRACENEW
+	static thread_local Vector *a       = new Vector[nbuf]; TRACENEW  // linear acceleration
+	static thread_local Vector *d       = new Vector[nbuf]; TRACENEW  // angular acceleration
 	Vector tau;
 	if (n > nbuf) { // grow buffers
 		delete []s;
@@ -292,6 +197,98 @@ void RigidBody::RK8_LinAng (double h, int nsub, int isub)
 	RKdrv_LinAng (h, nsub, isub, RK8_n, RK8_alpha, RK8_beta, RK8_gamma);
 }
 
+// ---------------------------------------------------------------------------
+// Driver routine for embedded Runge-Kutta pairs (linear+angular)
+// Performs a step of length h, starting at time t into the full step interval
+// T, and returns the local error estimate of the linear state, normalised
+// to the error scales pscale [m] and vscale [m/s]. The step is only applied
+// if the normalised error is <= 1, or if force is set. An applied step
+// updates s1 and the moments (acc, arot) at the new state. For pairs with
+// the FSAL property (first same as last: the last stage is evaluated at the
+// new state) the moments of the last stage are reused.
+// Note: work buffers are per thread
+// ---------------------------------------------------------------------------
+
+double RigidBody::RKdrv_LinAng_Embedded (double t, double h, double T, double pscale, double vscale, bool force,
+	int n, const double *alpha, const double *beta, const double *gamma, const double *egamma, bool fsal)
+{
+	int i, j;
+	double bh, eh;
+	static thread_local int nbuf = 16;
+	static thread_local StateVectors *s = new StateVectors[nbuf]; TRACENEW
+	static thread_local Vector *a       = new Vector[nbuf]; TRACENEW  // linear acceleration
+	static thread_local Vector *d       = new Vector[nbuf]; TRACENEW  // angular acceleration
+	Vector tau;
+	if (n > nbuf) { // grow buffers
+		delete []s;
+		delete []a;
+		delete []d;
+		s = new StateVectors[n]; TRACENEW
+		a = new Vector[n]; TRACENEW
+		d = new Vector[n]; TRACENEW
+		nbuf = n;
+	}
+
+	s[0].Set (s1->vel, s1->pos, s1->omega, s1->Q);
+	a[0].Set (acc);
+	d[0].Set (arot);
+
+	for (i = 1; i < n; i++) {
+		s[i].Set (s1->vel, s1->pos, s1->omega, s1->Q);
+		for (j = 0; j < i; j++)
+			s[i].Advance (beta[j]*h, a[j], s[j].vel, d[j], s[j].omega);
+		GetIntermediateMoments (a[i],tau,s[i],(t+alpha[i-1]*h)/T, h);
+		d[i].Set (EulerInv_full (tau, s[i].omega));
+		beta += n-1;
+	}
+
+	Vector epos, evel;
+	for (i = 0; i < n; i++) {
+		eh = egamma[i]*h;
+		epos += s[i].vel * eh;
+		evel += a[i]     * eh;
+	}
+	double err = std::max (epos.length()/pscale, evel.length()/vscale);
+	if (err > 1.0 && !force) return err; // reject step
+
+	for (i = 0; i < n; i++) {
+		bh = gamma[i]*h;
+		rvel_add += a[i]       * bh;
+		rpos_add += s[i].vel   * bh;
+		s1->Q.Rotate (s[i].omega * bh);
+		s1->omega += d[i]      * bh;
+	}
+	s1->pos = rpos_base + rpos_add;
+	s1->vel = rvel_base + rvel_add;
+	s1->R.Set (s1->Q);
+	if (fsal) {
+		acc.Set (a[n-1]);
+		arot.Set (d[n-1]);
+	} else {
+		GetIntermediateMoments (acc, tau, *s1, std::min (1.0, (t+h)/T), h);
+		arot.Set (EulerInv_full (tau, s1->omega));
+	}
+	return err;
+}
+
+// ---------------------------------------------------------------------------
+// Dormand-Prince 5(4) adaptive step (linear+angular)
+// ---------------------------------------------------------------------------
+
+double RigidBody::RK45_LinAng_Adaptive (double t, double h, double T, double pscale, double vscale, bool force)
+{
+	return RKdrv_LinAng_Embedded (t, h, T, pscale, vscale, force, RK45_n, RK45_alpha, RK45_beta, RK45_gamma, RK45_egamma, true);
+}
+
+// ---------------------------------------------------------------------------
+// Runge-Kutta-Fehlberg 7(8) adaptive step (linear+angular)
+// ---------------------------------------------------------------------------
+
+double RigidBody::RK78_LinAng_Adaptive (double t, double h, double T, double pscale, double vscale, bool force)
+{
+	return RKdrv_LinAng_Embedded (t, h, T, pscale, vscale, force, RK78_n, RK78_alpha, RK78_beta, RK78_gamma, RK78_egamma, false);
+}
+
 
 // ---------------------------------------------------------------------------
 // 2nd order symplectic propagator (linear+angular)
@@ -490,16 +487,16 @@ void RigidBody::RK4_Pert (const PertIntData &data)
 
 // ---------------------------------------------------------------------------
 // Driver routine for Runge-Kutta solvers RK5-RK8 (perturbation)
-// Note: NOT THREADSAFE
+// Note: work buffers are per thread
 // ---------------------------------------------------------------------------
 
 void RigidBody::RKdrv_Pert (const PertIntData &data, int n, const double *alpha, const double *beta, const double *gamma)
 {
 	int i, j;
-	static int nbuf = 8;
+	static thread_local int nbuf = 8;
 
-	static Vector *v = new Vector[nbuf];
-	static Vector *a = new Vector[nbuf];
+	static thread_local Vector *v = new Vector[nbuf];
+	static thread_local Vector *a = new Vector[nbuf];
 	if (n > nbuf) { // grow buffers
 		delete []v;
 		delete []a;
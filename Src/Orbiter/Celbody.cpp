@@ -16,6 +16,8 @@
 #include "Log.h"
 #include "Orbitersdk.h"
 #include "PinesGrav.h"
+#include "Util.h"
+#include "CfgFile.h"
 
 using namespace std;
 
@@ -48,7 +50,8 @@ CelestialBody::CelestialBody (char *fname)
 	DefaultParam ();
 	ClearModule ();
 
-	ifstream ifs (g_pOrbiter->ConfigPath (fname));
+	CfgFile ifs;
+	g_pOrbiter->preload.OpenConfig (ifs, g_pOrbiter->ConfigPath (fname));
 	if (!ifs) {
 		LOGOUT_ERR_FILENOTFOUND_MSG(g_pOrbiter->ConfigPath (fname), "while initialising celestial body");
 		g_pOrbiter->TerminateOnError();
@@ -57,6 +60,14 @@ CelestialBody::CelestialBody (char *fname)
 	if (GetItemString (ifs, "Module", cbuf))
 		RegisterModule (cbuf);
 
+	if (module && g_pOrbiter->Cfg()->CfgPhysicsPrm.bEphemCache) {
+		ephemCache = new ChebEphemeris; TRACENEW
+		if (!ephemCache->Open (EphemCachePath().c_str(), modPath.c_str())) {
+			delete ephemCache;
+			ephemCache = 0;
+		}
+	}
+
 	GetItemReal (ifs, "SidRotPeriod", rot_T);
 	GetItemReal (ifs, "SidRotOffset", Dphi);
 	GetItemReal (ifs, "Obliquity", eps_rel);
@@ -157,6 +168,10 @@ CelestialBody::CelestialBody (char *fname)
 CelestialBody::~CelestialBody ()
 {
 	ClearModule();
+	if (ephemCache) {
+		delete ephemCache;
+		ephemCache = NULL;
+	}
 	if (nsecondary) {
 		delete []secondary;
 		secondary = NULL;
@@ -186,6 +201,7 @@ void CelestialBody::DefaultParam ()
 	bInitFromElements = false;
 	hMod              = 0;
 	module            = 0;
+	ephemCache        = 0;     // no precompiled ephemerides
 	bFixedElements = false;
 }
 
@@ -549,6 +565,10 @@ void CelestialBody::GetRotation (double t, Matrix &rot) const
 
 int CelestialBody::ExternEphemeris (double mjd, int req, double *res) const
 {
+	if (ephemCache) {
+		int flg = ephemCache->Eval (mjd, res);
+		if (flg) return flg;
+	}
 	if (module)
 		return module->clbkEphemeris (mjd, req, res); // new interface
 	if (modIntf.oplanetEphemeris) {                   // OBSOLETE!
@@ -561,6 +581,10 @@ int CelestialBody::ExternEphemeris (double mjd, int req, double *res) const
 
 int CelestialBody::ExternFastEphemeris (double simt, int req, double *res) const
 {
+	if (ephemCache) {
+		int flg = ephemCache->Eval (td.MJD_ref + Day(simt), res);
+		if (flg) return flg;
+	}
 	if (module) {
 		return module->clbkFastEphemeris (simt, req, res); // new interface
 	}
@@ -640,10 +664,37 @@ bool CelestialBody::PosVelAtTime (double t, Vector *p, Vector *v) const
 	return true;
 }
 
-Vector CelestialBody::InterpolatePosition (double n) const
+void CelestialBody::BeginStateUpdate ()
 {
-	// Interpolate global position of body by iterative bisection
+	RigidBody::BeginStateUpdate ();
+	ipol.Invalidate (); // not valid for the new step until SetupInterpolation
+}
+
+void CelestialBody::EndStateUpdate ()
+{
+	RigidBody::EndStateUpdate ();
+	ipol.Invalidate ();
+}
 
+void CelestialBody::SetupInterpolation ()
+{
+	// Cubic Hermite interpolant of the position relative to the element
+	// reference, from the positions and velocities at both ends of the step.
+	// This is evaluated for every gravity source at every integrator stage of
+	// every vessel, so we only want to do the setup once per step.
+
+	Vector rp0 (s0->pos), rv0 (s0->vel);
+	Vector rp1 (s1->pos), rv1 (s1->vel);
+	const CelestialBody *ref = ElRef();
+	if (ref) {
+		rp0 -= ref->s0->pos;  rv0 -= ref->s0->vel;
+		rp1 -= ref->s1->pos;  rv1 -= ref->s1->vel;
+	}
+	ipol.Setup (rp0, rv0, rp1, rv1, td.SimDT);
+}
+
+Vector CelestialBody::InterpolatePosition (double n) const
+{
 	if      (n == 0)   return s0->pos;
 	else if (n == 1.0) return s1->pos;
 
@@ -651,44 +702,35 @@ Vector CelestialBody::InterpolatePosition (double n) const
 	const CelestialBody *ref = ElRef();
 	if (ref) {
 		// otherwise assume that reference position is origin
-		refp0.Set (ref->s0->pos);
-		refp1.Set (ref->s1->pos);
 		refpm = ref->InterpolatePosition (n);
 		// recursively get reference position at fractional step n
 	}
 
-	const double eps = 1e-2;
-	Vector rp0 (s0->pos-refp0);        // rel. position at current step
-	Vector rp1 (s1->pos-refp1);        // rel. position at next step
-	double rd0 = rp0.length();         // radius at current step
-	double rd1 = rp1.length();         // radius at next step
-	double n0 = 0.0;                   // lower bound of search bracket
-	double n1 = 1.0;                   // upper bound of search bracket
-	double nm = 0.5, d = 0.5;          // current trial point
-	double rdm = (rd0+rd1)*0.5;        // trial radius
-	Vector rpm = (rp0+rp1).unit()*rdm; // trial position
-	while (fabs (nm-n) > eps && d > eps) { // interval too large - continue
-		d *= 0.5;                         // new interval width
-		if (nm < n) {                     // cut away lower half of interval
-			rp0 = rpm;
-			rd0 = rdm;
-			n0  = nm;
-			nm += d;
-		} else {                          // cut away upper half of interval
-			rp1 = rpm;
-			rd1 = rdm;
-			n1  = nm;
-			nm -= d;
-		}
-		rdm = (rd0+rd1)*0.5;              // new trial radius
-		rpm = (rp0+rp1).unit()*rdm;       // new trial position
+	if (ipol.Cubic())
+		return ipol.Eval (n) + refpm;
+
+	// Interpolate global position of body by iterative bisection. This is
+	// also used during the update of the celestial bodies, before the
+	// interpolants of the step have been set up.
+	if (ref) {
+		refp0.Set (ref->s0->pos);
+		refp1.Set (ref->s1->pos);
 	}
-	if (fabs (nm-n) > 1e-10) {        // linear interpolation of remaining step
-		double scale = (n-n0)/(n1-n0);
-		rdm = rd0 + (rd1-rd0)*scale;
-		rpm = (rp0 + (rp1-rp0)*scale).unit() * rdm;
+	return PosInterpolant::Bisect (s0->pos-refp0, s1->pos-refp1, n) + refpm;
+}
+
+bool CelestialBody::InterpolationCoeffs (Vector *c) const
+{
+	c[0].Set (0,0,0);
+	c[1].Set (0,0,0);
+	c[2].Set (0,0,0);
+	for (const CelestialBody *cb = this; cb; cb = cb->ElRef()) {
+		if (!cb->ipol.Cubic()) return false;
+		c[0] += cb->ipol.Coeffs()[1];
+		c[1] += cb->ipol.Coeffs()[2];
+		c[2] += cb->ipol.Coeffs()[3];
 	}
-	return rpm + refpm;
+	return true;
 }
 
 StateVectors CelestialBody::InterpolateState (double n) const
@@ -711,6 +753,36 @@ StateVectors CelestialBody::InterpolateState (double n) const
 	return sv;
 }
 
+std::string CelestialBody::EphemCachePath () const
+{
+	return std::string("Cache\\Ephemeris\\") + name + ".chb";
+}
+
+bool CelestialBody::BuildEphemerisCache (double mjd0, double mjd1)
+{
+	if (!module || !module->bEphemeris()) return false;
+
+	// sample the module directly, bypassing any existing cache
+	auto source = [this](double mjd, double *res) -> int {
+		int flg = module->clbkEphemeris (mjd, EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL, res);
+		if (flg & EPHEM_POLAR) {
+			double crt[6] = {0.0};
+			Pol2Crt (res, crt, (flg & EPHEM_TRUEPOS) != 0, (flg & EPHEM_TRUEVEL) != 0);
+			memcpy (res, crt, 6*sizeof(double));
+			if (!(flg & EPHEM_BARYISTRUE) && (flg & (EPHEM_BARYPOS | EPHEM_BARYVEL))) {
+				Pol2Crt (res+6, crt, (flg & EPHEM_BARYPOS) != 0, (flg & EPHEM_BARYVEL) != 0);
+				memcpy (res+6, crt, 6*sizeof(double));
+			}
+			flg &= ~EPHEM_POLAR;
+		}
+		return flg;
+	};
+
+	std::string path = EphemCachePath();
+	MakePath (path.c_str());
+	return ChebEphemeris::Build (path.c_str(), modPath.c_str(), source, mjd0, mjd1, 1e-11);
+}
+
 void CelestialBody::RegisterModule (char *dllname)
 {
 	char cbuf[256];
@@ -723,6 +795,7 @@ void CelestialBody::RegisterModule (char *dllname)
 		hMod = LoadLibrary (cbuf);
 	}
 	if (!hMod) return;
+	modPath = cbuf;
 
 	// Check if the module provides instance initialisation
 	typedef CELBODY* (*INITPROC)(OBJHANDLE);
@@ -764,6 +837,7 @@ void CelestialBody::ClearModule ()
 		FreeLibrary (hMod);
 		hMod = 0;
 	}
+	modPath.clear();
 	memset (&modIntf, 0, sizeof (modIntf)); // old interface
 }
 
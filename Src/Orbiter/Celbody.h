@@ -12,6 +12,8 @@
 #include "RigidBody.h"
 #include "OrbiterAPI.h"
 #include "PinesGrav.h"
+#include "ChebEphem.h"
+#include "PosInterpolant.h"
 
 // Module interface methods - OBSOLETE
 typedef void   (*OPLANET_SetPrecision)(double prec);
@@ -40,6 +42,11 @@ public:
 	CELBODY *GetModuleInterface() { return module; }
 	// module interface pointer, if available
 
+	bool BuildEphemerisCache (double mjd0, double mjd1);
+	// Fit the module ephemerides over [mjd0,mjd1] and write them to the
+	// ephemeris cache file. Returns false if the body has no ephemeris
+	// module or the cache could not be built.
+
 	void Attach (CelestialBody *_parent);
 	// Set the objects's central body
 
@@ -100,11 +107,30 @@ public:
 	// Returns rotation matrix at time t.
 	// Note: this function assumes current precession, i.e. t sufficiently close to td.SimT0
 
+	virtual void BeginStateUpdate ();
+	virtual void EndStateUpdate ();
+	// Invalidate the trajectory interpolant in addition to the Body versions
+
+	void SetupInterpolation ();
+	// Set up the interpolant of the body's trajectory between last and current
+	// time step. Must be called once per step after the states s1 of the body
+	// and its element reference have been updated. Until then,
+	// InterpolatePosition uses the bisection fallback.
+
 	Vector InterpolatePosition (double n) const;
 	// interpolate a planet position to a time between last and current time step,
 	// where n=0 refers to last step, and n=1 to current step.
-	// linear interpolation of position, plus linear interpolation of radius, if
-	// body's element reference exists
+	// Uses the cubic Hermite interpolant of the position relative to the
+	// element reference set up by SetupInterpolation. If the body sweeps a
+	// large arc within the step, falls back to interpolation of position
+	// direction and radius by iterative bisection.
+
+	bool InterpolationCoeffs (Vector *c) const;
+	// Returns the coefficients c[0..2] of the n, n^2 and n^3 terms of the
+	// global position interpolant over the current step, such that
+	// InterpolatePosition(n) = s0->pos + (c[0] + (c[1] + c[2]*n)*n)*n.
+	// Returns false if the body or any of its element references uses the
+	// bisection fallback for the current step.
 
 	StateVectors InterpolateState (double n) const;
 	// Celestial body state vectors at fractional time n [0..1] between
@@ -123,7 +149,7 @@ public:
 
 	// returns true if the body uses Pines Algorithm to calculate gravitational acceleration from spherical harmonics
 	inline bool usePines() const { return usePinesGravity; }
-	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder){
+	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder) const {
 		return pinesgrav.GetPinesGrav(rposmax, maxDegree, maxOrder);
 	}
 	inline unsigned int GetPinesCutoff() const {
@@ -185,6 +211,9 @@ protected:
 	void ClearModule ();
 	CELBODY *module;         // pointer to module interface class, if available
 
+	ChebEphemeris *ephemCache; // precompiled ephemerides, if available
+	std::string EphemCachePath () const;
+
 	bool bFixedElements;
 	// Set this to true if the object's elements never change
 	// (i.e. using a 2-body approximation)
@@ -198,6 +227,7 @@ protected:
 
 private:
 	HINSTANCE hMod;          // module handle, if available
+	std::string modPath;     // module file name, if available (identifies the source of the ephemeris cache)
 	
 	double eps_ref;          // precession reference axis: obliquity against ecliptic normal
 	double lan_ref;          // precession reference axis: longitude of ascending node in ecliptic
@@ -227,6 +257,8 @@ private:
 	Vector bpos, bvel;       // object's barycentre state (the barycentre of the set of bodies including *this and its children) with respect to the true position of the parent of *this
 	Vector bposofs, bvelofs; // body barycentre state - true state
 	bool ephem_parentbary;   // true if body calculates its state with respect to the parent barycentre, false if with respect to parent's true position
+
+	PosInterpolant ipol;     // interpolant of the position relative to the element reference over the current step
 };
 
 #endif
\ No newline at end of file
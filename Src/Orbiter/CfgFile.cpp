@@ -0,0 +1,207 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// CfgFile.cpp
+// Configuration file stream with an item index
+// =======================================================================
+
+#include "CfgFile.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+static void ToLower (std::string &str)
+{
+	for (auto &c : str) c = (char)tolower ((unsigned char)c);
+}
+
+// =======================================================================
+
+CfgFile::CfgFile (): std::ifstream()
+{
+}
+
+// =======================================================================
+
+CfgFile::CfgFile (const char *fname): CfgFile()
+{
+	open (fname);
+}
+
+// =======================================================================
+
+void CfgFile::open (const char *_fname)
+{
+	close ();
+	std::ifstream::open (_fname);
+	if (is_open()) fname = _fname;
+}
+
+// =======================================================================
+
+void CfgFile::open (const char *_fname, const IndexRef &index)
+{
+	close ();
+	std::ifstream::open (_fname);
+	if (is_open()) idx = index;
+}
+
+// =======================================================================
+
+void CfgFile::close ()
+{
+	if (is_open()) std::ifstream::close ();
+	fname.clear();
+	idx.reset();
+}
+
+// =======================================================================
+
+bool CfgFile::Indexed ()
+{
+	return GetIndex() != nullptr;
+}
+
+// =======================================================================
+
+CfgFile::IndexRef CfgFile::GetIndex ()
+{
+	if (!idx && !fname.empty()) {
+		idx = ReadIndex (fname.c_str());
+		fname.clear(); // only try once
+	}
+	return idx;
+}
+
+// =======================================================================
+
+bool CfgFile::GetItem (const char *label, char *val)
+{
+	std::string key(label);
+	ToLower (key);
+	auto it = idx->item.find (key);
+
+	clear();
+	if (it == idx->item.end()) {
+		seekg (idx->endparse);
+		return false;
+	}
+	seekg (it->second.next);
+	if (!it->second.len) return false;
+	memcpy (val, idx->text.data() + it->second.val, it->second.len);
+	val[it->second.len] = '\0';
+	return true;
+}
+
+// =======================================================================
+
+bool CfgFile::FindLine (const char *line)
+{
+	const std::vector<size_t> &linepos = idx->linepos;
+	size_t len = strlen (line);
+	clear();
+	for (size_t i = 0; i < linepos.size(); i++) {
+		if (!_strnicmp (idx->text.c_str() + linepos[i], line, len)) {
+			seekg (i+1 < linepos.size() ? linepos[i+1] : idx->text.size());
+			return true;
+		}
+	}
+	seekg (0);
+	return false;
+}
+
+// =======================================================================
+
+CfgFile::IndexRef CfgFile::ReadIndex (const char *fname)
+{
+	FILE *f = fopen (fname, "rb");
+	if (!f) return IndexRef();
+	std::shared_ptr<Index> index = std::make_shared<Index>();
+	std::string &text = index->text;
+	char buf[16384];
+	size_t n;
+	while ((n = fread (buf, 1, sizeof(buf), f)) > 0)
+		text.append (buf, n);
+	fclose (f);
+
+	// Items are parsed as in a sequential scan: comments starting with ';'
+	// and surrounding white space are stripped, the tag ends at the first
+	// '=', and the first occurrence of a tag is used.
+	auto blank = [](char c) { return c == ' ' || c == '\t'; };
+	const char *s = text.c_str();
+	size_t len = text.size();
+	bool parse = true;
+	index->endparse = len;
+	for (size_t p = 0; p < len;) {
+		size_t e = text.find ('\n', p);
+		if (e == std::string::npos) e = len;
+		size_t next = (e < len ? e+1 : len);
+		index->linepos.push_back (p);
+
+		if (parse) {
+			size_t b = p, end = e;
+			if (end > b && s[end-1] == '\r') end--;
+			for (size_t i = b; i < end; i++)
+				if (s[i] == ';') { end = i; break; }
+			while (end > b && blank (s[end-1])) end--;
+			while (b < end && blank (s[b])) b++;
+			if (end-b == 9 && !_strnicmp (s+b, "END_PARSE", 9)) {
+				parse = false;
+				index->endparse = next;
+			} else {
+				size_t eq = b;
+				while (eq < end && s[eq] != '=') eq++;
+				size_t ke = eq;
+				while (ke > b && blank (s[ke-1])) ke--;
+				if (ke > b) {
+					std::string key(s+b, ke-b);
+					ToLower (key);
+					size_t v = (eq < end ? eq+1 : end);
+					while (v < end && blank (s[v])) v++;
+					index->item.emplace (key, Item{v, end-v, next});
+				}
+			}
+		}
+		p = next;
+	}
+	return index;
+}
+
+// =======================================================================
+// class CfgCache
+// =======================================================================
+
+CfgFile::IndexRef CfgCache::Get (const char *fname)
+{
+	std::string key(fname);
+	ToLower (key);
+	std::shared_future<CfgFile::IndexRef> index;
+	std::promise<CfgFile::IndexRef> result;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = file.find (key);
+		if (it != file.end()) index = it->second;
+		else file.emplace (key, result.get_future().share());
+	}
+	if (index.valid()) return index.get(); // waits if another thread is parsing the file
+	CfgFile::IndexRef ref = CfgFile::ReadIndex (fname);
+	result.set_value (ref);
+	return ref;
+}
+
+// =======================================================================
+
+void CfgCache::Clear ()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	file.clear();
+}
+
+// =======================================================================
+
+size_t CfgCache::nFile () const
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return file.size();
+}
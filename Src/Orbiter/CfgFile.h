@@ -0,0 +1,107 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// CfgFile.h
+// Configuration file stream with an item index. The file is tokenized
+// once, on the first item lookup, into a case-insensitive hash table of
+// item tags, so that GetItemXXX and oapiReadItem_XXX lookups don't need
+// to rescan the file. CfgFile is an ifstream, so sequential reading and
+// the FILEHANDLE interface keep working as before. Parsed files can be
+// shared between CfgFile instances via CfgCache.
+// =======================================================================
+
+#ifndef __CFGFILE_H
+#define __CFGFILE_H
+
+#include <windows.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <future>
+
+class CfgFile: public std::ifstream {
+public:
+	struct Item {
+		size_t val;      // offset of the value string
+		size_t len;      // length of the value string
+		size_t next;     // offset of the following line
+	};
+	struct Index {       // parsed file contents
+		std::string text;            // file contents
+		std::vector<size_t> linepos; // offsets of line starts
+		std::unordered_map<std::string, Item> item; // items, keyed by lower-case tag
+		size_t endparse;             // offset following the END_PARSE line, or end of file
+	};
+	typedef std::shared_ptr<const Index> IndexRef;
+
+	CfgFile ();
+	explicit CfgFile (const char *fname);
+
+	void open (const char *fname);
+	void close ();
+	// Open or close the file. These hide the std::ifstream methods; a file
+	// opened with std::ifstream::open is read without an index.
+
+	void open (const char *fname, const IndexRef &index);
+	// Open a file with an index obtained from an earlier GetIndex or
+	// ReadIndex call for the same file, so that it isn't parsed again.
+
+	bool Indexed ();
+	// Build the item index if required. Returns false if the file can't
+	// be indexed.
+
+	IndexRef GetIndex ();
+	// Return the item index, building it if required. The index is
+	// immutable and can be shared with other CfgFile instances.
+
+	static IndexRef ReadIndex (const char *fname);
+	// Parse file fname. Returns an empty reference if the file can't be read.
+
+	bool GetItem (const char *label, char *val);
+	// Copy the value of the first item 'label' (case-insensitive) before an
+	// END_PARSE line to val. Returns false if the item doesn't exist or has
+	// no value. The stream is left at the beginning of the line following
+	// the item (or the END_PARSE line, or at the end of the file), as for a
+	// sequential scan. Requires Indexed().
+
+	bool FindLine (const char *line);
+	// Find the first line starting with 'line' (case-insensitive) and
+	// leave the stream at the beginning of the next line. If not found,
+	// rewind the stream and return false. Requires Indexed().
+
+	inline size_t nItem () const { return idx ? idx->item.size() : 0; }
+	inline size_t nLine () const { return idx ? idx->linepos.size() : 0; }
+
+private:
+	std::string fname;   // file to index (empty: already indexed, or not a named file)
+	IndexRef idx;        // item index
+};
+
+// =======================================================================
+// Cache of parsed configuration files, for files that are opened
+// repeatedly, such as vessel class files. Files that can't be read are
+// cached as well.
+
+class CfgCache {
+public:
+	CfgFile::IndexRef Get (const char *fname);
+	// Return the index of file fname, parsing the file on the first request.
+	// Returns an empty reference if the file can't be read. A thread that
+	// requests a file while another thread is parsing it waits for the
+	// result instead of parsing the file again.
+
+	void Clear ();
+	// Release all cached files.
+
+	size_t nFile () const;
+
+private:
+	std::unordered_map<std::string, std::shared_future<CfgFile::IndexRef>> file; // keyed by lower-case path
+	mutable std::mutex mtx;
+};
+
+#endif // !__CFGFILE_H
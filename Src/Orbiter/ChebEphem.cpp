@@ -0,0 +1,203 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ChebEphem.cpp
+// Precompiled celestial body ephemerides (piecewise Chebyshev expansions)
+// =======================================================================
+
+#define OAPI_IMPLEMENTATION
+
+#include "ChebEphem.h"
+#include "OrbiterAPI.h"
+#include "CelbodyAPI.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <filesystem>
+
+static const char ChebMagic[8] = {'O','R','B','C','H','E','B','2'};
+static const int ChebNData = 12;
+
+// data groups in the ephemeris array (3 values each) and their flags
+static const int ChebGroupFlag[4] = {EPHEM_TRUEPOS, EPHEM_TRUEVEL, EPHEM_BARYPOS, EPHEM_BARYVEL};
+
+static bool ChebStamp (const char *fname, __int64 &size, __int64 &time)
+{
+	std::error_code ec;
+	size = (__int64)std::filesystem::file_size (fname, ec);
+	if (ec) return false;
+	time = (__int64)std::filesystem::last_write_time (fname, ec).time_since_epoch().count();
+	return !ec;
+}
+
+// =======================================================================
+
+ChebEphemeris::ChebEphemeris ()
+{
+	hdr = 0;
+	coef = 0;
+}
+
+// =======================================================================
+
+bool ChebEphemeris::Open (const char *fname, const char *srcname)
+{
+	Close ();
+	if (!file.Open (fname)) return false;
+
+	const Header *h = (const Header*)file.Data();
+	if (file.Size() < sizeof(Header) ||
+		memcmp (h->magic, ChebMagic, 8) ||
+		h->ndata != ChebNData || h->nseg <= 0 || h->ncoef <= 0 || h->seglen <= 0.0 ||
+		file.Size() < sizeof(Header) + (size_t)h->nseg*h->ndata*h->ncoef*sizeof(double)) {
+		file.Close();
+		return false;
+	}
+	if (srcname) { // must be built from the current version of srcname
+		__int64 srcsize, srctime;
+		if (strncmp (h->srcname, srcname, sizeof(h->srcname)) || h->srcname[sizeof(h->srcname)-1] ||
+			!ChebStamp (srcname, srcsize, srctime) || h->srcsize != srcsize || h->srctime != srctime) {
+			file.Close();
+			return false;
+		}
+	}
+	hdr = h;
+	coef = (const double*)(file.Data() + sizeof(Header));
+	return true;
+}
+
+// =======================================================================
+
+void ChebEphemeris::Close ()
+{
+	file.Close();
+	hdr = 0;
+	coef = 0;
+}
+
+// =======================================================================
+
+int ChebEphemeris::Eval (double mjd, double *res) const
+{
+	if (!hdr) return 0;
+
+	double s = (mjd - hdr->mjd0) / hdr->seglen;
+	if (s < 0.0 || s > hdr->nseg) return 0;
+	int iseg = (int)s;
+	if (iseg == hdr->nseg) iseg--;                  // end of last segment
+	double x = 2.0*(s-iseg) - 1.0, x2 = 2.0*x;      // segment-local time in [-1,1]
+	int ncoef = hdr->ncoef;
+	const double *c = coef + (size_t)iseg*ChebNData*ncoef;
+
+	for (int g = 0; g < 4; g++) {
+		if (!(hdr->flags & ChebGroupFlag[g])) continue;
+		for (int i = g*3; i < g*3+3; i++) {
+			// Clenshaw recurrence
+			const double *ci = c + i*ncoef;
+			double b0 = 0.0, b1 = 0.0, b2;
+			for (int k = ncoef-1; k > 0; k--) {
+				b2 = b1;
+				b1 = b0;
+				b0 = x2*b1 - b2 + ci[k];
+			}
+			res[i] = x*b0 - b1 + ci[0];
+		}
+	}
+	return hdr->flags;
+}
+
+// =======================================================================
+
+bool ChebEphemeris::Build (const char *fname, const char *srcname, const SourceFunc &func, double mjd0, double mjd1, double tol,
+	int ncoef, double seglen)
+{
+	const double seglen_min = 1.0/256.0;
+	double res[ChebNData];
+	int flags, k, j, i, g;
+
+	if (mjd1 <= mjd0 || ncoef < 2) return false;
+
+	Header h;
+	memset (&h, 0, sizeof(Header));
+	memcpy (h.magic, ChebMagic, 8);
+	if (srcname) {
+		if (strlen (srcname) >= sizeof(h.srcname) || !ChebStamp (srcname, h.srcsize, h.srctime)) return false;
+		strcpy (h.srcname, srcname);
+	}
+
+	flags = func (mjd0, res);
+	if (!(flags & (EPHEM_TRUEPOS | EPHEM_BARYPOS)) || (flags & EPHEM_POLAR)) return false;
+
+	// Chebyshev nodes and the transform from node samples to coefficients
+	std::vector<double> xnode(ncoef), T((size_t)ncoef*ncoef);
+	for (k = 0; k < ncoef; k++) {
+		double theta = PI*(k+0.5)/ncoef;
+		xnode[k] = cos (theta);
+		for (j = 0; j < ncoef; j++)
+			T[j*ncoef+k] = (j ? 2.0 : 1.0)/ncoef * cos (j*theta);
+	}
+
+	std::vector<double> sample((size_t)ncoef*ChebNData), c;
+	for (;;) {
+		int nseg = (int)ceil ((mjd1-mjd0)/seglen);
+		c.assign ((size_t)nseg*ChebNData*ncoef, 0.0);
+		bool ok = true;
+
+		for (int iseg = 0; iseg < nseg && ok; iseg++) {
+			double t0 = mjd0 + iseg*seglen;
+			double *cs = c.data() + (size_t)iseg*ChebNData*ncoef;
+
+			// sample at the nodes and transform
+			for (k = 0; k < ncoef; k++)
+				func (t0 + 0.5*(xnode[k]+1.0)*seglen, sample.data() + k*ChebNData);
+			for (i = 0; i < ChebNData; i++)
+				for (j = 0; j < ncoef; j++) {
+					double sum = 0.0;
+					for (k = 0; k < ncoef; k++)
+						sum += T[j*ncoef+k] * sample[k*ChebNData+i];
+					cs[i*ncoef+j] = sum;
+				}
+
+			// check the fit between the nodes
+			for (k = 0; k <= ncoef && ok; k++) {
+				double x = cos (PI*k/ncoef);
+				double t = t0 + 0.5*(x+1.0)*seglen;
+				func (t, res);
+				for (g = 0; g < 4 && ok; g++) {
+					if (!(flags & ChebGroupFlag[g])) continue;
+					double err2 = 0.0, ref2 = 0.0;
+					for (i = g*3; i < g*3+3; i++) {
+						double b0 = 0.0, b1 = 0.0, b2;
+						for (j = ncoef-1; j > 0; j--) {
+							b2 = b1;
+							b1 = b0;
+							b0 = 2.0*x*b1 - b2 + cs[i*ncoef+j];
+						}
+						double d = x*b0 - b1 + cs[i*ncoef] - res[i];
+						err2 += d*d;
+						ref2 += res[i]*res[i];
+					}
+					if (err2 > tol*tol*ref2) ok = false;
+				}
+			}
+		}
+		if (ok) {
+			h.flags = flags;
+			h.nseg = nseg;
+			h.ncoef = ncoef;
+			h.ndata = ChebNData;
+			h.mjd0 = mjd0;
+			h.seglen = seglen;
+			FILE *f = fopen (fname, "wb");
+			if (!f) return false;
+			bool written = (fwrite (&h, sizeof(Header), 1, f) == 1 &&
+				fwrite (c.data(), sizeof(double), c.size(), f) == c.size());
+			fclose (f);
+			return written;
+		}
+		seglen *= 0.5;
+		if (seglen < seglen_min) return false;
+	}
+}
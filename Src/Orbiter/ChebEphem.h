@@ -0,0 +1,74 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ChebEphem.h
+// Precompiled celestial body ephemerides, stored as piecewise Chebyshev
+// expansions over equal-length time segments in a memory-mapped binary
+// file. Evaluation cost is independent of the date and of the complexity
+// of the underlying ephemeris model.
+// A cache file records the ephemeris module it was fitted from (file name,
+// size and modification time), and is rejected if the module differs.
+// =======================================================================
+
+#ifndef __CHEBEPHEM_H
+#define __CHEBEPHEM_H
+
+#include "MappedFile.h"
+#include <functional>
+
+class ChebEphemeris {
+public:
+	typedef std::function<int(double mjd, double *res)> SourceFunc;
+	// Ephemeris source used to build a cache file. Must fill res[0..11] with
+	// cartesian true and barycentric positions and velocities in the same
+	// layout as CELBODY::clbkEphemeris, and return the EPHEM_xxx data flags.
+
+	ChebEphemeris ();
+
+	bool Open (const char *fname, const char *srcname = 0);
+	// Map an ephemeris cache file. Returns false if the file doesn't exist
+	// or has an invalid format. If srcname is given, the file is also
+	// rejected if it wasn't built from source file srcname, or if srcname
+	// has been modified since.
+
+	void Close ();
+
+	inline bool IsOpen () const { return hdr != 0; }
+	inline double MJD0 () const { return hdr->mjd0; }
+	inline double MJD1 () const { return hdr->mjd0 + hdr->nseg*hdr->seglen; }
+
+	int Eval (double mjd, double *res) const;
+	// Evaluate the ephemeris at date mjd into res[0..11].
+	// Returns the EPHEM_xxx flags of the data in res, or 0 if mjd is not
+	// covered by the cache.
+
+	static bool Build (const char *fname, const char *srcname, const SourceFunc &func, double mjd0, double mjd1, double tol,
+		int ncoef = 16, double seglen = 32.0);
+	// Fit the ephemerides from func over [mjd0,mjd1] and write them to fname.
+	// srcname: file providing func (the ephemeris module), recorded for
+	// Open (0: none). Segment length [days] starts at seglen and is halved
+	// until the relative error of positions and velocities is below tol for
+	// all segments. Returns false if the tolerance can't be met or the file
+	// can't be written.
+
+private:
+	struct Header {
+		char   magic[8]; // file identifier "ORBCHEB2"
+		char   srcname[128]; // source file the data were fitted from ("": none)
+		__int64 srcsize; // size of the source file
+		__int64 srctime; // modification time of the source file
+		int    flags;    // EPHEM_xxx flags of the stored data
+		int    nseg;     // number of segments
+		int    ncoef;    // number of coefficients per segment and data value
+		int    ndata;    // number of data values per segment (12)
+		double mjd0;     // start date
+		double seglen;   // segment length [days]
+	};
+
+	MappedFile file;
+	const Header *hdr;
+	const double *coef;  // coefficients [nseg][ndata][ncoef]
+};
+
+#endif // !__CHEBEPHEM_H
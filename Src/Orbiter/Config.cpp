@@ -15,6 +15,7 @@
 #include <string.h>
 #include <stdio.h>
 #include "Config.h"
+#include "CfgFile.h"
 #include "Astro.h"
 #include "Log.h"
 #include "VectorMap.h"
@@ -60,7 +61,17 @@ CFG_PHYSICSPRM CfgPhysicsPrm_default = {
 	20.0*RAD,	// APropSubLimit (angle step limit for angular subsampling)
 	10, 		// PropSubMax (max number of subsampling steps)
 	30.0*RAD,	// APropCouplingLimit (angle step limit for cross term suppresion)
-	3600.0*RAD	// APropTorqueLimit (angle step limit for torque suppression)
+	3600.0*RAD,	// APropTorqueLimit (angle step limit for torque suppression)
+	0,			// nUpdateThreads (serial vessel propagation)
+	false,		// bEphemCache (evaluate ephemerides from the planet modules)
+	1e-9,		// PropTolerance (relative local error tolerance of the adaptive propagators)
+	false,		// bOrbitRails (all vessels are propagated dynamically)
+	1e5,		// OrbitRailsRange (min. distance from focus vessel and camera for on-rails propagation)
+	1e5,		// OrbitRailsMinAlt (min. periapsis altitude for on-rails propagation)
+	5.0,		// OrbitRailsMinStep (min. simulation time step for on-rails propagation)
+	false,		// bMultiRate (all vessels are updated at every frame)
+	5e-4,		// MultiRateOrbitStep (max. multi-rate update interval as fraction of the orbit period)
+	10.0		// MultiRateMaxInterval (max. multi-rate update interval)
 };
 
 CFG_LOGICPRM CfgLogicPrm_default = {
@@ -145,7 +156,10 @@ CFG_DEBUGPRM CfgDebugPrm_default = {
 	true,       // bSaveExitScreen (capture screen on scenario exit)
 	false,      // bWireframeMode (don't set renderer to wireframe mode)
 	false,      // bNormaliseNormals (don't auto-normalise all normals)
-	false       // bVerboseLog (no verbose log output)
+	false,      // bVerboseLog (no verbose log output)
+	0,          // nLoadThreads (sequential scenario loading)
+	false,      // bLuaCoroutines (run scripts on interpreter threads)
+	false       // bFrameProfiler (disabled)
 };
 
 CFG_PLANETRENDERPRM CfgPRenderPrm_default = {
@@ -158,7 +172,9 @@ CFG_PLANETRENDERPRM CfgPRenderPrm_default = {
 	5,          // patch mesh resolution power
 	50,			// load frequency (Hz)
 	3,			// aniso mode (1=none)
-	0x0003      // TileLoadFlags (load from individual tile files + compressed archives)
+	0x0003,     // TileLoadFlags (load from individual tile files + compressed archives)
+	256,        // ElevCacheSize (number of elevation tiles cached for physics)
+	true        // bElevPrefetch (prefetch elevation tiles in separate thread)
 };
 
 CFG_MAPPRM CfgMapPrm_default = {
@@ -174,7 +190,8 @@ CFG_RECPLAYPRM CfgRecPlayPrm_default = {
 	true,		// bReplayFocus (replay focus events?)
 	true,		// bReplayCam (replay camera events?)
 	true,		// bSysInterval (use system time for sampling intervals?)
-	true		// bShowNotes (show playback onscreen annotations?)
+	true,		// bShowNotes (show playback onscreen annotations?)
+	true		// bRecordBinary (binary position/attitude streams?)
 };
 
 CFG_DEVPRM CfgDevPrm_default = {
@@ -250,8 +267,13 @@ CFG_CMDLINEPRM CfgCmdlinePrm_default = {
 	0.0,                // fixed time step length (0 = disabled)
 	0.0,                // Max sys time (0 = unlimited)
 	0.0,                // Max sim time (0 = unlimited)
+	0.0,                // ephemeris cache build start date
+	0.0,                // ephemeris cache build end date (don't build)
 	std::string(),      // launch scenario (empty: open Launchpad dialog)
-	std::list<std::string>() // list of plugins to load
+	std::list<std::string>(), // list of plugins to load
+	std::string(),      // flight recording to convert (empty: none)
+	false,              // conversion target format (text)
+	std::string()       // batch run output scenario (empty: interactive session)
 };
 
 CFG_WINDOWPOS CfgWindowPos_default = {
@@ -342,6 +364,10 @@ bool GetItemString (istream &is, const char *label, char *val)
 	char cbuf[512], *cl, *cv;
 	int i;
 
+	CfgFile *cf = dynamic_cast<CfgFile*>(&is);
+	if (cf && cf->Indexed())
+		return cf->GetItem (label, val);
+
 	is.clear();
 	is.seekg (0, ios::beg);
 
@@ -420,6 +446,10 @@ bool GetItemVECTOR (istream &is, const char *label, VECTOR3 &val)
 
 bool FindLine (istream &is, const char *line)
 {
+	CfgFile *cf = dynamic_cast<CfgFile*>(&is);
+	if (cf && cf->Indexed())
+		return cf->FindLine (line);
+
 	bool ok = false;
 	is.seekg (0); // rewind stream
 	if (is.good()) {
@@ -475,7 +505,7 @@ bool Config::Load(const char *fname)
 	Root = new char[strlen(fname)+1]; TRACENEW
 	strcpy (Root, fname);
 
-	ifstream ifs (fname);
+	CfgFile ifs (fname);
 	if (!ifs) return false;
 
 	found_config_file = true;
@@ -565,6 +595,9 @@ bool Config::Load(const char *fname)
 		CfgPRenderPrm.ResolutionBias = max (-2.0, min (2.0, d));
 	if (GetInt (ifs, "TileLoadFlags", i))
 		CfgPRenderPrm.TileLoadFlags = max (min(i, 3), 1);
+	if (GetInt (ifs, "ElevTileCacheSize", i))
+		CfgPRenderPrm.ElevCacheSize = max (16, i);
+	GetBool (ifs, "ElevTilePrefetch", CfgPRenderPrm.bElevPrefetch);
 
 	// map dialog parameters
 	if (GetInt (ifs, "MapDlgFlag", i))
@@ -612,6 +645,22 @@ bool Config::Load(const char *fname)
 	CfgPhysicsPrm.PropTLim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	CfgPhysicsPrm.PropALim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	GetInt (ifs, "PropSubsampling", CfgPhysicsPrm.PropSubMax);
+	GetInt (ifs, "VesselUpdateThreads", CfgPhysicsPrm.nUpdateThreads);
+	GetBool (ifs, "EphemerisCache", CfgPhysicsPrm.bEphemCache);
+	if (GetReal (ifs, "PropTolerance", d) && d > 0.0)
+		CfgPhysicsPrm.PropTolerance = d;
+	GetBool (ifs, "OrbitRails", CfgPhysicsPrm.bOrbitRails);
+	if (GetReal (ifs, "OrbitRailsRange", d) && d >= 0.0)
+		CfgPhysicsPrm.OrbitRailsRange = d;
+	if (GetReal (ifs, "OrbitRailsMinAlt", d) && d >= 0.0)
+		CfgPhysicsPrm.OrbitRailsMinAlt = d;
+	if (GetReal (ifs, "OrbitRailsMinStep", d) && d >= 0.0)
+		CfgPhysicsPrm.OrbitRailsMinStep = d;
+	GetBool (ifs, "MultiRateUpdate", CfgPhysicsPrm.bMultiRate);
+	if (GetReal (ifs, "MultiRateOrbitStep", d) && d > 0.0)
+		CfgPhysicsPrm.MultiRateOrbitStep = d;
+	if (GetReal (ifs, "MultiRateMaxInterval", d) && d >= 0.0)
+		CfgPhysicsPrm.MultiRateMaxInterval = d;
 
 #ifdef UNDEF
 	// BEGIN OBSOLETE
@@ -711,6 +760,10 @@ bool Config::Load(const char *fname)
 	GetBool (ifs, "WireframeMode", CfgDebugPrm.bWireframeMode);
     GetBool (ifs, "NormaliseNormals", CfgDebugPrm.bNormaliseNormals);
 	GetBool (ifs, "VerboseLog", CfgDebugPrm.bVerboseLog);
+	if (GetInt (ifs, "LoadThreads", i) && i >= 0)
+		CfgDebugPrm.nLoadThreads = i;
+	GetBool (ifs, "LuaCoroutines", CfgDebugPrm.bLuaCoroutines);
+	GetBool (ifs, "FrameProfiler", CfgDebugPrm.bFrameProfiler);
 
 	GetReal (ifs, "CameraPanspeed", CfgCameraPrm.Panspeed);
 	GetReal (ifs, "CameraTerrainLimit", CfgCameraPrm.TerrainLimit);
@@ -760,6 +813,7 @@ bool Config::Load(const char *fname)
 	GetBool (ifs, "ReplayCameraEvent", CfgRecPlayPrm.bReplayCam);
 	GetBool (ifs, "SystimeSampling", CfgRecPlayPrm.bSysInterval);
 	GetBool (ifs, "PlaybackNotes", CfgRecPlayPrm.bShowNotes);
+	GetBool (ifs, "RecordBinary", CfgRecPlayPrm.bRecordBinary);
 
 	// font characteristics
 	if (GetReal (ifs, "DialogFont_Scale", d)) CfgFontPrm.dlgFont_Scale = (float)d;
@@ -1146,6 +1200,12 @@ BOOL Config::Write (const char *fname) const
 			ofs << "NormaliseNormals = " << BoolStr (CfgDebugPrm.bNormaliseNormals) << '\n';
 		if (CfgDebugPrm.bVerboseLog != CfgDebugPrm_default.bVerboseLog || bEchoAll)
 			ofs << "VerboseLog = " << BoolStr (CfgDebugPrm.bVerboseLog) << '\n';
+		if (CfgDebugPrm.nLoadThreads != CfgDebugPrm_default.nLoadThreads || bEchoAll)
+			ofs << "LoadThreads = " << CfgDebugPrm.nLoadThreads << '\n';
+		if (CfgDebugPrm.bLuaCoroutines != CfgDebugPrm_default.bLuaCoroutines || bEchoAll)
+			ofs << "LuaCoroutines = " << BoolStr (CfgDebugPrm.bLuaCoroutines) << '\n';
+		if (CfgDebugPrm.bFrameProfiler != CfgDebugPrm_default.bFrameProfiler || bEchoAll)
+			ofs << "FrameProfiler = " << BoolStr (CfgDebugPrm.bFrameProfiler) << '\n';
 	}
 
 	if (memcmp (&CfgPhysicsPrm, &CfgPhysicsPrm_default, sizeof(CFG_PHYSICSPRM)) || bEchoAll) {
@@ -1188,6 +1248,26 @@ BOOL Config::Write (const char *fname) const
 #endif
 		if (CfgPhysicsPrm.PropSubMax != CfgPhysicsPrm_default.PropSubMax || bEchoAll)
 			ofs << "PropSubsampling = " << CfgPhysicsPrm.PropSubMax << '\n';
+		if (CfgPhysicsPrm.nUpdateThreads != CfgPhysicsPrm_default.nUpdateThreads || bEchoAll)
+			ofs << "VesselUpdateThreads = " << CfgPhysicsPrm.nUpdateThreads << '\n';
+		if (CfgPhysicsPrm.bEphemCache != CfgPhysicsPrm_default.bEphemCache || bEchoAll)
+			ofs << "EphemerisCache = " << BoolStr (CfgPhysicsPrm.bEphemCache) << '\n';
+		if (CfgPhysicsPrm.PropTolerance != CfgPhysicsPrm_default.PropTolerance || bEchoAll)
+			ofs << "PropTolerance = " << CfgPhysicsPrm.PropTolerance << '\n';
+		if (CfgPhysicsPrm.bOrbitRails != CfgPhysicsPrm_default.bOrbitRails || bEchoAll)
+			ofs << "OrbitRails = " << BoolStr (CfgPhysicsPrm.bOrbitRails) << '\n';
+		if (CfgPhysicsPrm.OrbitRailsRange != CfgPhysicsPrm_default.OrbitRailsRange || bEchoAll)
+			ofs << "OrbitRailsRange = " << CfgPhysicsPrm.OrbitRailsRange << '\n';
+		if (CfgPhysicsPrm.OrbitRailsMinAlt != CfgPhysicsPrm_default.OrbitRailsMinAlt || bEchoAll)
+			ofs << "OrbitRailsMinAlt = " << CfgPhysicsPrm.OrbitRailsMinAlt << '\n';
+		if (CfgPhysicsPrm.OrbitRailsMinStep != CfgPhysicsPrm_default.OrbitRailsMinStep || bEchoAll)
+			ofs << "OrbitRailsMinStep = " << CfgPhysicsPrm.OrbitRailsMinStep << '\n';
+		if (CfgPhysicsPrm.bMultiRate != CfgPhysicsPrm_default.bMultiRate || bEchoAll)
+			ofs << "MultiRateUpdate = " << BoolStr (CfgPhysicsPrm.bMultiRate) << '\n';
+		if (CfgPhysicsPrm.MultiRateOrbitStep != CfgPhysicsPrm_default.MultiRateOrbitStep || bEchoAll)
+			ofs << "MultiRateOrbitStep = " << CfgPhysicsPrm.MultiRateOrbitStep << '\n';
+		if (CfgPhysicsPrm.MultiRateMaxInterval != CfgPhysicsPrm_default.MultiRateMaxInterval || bEchoAll)
+			ofs << "MultiRateMaxInterval = " << CfgPhysicsPrm.MultiRateMaxInterval << '\n';
 	}
 
 	if (memcmp (&CfgPRenderPrm, &CfgPRenderPrm_default, sizeof(CFG_PLANETRENDERPRM)) || bEchoAll) {
@@ -1212,6 +1292,10 @@ BOOL Config::Write (const char *fname) const
 			ofs << "PlanetResolutionBias = " << CfgPRenderPrm.ResolutionBias << '\n';
 		if (CfgPRenderPrm.TileLoadFlags != CfgPRenderPrm_default.TileLoadFlags || bEchoAll)
 			ofs << "TileLoadFlags = " << CfgPRenderPrm.TileLoadFlags << '\n';
+		if (CfgPRenderPrm.ElevCacheSize != CfgPRenderPrm_default.ElevCacheSize || bEchoAll)
+			ofs << "ElevTileCacheSize = " << CfgPRenderPrm.ElevCacheSize << '\n';
+		if (CfgPRenderPrm.bElevPrefetch != CfgPRenderPrm_default.bElevPrefetch || bEchoAll)
+			ofs << "ElevTilePrefetch = " << BoolStr (CfgPRenderPrm.bElevPrefetch) << '\n';
 	}
 
 	if (memcmp (&CfgMapPrm, &CfgMapPrm_default, sizeof (CFG_MAPPRM)) || bEchoAll) {
@@ -1337,6 +1421,8 @@ BOOL Config::Write (const char *fname) const
 			ofs << "SystimeSampling = " << BoolStr (CfgRecPlayPrm.bSysInterval) << '\n';
 		if (CfgRecPlayPrm.bShowNotes != CfgRecPlayPrm_default.bShowNotes || bEchoAll)
 			ofs << "PlaybackNotes = " << BoolStr (CfgRecPlayPrm.bShowNotes) << '\n';
+		if (CfgRecPlayPrm.bRecordBinary != CfgRecPlayPrm_default.bRecordBinary || bEchoAll)
+			ofs << "RecordBinary = " << BoolStr (CfgRecPlayPrm.bRecordBinary) << '\n';
 	}
 
 	if (memcmp (&CfgFontPrm, &CfgFontPrm_default, sizeof(CFG_FONTPRM)) || bEchoAll) {
@@ -1478,6 +1564,10 @@ bool Config::GetString (istream &is, const char *category, char *val)
 	char cbuf[512];
 	int i;
 
+	CfgFile *cf = dynamic_cast<CfgFile*>(&is);
+	if (cf && cf->Indexed())
+		return cf->GetItem (category, val);
+
 	is.clear();
 	is.seekg (0, ios::beg);
 	while (is.getline (cbuf, 512) && strncmp (cbuf, category, strlen(category)));
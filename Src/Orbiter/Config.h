@@ -21,7 +21,7 @@
 // dynamic state propagation methods
 #define MAX_PROP_LEVEL  5
 #define MAX_APROP_LEVEL 5
-#define NPROP_METHOD   10
+#define NPROP_METHOD   12
 #define NAPROP_METHOD   6
 #define PROP_RK2        0
 #define PROP_RK4        1
@@ -33,6 +33,8 @@
 #define PROP_SY4        7
 #define PROP_SY6        8
 #define PROP_SY8        9
+#define PROP_RK45      10
+#define PROP_RK78      11
 
 #define SURF_MAX_PATCHLEVEL 14
 #define SURF_MAX_PATCHLEVEL2 21
@@ -78,6 +80,16 @@ struct CFG_PHYSICSPRM {
 	int    PropSubMax;			// max number of subsampling steps
 	double APropCouplingLimit;	// angle step limit for cross term suppresion
 	double APropTorqueLimit;	// angle step limit for torque suppression
+	int    nUpdateThreads;		// worker threads for concurrent vessel propagation (0=serial)
+	bool   bEphemCache;			// use precompiled Chebyshev ephemerides where available
+	double PropTolerance;		// relative local error tolerance of the adaptive propagators
+	bool   bOrbitRails;			// propagate distant, unpowered vessels analytically ("on rails")
+	double OrbitRailsRange;		// min. distance from focus vessel and camera for on-rails propagation [m]
+	double OrbitRailsMinAlt;	// min. periapsis altitude for on-rails propagation [m]
+	double OrbitRailsMinStep;	// min. simulation time step for on-rails propagation [s]
+	bool   bMultiRate;			// update idle vessels at their own rate, coasting in between
+	double MultiRateOrbitStep;	// max. update interval for multi-rate updates, as fraction of the orbit period
+	double MultiRateMaxInterval;	// max. update interval for multi-rate updates [s]
 };
 
 struct CFG_LOGICPRM {
@@ -171,6 +183,9 @@ struct CFG_DEBUGPRM {
 	bool   bWireframeMode;      // set renderer to wireframe mode?
 	bool   bNormaliseNormals;   // force auto-normalisation of all normals?
 	bool   bVerboseLog;         // verbose log output?
+	int    nLoadThreads;        // worker threads for preloading scenario resources (0=sequential loading)
+	bool   bLuaCoroutines;      // run scripts as coroutines on the simulation thread?
+	bool   bFrameProfiler;      // record per-frame timing of the simulation subsystems?
 };
 
 struct CFG_PLANETRENDERPRM {
@@ -184,6 +199,8 @@ struct CFG_PLANETRENDERPRM {
 	int    LoadFrequency;       // tile load frequency
 	int    AnisoMode;
 	DWORD  TileLoadFlags;       // flags for planetary tile load mechanism
+	int    ElevCacheSize;       // number of elevation tiles in the shared physics tile cache
+	bool   bElevPrefetch;       // prefetch elevation tiles ahead of surface vessels in a separate thread
 };
 
 struct CFG_MAPPRM {
@@ -200,6 +217,7 @@ struct CFG_RECPLAYPRM {
 	bool   bReplayCam;			// use recorded camera events during playback?
 	bool   bSysInterval;		// sample in system time intervals?
 	bool   bShowNotes;			// show inflight notes during playback?
+	bool   bRecordBinary;		// write position/attitude streams in binary format?
 };
 
 struct CFG_DEVPRM {
@@ -288,8 +306,13 @@ struct CFG_CMDLINEPRM {
 	double FixedStep;           // fixed time step length (0 = disabled). If != 0, overrides CFG_DEBUGPRM::FixedStep
 	double MaxSysTime;          // Max session runtime (sys time). 0 = unlimited
 	double MaxSimTime;          // Max session runtime (sim time). 0 = unlimited
+	double EphemBuildMJD0;      // start date for building the ephemeris cache
+	double EphemBuildMJD1;      // end date for building the ephemeris cache (<= MJD0: don't build)
 	std::string LaunchScenario; // if not empty, start scenario instantly without opening Launchpad
 	std::list<std::string> LoadPlugins; // list of plugins to load
+	std::string FRConvert;      // if not empty, convert the position/attitude streams of this flight recording
+	bool   bFRConvertBinary;    // FRConvert target format (true=binary, false=text)
+	std::string BatchScenario;  // if not empty, run LaunchScenario without user interface and save the final state to this scenario
 };
 
 // =============================================================
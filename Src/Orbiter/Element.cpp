@@ -4,6 +4,7 @@
 #include "Orbiter.h"
 #include "Element.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include <fstream>
 #include <windows.h>
 #include <stdio.h>
@@ -59,7 +60,8 @@ Elements::Elements (const Elements &el)
 Elements::Elements (char *fname)
 {
 	double epoch;
-	ifstream ifs (g_pOrbiter->ConfigPath (fname));
+	CfgFile ifs;
+	g_pOrbiter->preload.OpenConfig (ifs, g_pOrbiter->ConfigPath (fname));
 	if (!GetItemReal (ifs, "Epoch", epoch))           epoch  = 2000.0;
 	mjd_epoch = Jepoch2MJD (epoch);
 	t_epoch   = (mjd_epoch-td.MJD_ref)*86400.0;
@@ -0,0 +1,218 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ElevTileCache.cpp
+// Process-wide cache of decoded elevation tiles
+// =======================================================================
+
+#include "ElevTileCache.h"
+#include "elevmgr.h"
+#include "Orbiter.h"
+#include "Config.h"
+#include "Log.h"
+#include <chrono>
+
+extern Orbiter *g_pOrbiter;
+
+// =======================================================================
+
+std::shared_ptr<ElevTileCache> ElevTileCache::Acquire ()
+{
+	static std::mutex instanceMtx;
+	static std::weak_ptr<ElevTileCache> instance;
+
+	std::lock_guard<std::mutex> lock(instanceMtx);
+	std::shared_ptr<ElevTileCache> cache = instance.lock();
+	if (!cache) {
+		const CFG_PLANETRENDERPRM &prm = g_pOrbiter->Cfg()->CfgPRenderPrm;
+		cache = std::make_shared<ElevTileCache>(prm.ElevCacheSize, prm.bElevPrefetch);
+		instance = cache;
+	}
+	return cache;
+}
+
+// =======================================================================
+
+ElevTileCache::ElevTileCache (size_t _maxtiles, bool prefetch)
+{
+	maxtiles = max ((size_t)16, _maxtiles);
+	maxqueue = 32;
+	tick = 0;
+	memset (&stats, 0, sizeof(Stats));
+	busy = nullptr;
+	bRun = true;
+	if (prefetch)
+		worker = std::thread(&ElevTileCache::PrefetchLoop, this);
+}
+
+// =======================================================================
+
+ElevTileCache::~ElevTileCache ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bRun = false;
+		queue.clear();
+	}
+	queued.notify_all();
+	if (worker.joinable()) worker.join();
+
+	if (stats.nrequest) {
+		LOGOUT("Elevation tile cache: %zu requests, %0.1f%% hits, %zu loaded on request (mean %0.2f ms, max %0.2f ms), %zu prefetched",
+			stats.nrequest, 100.0*stats.nhit/stats.nrequest, stats.nload,
+			stats.nload ? 1e3*stats.loadtime/stats.nload : 0.0, 1e3*stats.loadtime_max, stats.nprefetch);
+	}
+}
+
+// =======================================================================
+
+ElevTileRef ElevTileCache::Get (const ElevationManager *mgr, int lvl, int ilat, int ilng)
+{
+	return Fetch ({mgr, lvl, ilat, ilng}, false);
+}
+
+// =======================================================================
+
+void ElevTileCache::Prefetch (const ElevationManager *mgr, int reqlvl, int ilat, int ilng)
+{
+	if (!worker.joinable()) return;
+
+	Key key = {mgr, reqlvl, ilat, ilng};
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (slot.find (key) != slot.end() || queue.size() >= maxqueue)
+			return;
+		for (auto &k : queue)
+			if (k == key) return;
+		queue.push_back (key);
+	}
+	queued.notify_one();
+}
+
+// =======================================================================
+
+void ElevTileCache::Purge (const ElevationManager *mgr)
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	for (auto it = queue.begin(); it != queue.end();)
+		if (it->mgr == mgr) it = queue.erase (it);
+		else it++;
+
+	// wait for pending loads of this manager
+	for (;;) {
+		bool pending = (busy == mgr);
+		for (auto &s : slot)
+			if (s.first.mgr == mgr && s.second.loading) {
+				pending = true;
+				break;
+			}
+		if (!pending) break;
+		loaded.wait (lock);
+	}
+
+	for (auto it = slot.begin(); it != slot.end();)
+		if (it->first.mgr == mgr) it = slot.erase (it);
+		else it++;
+}
+
+// =======================================================================
+
+ElevTileCache::Stats ElevTileCache::GetStats () const
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return stats;
+}
+
+// =======================================================================
+
+size_t ElevTileCache::KeyHash::operator() (const Key &k) const
+{
+	size_t h = std::hash<const void*>()(k.mgr);
+	h ^= ((size_t)k.lvl * 0x9E3779B1u) + ((size_t)k.ilat << 20) + (size_t)k.ilng + (h << 6) + (h >> 2);
+	return h;
+}
+
+// =======================================================================
+
+ElevTileRef ElevTileCache::Fetch (const Key &key, bool prefetch)
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	if (!prefetch) stats.nrequest++;
+
+	auto it = slot.find (key);
+	while (it != slot.end() && it->second.loading) { // being loaded by another thread
+		loaded.wait (lock);
+		it = slot.find (key);
+	}
+	if (it != slot.end()) {
+		it->second.lastuse = ++tick;
+		if (!prefetch) stats.nhit++;
+		return it->second.tile;
+	}
+
+	slot[key] = {ElevTileRef(), true, ++tick};
+	lock.unlock();
+
+	auto t0 = std::chrono::steady_clock::now();
+	ElevTileRef tile = key.mgr->LoadTile (key.lvl, key.ilat, key.ilng);
+	double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	lock.lock();
+	Slot &s = slot[key];
+	s.tile = tile;
+	s.loading = false;
+	if (prefetch) {
+		stats.nprefetch++;
+	} else {
+		stats.nload++;
+		stats.loadtime += dt;
+		if (dt > stats.loadtime_max) stats.loadtime_max = dt;
+	}
+	Evict ();
+	lock.unlock();
+	loaded.notify_all();
+	return tile;
+}
+
+// =======================================================================
+
+void ElevTileCache::Evict ()
+{
+	while (slot.size() > maxtiles) {
+		auto lru = slot.end();
+		for (auto it = slot.begin(); it != slot.end(); it++)
+			if (!it->second.loading && (lru == slot.end() || it->second.lastuse < lru->second.lastuse))
+				lru = it;
+		if (lru == slot.end()) break;
+		slot.erase (lru); // tiles still referenced by callers stay alive until released
+	}
+}
+
+// =======================================================================
+
+void ElevTileCache::PrefetchLoop ()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	while (bRun) {
+		if (queue.empty()) {
+			queued.wait (lock);
+			continue;
+		}
+		Key key = queue.front();
+		queue.pop_front();
+		busy = key.mgr;
+		lock.unlock();
+
+		// load the requested tile, or its highest-resolution available ancestor
+		for (int lvl = key.lvl; lvl >= 0; lvl--) {
+			int shift = key.lvl-lvl;
+			ElevTileRef tile = Fetch ({key.mgr, lvl, key.ilat >> shift, key.ilng >> shift}, true);
+			if (tile->elev) break;
+		}
+
+		lock.lock();
+		busy = nullptr;
+		loaded.notify_all();
+	}
+}
@@ -0,0 +1,112 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ElevTileCache.h
+// Process-wide cache of decoded elevation tiles, shared by all elevation
+// managers and their callers, with background prefetching of tiles
+// along the predicted ground track.
+// =======================================================================
+
+#ifndef __ELEVTILECACHE_H
+#define __ELEVTILECACHE_H
+
+#include <windows.h>
+#include <memory>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class ElevationManager;
+
+// =======================================================================
+// Decoded elevation tile. The elevation grid is immutable once the tile
+// has been filtered by the graphics client (see ElevationManager::Elevation).
+
+struct ElevTileData {
+	ElevTileData () { elev = nullptr; quadrants = 0; }
+	~ElevTileData () { if (elev) delete []elev; }
+
+	INT16 *elev;             // elevation grid including padding (nullptr: tile not present)
+	int quadrants;           // bit flags for quadrants covered by higher-resolution tiles
+	std::once_flag filtered; // graphics client elevation filter applied
+};
+
+typedef std::shared_ptr<ElevTileData> ElevTileRef;
+
+// =======================================================================
+
+class ElevTileCache {
+public:
+	struct Stats {
+		size_t nrequest;   // tile requests
+		size_t nhit;       // requests served from the cache
+		size_t nload;      // tiles loaded on request
+		size_t nprefetch;  // tiles loaded by the prefetch worker
+		double loadtime;   // total time spent loading tiles on request [s]
+		double loadtime_max; // longest load time on request [s]
+	};
+
+	static std::shared_ptr<ElevTileCache> Acquire ();
+	// Return the shared cache instance, creating it if required. The cache
+	// is destroyed when the last elevation manager releases it.
+
+	ElevTileCache (size_t maxtiles, bool prefetch);
+	~ElevTileCache ();
+
+	ElevTileRef Get (const ElevationManager *mgr, int lvl, int ilat, int ilng);
+	// Return tile (lvl,ilat,ilng) of mgr, loading it synchronously if not
+	// cached. If the tile is being loaded by another thread, wait for it.
+
+	void Prefetch (const ElevationManager *mgr, int reqlvl, int ilat, int ilng);
+	// Queue tile (reqlvl,ilat,ilng) for loading on the worker thread. If it
+	// doesn't exist, its lowest-resolution available ancestor is loaded.
+
+	void Purge (const ElevationManager *mgr);
+	// Remove all tiles of mgr from the cache and prefetch queue. Waits for
+	// any tile of mgr currently being loaded.
+
+	Stats GetStats () const;
+
+private:
+	struct Key {
+		const ElevationManager *mgr;
+		int lvl, ilat, ilng;
+		bool operator== (const Key &k) const { return mgr == k.mgr && lvl == k.lvl && ilat == k.ilat && ilng == k.ilng; }
+	};
+	struct KeyHash {
+		size_t operator() (const Key &k) const;
+	};
+	struct Slot {
+		ElevTileRef tile;    // tile data (empty while loading)
+		bool loading;        // tile is being loaded
+		UINT64 lastuse;      // access tick for LRU eviction
+	};
+
+	ElevTileRef Fetch (const Key &key, bool prefetch);
+	// Return a tile from the cache, or load it. Prefetch requests don't
+	// contribute to the request statistics.
+
+	void Evict ();
+	// Remove least recently used tiles until the cache size is within limits.
+	// Called with mtx locked.
+
+	void PrefetchLoop ();
+
+	std::unordered_map<Key, Slot, KeyHash> slot;
+	std::deque<Key> queue;   // prefetch requests
+	size_t maxtiles;         // max number of cached tiles
+	size_t maxqueue;         // max number of pending prefetch requests
+	UINT64 tick;             // access counter
+	Stats stats;
+	mutable std::mutex mtx;
+	std::condition_variable loaded; // signalled when a tile load completes
+	std::condition_variable queued; // signalled when a prefetch request is queued
+	std::thread worker;      // prefetch worker
+	const ElevationManager *busy; // manager of the prefetch request being processed
+	bool bRun;
+};
+
+#endif // !__ELEVTILECACHE_H
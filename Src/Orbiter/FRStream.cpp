@@ -0,0 +1,727 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// FRStream.cpp
+// Flight recorder streams, background writer and playback index
+// =======================================================================
+
+#include "FRStream.h"
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <algorithm>
+#include <filesystem>
+
+static const char FRMagic[8] = {'O','R','B','F','R','E','C','1'};
+
+struct FRStreamHeader {
+	char  magic[8];      // file identifier "ORBFREC1"
+	INT32 type;          // stream type (FRSTREAM_POS or FRSTREAM_ATT)
+	INT32 recsize;       // record size [bytes]
+};
+
+static const char FRIndexMagic[8] = {'O','R','B','F','R','I','X','1'};
+
+struct FRIndexHeader {
+	char    magic[8];    // file identifier "ORBFRIX1"
+	__int64 srcsize;     // size of the indexed stream file
+	__int64 srctime;     // modification time of the indexed stream file
+	INT32   nsample;     // number of samples
+	INT32   npage;       // number of pages
+	INT32   nctx;        // number of contexts
+	INT32   pad;
+	double  tend;        // time of the last sample
+	double  startmjd;    // start date
+};
+
+static_assert (sizeof(FRStreamRecord) == 64, "unexpected flight recorder record size");
+
+static const double FlushInterval = 1.0; // max. time data are held in the stream buffer [s]
+
+// =======================================================================
+// class FRWriter
+// =======================================================================
+
+std::shared_ptr<FRWriter> FRWriter::Acquire ()
+{
+	static std::mutex instanceMtx;
+	static std::weak_ptr<FRWriter> instance;
+
+	std::lock_guard<std::mutex> lock(instanceMtx);
+	std::shared_ptr<FRWriter> writer = instance.lock();
+	if (!writer) {
+		writer = std::make_shared<FRWriter>();
+		instance = writer;
+	}
+	return writer;
+}
+
+// =======================================================================
+
+FRWriter::FRWriter (): ring(NBlock)
+{
+	nsubmit = nwritten = 0;
+	bRun = true;
+	worker = std::thread(&FRWriter::WriteLoop, this);
+}
+
+// =======================================================================
+
+FRWriter::~FRWriter ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bRun = false;
+	}
+	submitted.notify_all();
+	worker.join();
+}
+
+// =======================================================================
+
+UINT64 FRWriter::Submit (FILE *f, const char *data, size_t size)
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	while (size) {
+		while (nsubmit - nwritten >= NBlock) // ring buffer full
+			written.wait (lock);
+		Block &b = ring[nsubmit % NBlock];
+		b.f = f;
+		b.size = min (size, (size_t)BlockSize);
+		memcpy (b.data, data, b.size);
+		data += b.size;
+		size -= b.size;
+		nsubmit++;
+		submitted.notify_one();
+	}
+	return nsubmit;
+}
+
+// =======================================================================
+
+void FRWriter::Sync (UINT64 seq)
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	while (nwritten < seq)
+		written.wait (lock);
+}
+
+// =======================================================================
+
+void FRWriter::Register (FRStream *s)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	streams.push_back (s);
+}
+
+// =======================================================================
+
+void FRWriter::Unregister (FRStream *s)
+{
+	// once this returns, the writer thread no longer accesses s
+	std::lock_guard<std::mutex> lock(mtx);
+	streams.erase (std::remove (streams.begin(), streams.end(), s), streams.end());
+}
+
+// =======================================================================
+
+void FRWriter::FlushStreams ()
+{
+	// Called by the writer thread with mtx locked. Streams that are busy
+	// are skipped: they are active, and flush themselves.
+	auto now = std::chrono::steady_clock::now();
+	for (FRStream *s : streams) {
+		if (nsubmit - nwritten >= NBlock) break; // ring buffer full: retry at the next tick
+		std::unique_lock<std::mutex> slock(s->stagemtx, std::try_to_lock);
+		if (!slock || !s->nstage ||
+			std::chrono::duration<double>(now - s->tflush).count() < 0.5*FlushInterval)
+			continue;
+		Block &b = ring[nsubmit % NBlock];
+		b.f = s->f;
+		b.size = s->nstage;
+		memcpy (b.data, s->stage, b.size);
+		s->seq = ++nsubmit;
+		s->nstage = 0;
+		s->tflush = now;
+	}
+}
+
+// =======================================================================
+
+void FRWriter::WriteLoop ()
+{
+	// staged data are passed on after between 0.5 and 1 flush intervals
+	const auto tick = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(0.5*FlushInterval));
+	auto tnext = std::chrono::steady_clock::now() + tick;
+	std::unique_lock<std::mutex> lock(mtx);
+	for (;;) {
+		if (std::chrono::steady_clock::now() >= tnext) {
+			FlushStreams ();
+			tnext = std::chrono::steady_clock::now() + tick;
+		}
+		if (nwritten == nsubmit) {
+			if (!bRun) break;
+			submitted.wait_until (lock, tnext);
+			continue;
+		}
+		// blocks are only modified by Submit once they have been written,
+		// so the current block can be accessed without the lock
+		Block &b = ring[nwritten % NBlock];
+		lock.unlock();
+		fwrite (b.data, 1, b.size, b.f);
+		fflush (b.f);
+		lock.lock();
+		nwritten++;
+		written.notify_all();
+	}
+}
+
+// =======================================================================
+// class FRStream
+// =======================================================================
+
+FRStream::FRStream ()
+{
+	f = NULL;
+	type = FRSTREAM_TEXT;
+	binary = false;
+	nstage = 0;
+	seq = 0;
+}
+
+// =======================================================================
+
+FRStream::~FRStream ()
+{
+	Close ();
+}
+
+// =======================================================================
+
+bool FRStream::Open (const char *fname, int _type, bool append, bool _binary)
+{
+	Close ();
+	type = _type;
+	binary = (_binary && type != FRSTREAM_TEXT);
+
+	bool writeheader = binary;
+	if (append) {
+		// retain the format of an existing file
+		FILE *fr = fopen (fname, "rb");
+		if (fr) {
+			FRStreamHeader hdr;
+			size_t n = fread (&hdr, 1, sizeof(FRStreamHeader), fr);
+			fclose (fr);
+			if (n) {
+				binary = (n == sizeof(FRStreamHeader) && !memcmp (hdr.magic, FRMagic, 8) && hdr.type == type);
+				writeheader = false;
+			}
+		}
+	}
+
+	f = fopen (fname, binary ? (append ? "ab" : "wb") : (append ? "a" : "w"));
+	if (!f) return false;
+	writer = FRWriter::Acquire();
+	tflush = std::chrono::steady_clock::now();
+	writer->Register (this);
+
+	if (writeheader) {
+		FRStreamHeader hdr;
+		memcpy (hdr.magic, FRMagic, 8);
+		hdr.type = type;
+		hdr.recsize = sizeof(FRStreamRecord);
+		Write ((const char*)&hdr, sizeof(FRStreamHeader));
+	}
+	return true;
+}
+
+// =======================================================================
+
+void FRStream::Close ()
+{
+	if (!f) return;
+	writer->Unregister (this);
+	Flush ();
+	writer->Sync (seq);
+	fclose (f);
+	f = NULL;
+	writer.reset();
+}
+
+// =======================================================================
+
+void FRStream::Put (const FRStreamRecord &rec)
+{
+	if (binary) {
+		Write ((const char*)&rec, sizeof(FRStreamRecord));
+	} else {
+		char cbuf[256];
+		int len = FRFormatRecord (rec, type, cbuf, 256);
+		Write (cbuf, len);
+	}
+}
+
+// =======================================================================
+
+void FRStream::Printf (const char *fmt, ...)
+{
+	char cbuf[1024];
+	va_list ap;
+	va_start (ap, fmt);
+	int len = vsnprintf (cbuf, 1024, fmt, ap);
+	va_end (ap);
+	if (len > 0)
+		Write (cbuf, min (len, 1023));
+}
+
+// =======================================================================
+
+void FRStream::Flush ()
+{
+	std::lock_guard<std::mutex> lock(stagemtx);
+	FlushStage ();
+}
+
+// =======================================================================
+
+void FRStream::FlushStage ()
+{
+	if (nstage) {
+		seq = writer->Submit (f, stage, nstage);
+		nstage = 0;
+	}
+	tflush = std::chrono::steady_clock::now();
+}
+
+// =======================================================================
+
+void FRStream::Write (const char *data, size_t size)
+{
+	// partially filled blocks are passed on by the writer thread once the
+	// stream has been idle for a while (FRWriter::FlushStreams)
+	if (!f) return;
+	std::lock_guard<std::mutex> lock(stagemtx);
+	while (size) {
+		size_t n = min (size, (size_t)FRWriter::BlockSize - nstage);
+		memcpy (stage+nstage, data, n);
+		nstage += n;
+		data += n;
+		size -= n;
+		if (nstage == FRWriter::BlockSize) FlushStage ();
+	}
+}
+
+// =======================================================================
+// class FRStreamReader
+// =======================================================================
+
+FRStreamReader::FRStreamReader ()
+{
+	f = NULL;
+	type = FRSTREAM_POS;
+	binary = false;
+}
+
+// =======================================================================
+
+FRStreamReader::~FRStreamReader ()
+{
+	Close ();
+}
+
+// =======================================================================
+
+bool FRStreamReader::Open (const char *fname, int _type)
+{
+	Close ();
+	type = _type;
+	if (!(f = fopen (fname, "rb"))) return false;
+
+	FRStreamHeader hdr;
+	size_t n = fread (&hdr, 1, sizeof(FRStreamHeader), f);
+	binary = (n == sizeof(FRStreamHeader) && !memcmp (hdr.magic, FRMagic, 8));
+	if (binary) {
+		if (hdr.type != type || hdr.recsize != sizeof(FRStreamRecord)) {
+			Close ();
+			return false;
+		}
+	} else {
+		// reopen in text mode
+		fclose (f);
+		f = fopen (fname, "r");
+	}
+	return f != NULL;
+}
+
+// =======================================================================
+
+void FRStreamReader::Close ()
+{
+	if (f) {
+		fclose (f);
+		f = NULL;
+	}
+}
+
+// =======================================================================
+
+__int64 FRStreamReader::Tell () const
+{
+	return f ? _ftelli64 (f) : -1;
+}
+
+// =======================================================================
+
+bool FRStreamReader::Seek (__int64 pos)
+{
+	return f && !_fseeki64 (f, pos, SEEK_SET);
+}
+
+// =======================================================================
+
+static char *FRTrim (char *s)
+{
+	while (*s == ' ' || *s == '\t') s++;
+	size_t len = strlen (s);
+	while (len && isspace ((unsigned char)s[len-1])) s[--len] = '\0';
+	return s;
+}
+
+bool FRStreamReader::Next (FRStreamRecord &rec)
+{
+	if (!f) return false;
+	memset (&rec, 0, sizeof(FRStreamRecord));
+
+	if (binary)
+		return fread (&rec, sizeof(FRStreamRecord), 1, f) == 1;
+
+	char cbuf[256];
+	while (fgets (cbuf, 256, f)) {
+		if (!_strnicmp (cbuf, "REF", 3)) {
+			rec.tag = FRTAG_REF;
+			strncpy (rec.name, FRTrim (cbuf+3), 47);
+			return true;
+		} else if (!_strnicmp (cbuf, "FRM", 3)) {
+			rec.tag = FRTAG_FRM;
+			rec.ival = (!_stricmp (FRTrim (cbuf+3), type == FRSTREAM_POS ? "EQUATORIAL" : "HORIZON") ? 1 : 0);
+			return true;
+		} else if (!_strnicmp (cbuf, "CRD", 3)) {
+			rec.tag = FRTAG_CRD;
+			rec.ival = (!_stricmp (FRTrim (cbuf+3), "POLAR") ? 1 : 0);
+			return true;
+		} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
+			rec.tag = FRTAG_STARTMJD;
+			if (sscanf (cbuf+8, "%lf", &rec.t) == 1)
+				return true;
+		} else {
+			rec.tag = FRTAG_SAMPLE;
+			double *v = rec.v;
+			if (type == FRSTREAM_POS) {
+				if (sscanf (cbuf, "%lf%lf%lf%lf%lf%lf%lf", &rec.t, v+0, v+1, v+2, v+3, v+4, v+5) == 7)
+					return true;
+			} else {
+				if (sscanf (cbuf, "%lf%lf%lf%lf", &rec.t, v+0, v+1, v+2) == 4)
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+// =======================================================================
+// class FRTrack
+// =======================================================================
+
+FRTrack::FRTrack ()
+{
+	nsample = 0;
+	tend = startmjd = 0.0;
+	cur = 0;
+	tick = 0;
+	for (int i = 0; i < NCachePage; i++)
+		cache[i].page = -1;
+}
+
+// =======================================================================
+
+FRTrack::~FRTrack ()
+{
+	Close ();
+}
+
+// =======================================================================
+
+bool FRTrack::Open (const char *fname, int type, bool useindex)
+{
+	Close ();
+	if (!reader.Open (fname, type)) return false;
+
+	std::string idxname = std::string(fname) + ".idx";
+	if (!useindex || !LoadIndex (fname, idxname.c_str())) {
+		if (!BuildIndex ()) {
+			Close ();
+			return false;
+		}
+		if (useindex && page.size() > 1) // not worth it for short streams
+			SaveIndex (fname, idxname.c_str());
+	}
+	return true;
+}
+
+// =======================================================================
+
+void FRTrack::Close ()
+{
+	reader.Close();
+	page.clear();
+	ctx.clear();
+	for (int i = 0; i < NCachePage; i++) {
+		cache[i].page = -1;
+		cache[i].s.clear();
+	}
+	nsample = 0;
+	tend = startmjd = 0.0;
+	cur = 0;
+}
+
+// =======================================================================
+
+bool FRTrack::BuildIndex ()
+{
+	// One pass over the stream. Each directive opens a new context, so
+	// that contexts can be re-enumerated when decoding a page.
+	Context c;
+	memset (&c, 0, sizeof(Context));
+	ctx.assign (1, c);
+	page.clear();
+	nsample = 0;
+
+	FRStreamRecord rec;
+	__int64 pos = reader.Tell();
+	while (reader.Next (rec)) {
+		if (rec.tag == FRTAG_SAMPLE) {
+			if (nsample % PageSize == 0) {
+				Page pg = {rec.t, pos, (INT32)ctx.size()-1, 0};
+				page.push_back (pg);
+			}
+			tend = rec.t;
+			nsample++;
+		} else {
+			c = ctx.back();
+			switch (rec.tag) {
+			case FRTAG_STARTMJD: startmjd = rec.t; break;
+			case FRTAG_REF:      strncpy (c.ref, rec.name, 47); c.ref[47] = '\0'; break;
+			case FRTAG_FRM:      c.frm = rec.ival; break;
+			case FRTAG_CRD:      c.crd = rec.ival; break;
+			}
+			ctx.push_back (c);
+		}
+		pos = reader.Tell();
+	}
+	return pos >= 0;
+}
+
+// =======================================================================
+
+static bool FRFileStamp (const char *fname, __int64 &size, __int64 &time)
+{
+	std::error_code ec;
+	size = (__int64)std::filesystem::file_size (fname, ec);
+	if (ec) return false;
+	time = (__int64)std::filesystem::last_write_time (fname, ec).time_since_epoch().count();
+	return !ec;
+}
+
+// =======================================================================
+
+bool FRTrack::LoadIndex (const char *fname, const char *idxname)
+{
+	__int64 size, time;
+	if (!FRFileStamp (fname, size, time)) return false;
+	FILE *f = fopen (idxname, "rb");
+	if (!f) return false;
+
+	FRIndexHeader hdr;
+	bool ok = (fread (&hdr, sizeof(FRIndexHeader), 1, f) == 1 &&
+		!memcmp (hdr.magic, FRIndexMagic, 8) && hdr.srcsize == size && hdr.srctime == time &&
+		hdr.npage == (hdr.nsample + PageSize-1)/PageSize && hdr.nctx > 0);
+	if (ok) {
+		page.resize (hdr.npage);
+		ctx.resize (hdr.nctx);
+		ok = (fread (page.data(), sizeof(Page), page.size(), f) == page.size() &&
+			fread (ctx.data(), sizeof(Context), ctx.size(), f) == ctx.size());
+	}
+	fclose (f);
+	if (ok) {
+		nsample = hdr.nsample;
+		tend = hdr.tend;
+		startmjd = hdr.startmjd;
+	} else {
+		page.clear();
+		ctx.clear();
+	}
+	return ok;
+}
+
+// =======================================================================
+
+void FRTrack::SaveIndex (const char *fname, const char *idxname) const
+{
+	FRIndexHeader hdr;
+	if (!FRFileStamp (fname, hdr.srcsize, hdr.srctime)) return;
+	FILE *f = fopen (idxname, "wb");
+	if (!f) return;
+	memcpy (hdr.magic, FRIndexMagic, 8);
+	hdr.nsample = nsample;
+	hdr.npage = (INT32)page.size();
+	hdr.nctx = (INT32)ctx.size();
+	hdr.pad = 0;
+	hdr.tend = tend;
+	hdr.startmjd = startmjd;
+	bool ok = (fwrite (&hdr, sizeof(FRIndexHeader), 1, f) == 1 &&
+		fwrite (page.data(), sizeof(Page), page.size(), f) == page.size() &&
+		fwrite (ctx.data(), sizeof(Context), ctx.size(), f) == ctx.size());
+	fclose (f);
+	if (!ok) remove (idxname);
+}
+
+// =======================================================================
+
+const std::vector<FRTrack::Sample> &FRTrack::LoadPage (int p)
+{
+	int i, lru = 0;
+	for (i = 0; i < NCachePage; i++) {
+		if (cache[i].page == p) {
+			cache[i].lastuse = ++tick;
+			return cache[i].s;
+		}
+		if (cache[i].page < 0 || (cache[lru].page >= 0 && cache[i].lastuse < cache[lru].lastuse))
+			lru = i;
+	}
+
+	CachePage &cp = cache[lru];
+	cp.page = p;
+	cp.lastuse = ++tick;
+	cp.s.clear();
+	int n = min ((int)PageSize, nsample - p*PageSize);
+	int c = page[p].ctx;
+	FRStreamRecord rec;
+	reader.Seek (page[p].pos);
+	while ((int)cp.s.size() < n && reader.Next (rec)) {
+		if (rec.tag == FRTAG_SAMPLE) {
+			Sample s;
+			s.t = rec.t;
+			memcpy (s.v, rec.v, 6*sizeof(double));
+			s.ctx = c;
+			cp.s.push_back (s);
+		} else if (c+1 < (int)ctx.size()) {
+			c++;
+		}
+	}
+	return cp.s;
+}
+
+// =======================================================================
+
+bool FRTrack::Get (int i, Sample &s)
+{
+	if (i < 0 || i >= nsample) return false;
+	const std::vector<Sample> &pg = LoadPage (i / PageSize);
+	if (i % PageSize >= (int)pg.size()) return false; // stream modified since indexing
+	s = pg[i % PageSize];
+	return true;
+}
+
+// =======================================================================
+
+int FRTrack::Locate (double t)
+{
+	if (nsample < 2) return 0;
+
+	// regular playback: a few steps forward from the last result
+	Sample s;
+	int i = cur;
+	if (i == 0 || (Get (i, s) && s.t < t)) {
+		for (int k = 0; k < 8; k++) {
+			if (i+2 >= nsample || (Get (i+1, s) && s.t >= t))
+				return cur = i;
+			i++;
+		}
+	}
+
+	// binary search over the pages, then within the page
+	int p0 = 0, p1 = (int)page.size();    // first page with t0 >= t is in [p0,p1]
+	while (p0 < p1) {
+		int pm = (p0+p1)/2;
+		if (page[pm].t0 < t) p0 = pm+1;
+		else p1 = pm;
+	}
+	if (!p0) return cur = 0;              // t before the first sample
+	const std::vector<Sample> &pg = LoadPage (p0-1);
+	int j0 = 0, j1 = (int)pg.size();      // first sample with t >= t in [j0,j1]
+	while (j0 < j1) {
+		int jm = (j0+j1)/2;
+		if (pg[jm].t < t) j0 = jm+1;
+		else j1 = jm;
+	}
+	i = (p0-1)*PageSize + j0-1;
+	return cur = max (0, min (i, nsample-2));
+}
+
+// =======================================================================
+// Conversion functions
+// =======================================================================
+
+int FRFormatRecord (const FRStreamRecord &rec, int type, char *buf, size_t len)
+{
+	int n = 0;
+	switch (rec.tag) {
+	case FRTAG_SAMPLE:
+		if (type == FRSTREAM_POS)
+			n = snprintf (buf, len, "%.10g %.12g %.12g %.12g %.10g %.10g %.10g\n",
+				rec.t, rec.v[0], rec.v[1], rec.v[2], rec.v[3], rec.v[4], rec.v[5]);
+		else
+			n = snprintf (buf, len, "%.10g %.6g %.6g %.6g\n", rec.t, rec.v[0], rec.v[1], rec.v[2]);
+		break;
+	case FRTAG_STARTMJD:
+		n = snprintf (buf, len, "STARTMJD %.12g\n", rec.t);
+		break;
+	case FRTAG_REF:
+		n = snprintf (buf, len, "REF %.47s\n", rec.name);
+		break;
+	case FRTAG_FRM:
+		n = snprintf (buf, len, "FRM %s\n", rec.ival == 0 ? "ECLIPTIC" : type == FRSTREAM_POS ? "EQUATORIAL" : "HORIZON");
+		break;
+	case FRTAG_CRD:
+		n = snprintf (buf, len, "CRD %s\n", rec.ival == 0 ? "CARTESIAN" : "POLAR");
+		break;
+	}
+	if (n < 0) n = 0;
+	else if ((size_t)n >= len) n = (int)len-1;
+	return n;
+}
+
+// =======================================================================
+
+bool FRStreamConvert (const char *fname, int type, bool binary)
+{
+	FRStreamReader reader;
+	if (!reader.Open (fname, type)) return false;
+	if (reader.IsBinary() == binary) return true; // nothing to do
+
+	std::vector<FRStreamRecord> rec;
+	FRStreamRecord r;
+	while (reader.Next (r))
+		rec.push_back (r);
+	reader.Close();
+
+	FRStream stream;
+	if (!stream.Open (fname, type, false, binary)) return false;
+	for (auto &r : rec)
+		stream.Put (r);
+	stream.Close();
+	return true;
+}
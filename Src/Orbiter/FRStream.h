@@ -0,0 +1,258 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// FRStream.h
+// Flight recorder output streams. Each stream keeps its file open for the
+// duration of the recording and passes its data in blocks to a background
+// writer thread, so that recording doesn't block the simulation thread on
+// file access. Position and attitude streams can be written either as
+// text or as fixed-size binary records; FRStreamReader reads both, and
+// FRTrack provides indexed random access to them for playback.
+// =======================================================================
+
+#ifndef __FRSTREAM_H
+#define __FRSTREAM_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Stream types
+#define FRSTREAM_POS  0   // position/velocity samples (*.pos)
+#define FRSTREAM_ATT  1   // attitude samples (*.att)
+#define FRSTREAM_TEXT 2   // free-format text (articulation and system events)
+
+// Record tags
+#define FRTAG_SAMPLE   0  // data sample
+#define FRTAG_STARTMJD 1  // STARTMJD directive
+#define FRTAG_REF      2  // REF directive
+#define FRTAG_FRM      3  // FRM directive
+#define FRTAG_CRD      4  // CRD directive
+
+// =======================================================================
+// A single record of a position or attitude stream. This is also the
+// on-disk record layout of binary streams.
+
+struct FRStreamRecord {
+	INT32 tag;           // record type (FRTAG_xxx)
+	INT32 ival;          // FRM: 0=ecliptic, 1=equatorial (pos) or horizon (att); CRD: 0=cartesian, 1=polar
+	double t;            // SAMPLE: time since recording start [s]; STARTMJD: start date [MJD]
+	union {
+		double v[6];     // SAMPLE: position and velocity (pos), or Euler angles in v[0..2] (att)
+		char name[48];   // REF: reference body name
+	};
+};
+
+class FRStream;
+
+// =======================================================================
+// Process-wide background writer. Data blocks submitted by the streams
+// are queued in a ring buffer and written in order of submission. The
+// writer thread also passes on data held by streams that have been idle
+// for more than the flush interval.
+
+class FRWriter {
+public:
+	enum { BlockSize = 16384, NBlock = 64 };
+
+	static std::shared_ptr<FRWriter> Acquire ();
+	// Return the shared writer instance, creating it if required. The
+	// writer thread terminates when the last stream releases it.
+
+	FRWriter ();
+	~FRWriter ();
+
+	UINT64 Submit (FILE *f, const char *data, size_t size);
+	// Queue data for writing to f. Blocks while the ring buffer is full.
+	// Returns the sequence number of the last queued block.
+
+	void Sync (UINT64 seq);
+	// Wait until all blocks up to sequence number seq have been written.
+
+	void Register (FRStream *s);
+	void Unregister (FRStream *s);
+	// Add/remove a stream to/from the streams flushed by the writer thread
+
+private:
+	struct Block {
+		FILE *f;
+		size_t size;
+		char data[BlockSize];
+	};
+	void WriteLoop ();
+	void FlushStreams ();
+
+	std::vector<Block> ring;
+	std::vector<FRStream*> streams; // open streams
+	UINT64 nsubmit;      // number of submitted blocks
+	UINT64 nwritten;     // number of written blocks
+	std::mutex mtx;
+	std::condition_variable submitted; // signalled when a block is submitted
+	std::condition_variable written;   // signalled when a block has been written
+	std::thread worker;
+	bool bRun;
+};
+
+// =======================================================================
+
+class FRStream {
+	friend class FRWriter;
+
+public:
+	FRStream ();
+	~FRStream ();
+
+	bool Open (const char *fname, int type, bool append = false, bool binary = false);
+	// Open a recorder stream of type FRSTREAM_xxx. Only position and
+	// attitude streams can be binary. When appending to an existing file,
+	// the format of the file is retained.
+
+	void Close ();
+	// Write all pending data and close the file.
+
+	inline bool IsOpen () const { return f != NULL; }
+	inline bool IsBinary () const { return binary; }
+
+	void Put (const FRStreamRecord &rec);
+	// Write a position or attitude record.
+
+	void Printf (const char *fmt, ...);
+	// Write formatted text to a text stream.
+
+	void Flush ();
+	// Pass buffered data to the writer.
+
+private:
+	void Write (const char *data, size_t size);
+	void FlushStage ();  // Flush with stagemtx locked
+
+	std::shared_ptr<FRWriter> writer;
+	FILE *f;
+	int type;
+	bool binary;
+	std::mutex stagemtx; // guards the staged data against the writer thread
+	char stage[FRWriter::BlockSize]; // data not yet passed to the writer
+	size_t nstage;
+	UINT64 seq;          // sequence number of the last submitted block
+	std::chrono::steady_clock::time_point tflush; // time of the last flush
+};
+
+// =======================================================================
+// Sequential reader for text or binary position and attitude streams.
+
+class FRStreamReader {
+public:
+	FRStreamReader ();
+	~FRStreamReader ();
+
+	bool Open (const char *fname, int type);
+	// Open a position or attitude stream. The file format is detected
+	// automatically.
+
+	void Close ();
+
+	inline bool IsBinary () const { return binary; }
+
+	bool Next (FRStreamRecord &rec);
+	// Read the next record. Returns false at the end of the stream.
+	// Unrecognised text lines are skipped.
+
+	__int64 Tell () const;
+	bool Seek (__int64 pos);
+	// Get/set the stream position. Only positions returned by Tell are valid.
+
+private:
+	FILE *f;
+	int type;
+	bool binary;
+};
+
+// =======================================================================
+// Indexed playback access to a position or attitude stream. Samples are
+// grouped into pages, and only a page index and a few decoded pages are
+// kept in memory, so resident memory doesn't grow with the length of the
+// recording. The index is stored in <stream>.idx and reused as long as
+// the stream file is unchanged.
+
+class FRTrack {
+public:
+	enum { PageSize = 256, NCachePage = 4 };
+
+	struct Context {     // directive state in effect for a sample
+		char ref[48];    // reference body name (empty: not defined)
+		INT32 frm;       // FRM directive value
+		INT32 crd;       // CRD directive value
+	};
+	struct Sample {
+		double t;        // sample time [s]
+		double v[6];     // sample data (see FRStreamRecord)
+		int ctx;         // index into the context list
+	};
+
+	FRTrack ();
+	~FRTrack ();
+
+	bool Open (const char *fname, int type, bool useindex = true);
+	// Open a position or attitude stream for playback. If useindex is true,
+	// a stored index is used if valid, and a new index is stored otherwise.
+
+	void Close ();
+
+	inline int nSample () const { return nsample; }
+	inline double TEnd () const { return tend; }
+	inline double StartMJD () const { return startmjd; }
+	inline const std::vector<Context> &Contexts () const { return ctx; }
+
+	bool Get (int i, Sample &s);
+	// Return sample i (0 <= i < nSample()).
+
+	int Locate (double t);
+	// Return the index i of the interpolation interval [i,i+1] for time t,
+	// i.e. the last sample before t, clamped to [0,nSample()-2]. Forward
+	// steps from the previous result are fast; other times are found by
+	// binary search.
+
+private:
+	struct Page {
+		double t0;       // time of the first sample
+		__int64 pos;     // stream position of the first sample
+		INT32 ctx;       // context of the first sample
+		INT32 pad;
+	};
+	struct CachePage {
+		int page;        // page index (-1: unused)
+		UINT64 lastuse;  // access tick for LRU replacement
+		std::vector<Sample> s;
+	};
+
+	bool BuildIndex ();
+	bool LoadIndex (const char *fname, const char *idxname);
+	void SaveIndex (const char *fname, const char *idxname) const;
+	const std::vector<Sample> &LoadPage (int p);
+
+	FRStreamReader reader;
+	std::vector<Page> page;
+	std::vector<Context> ctx;
+	CachePage cache[NCachePage];
+	int nsample;         // number of samples
+	double tend;         // time of the last sample
+	double startmjd;     // value of the last STARTMJD directive
+	int cur;             // result of the last Locate call
+	UINT64 tick;
+};
+
+int FRFormatRecord (const FRStreamRecord &rec, int type, char *buf, size_t len);
+// Format a record as a line of the text format of stream type 'type'.
+// Returns the string length.
+
+bool FRStreamConvert (const char *fname, int type, bool binary);
+// Rewrite a position or attitude stream in text or binary format.
+// Returns false if the file can't be read or written.
+
+#endif // !__FRSTREAM_H
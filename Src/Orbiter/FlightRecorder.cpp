@@ -16,6 +16,8 @@
 #include "State.h"
 #include "MenuInfoBar.h"
 #include "DlgMgr.h"
+#include "FRStream.h"
+#include "Profiler.h"
 #include <fstream>
 #include <string>
 #include <filesystem>
@@ -57,6 +59,7 @@ Vessel *vfocus = NULL;  // focus vessel as defined by playback stream
 // ================================================================
 
 void Euler2Quaternion (double *a, Quaternion &q, int frm);
+static void FRPutDirective (FRStream *stream, int tag, int ival, double t = 0.0, const char *name = 0);
 
 
 // ================================================================
@@ -71,13 +74,10 @@ void Vessel::FRecorder_Reset ()
 	//frec_last.frm = 0;  // ecliptic frame by default
 	frec_last.crd = 0;  // cartesian coordinates by default
 	frec_last.ref = 0;
-	frec = 0;
-	nfrec = 0;
-	frec_att = 0;
+	FRpos_track = FRatt_track = 0;
 	frec_att_last.simt = frec_att_last_syst = -1e10;
 	frec_att_last.frm = g_pOrbiter->Cfg()->CfgRecPlayPrm.RecordAttFrame;
 	frec_att_last.ref = 0;
-	nfrec_att = 0;
 	nfrec_eng = 0;
 	frec_eng_simt = -1e10;
 	FRfname = 0;
@@ -87,6 +87,7 @@ void Vessel::FRecorder_Reset ()
 	WarpDelay = 0.0;
 	vfocus = NULL;
 	FRatc_stream = 0;
+	FRpos_ostream = FRatt_ostream = FRatc_ostream = 0;
 }
 
 void Vessel::FRecorder_Activate (bool active, const char *fname, bool append)
@@ -104,14 +105,40 @@ void Vessel::FRecorder_Activate (bool active, const char *fname, bool append)
 		MJDofs = td.MJD0;
 		//frec_last.frm = 1;  // for now, record in equatorial frame by default
 		frec_last.crd = 1;  // for now, record in polar coordinates by default
+
+		// open the record streams; a new recording overwrites existing files
+		bool binary = g_pOrbiter->Cfg()->CfgRecPlayPrm.bRecordBinary;
+		bool fappend = (frec_last.fstatus != FLIGHTSTATUS_UNDEFINED);
+		FRpos_ostream = new FRStream; TRACENEW
+		FRatt_ostream = new FRStream; TRACENEW
+		FRatc_ostream = new FRStream; TRACENEW
+		bool ok = FRpos_ostream->Open (FRfname, FRSTREAM_POS, fappend, binary);
+		strcpy (cbuf+strlen(cbuf)-3, "att");
+		ok = FRatt_ostream->Open (cbuf, FRSTREAM_ATT, fappend, binary) && ok;
+		strcpy (cbuf+strlen(cbuf)-3, "atc");
+		ok = FRatc_ostream->Open (cbuf, FRSTREAM_TEXT, fappend) && ok;
+		if (!ok)
+			LOGOUT_WARN("Flight recorder: could not open record streams for %s", name.c_str());
 	} else {
 		bFRrecord = false;
 		FRecorder_Save (true);
+		FRecorder_CloseStreams ();
 	}
 }
 
+void Vessel::FRecorder_CloseStreams ()
+{
+	FRStream **stream[3] = {&FRpos_ostream, &FRatt_ostream, &FRatc_ostream};
+	for (int i = 0; i < 3; i++)
+		if (*stream[i]) {
+			delete *stream[i];
+			*stream[i] = 0;
+		}
+}
+
 void Vessel::FRecorder_Save (bool force)
 {
+	PROFILE_ZONE("Flight recorder");
 	int i, iter = 0, niter = 1;
 	DWORD j;
 	double dt, alim;
@@ -157,31 +184,36 @@ void Vessel::FRecorder_Save (bool force)
 				}
 				frec_last.rvel    = vel;
 
-				ofstream ofs (FRfname, ios::app);
-				ofs << setprecision(10)  << (frec_last.simt-Tofs) << ' ';
+				FRStreamRecord rec;
+				rec.tag = FRTAG_SAMPLE;
+				rec.ival = 0;
+				rec.t = frec_last.simt-Tofs;
 				if (frec_last.crd == 1) { // store in polar coords
 					double r = frec_last.rpos.length();
 					double phi = atan2 (frec_last.rpos.z, frec_last.rpos.x);
 					double tht = asin (frec_last.rpos.y/r);
-					ofs << setprecision(12) << r << ' ' << phi << ' ' << tht << ' ';
 					double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
 					double arg  = cphi*frec_last.rvel.x + sphi*frec_last.rvel.z;
-					double vr   = stht*frec_last.rvel.y + ctht*arg;
-					double vphi = (cphi*frec_last.rvel.z - sphi*frec_last.rvel.x) / (r*ctht);
-					double vtht = (ctht*frec_last.rvel.y - stht*arg)/r;
-					ofs << setprecision(10) << vr << ' ' << vphi << ' ' << vtht << endl;
+					rec.v[0] = r;
+					rec.v[1] = phi;
+					rec.v[2] = tht;
+					rec.v[3] = stht*frec_last.rvel.y + ctht*arg;                         // vr
+					rec.v[4] = (cphi*frec_last.rvel.z - sphi*frec_last.rvel.x) / (r*ctht); // vphi
+					rec.v[5] = (ctht*frec_last.rvel.y - stht*arg)/r;                     // vtht
 				} else {
-					ofs << setprecision(12) << frec_last.rpos.x << ' ' << frec_last.rpos.y << ' ' << frec_last.rpos.z << ' ';
-					ofs << setprecision(10) << frec_last.rvel.x << ' ' << frec_last.rvel.y << ' ' << frec_last.rvel.z << endl;
+					for (i = 0; i < 3; i++) {
+						rec.v[i]   = frec_last.rpos.data[i];
+						rec.v[i+3] = frec_last.rvel.data[i];
+					}
 				}
+				FRpos_ostream->Put (rec);
 			}
 		}
 		if (cbody != ref) {
-			ofstream ofs(FRfname, isfirst ? ios::trunc : ios::app);
-			ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
-			ofs << "REF " << cbody->Name() << endl;
-			ofs << "FRM " << (frec_last.frm == 0 ? "ECLIPTIC" : "EQUATORIAL") << endl;
-			ofs << "CRD " << (frec_last.crd == 0 ? "CARTESIAN" : "POLAR") << endl;
+			FRPutDirective (FRpos_ostream, FRTAG_STARTMJD, 0, MJDofs);
+			FRPutDirective (FRpos_ostream, FRTAG_REF, 0, 0.0, cbody->Name());
+			FRPutDirective (FRpos_ostream, FRTAG_FRM, frec_last.frm);
+			FRPutDirective (FRpos_ostream, FRTAG_CRD, frec_last.crd);
 			frec_last.ref = ref = cbody;
 		}
 	} 
@@ -235,13 +267,15 @@ void Vessel::FRecorder_Save (bool force)
 				if (diff > alim) attforce = true;
 			}
 			if (attforce) {
-				char cbuf[256];
-				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
-				ofstream ofs (cbuf, ios::app);
-				ofs << setprecision(10) << (td.SimT1-Tofs) << setprecision(6);
+				FRStreamRecord rec;
+				rec.tag = FRTAG_SAMPLE;
+				rec.ival = 0;
+				rec.t = td.SimT1-Tofs;
 				for (i = 0; i < 3; i++)
-					ofs << ' ' << (/*frec_att_last.att[i] =*/ a[i]);
-				ofs << endl;
+					rec.v[i] = (/*frec_att_last.att[i] =*/ a[i]);
+				for (; i < 6; i++)
+					rec.v[i] = 0.0;
+				FRatt_ostream->Put (rec);
 				frec_att_last.q.Set (q);
 				frec_att_last_syst = td.SysT1;
 				frec_att_last.simt = td.SimT1;
@@ -249,18 +283,15 @@ void Vessel::FRecorder_Save (bool force)
 		
 		}
 		if (ref != sp.ref) {
-			char cbuf[256];
-			strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
-			ofstream ofs (cbuf, isfirst ? ios::trunc : ios::app);
 			if (isfirst)
-				ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
+				FRPutDirective (FRatt_ostream, FRTAG_STARTMJD, 0, MJDofs);
 			switch (frec_att_last.frm) {
 			case 0:
-				ofs << "FRM ECLIPTIC" << endl;
+				FRPutDirective (FRatt_ostream, FRTAG_FRM, 0);
 				break;
 			case 1:
-				ofs << "REF " << sp.ref->Name() << endl;
-				ofs << "FRM HORIZON" << endl;
+				FRPutDirective (FRatt_ostream, FRTAG_REF, 0, 0.0, sp.ref->Name());
+				FRPutDirective (FRatt_ostream, FRTAG_FRM, 1);
 				break;
 			}
 			frec_att_last.ref = ref = sp.ref;
@@ -283,34 +314,25 @@ void Vessel::FRecorder_Save (bool force)
 	bool bfopen = false;
 	dt = td.SimT1-frec_eng_simt;
 	alim = min (0.2, 0.1/dt);
-	ofstream ofs;
 	for (j = 0; j < m_thruster.size(); j++) {
 		if (fabs(frec_eng[j]-m_thruster[j]->level) > alim || force) {
 			if (!bfopen) {
 				frec_eng_simt = td.SimT1;
-				char cbuf[256];
-				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
-				ofs.open (cbuf, isfirst ? ios::trunc : ios::app);
-				ofs << setprecision(10) << (frec_eng_simt-Tofs) << " ENG";
+				FRatc_ostream->Printf ("%.10g ENG", frec_eng_simt-Tofs);
 				bfopen = true;
 			}
-			ofs << ' ' << j << ':' << setprecision(2) << (frec_eng[j] = m_thruster[j]->level);
+			FRatc_ostream->Printf (" %d:%.2g", j, (frec_eng[j] = m_thruster[j]->level));
 		}
 	}
-	if (bfopen) {
-		ofs << endl;
-		ofs.close();
-	}
+	if (bfopen)
+		FRatc_ostream->Printf ("\n");
 }
 
 // Save a vessel-specific event
 void Vessel::FRecorder_SaveEvent (const char *event_type, const char *event)
 {
-	if (!bFRrecord) return;
-	char cbuf[256];
-	strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
-	ofstream ofs(cbuf, ios::app);
-	ofs << setprecision(10) << (td.SimT1-Tofs) << ' ' << event_type << ' ' << event << endl;
+	if (!bFRrecord || !FRatc_ostream) return;
+	FRatc_ostream->Printf ("%.10g %s %s\n", td.SimT1-Tofs, event_type, event);
 }
 
 void Vessel::FRecorder_SaveEventInt (const char *event_type, int event)
@@ -327,16 +349,7 @@ void Vessel::FRecorder_SaveEventFloat (const char *event_type, double event)
 
 void Vessel::FRecorder_Clear ()
 {
-	if (nfrec) {
-		delete []frec;
-		frec = NULL;
-		nfrec = 0;
-	}
-	if (nfrec_att) {
-		delete []frec_att;
-		frec_att = NULL;
-		nfrec_att = 0;
-	}
+	FRecorder_CloseTracks ();
 	if (nfrec_eng) {
 		delete []frec_eng;
 		frec_eng = NULL;
@@ -350,6 +363,7 @@ void Vessel::FRecorder_Clear ()
 		delete FRatc_stream;
 		FRatc_stream = 0;
 	}
+	FRecorder_CloseStreams ();
 	bFRplayback = false;
 	bFRrecord = false;
 }
@@ -363,103 +377,26 @@ bool Vessel::FRecorder_Read (const char *scname)
 		if (scname[i-1] == '\\') break;
 	sprintf (fname, "Flights/%s/%s.pos", scname+i, name.c_str());
 
-	ifstream ifs (fname);
-	if (!ifs) {
+	// position and attitude streams may be in text or binary format;
+	// samples are paged in on demand during playback
+	FRTrack *track = new FRTrack; TRACENEW
+	if (!track->Open (fname, FRSTREAM_POS) || track->nSample() < 2) {
+		delete track;
 		bFRplayback = false;
 		return false;
 	}
 
 	FRecorder_Clear();
-	
-	int nbuf = 0, nbuf_att = 0, frm = 0, crd = 0, attfrm = 0;
-	double simt, x, y, z, vx, vy, vz;
-	const CelestialBody *ref = g_psys->GetGravObj(0);
-
-	// open position/velocity stream
-	while (ifs.getline (cbuf, 256)) {
-		if (!_strnicmp (cbuf, "REF", 3)) {
-			ref = g_psys->GetGravObj (trim_string (cbuf+4), true);
-			if (!ref) ref = g_psys->GetGravObj (0);
-		} else if (!_strnicmp (cbuf, "FRM", 3)) {
-			if (!_stricmp (trim_string (cbuf+4), "EQUATORIAL")) frm = 1;
-			else frm = 0;
-		} else if (!_strnicmp (cbuf, "CRD", 3)) {
-			if (!_stricmp (trim_string (cbuf+4), "POLAR")) crd = 1;
-			else crd = 0;
-		} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
-			sscanf (cbuf+9, "%lf", &MJDofs);
-		} else {
-			if (sscanf (cbuf, "%lf%lf%lf%lf%lf%lf%lf", &simt, &x, &y, &z, &vx, &vy, &vz) != 7)
-				continue;
-			if (crd == 1) { // map from polar coords
-				double xz, r = x, phi = y, tht = z;
-				double vr = vx, vphi = vy, vtht = vz;
-				double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
-				y = r*sin(tht); xz = r*cos(tht);
-				x = xz*cos(phi); z = xz*sin(phi);
-				vx = vr*cphi*ctht - r*vphi*sphi*ctht - r*vtht*cphi*stht;
-				vy = vr*stht + r*vtht*ctht;
-				vz = vr*sphi*ctht + r*vphi*cphi*ctht - r*vtht*sphi*stht;
-				//vy = vr*sin(vtht); xz = vr*cos(vtht);
-				//vx = xz*cos(vphi); vz = xz*sin(vphi);
-			}
-			if (nfrec == nbuf) { // re-allocate
-				FRecord *tmp = new FRecord[nbuf += 1024]; TRACENEW
-				if (nfrec) {
-					memcpy (tmp, frec, nfrec*sizeof(FRecord));
-					delete []frec;
-				}
-				frec = tmp;
-			}
-			frec[nfrec].simt = simt;
-			frec[nfrec].frm  = frm;
-			frec[nfrec].ref  = ref;
-			frec[nfrec].rpos.Set (x, y, z);
-			frec[nfrec].rvel.Set (vx, vy, vz);
-			nfrec++;
-		}
-	}
-	ifs.close();
-	ifs.clear();
-	cfrec = 0;
-	cfrec_att = 0;
+	FRpos_track = track;
+	FRecorder_MapContexts (FRpos_track, FRpos_ref);
+	if (FRpos_track->StartMJD()) MJDofs = FRpos_track->StartMJD();
 
-	// open attitude stream
-	ref = g_psys->GetGravObj(0);
 	strcpy (fname+strlen(fname)-3, "att");
-	ifs.open (fname);
-	while (ifs.getline (cbuf, 256)) {
-		if (!_strnicmp (cbuf, "REF", 3)) {
-			ref = g_psys->GetGravObj (trim_string (cbuf+4), true);
-			if (!ref) ref = g_psys->GetGravObj (0);
-		} else if (!_strnicmp (cbuf, "FRM", 3)) {
-			if (!_stricmp (trim_string (cbuf+4), "HORIZON")) attfrm = 1;
-			else attfrm = 0;
-		} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
-			sscanf (cbuf+9, "%lf", &MJDofs);
-			// assumes that MJDofs from all streams are the same!
-		} else {
-			double a[3];
-			sscanf (cbuf, "%lf%lf%lf%lf", &simt, a+0, a+1, a+2);
-			if (nfrec_att == nbuf_att) { // re-allocate
-				FRecord_att *tmp = new FRecord_att[nbuf_att += 1024]; TRACENEW
-				if (nfrec_att) {
-					memcpy (tmp, frec_att, nfrec_att*sizeof(FRecord_att));
-					delete []frec_att;
-				}
-				frec_att = tmp;
-			}
-			frec_att[nfrec_att].simt = simt;
-			frec_att[nfrec_att].frm = attfrm;
-			frec_att[nfrec_att].ref = ref;
-
-			// convert Euler angles to quaternions
-			Euler2Quaternion (a, frec_att[nfrec_att].q, frec_att[nfrec_att].frm);
-			//for (int i = 0; i < 3; i++)
-			//	frec_att[nfrec_att].att[i] = a[i];
-
-			nfrec_att++;
-		}
+	FRatt_track = new FRTrack; TRACENEW
+	if (FRatt_track->Open (fname, FRSTREAM_ATT)) {
+		FRecorder_MapContexts (FRatt_track, FRatt_ref);
+		if (FRatt_track->StartMJD()) MJDofs = FRatt_track->StartMJD();
+		// assumes that MJDofs from all streams are the same!
 	}
 
 	// open articulation event stream
@@ -476,8 +413,57 @@ bool Vessel::FRecorder_Read (const char *scname)
 	return true;
 }
 
+void Vessel::FRecorder_MapContexts (const FRTrack *track, std::vector<const CelestialBody*> &ref)
+{
+	const std::vector<FRTrack::Context> &ctx = track->Contexts();
+	ref.resize (ctx.size());
+	for (size_t i = 0; i < ctx.size(); i++) {
+		ref[i] = (ctx[i].ref[0] ? g_psys->GetGravObj (ctx[i].ref, true) : 0);
+		if (!ref[i]) ref[i] = g_psys->GetGravObj (0);
+	}
+}
+
+void Vessel::FRecorder_GetPosSample (int i, FRecord &rec)
+{
+	FRTrack::Sample smp;
+	if (!FRpos_track->Get (i, smp))
+		memset (&smp, 0, sizeof(FRTrack::Sample));
+	const FRTrack::Context &ctx = FRpos_track->Contexts()[smp.ctx];
+	double x = smp.v[0], y = smp.v[1], z = smp.v[2];
+	double vx = smp.v[3], vy = smp.v[4], vz = smp.v[5];
+	if (ctx.crd == 1) { // map from polar coords
+		double xz, r = x, phi = y, tht = z;
+		double vr = vx, vphi = vy, vtht = vz;
+		double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
+		y = r*sin(tht); xz = r*cos(tht);
+		x = xz*cos(phi); z = xz*sin(phi);
+		vx = vr*cphi*ctht - r*vphi*sphi*ctht - r*vtht*cphi*stht;
+		vy = vr*stht + r*vtht*ctht;
+		vz = vr*sphi*ctht + r*vphi*cphi*ctht - r*vtht*sphi*stht;
+	}
+	rec.simt = smp.t;
+	rec.frm  = ctx.frm;
+	rec.crd  = 0;
+	rec.ref  = FRpos_ref[smp.ctx];
+	rec.rpos.Set (x, y, z);
+	rec.rvel.Set (vx, vy, vz);
+}
+
+void Vessel::FRecorder_GetAttSample (int i, FRecord_att &rec)
+{
+	FRTrack::Sample smp;
+	if (!FRatt_track->Get (i, smp))
+		memset (&smp, 0, sizeof(FRTrack::Sample));
+	rec.simt = smp.t;
+	rec.frm  = FRatt_track->Contexts()[smp.ctx].frm;
+	rec.ref  = FRatt_ref[smp.ctx];
+	// convert Euler angles to quaternions
+	Euler2Quaternion (smp.v, rec.q, rec.frm);
+}
+
 void Vessel::FRecorder_Play ()
 {
+	PROFILE_ZONE("Flight recorder");
 	dCHECK(s1, "Update state not available.")
 	StateVectors *sv = s1;
 
@@ -488,40 +474,43 @@ void Vessel::FRecorder_Play ()
 		int i;
 		static Vector s;
 
-		while (cfrec+2 < nfrec && frec[cfrec+1].simt < td.SimT1) cfrec++;
-		dT = frec[cfrec+1].simt - frec[cfrec].simt;
-		dt = td.SimT1 - frec[cfrec].simt;
+		FRecord rec0, rec1;
+		int k = FRpos_track->Locate (td.SimT1);
+		FRecorder_GetPosSample (k, rec0);
+		FRecorder_GetPosSample (k+1, rec1);
+		dT = rec1.simt - rec0.simt;
+		dt = td.SimT1 - rec0.simt;
 
-		Vector P0 = frec[cfrec].rpos, P1 = frec[cfrec+1].rpos;
-		Vector V0 = frec[cfrec].rvel, V1 = frec[cfrec+1].rvel;
-		if (frec[cfrec].frm == 1) { // map from equatorial frame
+		Vector P0 = rec0.rpos, P1 = rec1.rpos;
+		Vector V0 = rec0.rvel, V1 = rec1.rvel;
+		if (rec0.frm == 1) { // map from equatorial frame
 			// propagate from current rotation state to rotation state at last sample
-			double dlng = Pi2*dt/frec[cfrec].ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
+			double dlng = Pi2*dt/rec0.ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
 			s.x =  P0.x*cosd + P0.z*sind;
 			s.z = -P0.x*sind + P0.z*cosd;
 			s.y =  P0.y;
-			P0.Set (mul (frec[cfrec].ref->s1->R, s));
+			P0.Set (mul (rec0.ref->s1->R, s));
 
 			// Needs to be fixed!
-			frec[cfrec].ref->LocalToEquatorial (s, lng, lat, rad);
-			vref = Pi2/frec[cfrec].ref->RotT() * rad * cos(lat);
+			rec0.ref->LocalToEquatorial (s, lng, lat, rad);
+			vref = Pi2/rec0.ref->RotT() * rad * cos(lat);
 			s.x =  V0.x*cosd + V0.z*sind;
 			s.z = -V0.x*sind + V0.z*cosd;
 			s.y =  V0.y;
-			V0.Set (mul (frec[cfrec].ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
+			V0.Set (mul (rec0.ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
 		}
-		if (frec[cfrec+1].frm == 1) { // map from equatorial frame
-			double dlng = Pi2*(dt-dT)/frec[cfrec+1].ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
+		if (rec1.frm == 1) { // map from equatorial frame
+			double dlng = Pi2*(dt-dT)/rec1.ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
 			s.x =  P1.x*cosd + P1.z*sind;
 			s.z = -P1.x*sind + P1.z*cosd;
 			s.y =  P1.y;
-			P1.Set (mul (frec[cfrec+1].ref->s1->R, s));
-			frec[cfrec+1].ref->LocalToEquatorial (s, lng, lat, rad);
-			vref = Pi2/frec[cfrec+1].ref->RotT() * rad * cos(lat);
+			P1.Set (mul (rec1.ref->s1->R, s));
+			rec1.ref->LocalToEquatorial (s, lng, lat, rad);
+			vref = Pi2/rec1.ref->RotT() * rad * cos(lat);
 			s.x =  V1.x*cosd + V1.z*sind;
 			s.z = -V1.x*sind + V1.z*cosd;
 			s.y =  V1.y;
-			V1.Set (mul (frec[cfrec].ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
+			V1.Set (mul (rec0.ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
 		}
 
 		for (i = 0; i < 3; i++) {
@@ -533,39 +522,42 @@ void Vessel::FRecorder_Play ()
 			sv->pos.data[i] = r0 + v0*dt + 0.5*a0*dt*dt + b*dt*dt*dt/6.0;
 		}
 
-		sv->pos += frec[cfrec].ref->s1->pos;
-		sv->vel += frec[cfrec].ref->s1->vel;
+		sv->pos += rec0.ref->s1->pos;
+		sv->vel += rec0.ref->s1->vel;
 	
 		// attitude
-		if (td.SimT1 < frec_att[nfrec_att-1].simt) {
+		if (FRatt_track->nSample() >= 2 && td.SimT1 < FRatt_track->TEnd()) {
 
 			// store old orientation for calculating angular velocities
 			Vector r1 (sv->R.m11, sv->R.m21, sv->R.m31);
 			Vector r2 (sv->R.m12, sv->R.m22, sv->R.m32);
 			Vector r3 (sv->R.m13, sv->R.m23, sv->R.m33);
 
-			while (cfrec_att+2 < nfrec_att && frec_att[cfrec_att+1].simt < td.SimT1) cfrec_att++;
-			dt = frec_att[cfrec_att+1].simt - frec_att[cfrec_att].simt;
-			w1 = (td.SimT1-frec_att[cfrec_att].simt)/dt;
+			FRecord_att att0, att1;
+			k = FRatt_track->Locate (td.SimT1);
+			FRecorder_GetAttSample (k, att0);
+			FRecorder_GetAttSample (k+1, att1);
+			dt = att1.simt - att0.simt;
+			w1 = (td.SimT1-att0.simt)/dt;
 			w0 = 1.0-w1;
 
 			// Orientation at intermediate time point by interpolating endpoint quaternions
-			if (frec_att[cfrec_att].frm == 0) {
+			if (att0.frm == 0) {
 				Quaternion Q;
-				Q.interp (frec_att[cfrec_att].q, frec_att[cfrec_att+1].q, w1);
+				Q.interp (att0.q, att1.q, w1);
 				sv->SetRot (Q);
 			} else {
 				Quaternion Q;
-				Q.interp (frec_att[cfrec_att].q, frec_att[cfrec_att+1].q, w1);
+				Q.interp (att0.q, att1.q, w1);
 				sv->R.Set (Q);
 				double lng, lat, rad, slng, clng, slat, clat;
-				Vector loc = tmul (frec_att[cfrec_att].ref->s1->R, sv->pos - frec_att[cfrec_att].ref->s1->pos);
-				frec_att[cfrec_att].ref->LocalToEquatorial (loc, lng, lat, rad);
+				Vector loc = tmul (att0.ref->s1->R, sv->pos - att0.ref->s1->pos);
+				att0.ref->LocalToEquatorial (loc, lng, lat, rad);
 				slng = sin(lng), clng = cos(lng), slat = sin(lat), clat = cos(lat);
 				sv->R.postmul (Matrix (-slng,      0,     clng,
 					                    clat*clng, slat,  clat*slng,
 									   -slat*clng, clat, -slat*slng));
-				sv->R.tpostmul (frec_att[cfrec_att].ref->s1->R);
+				sv->R.tpostmul (att0.ref->s1->R);
 				//rrot.postmul (sp.Local2Hor());
 				//rrot.tpostmul (cbody->GRot());
 				sv->SetRot (transp (sv->R));
@@ -734,7 +726,7 @@ void Vessel::FRecorder_PlayEvent ()
 
 void Vessel::FRecorder_CheckEnd ()
 {
-	if (td.SimT1 > frec[nfrec-1].simt) { // reached end of playback list
+	if (FRpos_track && td.SimT1 > FRpos_track->TEnd()) { // reached end of playback list
 		g_pOrbiter->EndPlayback();
 		//FRecorder_EndPlayback();
 		//g_pOrbiter->SNote()->ClearNote();
@@ -756,7 +748,22 @@ void Vessel::FRecorder_EndPlayback ()
 		s0->Q.Set (s0->R);
 		if (supervessel && supervessel->GetVessel(0) == this)
 			supervessel->FRecorder_EndPlayback();
+		FRecorder_CloseTracks ();
+	}
+}
+
+void Vessel::FRecorder_CloseTracks ()
+{
+	if (FRpos_track) {
+		delete FRpos_track;
+		FRpos_track = 0;
 	}
+	if (FRatt_track) {
+		delete FRatt_track;
+		FRatt_track = 0;
+	}
+	FRpos_ref.clear();
+	FRatt_ref.clear();
 }
 
 // ================================================================
@@ -768,6 +775,7 @@ void Orbiter::FRecorder_Reset ()
 {
 	FRsysname = 0;
 	FRsys_stream = 0;
+	FRsys_ostream = 0;
 	FReditor = 0;
 	frec_sys_simt = -1e10;
 	bRecord = bPlayback = false;
@@ -800,17 +808,42 @@ void Orbiter::FRecorder_Activate (bool active, const char *fname, bool append)
 		if (FRsysname) delete []FRsysname;
 		FRsysname = new char[strlen(cbuf)+1]; TRACENEW
 		strcpy (FRsysname, cbuf);
+		if (!FRsys_ostream) {
+			FRsys_ostream = new FRStream; TRACENEW
+		}
+		if (!FRsys_ostream->Open (FRsysname, FRSTREAM_TEXT, true))
+			LOGOUT_WARN("Flight recorder: could not open %s", FRsysname);
 	} else {
 		bRecord = false;
+		if (FRsys_ostream) {
+			delete FRsys_ostream;
+			FRsys_ostream = 0;
+		}
 	}
 }
 
 // Save a system event
 void Orbiter::FRecorder_SaveEvent (const char *event_type, const char *event)
 {
-	if (!bRecord) return;
-	ofstream ofs(FRsysname, ios::app);
-	ofs << setprecision(10) << (td.SimT1-Tofs) << ' ' << event_type << ' ' << event << endl;
+	if (!bRecord || !FRsys_ostream) return;
+	FRsys_ostream->Printf ("%.10g %s %s\n", td.SimT1-Tofs, event_type, event);
+}
+
+// Convert the position and attitude streams of a recording
+void Orbiter::FRecorder_Convert (const char *fname, bool binary)
+{
+	fs::path dir = fs::path("Flights") / fname;
+	std::error_code ec;
+	int nconv = 0, nfail = 0;
+	for (auto &entry : fs::directory_iterator (dir, ec)) {
+		std::string ext = entry.path().extension().string();
+		int type = (!_stricmp (ext.c_str(), ".pos") ? FRSTREAM_POS : !_stricmp (ext.c_str(), ".att") ? FRSTREAM_ATT : -1);
+		if (type < 0) continue;
+		if (FRStreamConvert (entry.path().string().c_str(), type, binary)) nconv++;
+		else nfail++;
+	}
+	if (ec) LOGOUT_WARN("Flight recorder: recording not found: %s", dir.string().c_str());
+	else LOGOUT("Flight recorder: %d streams of %s converted to %s format (%d failed)", nconv, fname, binary ? "binary" : "text", nfail);
 }
 
 void Orbiter::FRecorder_OpenPlayback (const char *scname)
@@ -943,6 +976,18 @@ void Orbiter::FRecorder_ToggleEditor ()
 // ================================================================
 // helper functions
 
+// write a format directive to a position or attitude stream
+static void FRPutDirective (FRStream *stream, int tag, int ival, double t, const char *name)
+{
+	FRStreamRecord rec;
+	memset (&rec, 0, sizeof(FRStreamRecord));
+	rec.tag = tag;
+	rec.ival = ival;
+	rec.t = t;
+	if (name) strncpy (rec.name, name, 47);
+	stream->Put (rec);
+}
+
 // convert Euler angles from given reference frame to quaternion
 void Euler2Quaternion (double *a, Quaternion &q, int frm)
 {
@@ -0,0 +1,372 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// GravityKernel.cpp
+// Point-mass gravity summation over a snapshot of the gravity sources
+// =======================================================================
+
+#include "GravityKernel.h"
+#include <math.h>
+#include <atomic>
+
+// Keep the scalar and vectorised kernels rounding identically
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GRAVITY_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define GRAVITY_AVX2_FUNC
+#else
+#define GRAVITY_AVX2_FUNC __attribute__((target("avx2")))
+#endif
+#endif
+
+typedef void (*SUMFUNC)(const double*, const double*, const double*, const double*, int, const double*, double*);
+typedef void (*SUMNFUNC)(const double*, const double*, const double*, const double*, int,
+	const double*, const double*, const double*, int, double*, double*, double*);
+
+// =======================================================================
+
+void GravitySum_Scalar (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *q, double *acc)
+{
+	double dx, dy, dz, r2, f;
+	acc[0] = acc[1] = acc[2] = 0.0;
+	for (int i = 0; i < n; i++) {
+		dx = sx[i] - q[0];
+		dy = sy[i] - q[1];
+		dz = sz[i] - q[2];
+		r2 = dx*dx + dy*dy + dz*dz;
+		if (r2 > 0.0) {
+			f = gm[i] / (r2*sqrt(r2));
+			acc[0] += dx*f;
+			acc[1] += dy*f;
+			acc[2] += dz*f;
+		}
+	}
+}
+
+// =======================================================================
+
+void GravitySumN_Scalar (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *qx, const double *qy, const double *qz, int nq, double *ax, double *ay, double *az)
+{
+	double q[3], acc[3];
+	for (int k = 0; k < nq; k++) {
+		q[0] = qx[k], q[1] = qy[k], q[2] = qz[k];
+		GravitySum_Scalar (gm, sx, sy, sz, n, q, acc);
+		ax[k] = acc[0], ay[k] = acc[1], az[k] = acc[2];
+	}
+}
+
+#ifdef GRAVITY_AVX2
+
+// =======================================================================
+// Four sources per instruction
+
+GRAVITY_AVX2_FUNC static void GravitySum_AVX2 (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *q, double *acc)
+{
+	__m256d qx = _mm256_set1_pd (q[0]);
+	__m256d qy = _mm256_set1_pd (q[1]);
+	__m256d qz = _mm256_set1_pd (q[2]);
+	__m256d zero = _mm256_setzero_pd();
+	__m256d vax = zero, vay = zero, vaz = zero;
+	int i;
+
+	for (i = 0; i+4 <= n; i += 4) {
+		__m256d dx = _mm256_sub_pd (_mm256_loadu_pd (sx+i), qx);
+		__m256d dy = _mm256_sub_pd (_mm256_loadu_pd (sy+i), qy);
+		__m256d dz = _mm256_sub_pd (_mm256_loadu_pd (sz+i), qz);
+		__m256d r2 = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)), _mm256_mul_pd (dz, dz));
+		__m256d f  = _mm256_div_pd (_mm256_loadu_pd (gm+i), _mm256_mul_pd (r2, _mm256_sqrt_pd (r2)));
+		f = _mm256_and_pd (f, _mm256_cmp_pd (r2, zero, _CMP_GT_OQ)); // skip sources at the query point
+		vax = _mm256_add_pd (vax, _mm256_mul_pd (dx, f));
+		vay = _mm256_add_pd (vay, _mm256_mul_pd (dy, f));
+		vaz = _mm256_add_pd (vaz, _mm256_mul_pd (dz, f));
+	}
+
+	double buf[4];
+	_mm256_storeu_pd (buf, vax);
+	acc[0] = (buf[0] + buf[1]) + (buf[2] + buf[3]);
+	_mm256_storeu_pd (buf, vay);
+	acc[1] = (buf[0] + buf[1]) + (buf[2] + buf[3]);
+	_mm256_storeu_pd (buf, vaz);
+	acc[2] = (buf[0] + buf[1]) + (buf[2] + buf[3]);
+
+	if (i < n) { // remaining sources
+		double acc_r[3];
+		GravitySum_Scalar (gm+i, sx+i, sy+i, sz+i, n-i, q, acc_r);
+		acc[0] += acc_r[0];
+		acc[1] += acc_r[1];
+		acc[2] += acc_r[2];
+	}
+}
+
+// =======================================================================
+// Four query points per instruction. The sources are summed in the same
+// order as in the scalar version, so the results are identical.
+
+GRAVITY_AVX2_FUNC static void GravitySumN_AVX2 (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *qx, const double *qy, const double *qz, int nq, double *ax, double *ay, double *az)
+{
+	__m256d zero = _mm256_setzero_pd();
+	int i, k;
+
+	for (k = 0; k+4 <= nq; k += 4) {
+		__m256d vqx = _mm256_loadu_pd (qx+k);
+		__m256d vqy = _mm256_loadu_pd (qy+k);
+		__m256d vqz = _mm256_loadu_pd (qz+k);
+		__m256d vax = zero, vay = zero, vaz = zero;
+		for (i = 0; i < n; i++) {
+			__m256d dx = _mm256_sub_pd (_mm256_set1_pd (sx[i]), vqx);
+			__m256d dy = _mm256_sub_pd (_mm256_set1_pd (sy[i]), vqy);
+			__m256d dz = _mm256_sub_pd (_mm256_set1_pd (sz[i]), vqz);
+			__m256d r2 = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)), _mm256_mul_pd (dz, dz));
+			__m256d f  = _mm256_div_pd (_mm256_set1_pd (gm[i]), _mm256_mul_pd (r2, _mm256_sqrt_pd (r2)));
+			f = _mm256_and_pd (f, _mm256_cmp_pd (r2, zero, _CMP_GT_OQ));
+			vax = _mm256_add_pd (vax, _mm256_mul_pd (dx, f));
+			vay = _mm256_add_pd (vay, _mm256_mul_pd (dy, f));
+			vaz = _mm256_add_pd (vaz, _mm256_mul_pd (dz, f));
+		}
+		_mm256_storeu_pd (ax+k, vax);
+		_mm256_storeu_pd (ay+k, vay);
+		_mm256_storeu_pd (az+k, vaz);
+	}
+
+	if (k < nq) // remaining query points
+		GravitySumN_Scalar (gm, sx, sy, sz, n, qx+k, qy+k, qz+k, nq-k, ax+k, ay+k, az+k);
+}
+
+// =======================================================================
+
+static bool CpuHasAVX2 ()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid (info, 0);
+	if (info[0] < 7) return false;
+	__cpuid (info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave) return false;
+	if ((_xgetbv (0) & 6) != 6) return false; // OS saves YMM registers
+	__cpuidex (info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init ();
+	return __builtin_cpu_supports ("avx2");
+#endif
+}
+
+#endif // GRAVITY_AVX2
+
+// =======================================================================
+
+static SUMFUNC SelectSumFunc ()
+{
+#ifdef GRAVITY_AVX2
+	if (CpuHasAVX2()) return GravitySum_AVX2;
+#endif
+	return GravitySum_Scalar;
+}
+
+static SUMNFUNC SelectSumNFunc ()
+{
+#ifdef GRAVITY_AVX2
+	if (CpuHasAVX2()) return GravitySumN_AVX2;
+#endif
+	return GravitySumN_Scalar;
+}
+
+static SUMFUNC SumFunc ()
+{
+	static const SUMFUNC func = SelectSumFunc();
+	return func;
+}
+
+static SUMNFUNC SumNFunc ()
+{
+	static const SUMNFUNC func = SelectSumNFunc();
+	return func;
+}
+
+void GravitySum (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *q, double *acc)
+{
+	SumFunc() (gm, sx, sy, sz, n, q, acc);
+}
+
+void GravitySumN (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *qx, const double *qy, const double *qz, int nq, double *ax, double *ay, double *az)
+{
+	SumNFunc() (gm, sx, sy, sz, n, qx, qy, qz, nq, ax, ay, az);
+}
+
+bool GravitySumVectorised ()
+{
+	return SumFunc() != GravitySum_Scalar;
+}
+
+// =======================================================================
+// class GravitySources
+
+static std::atomic<unsigned long long> g_version(0); // source of snapshot version stamps
+
+GravitySources::GravitySources ()
+{
+	nsrc = 0;
+	ninterp = 0;
+	version = ++g_version;
+}
+
+// =======================================================================
+
+void GravitySources::Resize (int n)
+{
+	int j;
+	nsrc = n;
+	ninterp = 0;
+	gm.assign (n, 0.0);
+	for (j = 0; j < 3; j++) {
+		p0[j].assign (n, 0.0);
+		p1[j].assign (n, 0.0);
+	}
+	for (j = 0; j < 9; j++)
+		c[j].assign (n, 0.0);
+	interp.assign (n, 0);
+	nonsph.assign (n, 0);
+	nonsphidx.clear();
+	version = ++g_version;
+}
+
+// =======================================================================
+
+void GravitySources::SetSource (int i, double _gm, const double *p, bool nonspherical)
+{
+	gm[i] = _gm;
+	for (int j = 0; j < 3; j++)
+		p0[j][i] = p1[j][i] = p[j];
+	if (interp[i]) {
+		interp[i] = 0;
+		ninterp--;
+	}
+	if (nonsph[i] != (char)nonspherical) { // rebuild the list
+		nonsph[i] = (char)nonspherical;
+		nonsphidx.clear();
+		for (int k = 0; k < nsrc; k++)
+			if (nonsph[k]) nonsphidx.push_back (k);
+	}
+	version = ++g_version;
+}
+
+// =======================================================================
+
+void GravitySources::SetTrajectory (int i, const double *p, const double *coeff)
+{
+	int j;
+	for (j = 0; j < 3; j++)
+		p1[j][i] = p[j];
+	if (coeff) {
+		for (j = 0; j < 9; j++)
+			c[j][i] = coeff[j];
+		if (!interp[i]) {
+			interp[i] = 1;
+			ninterp++;
+		}
+	} else if (interp[i]) {
+		interp[i] = 0;
+		ninterp--;
+	}
+	version = ++g_version;
+}
+
+// =======================================================================
+
+void GravitySources::Position (int i, double n, double *p) const
+{
+	for (int j = 0; j < 3; j++) {
+		if      (n == 0.0) p[j] = p0[j][i];
+		else if (n == 1.0) p[j] = p1[j][i];
+		else p[j] = p0[j][i] + (c[j][i] + (c[3+j][i] + c[6+j][i]*n)*n)*n;
+	}
+}
+
+// =======================================================================
+
+void GravitySources::Positions (double n, const double *p[3]) const
+{
+	int i, j;
+	if (n == 0.0 || n == 1.0) {
+		const std::vector<double> *ps = (n == 0.0 ? p0 : p1);
+		for (j = 0; j < 3; j++)
+			p[j] = ps[j].data();
+		return;
+	}
+
+	// The integrator stages of all vessels query the same few step
+	// fractions, so the interpolated positions of the last one are kept
+	static thread_local struct {
+		unsigned long long version = 0;
+		double n = 0.0;
+		std::vector<double> p[3];
+	} cache;
+	if (cache.version != version || cache.n != n) {
+		for (j = 0; j < 3; j++) {
+			cache.p[j].resize (nsrc);
+			double *pj = cache.p[j].data();
+			const double *p0j = p0[j].data(), *c0 = c[j].data(), *c1 = c[3+j].data(), *c2 = c[6+j].data();
+			for (i = 0; i < nsrc; i++)
+				pj[i] = p0j[i] + (c0[i] + (c1[i] + c2[i]*n)*n)*n;
+		}
+		cache.version = version;
+		cache.n = n;
+	}
+	for (j = 0; j < 3; j++)
+		p[j] = cache.p[j].data();
+}
+
+// =======================================================================
+
+void GravitySources::Acc (double n, const double *q, int exclude, double *acc) const
+{
+	const double *p[3];
+	Positions (n, p);
+	if (exclude < 0 || exclude >= nsrc) {
+		GravitySum (gm.data(), p[0], p[1], p[2], nsrc, q, acc);
+	} else { // sum the ranges before and after the excluded source
+		int i1 = exclude+1;
+		double a[3];
+		GravitySum (gm.data(), p[0], p[1], p[2], exclude, q, acc);
+		GravitySum (gm.data()+i1, p[0]+i1, p[1]+i1, p[2]+i1, nsrc-i1, q, a);
+		acc[0] += a[0], acc[1] += a[1], acc[2] += a[2];
+	}
+}
+
+// =======================================================================
+
+void GravitySources::AccN (double n, const double *qx, const double *qy, const double *qz, int nq,
+	int exclude, double *ax, double *ay, double *az) const
+{
+	const double *p[3];
+	Positions (n, p);
+	if (exclude < 0 || exclude >= nsrc) {
+		GravitySumN (gm.data(), p[0], p[1], p[2], nsrc, qx, qy, qz, nq, ax, ay, az);
+	} else {
+		int i1 = exclude+1;
+		static thread_local std::vector<double> buf;
+		buf.resize (3*nq);
+		double *bx = buf.data(), *by = bx+nq, *bz = by+nq;
+		GravitySumN (gm.data(), p[0], p[1], p[2], exclude, qx, qy, qz, nq, ax, ay, az);
+		GravitySumN (gm.data()+i1, p[0]+i1, p[1]+i1, p[2]+i1, nsrc-i1, qx, qy, qz, nq, bx, by, bz);
+		for (int k = 0; k < nq; k++) {
+			ax[k] += bx[k];
+			ay[k] += by[k];
+			az[k] += bz[k];
+		}
+	}
+}
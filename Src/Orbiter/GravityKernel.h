@@ -0,0 +1,135 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// GravityKernel.h
+// Point-mass gravity of the celestial bodies, evaluated from a
+// structure-of-arrays snapshot of their gravitational parameters and
+// positions. The planetary system refreshes the snapshot once per time
+// step, so that the gravity summation for vessels doesn't have to visit
+// the celestial body objects. The summation kernels process four sources
+// (single query point) or four query points (batch queries) per
+// instruction.
+// Nonspherical perturbations are not part of the snapshot; they are
+// added by the caller for the sources flagged as nonspherical.
+// =======================================================================
+
+#ifndef __GRAVITYKERNEL_H
+#define __GRAVITYKERNEL_H
+
+#include <vector>
+
+// Sum the point-mass accelerations of n sources with gravitational
+// parameters gm [m^3/s^2] at positions (sx,sy,sz) at query point q, and
+// return the result in acc. Sources at the query point are skipped.
+// Uses an AVX2 kernel if supported by the CPU, otherwise the scalar version.
+void GravitySum (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *q, double *acc);
+
+// Sum the point-mass accelerations of n sources for nq query points
+// (qx,qy,qz), and return the results in (ax,ay,az).
+void GravitySumN (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *qx, const double *qy, const double *qz, int nq, double *ax, double *ay, double *az);
+
+// Scalar reference implementations
+void GravitySum_Scalar (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *q, double *acc);
+void GravitySumN_Scalar (const double *gm, const double *sx, const double *sy, const double *sz, int n,
+	const double *qx, const double *qy, const double *qz, int nq, double *ax, double *ay, double *az);
+
+// Returns true if the summation uses the vectorised kernels on this CPU
+bool GravitySumVectorised ();
+
+// =======================================================================
+// Snapshot of the gravity sources
+
+class GravitySources {
+public:
+	GravitySources ();
+
+	void Resize (int n);
+	// Set the number of sources. Source parameters must be set with
+	// SetSource before the snapshot is used.
+
+	inline int Size () const { return nsrc; }
+
+	void SetSource (int i, double gm, const double *p0, bool nonspherical);
+	// Set gravitational parameter gm [m^3/s^2] and position p0 [m] at the
+	// start of the current step for source i. Invalidates the trajectory
+	// interpolant of the source.
+
+	void SetTrajectory (int i, const double *p1, const double *c);
+	// Set the position p1 at the end of the step, and the coefficients
+	// c[3*k+j] of the n^(k+1) terms (k=0..2) of the cubic interpolant of
+	// axis j of the position over the step. c = NULL if the source has no
+	// cubic interpolant.
+
+	inline bool Interpolated () const { return ninterp == nsrc; }
+	// True if all sources have a cubic trajectory interpolant
+
+	inline bool Nonspherical (int i) const { return nonsph[i] != 0; }
+	inline const std::vector<int> &NonsphericalList () const { return nonsphidx; }
+	// Sources flagged as nonspherical
+
+	void Position (int i, double n, double *p) const;
+	// Position of source i at fractional step time n. For 0 < n < 1 the
+	// source must be interpolated.
+
+	void Acc (double n, const double *q, int exclude, double *acc) const;
+	// Point-mass acceleration at query point q at fractional step time n
+	// from all sources except source index exclude (-1: none).
+
+	template<typename IDX>
+	void Acc (double n, const double *q, const IDX *idx, int nidx, int exclude, double *acc) const;
+	// As above, for the sources in list idx only
+
+	void AccN (double n, const double *qx, const double *qy, const double *qz, int nq,
+		int exclude, double *ax, double *ay, double *az) const;
+	// Point-mass accelerations at nq query points from all sources except
+	// source index exclude (-1: none).
+
+private:
+	void Positions (double n, const double *p[3]) const;
+	// Position arrays of all sources at fractional step time n. Interpolated
+	// positions are cached per thread for the most recent n.
+
+	unsigned long long version;       // snapshot version, changed by each modification
+	int nsrc;                         // number of sources
+	int ninterp;                      // number of sources with cubic interpolant
+	std::vector<double> gm;           // gravitational parameters
+	std::vector<double> p0[3], p1[3]; // positions at start/end of step
+	std::vector<double> c[9];         // interpolant coefficients c[3*k+j] (n^(k+1) term of axis j)
+	std::vector<char> interp;         // source has a cubic interpolant
+	std::vector<char> nonsph;         // source is flagged as nonspherical
+	std::vector<int> nonsphidx;       // list of nonspherical sources
+};
+
+// =======================================================================
+
+template<typename IDX>
+void GravitySources::Acc (double n, const double *q, const IDX *idx, int nidx, int exclude, double *acc) const
+{
+	const int MAXBUF = 64;
+	double gmbuf[MAXBUF], xbuf[MAXBUF], ybuf[MAXBUF], zbuf[MAXBUF];
+	const double *p[3];
+	double a[3];
+	int i, j, k = 0;
+	Positions (n, p);
+	acc[0] = acc[1] = acc[2] = 0.0;
+	for (j = 0; j < nidx; j++) {
+		if ((i = (int)idx[j]) == exclude) continue;
+		gmbuf[k] = gm[i];
+		xbuf[k] = p[0][i], ybuf[k] = p[1][i], zbuf[k] = p[2][i];
+		if (++k == MAXBUF) {
+			GravitySum (gmbuf, xbuf, ybuf, zbuf, k, q, a);
+			acc[0] += a[0], acc[1] += a[1], acc[2] += a[2];
+			k = 0;
+		}
+	}
+	if (k) {
+		GravitySum (gmbuf, xbuf, ybuf, zbuf, k, q, a);
+		acc[0] += a[0], acc[1] += a[1], acc[2] += a[2];
+	}
+}
+
+#endif // !__GRAVITYKERNEL_H
@@ -91,7 +91,8 @@ bool DInput::CreateJoyDevice ()
 
 void DInput::DestroyDevices ()
 {
-	diframe->DestroyDevices();
+	if (diframe) // not created in batch runs
+		diframe->DestroyDevices();
 }
 
 void DInput::OptionChanged(DWORD cat, DWORD item)
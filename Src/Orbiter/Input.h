@@ -27,8 +27,8 @@ public:
 	void DestroyDevices ();
 
 	inline CDIFramework7 *GetDIFrame() const { return diframe; }
-	inline const LPDIRECTINPUTDEVICE8 GetKbdDevice() const { return diframe->GetKbdDevice(); }
-	inline const LPDIRECTINPUTDEVICE8 GetJoyDevice() const { return diframe->GetJoyDevice(); }
+	inline const LPDIRECTINPUTDEVICE8 GetKbdDevice() const { return diframe ? diframe->GetKbdDevice() : NULL; }
+	inline const LPDIRECTINPUTDEVICE8 GetJoyDevice() const { return diframe ? diframe->GetJoyDevice() : NULL; }
 
 	void OptionChanged(DWORD cat, DWORD item);
 
@@ -3,6 +3,7 @@
 
 #include "Keymap.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include <fstream>
 
 #define NKEY 95
@@ -243,7 +244,7 @@ void Keymap::Write (const char *fname)
 bool Keymap::Read (const char *fname)
 {
 	char cbuf[256];
-	ifstream ifs (fname, ios::in);
+	CfgFile ifs (fname);
 	if (!ifs) return false;
 	for (int i = 0; i < LKEY_COUNT; i++) {
 		//func[i] = 0;
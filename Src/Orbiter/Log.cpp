@@ -15,7 +15,7 @@ using namespace std;
 extern char DBG_MSG[256];
 extern TimeData td;
 
-static char logname[256] = "Orbiter.log";
+static char logname[1024] = "Orbiter.log";
 static char logs[256] = "";
 static bool finelog = false;
 static DWORD t0 = 0;
@@ -24,7 +24,8 @@ static LogOutFunc logOut = 0;
 
 void InitLog (const char *logfile, bool append)
 {
-	strcpy (logname, logfile);
+	strncpy (logname, logfile, sizeof(logname)-1);
+	logname[sizeof(logname)-1] = '\0';
 	ofstream ofs (logname, append ? ios::app : ios::out);
 	ofs << "**** " << logname << endl;
 	t0 = timeGetTime();
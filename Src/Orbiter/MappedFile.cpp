@@ -0,0 +1,68 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// MappedFile.cpp
+// Read-only memory-mapped file
+// =======================================================================
+
+#include "MappedFile.h"
+
+MappedFile::MappedFile ()
+{
+	hFile = INVALID_HANDLE_VALUE;
+	hMap = NULL;
+	data = 0;
+	size = 0;
+}
+
+// =======================================================================
+
+MappedFile::~MappedFile ()
+{
+	Close ();
+}
+
+// =======================================================================
+
+bool MappedFile::Open (const char *fname)
+{
+	Close ();
+
+	hFile = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx (hFile, &fsize) || !fsize.QuadPart) {
+		Close ();
+		return false;
+	}
+	size = (size_t)fsize.QuadPart;
+
+	hMap = CreateFileMappingA (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMap) data = (const BYTE*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		Close ();
+		return false;
+	}
+	return true;
+}
+
+// =======================================================================
+
+void MappedFile::Close ()
+{
+	if (data) {
+		UnmapViewOfFile (data);
+		data = 0;
+	}
+	if (hMap) {
+		CloseHandle (hMap);
+		hMap = NULL;
+	}
+	if (hFile != INVALID_HANDLE_VALUE) {
+		CloseHandle (hFile);
+		hFile = INVALID_HANDLE_VALUE;
+	}
+	size = 0;
+}
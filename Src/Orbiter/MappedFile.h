@@ -0,0 +1,36 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// MappedFile.h
+// Read-only memory-mapped file
+// =======================================================================
+
+#ifndef __MAPPEDFILE_H
+#define __MAPPEDFILE_H
+
+#include <windows.h>
+
+class MappedFile {
+public:
+	MappedFile ();
+	~MappedFile ();
+
+	bool Open (const char *fname);
+	// Map the complete file into memory. Returns false if the file
+	// doesn't exist, is empty, or can't be mapped.
+
+	void Close ();
+
+	inline bool IsOpen () const { return data != 0; }
+	inline const BYTE *Data () const { return data; }
+	inline size_t Size () const { return size; }
+
+private:
+	HANDLE hFile;
+	HANDLE hMap;
+	const BYTE *data;
+	size_t size;
+};
+
+#endif // !__MAPPEDFILE_H
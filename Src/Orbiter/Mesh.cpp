@@ -2,7 +2,9 @@
 // Licensed under the MIT License
 
 #include "Mesh.h"
+#include "MeshBin.h"
 #include <stdio.h>
+#include <fstream>
 #include "D3dmath.h"
 #include "Orbiter.h"
 #include "Log.h"
@@ -1056,14 +1058,96 @@ ostream &operator<< (ostream &os, const Mesh &mesh)
 	return os;
 }
 
+bool Mesh::LoadBinary (const char *fname, const char *srcname)
+{
+	MeshBinReader mbr;
+	if (!mbr.Open (fname, srcname)) return false;
+	static_assert (sizeof(D3DMATERIAL7) == sizeof(MeshBinMaterial), "material layout");
+	DWORD i;
+
+	Clear();
+	for (i = 0; i < mbr.nGroup(); i++)
+		AddGroup (mbr.Group (i), mbr.Vtx (i), mbr.Idx (i));
+	for (i = 0; i < mbr.nMaterial(); i++) {
+		D3DMATERIAL7 mtrl;
+		memcpy (&mtrl, &mbr.Material (i), sizeof(D3DMATERIAL7));
+		AddMaterial (mtrl);
+	}
+	LoadTextures (mbr.nTexture() ? &mbr.Texture (0) : 0, mbr.nTexture());
+	Setup();
+	return true;
+}
+
+void Mesh::Set (const MeshBinData &data)
+{
+	Clear();
+	for (auto &grp : data.grp)
+		AddGroup (grp.spec, grp.vtx.data(), grp.idx.data());
+	for (auto &m : data.mtrl) {
+		D3DMATERIAL7 mtrl;
+		memcpy (&mtrl, &m, sizeof(D3DMATERIAL7));
+		AddMaterial (mtrl);
+	}
+	LoadTextures (data.tex.data(), (DWORD)data.tex.size());
+	Setup();
+}
+
+int Mesh::AddGroup (const MeshBinGroup &gs, const MeshBinVertex *bvtx, const UINT16 *bidx)
+{
+	static_assert (sizeof(NTVERTEX) == sizeof(MeshBinVertex), "vertex layout");
+	NTVERTEX *vtx = new NTVERTEX[gs.nvtx]; TRACENEW
+	memcpy (vtx, bvtx, gs.nvtx*sizeof(NTVERTEX));
+	WORD *idx = new WORD[gs.nidx]; TRACENEW
+	memcpy (idx, bidx, gs.nidx*sizeof(WORD));
+	int grp = AddGroup (vtx, gs.nvtx, idx, gs.nidx, gs.mtrl, gs.tex, gs.zbias);
+	Grp[grp].Flags = gs.flags;
+	Grp[grp].UsrFlag = gs.usrflag;
+	if (gs.opts & MESHBIN_CALCNORMALS) CalcNormals (grp, true);
+	if (gs.flags & 0x04) MakeGroupVertexBuffer (grp);
+	return grp;
+}
+
+void Mesh::LoadTextures (const MeshBinTexture *tex, DWORD ntex)
+{
+	ReleaseTextures ();
+	if (!ntex) return;
+	Tex = new SURFHANDLE[nTex = ntex]; TRACENEW
+	for (DWORD i = 0; i < nTex; i++) {
+		Tex[i] = 0;
+		if (tex[i].name[0] != '0' || tex[i].name[1] != '\0') {
+			bool uncompress = (tex[i].flags & MESHBIN_TEX_UNCOMPRESS) != 0;
+			if (g_pOrbiter->GetGraphicsClient())
+				Tex[i] = g_pOrbiter->GetGraphicsClient()->clbkLoadTexture (tex[i].name, 8 | (uncompress ? 2:0));
+		}
+	}
+}
+
 bool Mesh::bEnableSpecular = false;
 
+// =======================================================================
+// Read a mesh from its binary version if available and up to date, or
+// from the text mesh otherwise. Meshes required by a scenario may have
+// been decoded by the scenario preloader already.
+
+static bool ReadMesh (const char *meshname, Mesh &mesh)
+{
+	std::string path(g_pOrbiter->MeshPath (meshname));
+	ScenarioPreload::MeshRef data = g_pOrbiter->preload.Mesh (path.c_str());
+	if (data) { // decoded by the scenario preloader
+		mesh.Set (*data);
+		return true;
+	}
+	if (mesh.LoadBinary ((path + 'b').c_str(), path.c_str())) return true;
+	ifstream ifs (path, ios::in);
+	ifs >> mesh;
+	return ifs.good();
+}
+
 // =======================================================================
 // Class MeshManager
 
 MeshManager::MeshManager()
 {
-	nmlist = nmlistbuf = 0;
 }
 
 MeshManager::~MeshManager()
@@ -1073,28 +1157,23 @@ MeshManager::~MeshManager()
 
 void MeshManager::Flush()
 {
-	for (int i = 0; i < nmlist; i++)
-		delete mlist[i].mesh;
-	if (nmlistbuf) {
-		delete []mlist;
-		nmlist = nmlistbuf = 0;
-	}
+	for (auto &it : mlist)
+		delete it.second;
+	mlist.clear();
 }
 
 const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 {
-	int i;
-	DWORDLONG crc = Str2Crc (fname);
-	for (i = 0; i < nmlist; i++) {
-		if (crc == mlist[i].crc && !_strnicmp (fname, mlist[i].fname, 32)) {
-			if (firstload) *firstload = false;
-			return mlist[i].mesh; // found it
-		}
+	std::string key(fname);
+	for (auto &c : key) c = (char)tolower ((unsigned char)c);
+	auto it = mlist.find (key);
+	if (it != mlist.end()) {
+		if (firstload) *firstload = false;
+		return it->second; // found it
 	}
 	// not found, so load from file
-	ifstream ifs (g_pOrbiter->MeshPath (fname), ios::in);
 	Mesh *mesh = new Mesh; TRACENEW
-	ifs >> *mesh;
+	ReadMesh (fname, *mesh);
 	if (!mesh->nGroup()) { // load error
 		if (!fname[0]) LOGOUT_ERR ("Mesh file name not provided");
 		else LOGOUT_ERR ("Mesh not found: %s", g_pOrbiter->MeshPath (fname));
@@ -1102,20 +1181,8 @@ const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 		delete mesh;
 		return 0;
 	}
-	if (nmlist == nmlistbuf) { // need to allocate buffer
-		MeshBuffer *tmp = new MeshBuffer[nmlistbuf += 32]; TRACENEW
-		if (nmlist) {
-			memcpy (tmp, mlist, nmlist*sizeof(MeshBuffer));
-			delete []mlist;
-			mlist = NULL;
-		}
-		mlist = tmp;
-	}
 	mesh->SetName(fname);
-	mlist[nmlist].mesh = mesh;
-	mlist[nmlist].crc  = crc;
-	strncpy (mlist[nmlist].fname, fname, 32);
-	nmlist++;
+	mlist.emplace (key, mesh);
 	if (firstload) *firstload = true;
 	return mesh;
 }
@@ -1125,9 +1192,7 @@ const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 
 bool LoadMesh (const char *meshname, Mesh &mesh)
 {
-	ifstream ifs (g_pOrbiter->MeshPath (meshname), ios::in);
-	ifs >> mesh;
-	if (ifs.good()) {
+	if (ReadMesh (meshname, mesh)) {
 		mesh.SetName(meshname);
 		return true;
 	} else {
@@ -13,8 +13,15 @@
 #include <d3d.h>
 #include <d3dtypes.h>
 #include <iostream>
+#include <string>
+#include <unordered_map>
 #include "OrbiterAPI.h"
 
+struct MeshBinGroup;
+struct MeshBinVertex;
+struct MeshBinTexture;
+struct MeshBinData;
+
 typedef char Str256[256];
 
 const DWORD SPEC_DEFAULT = (DWORD)(-1); // "default" material/texture flag
@@ -207,6 +214,15 @@ public:
 	friend std::istream &operator>> (std::istream &is, Mesh &mesh);
 	// read mesh from file
 
+	bool LoadBinary (const char *fname, const char *srcname = 0);
+	// read mesh from binary mesh file fname (see MeshBin.h). If srcname is
+	// provided, the file is rejected unless the size and modification time
+	// of text mesh srcname match those recorded at conversion.
+	// Returns false if the file doesn't exist or can't be used.
+
+	void Set (const MeshBinData &data);
+	// set up the mesh from a decoded text mesh (see MeshBin.h)
+
 	friend std::ostream &operator<< (std::ostream &os, const Mesh &mesh);
 	// write mesh to file
 
@@ -214,6 +230,12 @@ protected:
 	void ReleaseTextures ();
 	// Release textures acquired by the mesh
 
+	int AddGroup (const MeshBinGroup &grp, const MeshBinVertex *vtx, const UINT16 *idx);
+	// Add a group from binary mesh data
+
+	void LoadTextures (const MeshBinTexture *tex, DWORD ntex);
+	// Replace the texture list by the textures of binary mesh data
+
 private:
 	DWORD nGrp;         // number of groups
 	GroupSpec *Grp;     // list of group specs	
@@ -255,12 +277,7 @@ public:
 	// file, and false if the mesh was in memory already
 
 private:
-	struct MeshBuffer {
-		Mesh *mesh;
-		DWORDLONG crc;
-		char fname[32];
-	} *mlist;
-	int nmlist, nmlistbuf;
+	std::unordered_map<std::string, Mesh*> mlist; // keyed by lower-case file name
 };
 
 // =======================================================================
@@ -269,6 +286,8 @@ private:
 bool LoadMesh (const char *meshname, Mesh &mesh);
 // Load an unmanaged mesh (caller is responsible for deleting after use)
 // meshname is relative to MeshPath directory.
+// A binary version of the mesh (<meshname>.mshb) is used if it exists
+// and is up to date. Otherwise the text mesh is read.
 // Returns true if mesh was loaded, false if not found.
 
 void CreateSpherePatch (Mesh &mesh, int nlng, int nlat, int ilat, int res,
@@ -0,0 +1,307 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// MeshBin.cpp
+// Binary mesh files
+// =======================================================================
+
+#include "MeshBin.h"
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+
+static const char MeshBinMagic[8] = {'O','R','B','M','S','H','B','1'};
+static const UINT32 MeshBinInherit = (UINT32)-2; // SPEC_INHERIT
+
+static_assert (sizeof(MeshBinHeader) == 40, "MeshBinHeader layout");
+static_assert (sizeof(MeshBinVertex) == 32, "MeshBinVertex layout");
+static_assert (sizeof(MeshBinGroup) == 48, "MeshBinGroup layout");
+static_assert (sizeof(MeshBinMaterial) == 68, "MeshBinMaterial layout");
+static_assert (sizeof(MeshBinTexture) == 260, "MeshBinTexture layout");
+
+static bool MeshBinStamp (const char *fname, __int64 &size, __int64 &time)
+{
+	std::error_code ec;
+	size = (__int64)std::filesystem::file_size (fname, ec);
+	if (ec) return false;
+	time = (__int64)std::filesystem::last_write_time (fname, ec).time_since_epoch().count();
+	return !ec;
+}
+
+static bool ReadLine (std::istream &is, char *cbuf)
+{
+	if (!is.getline (cbuf, 256)) return false;
+	size_t len = strlen (cbuf);
+	if (len && cbuf[len-1] == '\r') cbuf[len-1] = '\0'; // as in text mode on Windows
+	return true;
+}
+
+// =======================================================================
+// Text mesh parser. Follows the Orbiter mesh loader (operator>> in
+// Mesh.cpp) line by line, so that both interpret a file identically.
+
+bool MeshBinParse (std::istream &is, MeshBinData &mesh)
+{
+	char cbuf[256];
+	int i, j, ngrp, nvtx, ntri, nmtrl, ntex, res;
+	bool term, staticmesh = false;
+
+	mesh.grp.clear();
+	mesh.mtrl.clear();
+	mesh.tex.clear();
+
+	if (!ReadLine (is, cbuf)) return false;
+	if (strcmp (cbuf, "MSHX1")) return false;
+
+	for (;;) {
+		if (!ReadLine (is, cbuf)) return false;
+		if (!_strnicmp (cbuf, "GROUPS", 6)) {
+			if (sscanf (cbuf+6, "%d", &ngrp) != 1) return false;
+			break;
+		} else if (!_strnicmp (cbuf, "STATICMESH", 10)) {
+			staticmesh = true;
+		}
+	}
+
+	for (int g = 0; g < ngrp; g++) {
+		MeshBinData::Group grp;
+		MeshBinGroup &spec = grp.spec;
+		memset (&spec, 0, sizeof(MeshBinGroup));
+		int mtrl_idx = MeshBinInherit, tex_idx = MeshBinInherit;
+		unsigned long uflag = 0;
+		unsigned short zbias = 0;
+		int flag = (staticmesh ? 0x04 : 0);
+		bool bnormal = true, calcnml = false, flipidx = false;
+		term = false;
+		nvtx = ntri = 0;
+
+		for (;;) {
+			if (!ReadLine (is, cbuf)) { term = true; break; }
+			if (!_strnicmp (cbuf, "MATERIAL", 8)) {
+				sscanf (cbuf+8, "%d", &mtrl_idx);
+				mtrl_idx--;
+			} else if (!_strnicmp (cbuf, "TEXTURE", 7)) {
+				sscanf (cbuf+7, "%d", &tex_idx);
+				tex_idx--;
+			} else if (!_strnicmp (cbuf, "ZBIAS", 5)) {
+				sscanf (cbuf+5, "%hu", &zbias);
+			} else if (!_strnicmp (cbuf, "TEXWRAP", 7)) {
+				char uvstr[10] = "";
+				sscanf (cbuf+7, "%9s", uvstr);
+				if (uvstr[0] == 'U' || uvstr[1] == 'U') flag |= 0x01;
+				if (uvstr[0] == 'V' || uvstr[1] == 'V') flag |= 0x02;
+			} else if (!_strnicmp (cbuf, "NONORMAL", 8)) {
+				bnormal = false; calcnml = true;
+			} else if (!_strnicmp (cbuf, "FLAG", 4)) {
+				sscanf (cbuf+4, "%lx", &uflag);
+			} else if (!_strnicmp (cbuf, "FLIP", 4)) {
+				flipidx = true;
+			} else if (!_strnicmp (cbuf, "LABEL", 5)) {
+				// ignore group labels here
+			} else if (!_strnicmp (cbuf, "STATIC", 6)) {
+				flag |= 0x04;
+			} else if (!_strnicmp (cbuf, "DYNAMIC", 7)) {
+				flag ^= 0x04;
+			} else if (!_strnicmp (cbuf, "GEOM", 4)) {
+				if (sscanf (cbuf+4, "%d%d", &nvtx, &ntri) != 2 || nvtx < 0 || ntri < 0) { // parse error - skip group
+					nvtx = ntri = 0;
+					break;
+				}
+				grp.vtx.assign (nvtx, MeshBinVertex{});
+				for (i = 0; i < nvtx; i++) {
+					MeshBinVertex &v = grp.vtx[i];
+					if (!ReadLine (is, cbuf)) {
+						grp.vtx.clear();
+						break;
+					}
+					if (bnormal) {
+						j = sscanf (cbuf, "%f%f%f%f%f%f%f%f",
+							&v.x, &v.y, &v.z, &v.nx, &v.ny, &v.nz, &v.tu, &v.tv);
+						if (j < 6) calcnml = true;
+					} else {
+						j = sscanf (cbuf, "%f%f%f%f%f",
+							&v.x, &v.y, &v.z, &v.tu, &v.tv);
+					}
+				}
+				grp.idx.assign (ntri*3, 0);
+				for (i = j = 0; i < ntri; i++) {
+					short *idx = (short*)grp.idx.data() + j;
+					if (!ReadLine (is, cbuf)) {
+						grp.vtx.clear();
+						grp.idx.clear();
+						break;
+					}
+					sscanf (cbuf, "%hd%hd%hd", idx, idx+1, idx+2);
+					j += 3;
+				}
+				if (flipidx)
+					for (i = 0; i < (int)grp.idx.size()/3; i++)
+						std::swap (grp.idx[i*3+1], grp.idx[i*3+2]);
+				break;
+			}
+		}
+		if (grp.vtx.size() && grp.idx.size()) {
+			spec.nvtx    = (UINT32)grp.vtx.size();
+			spec.nidx    = (UINT32)grp.idx.size();
+			spec.mtrl    = (UINT32)mtrl_idx;
+			spec.tex     = (UINT32)tex_idx;
+			spec.usrflag = (UINT32)uflag;
+			spec.zbias   = zbias;
+			spec.flags   = (UINT16)flag;
+			spec.opts    = (calcnml ? MESHBIN_CALCNORMALS : 0);
+			mesh.grp.push_back (std::move (grp));
+		}
+		if (term) break;
+	}
+
+	// read material list
+	if (ReadLine (is, cbuf) && !strncmp (cbuf, "MATERIALS", 9) && (sscanf (cbuf+9, "%d", &nmtrl) == 1)) {
+		for (i = 0; i < nmtrl; i++) // skip material names
+			ReadLine (is, cbuf);
+		for (i = 0; i < nmtrl; i++) {
+			MeshBinMaterial m;
+			memset (&m, 0, sizeof(MeshBinMaterial));
+			cbuf[0] = '\0'; ReadLine (is, cbuf); // material name
+			cbuf[0] = '\0'; ReadLine (is, cbuf);
+			sscanf (cbuf, "%f%f%f%f", m.diffuse, m.diffuse+1, m.diffuse+2, m.diffuse+3);
+			cbuf[0] = '\0'; ReadLine (is, cbuf);
+			sscanf (cbuf, "%f%f%f%f", m.ambient, m.ambient+1, m.ambient+2, m.ambient+3);
+			cbuf[0] = '\0'; ReadLine (is, cbuf);
+			res = sscanf (cbuf, "%f%f%f%f%f", m.specular, m.specular+1, m.specular+2, m.specular+3, &m.power);
+			if (res < 5) m.power = 0.0f;
+			cbuf[0] = '\0'; ReadLine (is, cbuf);
+			sscanf (cbuf, "%f%f%f%f", m.emissive, m.emissive+1, m.emissive+2, m.emissive+3);
+			mesh.mtrl.push_back (m);
+		}
+	}
+
+	// read texture list
+	if (ReadLine (is, cbuf) && !strncmp (cbuf, "TEXTURES", 8) && (sscanf (cbuf+8, "%d", &ntex) == 1)) {
+		char flagstr[256];
+		for (i = 0; i < ntex; i++) {
+			MeshBinTexture t;
+			memset (&t, 0, sizeof(MeshBinTexture));
+			cbuf[0] = flagstr[0] = '\0';
+			ReadLine (is, cbuf);
+			sscanf (cbuf, "%255s%255s", t.name, flagstr);
+			if (toupper (flagstr[0]) == 'D') t.flags |= MESHBIN_TEX_UNCOMPRESS;
+			mesh.tex.push_back (t);
+		}
+	}
+	return true;
+}
+
+// =======================================================================
+
+bool MeshBinWrite (const char *fname, const MeshBinData &mesh, const char *srcname)
+{
+	MeshBinHeader hdr;
+	memset (&hdr, 0, sizeof(MeshBinHeader));
+	memcpy (hdr.magic, MeshBinMagic, 8);
+	if (srcname && !MeshBinStamp (srcname, hdr.srcsize, hdr.srctime)) return false;
+	hdr.ngrp  = (UINT32)mesh.grp.size();
+	hdr.nmtrl = (UINT32)mesh.mtrl.size();
+	hdr.ntex  = (UINT32)mesh.tex.size();
+
+	// data blocks follow the tables, each aligned to 4 bytes
+	std::vector<MeshBinGroup> grp (mesh.grp.size());
+	UINT64 ofs = sizeof(MeshBinHeader) + hdr.ngrp*sizeof(MeshBinGroup) +
+		hdr.nmtrl*sizeof(MeshBinMaterial) + hdr.ntex*sizeof(MeshBinTexture);
+	for (size_t g = 0; g < grp.size(); g++) {
+		const MeshBinData::Group &src = mesh.grp[g];
+		grp[g] = src.spec;
+		grp[g].nvtx = (UINT32)src.vtx.size();
+		grp[g].nidx = (UINT32)src.idx.size();
+		grp[g].pad = 0;
+		grp[g].vtxofs = ofs;
+		ofs += src.vtx.size()*sizeof(MeshBinVertex);
+		grp[g].idxofs = ofs;
+		ofs += (src.idx.size()*sizeof(UINT16) + 3) & ~(UINT64)3;
+	}
+
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+	static const char zero[4] = {0,0,0,0};
+	auto write = [f](const void *data, size_t size, size_t n) { return !n || fwrite (data, size, n, f) == n; };
+	bool ok = (write (&hdr, sizeof(MeshBinHeader), 1) &&
+		write (grp.data(), sizeof(MeshBinGroup), grp.size()) &&
+		write (mesh.mtrl.data(), sizeof(MeshBinMaterial), mesh.mtrl.size()) &&
+		write (mesh.tex.data(), sizeof(MeshBinTexture), mesh.tex.size()));
+	for (size_t g = 0; ok && g < grp.size(); g++) {
+		const MeshBinData::Group &src = mesh.grp[g];
+		ok = (write (src.vtx.data(), sizeof(MeshBinVertex), src.vtx.size()) &&
+			write (src.idx.data(), sizeof(UINT16), src.idx.size()) &&
+			write (zero, 1, (4 - (src.idx.size()*sizeof(UINT16)) % 4) % 4));
+	}
+	if (fclose (f)) ok = false;
+	if (!ok) remove (fname);
+	return ok;
+}
+
+// =======================================================================
+// class MeshBinReader
+// =======================================================================
+
+MeshBinReader::MeshBinReader ()
+{
+	hdr = 0;
+	grp = 0;
+	mtrl = 0;
+	tex = 0;
+}
+
+// =======================================================================
+
+bool MeshBinReader::Open (const char *fname, const char *srcname)
+{
+	Close ();
+	if (!file.Open (fname)) return false;
+
+	const BYTE *data = file.Data();
+	UINT64 size = file.Size();
+	const MeshBinHeader *h = (const MeshBinHeader*)data;
+	bool ok = (size >= sizeof(MeshBinHeader) && !memcmp (h->magic, MeshBinMagic, 8));
+
+	// the file must be up to date with the text mesh, if present
+	__int64 srcsize, srctime;
+	if (ok && srcname && MeshBinStamp (srcname, srcsize, srctime))
+		ok = (h->srcsize == srcsize && h->srctime == srctime);
+
+	// all tables and data blocks must lie within the file
+	if (ok) {
+		UINT64 ofs = sizeof(MeshBinHeader) + (UINT64)h->ngrp*sizeof(MeshBinGroup) +
+			(UINT64)h->nmtrl*sizeof(MeshBinMaterial) + (UINT64)h->ntex*sizeof(MeshBinTexture);
+		ok = (ofs <= size);
+	}
+	if (ok) {
+		grp  = (const MeshBinGroup*)(data + sizeof(MeshBinHeader));
+		mtrl = (const MeshBinMaterial*)(grp + h->ngrp);
+		tex  = (const MeshBinTexture*)(mtrl + h->nmtrl);
+		for (UINT32 g = 0; ok && g < h->ngrp; g++) {
+			const MeshBinGroup &gs = grp[g];
+			ok = (gs.nvtx && gs.nidx && !(gs.vtxofs % 4) && !(gs.idxofs % 2) &&
+				gs.vtxofs <= size && (size - gs.vtxofs)/sizeof(MeshBinVertex) >= gs.nvtx &&
+				gs.idxofs <= size && (size - gs.idxofs)/sizeof(UINT16) >= gs.nidx);
+		}
+		for (UINT32 i = 0; ok && i < h->ntex; i++)
+			ok = (memchr (tex[i].name, '\0', sizeof(tex[i].name)) != 0);
+	}
+	if (!ok) {
+		Close ();
+		return false;
+	}
+	hdr = h;
+	return true;
+}
+
+// =======================================================================
+
+void MeshBinReader::Close ()
+{
+	file.Close ();
+	hdr = 0;
+	grp = 0;
+	mtrl = 0;
+	tex = 0;
+}
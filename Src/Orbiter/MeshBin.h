@@ -0,0 +1,130 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// MeshBin.h
+// Binary mesh files (*.mshb). A binary mesh contains the same data as a
+// text mesh file (groups, vertex and index lists, materials and texture
+// names) in a layout that can be used directly from a memory-mapped file.
+// Binary meshes are created from text meshes with the meshc utility and
+// are loaded in place of the text mesh of the same name, as long as the
+// text mesh hasn't been modified since the conversion.
+//
+// File layout: MeshBinHeader, ngrp x MeshBinGroup, nmtrl x MeshBinMaterial,
+// ntex x MeshBinTexture, followed by the vertex and index blocks of the
+// groups (4-byte aligned).
+// =======================================================================
+
+#ifndef __MESHBIN_H
+#define __MESHBIN_H
+
+#include <windows.h>
+#include <iostream>
+#include <vector>
+#include "MappedFile.h"
+
+// Group options
+#define MESHBIN_CALCNORMALS  0x0001  // vertex normals are missing and must be computed after loading
+
+// Texture flags
+#define MESHBIN_TEX_UNCOMPRESS 0x0001 // texture is loaded uncompressed ('D' flag)
+
+struct MeshBinHeader {
+	char    magic[8];    // file identifier "ORBMSHB1"
+	__int64 srcsize;     // size of the text mesh the file was converted from (0: none)
+	__int64 srctime;     // modification time of the text mesh
+	UINT32  ngrp;        // number of groups
+	UINT32  nmtrl;       // number of materials
+	UINT32  ntex;        // number of textures
+	UINT32  pad;
+};
+
+struct MeshBinVertex {   // vertex layout (same as NTVERTEX)
+	float x, y, z;       // position
+	float nx, ny, nz;    // normal
+	float tu, tv;        // texture coordinates
+};
+
+struct MeshBinGroup {
+	UINT32  nvtx;        // number of vertices
+	UINT32  nidx;        // number of indices
+	UINT32  mtrl;        // material index (or SPEC_INHERIT/SPEC_DEFAULT)
+	UINT32  tex;         // texture index (or SPEC_INHERIT/SPEC_DEFAULT)
+	UINT32  usrflag;     // user flags (FLAG entry)
+	UINT16  zbias;       // z-bias
+	UINT16  flags;       // group flags (wrap and static flags)
+	UINT32  opts;        // MESHBIN_xxx options
+	UINT32  pad;
+	UINT64  vtxofs;      // file offset of the vertex list
+	UINT64  idxofs;      // file offset of the index list
+};
+
+struct MeshBinMaterial { // material layout (same as D3DMATERIAL7)
+	float diffuse[4];
+	float ambient[4];
+	float specular[4];
+	float emissive[4];
+	float power;
+};
+
+struct MeshBinTexture {
+	char   name[256];    // texture file name ("0": no texture)
+	UINT32 flags;        // MESHBIN_TEX_xxx flags
+};
+
+// =======================================================================
+// Mesh data in memory, used for conversion
+
+struct MeshBinData {
+	struct Group {
+		MeshBinGroup spec;   // group parameters (offsets are ignored)
+		std::vector<MeshBinVertex> vtx;
+		std::vector<UINT16> idx;
+	};
+	std::vector<Group> grp;
+	std::vector<MeshBinMaterial> mtrl;
+	std::vector<MeshBinTexture> tex;
+};
+
+bool MeshBinParse (std::istream &is, MeshBinData &mesh);
+// Read a mesh in text format. Groups are interpreted as by the Orbiter
+// mesh loader. Returns false if the stream isn't a text mesh.
+
+bool MeshBinWrite (const char *fname, const MeshBinData &mesh, const char *srcname = 0);
+// Write a binary mesh file. If srcname is given, the file is tied to the
+// current state of text mesh srcname.
+
+// =======================================================================
+// Read access to a memory-mapped binary mesh file
+
+class MeshBinReader {
+public:
+	MeshBinReader ();
+
+	bool Open (const char *fname, const char *srcname = 0);
+	// Map and validate a binary mesh file. If srcname is given and the file
+	// exists, it must be the text mesh the binary mesh was converted from,
+	// unmodified since the conversion. Returns false if the file doesn't
+	// exist, is invalid or outdated.
+
+	void Close ();
+
+	inline UINT32 nGroup () const { return hdr->ngrp; }
+	inline UINT32 nMaterial () const { return hdr->nmtrl; }
+	inline UINT32 nTexture () const { return hdr->ntex; }
+
+	inline const MeshBinGroup &Group (UINT32 i) const { return grp[i]; }
+	inline const MeshBinVertex *Vtx (UINT32 i) const { return (const MeshBinVertex*)(file.Data() + grp[i].vtxofs); }
+	inline const UINT16 *Idx (UINT32 i) const { return (const UINT16*)(file.Data() + grp[i].idxofs); }
+	inline const MeshBinMaterial &Material (UINT32 i) const { return mtrl[i]; }
+	inline const MeshBinTexture &Texture (UINT32 i) const { return tex[i]; }
+
+private:
+	MappedFile file;
+	const MeshBinHeader *hdr;
+	const MeshBinGroup *grp;
+	const MeshBinMaterial *mtrl;
+	const MeshBinTexture *tex;
+};
+
+#endif // !__MESHBIN_H
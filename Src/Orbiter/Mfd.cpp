@@ -6,6 +6,7 @@
 #include "Pane.h"
 #include "Orbiter.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include "Mfd.h"
 #include "MfdOrbit.h"
 #include "MfdSurface.h"
@@ -151,7 +152,7 @@ void Instrument::GlobalInit (oapi::GraphicsClient *gc)
 	draw[4][1].col = 0xA00000;  // aux colour 4 dim
 
 	// Read customised settings
-	ifstream ifs (g_pOrbiter->ConfigPath ("MFD\\Default"));
+	CfgFile ifs (g_pOrbiter->ConfigPath ("MFD\\Default"));
 	if (ifs) {
 		char label[64];
 		int c;
@@ -0,0 +1,162 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ObjectRegistry.cpp
+// Registry of the objects of a planetary system, for constant-time
+// handle validation and name lookup.
+// =======================================================================
+
+#include "ObjectRegistry.h"
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+
+// =======================================================================
+
+ObjectRegistry::ObjectRegistry ()
+{
+	seq = 0;
+}
+
+// =======================================================================
+
+std::string ObjectRegistry::Key (const char *name)
+{
+	// fold case as _stricmp does
+	std::string key (name);
+	for (size_t i = 0; i < key.size(); i++)
+		key[i] = (char)tolower ((unsigned char)key[i]);
+	return key;
+}
+
+// =======================================================================
+
+void ObjectRegistry::Clear ()
+{
+	// keep the slots so that handles issued before stay stale
+	for (unsigned int i = 0; i < slots.size(); i++)
+		if (slots[i].obj) {
+			slots[i].obj = 0;
+			if (!++slots[i].gen) slots[i].gen = 1; // 0 is reserved
+			slots[i].name.clear();
+			freeslots.push_back (i);
+		}
+	objmap.clear();
+	namemap.clear();
+}
+
+// =======================================================================
+
+ObjectRegistry::Handle ObjectRegistry::Insert (const void *obj, const char *name, unsigned int flags)
+{
+	auto it = objmap.find (obj);
+	if (it != objmap.end())
+		return GetHandle (obj);
+
+	unsigned int i;
+	if (freeslots.size()) {
+		i = freeslots.back();
+		freeslots.pop_back();
+	} else {
+		i = (unsigned int)slots.size();
+		slots.push_back (Slot());
+		slots[i].gen = 1;
+	}
+	Slot &s = slots[i];
+	s.obj = obj;
+	s.flags = flags;
+	s.seq = seq++;
+	s.name = name;
+	objmap[obj] = i;
+	namemap[Key (name)].push_back (i); // sequence numbers increase, so the list stays ordered
+	return ((Handle)s.gen << 32) | i;
+}
+
+// =======================================================================
+
+void ObjectRegistry::Unindex (unsigned int slot)
+{
+	auto it = namemap.find (Key (slots[slot].name.c_str()));
+	if (it == namemap.end()) return;
+	std::vector<unsigned int> &list = it->second;
+	list.erase (std::find (list.begin(), list.end(), slot));
+	if (list.empty()) namemap.erase (it);
+}
+
+// =======================================================================
+
+bool ObjectRegistry::Remove (const void *obj)
+{
+	auto it = objmap.find (obj);
+	if (it == objmap.end()) return false;
+	unsigned int i = it->second;
+	Unindex (i);
+	objmap.erase (it);
+	slots[i].obj = 0;
+	if (!++slots[i].gen) slots[i].gen = 1; // 0 is reserved
+	slots[i].name.clear();
+	freeslots.push_back (i);
+	return true;
+}
+
+// =======================================================================
+
+bool ObjectRegistry::Rename (const void *obj, const char *name)
+{
+	auto it = objmap.find (obj);
+	if (it == objmap.end()) return false;
+	unsigned int i = it->second;
+	Unindex (i);
+	slots[i].name = name;
+	std::vector<unsigned int> &list = namemap[Key (name)];
+	auto pos = std::lower_bound (list.begin(), list.end(), i, [this](unsigned int a, unsigned int b) {
+		return slots[a].seq < slots[b].seq;
+	});
+	list.insert (pos, i);
+	return true;
+}
+
+// =======================================================================
+
+bool ObjectRegistry::Contains (const void *obj, unsigned int flags) const
+{
+	auto it = objmap.find (obj);
+	if (it == objmap.end()) return false;
+	return !flags || (slots[it->second].flags & flags);
+}
+
+// =======================================================================
+
+ObjectRegistry::Handle ObjectRegistry::GetHandle (const void *obj) const
+{
+	auto it = objmap.find (obj);
+	if (it == objmap.end()) return 0;
+	return ((Handle)slots[it->second].gen << 32) | it->second;
+}
+
+// =======================================================================
+
+const void *ObjectRegistry::Get (Handle h) const
+{
+	unsigned int i = (unsigned int)(h & 0xffffffff);
+	unsigned int gen = (unsigned int)(h >> 32);
+	if (i >= slots.size() || slots[i].gen != gen) return 0;
+	return slots[i].obj;
+}
+
+// =======================================================================
+
+const void *ObjectRegistry::Find (const char *name, bool ignorecase, unsigned int flags) const
+{
+	auto it = namemap.find (Key (name));
+	if (it == namemap.end()) return 0;
+	const std::vector<unsigned int> &list = it->second;
+	for (size_t j = 0; j < list.size(); j++) {
+		const Slot &s = slots[list[j]];
+		if (flags && !(s.flags & flags)) continue;
+		if (!ignorecase && strcmp (s.name.c_str(), name)) continue;
+		return s.obj;
+	}
+	return 0;
+}
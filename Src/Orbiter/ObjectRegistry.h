@@ -0,0 +1,81 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// ObjectRegistry.h
+// Registry of the objects of a planetary system, for constant-time
+// handle validation and name lookup. Each registered object occupies a
+// slot with a generation counter. A slot released by Remove is reused
+// with an incremented generation, so handles to removed objects are
+// recognised as stale even if the slot, or the object address, is
+// reused. Names are indexed case-insensitively.
+// =======================================================================
+
+#ifndef __OBJECTREGISTRY_H
+#define __OBJECTREGISTRY_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+class ObjectRegistry {
+public:
+	typedef unsigned long long Handle;
+	// generation in the upper 32 bits, slot index in the lower 32 bits.
+	// 0 is never a valid handle.
+
+	ObjectRegistry ();
+
+	inline size_t Size () const { return objmap.size(); }
+
+	void Clear ();
+
+	Handle Insert (const void *obj, const char *name, unsigned int flags = 0);
+	// Register obj under name, with user-defined category flags for
+	// filtered lookups. Returns the handle of the object. If obj is
+	// already registered, its existing handle is returned.
+
+	bool Remove (const void *obj);
+	// Remove obj. Returns false if obj is not registered.
+
+	bool Rename (const void *obj, const char *name);
+	// Change the name under which obj is indexed
+
+	bool Contains (const void *obj, unsigned int flags = 0) const;
+	// True if obj is registered, and (flags != 0) belongs to any of the
+	// categories in flags
+
+	Handle GetHandle (const void *obj) const;
+	// Handle of obj, or 0 if obj is not registered
+
+	const void *Get (Handle h) const;
+	// Object for handle h, or NULL if the handle is stale or invalid
+
+	const void *Find (const char *name, bool ignorecase = false, unsigned int flags = 0) const;
+	// Object registered under name, and (flags != 0) belonging to any of
+	// the categories in flags. If several objects match, the earliest
+	// registered is returned. Returns NULL if no object matches.
+
+private:
+	struct Slot {
+		const void *obj;       // registered object (NULL: slot is free)
+		unsigned int gen;      // generation, incremented when the slot is released
+		unsigned int flags;    // category flags
+		unsigned long long seq;// registration sequence number
+		std::string name;      // object name
+	};
+
+	static std::string Key (const char *name);
+	// case-folded index key of name
+
+	void Unindex (unsigned int slot);
+	// remove slot from the name index
+
+	std::vector<Slot> slots;                                            // object slots
+	std::vector<unsigned int> freeslots;                                // released slots
+	std::unordered_map<const void*, unsigned int> objmap;               // object -> slot
+	std::unordered_map<std::string, std::vector<unsigned int> > namemap; // name key -> slots
+	unsigned long long seq;                                             // next sequence number
+};
+
+#endif // !__OBJECTREGISTRY_H
@@ -0,0 +1,172 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// OrbitRail.cpp
+// Analytic ("on rails") propagation of a closed orbit relative to a
+// central body.
+// =======================================================================
+
+#include "OrbitRail.h"
+#include <math.h>
+
+// rotate x by angle (c=cos, s=sin) about unit axis k, in the sense of the
+// orbital motion for an orbit with normal k (left-handed coordinates)
+static inline Vector Rotate (const Vector &x, const Vector &k, double c, double s)
+{
+	return x*c + crossp (x, k)*s + k*(dotp (k, x)*(1.0-c));
+}
+
+// =======================================================================
+
+OrbitRail::OrbitRail ()
+{
+	mu = a = e = t0 = M0 = dM = dperi = dnode = 0.0;
+	b = 1.0;
+	valid = false;
+}
+
+// =======================================================================
+
+bool OrbitRail::Set (const Vector &r, const Vector &v, double _mu, double t, const Vector &_pole, double J2R2)
+{
+	valid = false;
+	mu = _mu;
+	t0 = t;
+	pole = _pole;
+	ap.Set (0,0,0);
+	dap.Set (0,0,0);
+
+	double r0 = r.length();
+	double v2 = v.length2();
+	double rv = dotp (r, v);
+	double ia = 2.0/r0 - v2/mu; // 1/a
+	if (ia <= 0.0) return false;  // open orbit
+	a = 1.0/ia;
+	Vector E (r * (1.0/r0 - ia) - v * (rv/mu)); // eccentricity vector
+	e = E.length();
+	if (e >= 1.0) return false;
+
+	H = crossp (v, r).unit();   // left-handed coordinates!
+	if (e > 1e-12) {
+		P = E/e;
+		double ea = atan2 (rv/sqrt (mu*a), 1.0 - r0*ia); // eccentric anomaly
+		M0 = ea - e*sin (ea);
+	} else {                     // circular: measure the anomaly from r
+		e = 0.0;
+		P = r/r0;
+		M0 = 0.0;
+	}
+	b = sqrt (1.0 - e*e);
+	Q = crossp (P, H);
+
+	double n = sqrt (mu*ia*ia*ia);
+	dM = n;
+	dperi = dnode = 0.0;
+	if (J2R2 && pole.length2() > 0.0) {
+		// mean motion from the conserved energy including the J2 potential,
+		// less the orbit-averaged J2 potential
+		double ci = dotp (H, pole), ci2 = ci*ci;
+		double sphi = dotp (r, pole)/r0;
+		double U  = mu*J2R2*0.5*(3.0*sphi*sphi - 1.0)/(r0*r0*r0);
+		double Um = mu*J2R2*(0.25 - 0.75*ci2)/(a*a*a*b*b*b);
+		double am = -0.5*mu/(0.5*v2 - mu/r0 + U - Um);
+		if (am > 0.0) n = sqrt (mu/(am*am*am));
+
+		// secular rates of node, periapsis and mean anomaly
+		double p = a*b*b;
+		double k = 1.5*n*J2R2/(p*p);
+		dnode = -k*ci;
+		dperi = 0.5*k*(5.0*ci2 - 1.0);
+		dM = n + 0.5*k*b*(3.0*ci2 - 1.0);
+	}
+	return valid = true;
+}
+
+// =======================================================================
+
+void OrbitRail::PosVel (double t, Vector &r, Vector &v) const
+{
+	double dt = t-t0;
+	double M = M0 + dM*dt;
+	M -= Pi2*floor ((M+Pi)/Pi2); // -Pi <= M < Pi
+
+	// solve Kepler's equation by Newton iteration
+	double E = (e < 0.8 ? M + e*sin (M) : (M < 0.0 ? -Pi : Pi));
+	for (int i = 0; i < 30; i++) {
+		double dE = (E - e*sin (E) - M)/(1.0 - e*cos (E));
+		E -= dE;
+		if (fabs (dE) < 1e-14) break;
+	}
+
+	double sinE = sin (E), cosE = cos (E);
+	double vf = sqrt (mu*a)/(a*(1.0 - e*cosE));
+	r = P*(a*(cosE-e)) + Q*(a*b*sinE);
+	v = P*(-vf*sinE) + Q*(vf*b*cosE);
+
+	if (dperi) { // apsidal rotation in the orbit plane
+		double phi = dperi*dt, c = cos (phi), s = sin (phi);
+		r = Rotate (r, H, c, s);
+		v = Rotate (v, H, c, s);
+	}
+	if (dnode) { // nodal rotation about the pole
+		double phi = dnode*dt, c = cos (phi), s = sin (phi);
+		r = Rotate (r, pole, c, s);
+		v = Rotate (v, pole, c, s);
+	}
+	if (ap.x || ap.y || ap.z) { // perturbation, to second order in dt
+		r += ap*(0.5*dt*dt) + dap*(dt*dt*dt/6.0);
+		v += ap*dt + dap*(0.5*dt*dt);
+	}
+}
+
+// =======================================================================
+
+double OrbitRail::PeDist (const Vector &r, const Vector &v, double mu)
+{
+	double ia = 2.0/r.length() - v.length2()/mu;
+	if (ia <= 0.0) return -1.0;
+	double a = 1.0/ia;
+	double h2 = crossp (v, r).length2();
+	double e2 = 1.0 - h2/(mu*a);
+	return a*(1.0 - sqrt (e2 > 0.0 ? e2 : 0.0));
+}
+
+// =======================================================================
+// class OrbitCoast
+// =======================================================================
+
+bool OrbitCoast::Anchor (const Vector &r, const Vector &v, double mu, double t, const Vector &_pert)
+{
+	// rate of change of the perturbation since the previous anchor.
+	// Without it, the systematic error of a constant perturbation over
+	// the interval accumulates as an energy drift.
+	Vector dpert;
+	if (valid && t > t0)
+		dpert = (_pert - pert)/(t - t0);
+
+	if (!(valid = rail.Set (r, v, mu, t))) return false; // open orbit
+	rail.SetPerturbation (_pert, dpert);
+	pert = _pert;
+	t0 = t;
+	return true;
+}
+
+// =======================================================================
+
+double OrbitCoast::Interval (double r, double v, double omega, double orbstep, double hmax, double dt)
+{
+	// orbit period fraction: the same measure as the step length 'ostep'
+	// used for propagator selection, per unit time
+	double h = hmax;
+	if (v*h > orbstep*Pi2*r)
+		h = orbstep*Pi2*r/v;
+
+	// rotation: limit the angle covered without gravity gradient torque
+	const double arot_max = 0.1*Pi;
+	if (omega*h > arot_max)
+		h = arot_max/omega;
+
+	// no gain from intervals of less than two steps
+	return (h >= 2.0*dt ? h : 0.0);
+}
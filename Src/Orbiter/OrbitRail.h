@@ -0,0 +1,127 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// OrbitRail.h
+// Analytic ("on rails") propagation of a closed orbit relative to a
+// central body: Kepler motion, optionally with the secular drift of the
+// node, periapsis and mean anomaly caused by the J2 term of the central
+// body's gravity field.
+// The orbit shape is taken from the osculating elements at the epoch, so
+// the propagated state is continuous with the integrated state at rail
+// entry. With J2 drift, the mean motion is derived from the conserved
+// energy including the J2 potential, which removes most of the along-track
+// drift of a pure Kepler orbit started from osculating elements.
+// A perturbing acceleration, extrapolated linearly from the epoch, can be
+// superimposed for short intervals (multi-rate coasting, see OrbitCoast).
+// =======================================================================
+
+#ifndef __ORBITRAIL_H
+#define __ORBITRAIL_H
+
+#include "Vecmat.h"
+
+class OrbitRail {
+public:
+	OrbitRail ();
+
+	bool Set (const Vector &r, const Vector &v, double mu, double t,
+		const Vector &pole = Vector(0,0,0), double J2R2 = 0.0);
+	// Set up the orbit from position r and velocity v relative to the
+	// central body at time t. mu: gravitational parameter of the central
+	// body [m^3/s^2]. pole: unit vector of the central body's rotation
+	// axis, J2R2: J2 coefficient times the square of the body's reference
+	// radius [m^2] (0: pure Kepler orbit). Returns false if the orbit is
+	// not closed, in which case the rail is left invalid.
+
+	inline void SetPerturbation (const Vector &acc, const Vector &dacc = Vector(0,0,0))
+	{ ap = acc; dap = dacc; }
+	// Perturbing acceleration relative to the central body at the epoch,
+	// and its rate of change [m/s^3], applied on top of the analytic orbit
+	// (default: zero). Used to carry the non-central forces over short
+	// coasting intervals. Reset by Set.
+
+	inline void Invalidate () { valid = false; }
+	inline bool Valid () const { return valid; }
+
+	void PosVel (double t, Vector &r, Vector &v) const;
+	// Position and velocity relative to the central body at time t
+
+	inline double Epoch () const { return t0; }
+	inline double Mu () const { return mu; }
+	inline double PeDist () const { return a*(1.0-e); }
+	inline double ApDist () const { return a*(1.0+e); }
+	// epoch, gravitational parameter, and periapsis and apoapsis distances
+
+	static double PeDist (const Vector &r, const Vector &v, double mu);
+	// Periapsis distance of the orbit with position r and velocity v, or
+	// -1 if the orbit is not closed
+
+private:
+	double mu;      // gravitational parameter [m^3/s^2]
+	double a;       // osculating semi-major axis at epoch [m]
+	double e;       // osculating eccentricity at epoch
+	double b;       // sqrt(1-e^2)
+	double t0;      // epoch [s]
+	double M0;      // mean anomaly at epoch [rad]
+	double dM;      // mean anomaly rate [rad/s]
+	double dperi;   // secular periapsis rotation rate [rad/s]
+	double dnode;   // secular node rotation rate about the pole [rad/s]
+	Vector P, Q;    // unit vectors towards periapsis, and 90 deg ahead in the orbit plane
+	Vector H;       // unit orbit normal
+	Vector pole;    // rotation axis of the central body
+	Vector ap, dap; // perturbing acceleration at epoch [m/s^2] and its rate [m/s^3]
+	bool valid;     // rail is set up
+};
+
+// =======================================================================
+// class OrbitCoast
+// Multi-rate coasting: a body that receives full dynamic updates only at
+// intervals coasts in between along the two-body orbit of its last full
+// update (the anchor), with the perturbing acceleration extrapolated
+// linearly from the last two anchors.
+// =======================================================================
+
+class OrbitCoast {
+public:
+	OrbitCoast (): t0(0.0), valid(false) {}
+
+	bool Anchor (const Vector &r, const Vector &v, double mu, double t, const Vector &pert);
+	// Set the anchor from a full update at time t: position r and velocity
+	// v relative to the central body, mu: gravitational parameter of the
+	// central body, pert: perturbing acceleration relative to the central
+	// body. The rate of change of the perturbation is taken from the
+	// previous anchor if it is still valid. Returns false (and invalidates
+	// the anchor) if the orbit is not closed.
+
+	inline bool Covers (double t, double h) const { return valid && h > 0.0 && t < t0 + h; }
+	// Can the body coast to time t, given the update interval h?
+
+	inline void PosVel (double t, Vector &r, Vector &v) const { rail.PosVel (t, r, v); }
+	// Coasting position and velocity relative to the central body at time t
+
+	inline void Invalidate () { valid = false; }
+	// Force a full update at the next step, and don't carry the
+	// perturbation rate over to the next anchor
+
+	inline bool Valid () const { return valid; }
+	inline double Epoch () const { return t0; }
+	inline double Mu () const { return rail.Mu(); }
+
+	static double Interval (double r, double v, double omega, double orbstep, double hmax, double dt);
+	// Interval between full updates for a body at distance r [m] from the
+	// central body, moving at relative velocity v [m/s] and rotating at
+	// angular velocity omega [rad/s]: the time to cover orbit fraction
+	// orbstep, limited to hmax [s] and to the time for a rotation of 0.1 pi
+	// (to limit the effect of the gravity gradient torque, which is not
+	// applied during coasting). Returns 0 (update at every step) if the
+	// interval is shorter than two steps of length dt.
+
+private:
+	OrbitRail rail; // orbit and perturbation from the anchor
+	Vector pert;    // perturbing acceleration at the anchor
+	double t0;      // anchor time [s]
+	bool valid;     // anchor is set
+};
+
+#endif // !__ORBITRAIL_H
@@ -43,9 +43,11 @@
 #include "DlgCtrl.h"
 #include "GraphicsAPI.h"
 #include "ConsoleManager.h"
+#include "Profiler.h"
 #include "imgui.h"
 #include "imgui_impl_win32.h"
 #include <filesystem>
+#include <algorithm>
 
 #include "Tracy.hpp"
 
@@ -195,8 +197,20 @@ INT WINAPI WinMain (HINSTANCE hInstance, HINSTANCE, LPSTR strCmdLine, INT nCmdSh
 	// Parse command line
 	orbiter::CommandLine::Parse(g_pOrbiter, strCmdLine);
 
-	// Initialise the log
-	INITLOG("Orbiter.log", g_pOrbiter->Cfg()->CfgCmdlinePrm.bAppendLog); // init log file
+	// Parse master config file
+	g_pOrbiter->LoadConfig();
+
+	// Initialise the log. Batch runs log next to their output scenario (in
+	// the configured ScenarioDir), so that runs started in parallel don't
+	// write to the same log file.
+	std::string logfile ("Orbiter.log");
+	if (g_pOrbiter->BatchRun()) {
+		logfile = g_pOrbiter->ScnPath (g_pOrbiter->Cfg()->CfgCmdlinePrm.BatchScenario.c_str());
+		if (logfile.size() > 4 && !stricmp (logfile.c_str() + logfile.size() - 4, ".scn"))
+			logfile.resize (logfile.size() - 4);
+		logfile += ".log";
+	}
+	INITLOG(logfile.c_str(), g_pOrbiter->Cfg()->CfgCmdlinePrm.bAppendLog); // init log file
 #ifdef ISBETA
 	LOGOUT("Build %s BETA [v.%06d]", __DATE__, GetVersion());
 #else
@@ -208,6 +222,11 @@ INT WINAPI WinMain (HINSTANCE hInstance, HINSTANCE, LPSTR strCmdLine, INT nCmdSh
 	srand(12345);
 	LOGOUT("Timer precision: %g sec", fine_counter_step);
 
+	// Convert flight recording streams
+	const CFG_CMDLINEPRM &cmdprm = g_pOrbiter->Cfg()->CfgCmdlinePrm;
+	if (!cmdprm.FRConvert.empty())
+		g_pOrbiter->FRecorder_Convert (cmdprm.FRConvert.c_str(), cmdprm.bFRConvertBinary);
+
 	oapiRegisterCustomControls(hInstance);
 
 	HRESULT hr;
@@ -221,9 +240,9 @@ INT WINAPI WinMain (HINSTANCE hInstance, HINSTANCE, LPSTR strCmdLine, INT nCmdSh
 
 	setlocale (LC_CTYPE, "");
 
-	g_pOrbiter->Run ();
+	INT res = g_pOrbiter->Run ();
 	delete g_pOrbiter;
-	return 0;
+	return res;
 }
 
 void SetEnvironmentVars ()
@@ -266,6 +285,9 @@ bool Orbiter::InitializeWorld (char *name)
 		DestroyWorld();
 		return false;
 	}
+	const CFG_CMDLINEPRM &cmdprm = pConfig->CfgCmdlinePrm;
+	if (cmdprm.EphemBuildMJD1 > cmdprm.EphemBuildMJD0)
+		g_psys->BuildEphemerisCache (cmdprm.EphemBuildMJD0, cmdprm.EphemBuildMJD1);
 	return true;
 }
 
@@ -329,6 +351,7 @@ Orbiter::Orbiter ()
 	bPlayback       = false;
 	bCapture        = false;
 	bFastExit       = false;
+	nExitCode       = 0;
 	bRoughType      = false;
 	bStartVideoTab  = false;
 	//lstatus.bkgDC   = 0;
@@ -374,6 +397,17 @@ Orbiter::~Orbiter ()
 	CloseApp ();
 }
 
+//-----------------------------------------------------------------------------
+// Name: LoadConfig()
+// Desc: Parse the master config file. Called before the log is initialised,
+//       so that the log path can depend on the configured directories
+//-----------------------------------------------------------------------------
+void Orbiter::LoadConfig ()
+{
+	pConfig->Load(MasterConfigFile);
+	strcpy (cfgpath, pConfig->CfgDirPrm.ConfigDir);   cfglen = strlen (cfgpath);
+}
+
 //-----------------------------------------------------------------------------
 // Name: Create()
 // Desc: This method selects a D3D device
@@ -389,15 +423,14 @@ HRESULT Orbiter::Create (HINSTANCE hInstance)
 	InitCommonControls();
 	LoadLibrary ("riched20.dll");
 
-	// parameter manager - parses from master config file
 	hInst = hInstance;
-	pConfig->Load(MasterConfigFile);
-	strcpy (cfgpath, pConfig->CfgDirPrm.ConfigDir);   cfglen = strlen (cfgpath);
 
-	if (FAILED (hr = pDI->Create (hInstance))) return hr;
+	if (!BatchRun()) { // batch runs don't use input devices
+		if (FAILED (hr = pDI->Create (hInstance))) return hr;
 
-	// validate configuration
-	if (pConfig->CfgJoystickPrm.Joy_idx > GetDInput()->NumJoysticks()) pConfig->CfgJoystickPrm.Joy_idx = 0;
+		// validate configuration
+		if (pConfig->CfgJoystickPrm.Joy_idx > GetDInput()->NumJoysticks()) pConfig->CfgJoystickPrm.Joy_idx = 0;
+	}
 
 	// Read key mapping from file (or write default keymap)
 	if (!keymap.Read ("keymap.cfg")) keymap.Write ("keymap.cfg");
@@ -424,14 +457,16 @@ HRESULT Orbiter::Create (HINSTANCE hInstance)
 	if (pConfig->CfgCmdlinePrm.bOpenVideoTab)
 		OpenVideoTab();
 
-	if (pConfig->CfgDemoPrm.bBkImage) {
-		hBk = CreateDialog (hInstance, MAKEINTRESOURCE(IDD_DEMOBK), NULL, BkMsgProc);
-		ShowWindow (hBk, SW_MAXIMIZE);
+	if (!BatchRun()) { // batch runs have no user interface
+		if (pConfig->CfgDemoPrm.bBkImage) {
+			hBk = CreateDialog (hInstance, MAKEINTRESOURCE(IDD_DEMOBK), NULL, BkMsgProc);
+			ShowWindow (hBk, SW_MAXIMIZE);
+		}
+
+		// Create the "launchpad" main dialog window
+		m_pLaunchpad = new orbiter::LaunchpadDialog (this); TRACENEW
+		m_pLaunchpad->Create (bStartVideoTab);
 	}
-	
-	// Create the "launchpad" main dialog window
-	m_pLaunchpad = new orbiter::LaunchpadDialog (this); TRACENEW
-	m_pLaunchpad->Create (bStartVideoTab);
 
 	Instrument::RegisterBuiltinModes();
 
@@ -452,7 +487,7 @@ HRESULT Orbiter::Create (HINSTANCE hInstance)
 		bSysClearType = (ok && cleartype);
 		//if (pConfig->CfgDebugPrm.bForceReenableSmoothFont) bSysClearType = true;
 	}
-	if (pConfig->CfgDebugPrm.bDisableSmoothFont)
+	if (pConfig->CfgDebugPrm.bDisableSmoothFont && !BatchRun())
 		ActivateRoughType();
 
 	memstat = new MemStat;
@@ -466,6 +501,7 @@ HRESULT Orbiter::Create (HINSTANCE hInstance)
 //-----------------------------------------------------------------------------
 void Orbiter::SaveConfig ()
 {
+	if (BatchRun()) return; // batch runs leave the configuration unchanged
 	pConfig->Write (); // save current settings
 	m_pLaunchpad->WriteExtraParams ();
 }
@@ -612,7 +648,9 @@ HINSTANCE Orbiter::LoadModule (const char *path, const char *name)
 	}
 
 	if (hDLL) {
-		DLLModule module = { hDLL, register_module ? register_module : new oapi::Module(hDLL), std::string(name), !register_module };
+		DLLModule module = { hDLL, register_module ? register_module : new oapi::Module(hDLL), std::string(name), !register_module,
+			g_profiler.RegisterZone (("PreStep " + std::string(name)).c_str()),
+			g_profiler.RegisterZone (("PostStep " + std::string(name)).c_str()) };
 		// If the DLL doesn't provide a Module interface, create a default one which provides the legacy callbacks
 		LOGOUT(register_module ? "Loading module %s" : "Loading module %s (legacy interface)", name);
 		m_Plugin.push_back(module);
@@ -680,8 +718,7 @@ VOID Orbiter::Launch (const char *scenario)
 
 	HCURSOR hCursor = SetCursor (LoadCursor (NULL, IDC_WAIT));
 	bool have_state = false;
-	pConfig->Write (); // save current settings
-	m_pLaunchpad->WriteExtraParams ();
+	SaveConfig (); // save current settings
 
 	if (!have_state && !pState->Read (ScnPath (scenario))) {
 		LOGOUT_ERR ("Scenario not found: %s", scenario);
@@ -705,8 +742,11 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 	SetLogVerbosity (pCfg->CfgDebugPrm.bVerboseLog);
 	LOGOUT("");
 	LOGOUT("**** Creating simulation session");
+	g_profiler.Enable (pCfg->CfgDebugPrm.bFrameProfiler);
+	preload.Start (pCfg, &vclassreg, ScnPath (scenario), pState->Solsys());
 
-	m_pLaunchpad->Hide(); // hide launchpad dialog while the render window is visible
+	if (m_pLaunchpad)
+		m_pLaunchpad->Hide(); // hide launchpad dialog while the render window is visible
 	
 	if (gclient) {
 		if(pState->SplashScreen())
@@ -715,7 +755,8 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 		GetRenderParameters ();
 	} else {
 		hRenderWnd = NULL;
-		m_pConsole = new orbiter::ConsoleNG(this);
+		if (!BatchRun())
+			m_pConsole = new orbiter::ConsoleNG(this);
 	}
 
 	pDI->SetRenderWindow(hRenderWnd);
@@ -747,9 +788,11 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 		snote_playback = gclient->clbkCreateAnnotation ();
 	}
 	else {
-		pDlgMgr = new DialogManager(this, m_pConsole->WindowHandle());
+		pDlgMgr = new DialogManager(this, m_pConsole ? m_pConsole->WindowHandle() : NULL);
 	}
 
+	preload.Stage ("render window");
+
 	// read simulation environment state
 	strcpy (ScenarioName, scenario);
 	g_qsaveid = 0;
@@ -775,6 +818,7 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 		return 0;
 	}
 	LOGOUT("Finished initialising world");
+	preload.Stage ("world");
 	time_prev = std::chrono::steady_clock::now() - std::chrono::milliseconds(1); // make sure SimDT > 0 for first frame
 
 	g_psys->InitState (ScnPath (scenario));
@@ -786,6 +830,7 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 	SetFocusObject (vfocus, false);
 
 	LOGOUT("Finished initialising status");
+	preload.Stage ("vessels");
 
 	if (g_camera) {
 		g_camera->InitState (scenario, g_focusobj);
@@ -847,8 +892,10 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 		g_pane->InitState (ScnPath (scenario));
 		LOGOUT ("Finished initialising panels");
 	}
+	preload.Stage ("post creation");
+	preload.Finish (); // log the load stages and release preloaded files
 
-	if (pCfg->CfgLogicPrm.bStartPaused) {
+	if (pCfg->CfgLogicPrm.bStartPaused && !BatchRun()) {
 		BeginTimeStep (true);
 		UpdateWorld(); // otherwise it doesn't get initialised during pause
 		EndTimeStep (true);
@@ -893,12 +940,27 @@ void Orbiter::CloseSession ()
 
 	if      (bRecord)   ToggleRecorder();
 	else if (bPlayback) EndPlayback();
-	const char* desc = pConfig->CfgDebugPrm.bSaveExitScreen ? "CurrentState_img" : "CurrentState";
-	SaveScenario (CurrentScenario, desc, 2);
+	if (BatchRun()) {
+		const char *scn = pConfig->CfgCmdlinePrm.BatchScenario.c_str();
+		char desc[256];
+		sprintf (desc, "Orbiter batch run final state at T = %0.0f", td.SimT0);
+		LOGOUT("Batch run: %zu frames, simulation time %0.3f s, system time %0.3f s", td.FrameCount(), td.SimT0, td.SysT0);
+		if (!SaveScenario (scn, desc, 0)) {
+			LOGOUT_ERR("Could not write scenario %s", scn);
+			nExitCode = 1; // let the calling script know that the run failed
+		}
+	} else {
+		const char* desc = pConfig->CfgDebugPrm.bSaveExitScreen ? "CurrentState_img" : "CurrentState";
+		SaveScenario (CurrentScenario, desc, 2);
+	}
 	if (hScnInterp) {
 		script->DelInterpreter (hScnInterp);
 		hScnInterp = NULL;
 	}
+	if (g_profiler.Enabled()) {
+		LogProfilerSummary ();
+		g_profiler.Enable (false);
+	}
 
 	if (ConsoleManager::IsConsoleExclusive())
 		ConsoleManager::ShowConsole(false);
@@ -928,8 +990,10 @@ void Orbiter::CloseSession ()
 		if (g_pane) { delete g_pane;   g_pane = 0; }
 		if (pDlgMgr)  { delete pDlgMgr; pDlgMgr = 0; }
 		Instrument::GlobalExit (gclient);
+		preload.Finish ();   // if the session was aborted during the load
 		meshmanager.Flush(); // destroy buffered meshes
 		DestroyWorld ();     // destroy logical objects
+		vclassreg.Flush();   // release vessel class files and modules
 		if (gclient)
 			gclient->clbkDestroyRenderWindow (false); // destroy graphics objects
 
@@ -956,7 +1020,7 @@ void Orbiter::CloseSession ()
 		CloseApp (true);
 		if (pConfig->CfgDebugPrm.ShutdownMode == 2 || bFastExit) {
 			LOGOUT("**** Fast process shutdown\r\n");
-			exit (0); // just kill the process
+			exit (nExitCode); // just kill the process
 		} else {
 			LOGOUT("**** Respawning Orbiter process\r\n");
 			const char *name = "orbiter.exe";
@@ -995,6 +1059,7 @@ void Orbiter::BroadcastGlobalInit ()
 
 HRESULT Orbiter::Render3DEnvironment (bool hidedialogs)
 {
+	PROFILE_ZONE("Render");
 	if (gclient) {
 		if(!hidedialogs)
 			pDlgMgr->ImGuiNewFrame();
@@ -1028,6 +1093,7 @@ INT Orbiter::Run ()
     // Recieve and process Windows messages
     BOOL  bGotMsg, bCanRender, bpCanRender = TRUE;
     MSG   msg;
+	if (BatchRun()) return RunBatch ();
     PeekMessage (&msg, NULL, 0U, 0U, PM_NOREMOVE);
 
 	if (!pConfig->CfgCmdlinePrm.LaunchScenario.empty())
@@ -1085,6 +1151,34 @@ INT Orbiter::Run ()
     return msg.wParam;
 }
 
+//-----------------------------------------------------------------------------
+// Name: RunBatch()
+// Desc: Batch run loop. Steps the session without input processing or
+//       rendering, until it is terminated by a session limit or a script.
+//       The final state is saved and the process exits in CloseSession.
+//-----------------------------------------------------------------------------
+INT Orbiter::RunBatch ()
+{
+	const CFG_CMDLINEPRM &cmdprm = pConfig->CfgCmdlinePrm;
+	if (cmdprm.LaunchScenario.empty()) {
+		LOGOUT_ERR("Batch run requires a scenario (--scenario)");
+		return 1;
+	}
+	if (!cmdprm.FrameLimit && !cmdprm.MaxSysTime && !cmdprm.MaxSimTime)
+		LOGOUT_WARN("Batch run without session limit: runs until a script terminates the session");
+	if (cmdprm.FixedStep <= 0.0 && pConfig->CfgDebugPrm.FixedStep <= 0.0)
+		LOGOUT_WARN("Batch run without fixed step: time steps depend on the host speed");
+
+	Launch (cmdprm.LaunchScenario.c_str());
+	while (bSession) {
+		if (BeginTimeStep (bRunning)) {
+			UpdateWorld();
+			EndTimeStep (bRunning);
+		}
+	}
+	return nExitCode;
+}
+
 void Orbiter::SingleFrame ()
 {
 	if (bSession) {
@@ -1104,9 +1198,10 @@ void Orbiter::TerminateOnError ()
 {
 	LogOut (">>> TERMINATING <<<");
 	if (hRenderWnd) ShowWindow (hRenderWnd, FALSE);
-	MessageBox (NULL,
-		"Terminating after critical error. See Orbiter.log for details.",
-		"Orbiter: Critical Error", MB_OK | MB_ICONERROR);
+	if (!BatchRun())
+		MessageBox (NULL,
+			"Terminating after critical error. See Orbiter.log for details.",
+			"Orbiter: Critical Error", MB_OK | MB_ICONERROR);
 	exit (1);
 }
 
@@ -1216,6 +1311,7 @@ Vessel *Orbiter::SetFocusObject (Vessel *vessel, bool setview)
 
 	g_pfocusobj = g_focusobj;
 	g_focusobj = vessel;
+	g_psys->SyncVesselUpdates ();
 
 	// Inform pane about focus change
 	if (g_pane) g_pane->FocusChanged (g_focusobj);
@@ -1246,26 +1342,42 @@ void Orbiter::SetView (Body *body, int mode)
 }
 
 //-----------------------------------------------------------------------------
-// Name: InsertVessels
+// Name: InsertVessel
 // Desc: Insert a newly created vessel into the simulation
 //-----------------------------------------------------------------------------
 void Orbiter::InsertVessel (Vessel *vessel)
 {
-	g_psys->AddVessel (vessel);
+	std::vector<Vessel*> list (1, vessel);
+	InsertVessels (list);
+}
+
+//-----------------------------------------------------------------------------
+// Name: InsertVessels
+// Desc: Insert a batch of newly created vessels into the simulation
+//-----------------------------------------------------------------------------
+void Orbiter::InsertVessels (const std::vector<Vessel*> &list)
+{
+	if (list.empty()) return;
+	g_psys->AddVessels (list);
 
 	// broadcast vessel creation to plugins
-	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
-		it->pModule->clbkNewVessel((OBJHANDLE)vessel);
+	for (size_t i = 0; i < list.size(); i++) {
+		for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
+			it->pModule->clbkNewVessel((OBJHANDLE)list[i]);
 
-	if (gclient)
-		gclient->clbkNewVessel((OBJHANDLE)vessel);
+		if (gclient)
+			gclient->clbkNewVessel((OBJHANDLE)list[i]);
+	}
 
-	if (pDlgMgr) pDlgMgr->BroadcastMessage (MSG_CREATEVESSEL, vessel);
+	// one notification per batch to open dialogs
+	if (pDlgMgr) pDlgMgr->BroadcastMessage (MSG_CREATEVESSEL, list.back());
 	//if (gclient) gclient->clbkDialogBroadcast (MSG_CREATEVESSEL, vessel);
 
-	vessel->PostCreation();
-	vessel->InitSupervessel();
-	vessel->ModulePostCreation();
+	for (size_t i = 0; i < list.size(); i++) {
+		list[i]->PostCreation();
+		list[i]->InitSupervessel();
+		list[i]->ModulePostCreation();
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -1275,61 +1387,71 @@ void Orbiter::InsertVessel (Vessel *vessel)
 //-----------------------------------------------------------------------------
 bool Orbiter::KillVessels ()
 {
-	int i, n = g_psys->nVessel();
-	DWORD j;
-
-	for (i = n-1; i >= 0; i--) {
-		if (g_psys->GetVessel(i)->KillPending()) {
-			Vessel *vessel = g_psys->GetVessel(i);
-			// switch to new focus object
-			if (vessel == g_focusobj) {
-				if (vessel->ProxyVessel() && !vessel->ProxyVessel()->KillPending()) {
-					SetFocusObject (vessel->ProxyVessel(), false);
-				} else {
-					double d, dmin = 1e20;
-					Vessel *v, *tgt = 0;
-					for (j = 0; j < g_psys->nVessel(); j++) {
-						v = g_psys->GetVessel(j);
-						if (v->KillPending()) continue;
-						if (v != vessel && v->GetEnableFocus()) {
-							d = vessel->GPos().dist (v->GPos());
-							if (d < dmin) dmin = d, tgt = v;
-						}
-					}
-					if (tgt) SetFocusObject (tgt, false);
-					else return false; // no focus object available - give up
+	DWORD i, n = g_psys->nVessel();
+	std::vector<Vessel*> kill;
+
+	for (i = 0; i < n; i++)
+		if (g_psys->GetVessel(i)->KillPending())
+			kill.push_back (g_psys->GetVessel(i));
+	if (kill.empty()) return true;
+
+	// switch to new focus object
+	if (g_focusobj && g_focusobj->KillPending()) {
+		Vessel *vessel = g_focusobj;
+		if (vessel->ProxyVessel() && !vessel->ProxyVessel()->KillPending()) {
+			SetFocusObject (vessel->ProxyVessel(), false);
+		} else {
+			double d, dmin = 1e20;
+			Vessel *v, *tgt = 0;
+			for (i = 0; i < n; i++) {
+				v = g_psys->GetVessel(i);
+				if (v->KillPending()) continue;
+				if (v->GetEnableFocus()) {
+					d = vessel->GPos().dist (v->GPos());
+					if (d < dmin) dmin = d, tgt = v;
 				}
 			}
-			if (vessel == g_pfocusobj)
-				g_pfocusobj = 0; // clear previous focus (for Ctrl-F3 fast-switching)
-
-			// switch to new camera target
-			if (vessel == g_camera->Target())
-				SetView (g_focusobj, 1);
-
-			// broadcast vessel destruction to plugins
-			for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
-				it->pModule->clbkDeleteVessel((OBJHANDLE)vessel);
-
-			if (gclient)
-				gclient->clbkDeleteVessel((OBJHANDLE)vessel);
-			// broadcast vessel destruction to all vessels
-			g_psys->BroadcastVessel (MSG_KILLVESSEL, vessel);
-			// broadcast vessel destruction to all MFDs
-			if (g_pane) g_pane->DelVessel (vessel);
-			// broadcast vessel destruction to all open dialogs
-			//if (gclient) gclient->clbkDialogBroadcast (MSG_KILLVESSEL, vessel);
-			if (pDlgMgr) pDlgMgr->BroadcastMessage (MSG_KILLVESSEL, vessel);
-			// echo deletion on console window
-			if (m_pConsole) {
-				char cbuf[256];
-				sprintf (cbuf, "Vessel %s deleted", vessel->Name());
-				m_pConsole->Echo(cbuf);
-			}
-			// kill the vessel
-			g_psys->DelVessel (vessel);
+			if (tgt) SetFocusObject (tgt, false);
+			else return false; // no focus object available - give up
 		}
 	}
+	if (g_pfocusobj && g_pfocusobj->KillPending())
+		g_pfocusobj = 0; // clear previous focus (for Ctrl-F3 fast-switching)
+
+	// switch to new camera target
+	if (g_camera->Target() && g_camera->Target()->Type() == OBJTP_VESSEL && ((Vessel*)g_camera->Target())->KillPending())
+		SetView (g_focusobj, 1);
+
+	for (auto k = kill.rbegin(); k != kill.rend(); k++) {
+		Vessel *vessel = *k;
+		// broadcast vessel destruction to plugins
+		for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
+			it->pModule->clbkDeleteVessel((OBJHANDLE)vessel);
+
+		if (gclient)
+			gclient->clbkDeleteVessel((OBJHANDLE)vessel);
+		// broadcast vessel destruction to all MFDs
+		if (g_pane) g_pane->DelVessel (vessel);
+		// echo deletion on console window
+		if (m_pConsole) {
+			char cbuf[256];
+			sprintf (cbuf, "Vessel %s deleted", vessel->Name());
+			m_pConsole->Echo(cbuf);
+		}
+	}
+
+	// broadcast destruction of the batch to all vessels
+	std::vector<const Vessel*> sorted (kill.begin(), kill.end());
+	std::sort (sorted.begin(), sorted.end());
+	g_psys->BroadcastVessel (MSG_KILLVESSELS, &sorted);
+	// broadcast vessel destruction to all open dialogs. The message is posted,
+	// so the vessel pointer is no longer valid when it is received: one
+	// notification per batch is sufficient
+	//if (gclient) gclient->clbkDialogBroadcast (MSG_KILLVESSEL, vessel);
+	if (pDlgMgr) pDlgMgr->BroadcastMessage (MSG_KILLVESSEL, kill.back());
+
+	// kill the vessels
+	g_psys->DelVessels (kill);
 	return true;
 }
 
@@ -1448,6 +1570,7 @@ VOID Orbiter::IncFOV (double dfov)
 bool Orbiter::SaveScenario (const char *fname, const char *desc, int desc_type)
 {
 	pState->Update ();
+	g_psys->SyncVesselUpdates (); // continue as after loading the saved state
 
 	ofstream ofs (ScnPath (fname));
 	if (ofs) {
@@ -1813,6 +1936,9 @@ void Orbiter::EndTimeStep (bool running)
 	if (gclient) gclient->clbkUpdate (bRunning);
 	g_bForceUpdate = false;                        // clear flag
 
+	// close the profiler frame
+	g_profiler.EndFrame ();
+
 	// check for termination of demo mode
 	if (SessionLimitReached())
 		if (hRenderWnd) PostMessage(hRenderWnd, WM_CLOSE, 0, 0);
@@ -1932,10 +2058,13 @@ void Orbiter::UnregisterMenuCmd (int cmdId)
 void Orbiter::ModulePreStep ()
 {
 	// broadcast to modules
-	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
+	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++) {
+		PROFILE_ZONE_ID(it->zonePreStep);
 		it->pModule->clbkPreStep(td.SimT0, td.SimDT, td.MJD0);
+	}
 
 	// broadcast to vessels
+	PROFILE_ZONE("PreStep vessels");
 	for (DWORD i = 0; i < g_psys->nVessel(); i++)
 		g_psys->GetVessel(i)->ModulePreStep (td.SimT0, td.SimDT, td.MJD0);
 }
@@ -1947,12 +2076,32 @@ void Orbiter::ModulePreStep ()
 void Orbiter::ModulePostStep ()
 {
 	// broadcast to vessels
-	for (DWORD i = 0; i < g_psys->nVessel(); i++)
-		g_psys->GetVessel(i)->ModulePostStep (td.SimT1, td.SimDT, td.MJD1);
+	{
+		PROFILE_ZONE("PostStep vessels");
+		for (DWORD i = 0; i < g_psys->nVessel(); i++)
+			g_psys->GetVessel(i)->ModulePostStep (td.SimT1, td.SimDT, td.MJD1);
+	}
 
 	// broadcast to modules
-	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
+	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++) {
+		PROFILE_ZONE_ID(it->zonePostStep);
 		it->pModule->clbkPostStep(td.SimT1, td.SimDT, td.MJD1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name: LogProfilerSummary()
+// Desc: write the frame profiler zone summary of the session to the log
+//-----------------------------------------------------------------------------
+void Orbiter::LogProfilerSummary () const
+{
+	std::vector<Profiler::ZoneSummary> zone;
+	double tframe;
+	size_t nframe = g_profiler.Summary (zone, 0, &tframe);
+	if (!nframe) return;
+	LOGOUT("Frame profiler: last %zu frames, mean frame time %0.3f ms", nframe, tframe*1e3);
+	for (auto it = zone.begin(); it != zone.end(); it++)
+		LOGOUT("  %-32s mean %8.3f ms  max %8.3f ms  calls %8.1f", it->name.c_str(), it->t*1e3, it->tmax*1e3, it->count);
 }
 
 //-----------------------------------------------------------------------------
@@ -2718,7 +2867,8 @@ bool Orbiter::RegisterWindow (HINSTANCE hInstance, HWND hWnd, DWORD flag)
 
 void Orbiter::UpdateDeallocationProgress()
 {
-	m_pLaunchpad->UpdateWaitProgress();
+	if (m_pLaunchpad)
+		m_pLaunchpad->UpdateWaitProgress();
 }
 
 HWND Orbiter::OpenDialog (int id, DLGPROC pDlg, void *context)
@@ -11,6 +11,8 @@
 #include <stdio.h>
 #include <commctrl.h>
 #include "Mesh.h"
+#include "VesselClass.h"
+#include "Preload.h"
 #include "TimeData.h"
 #include <chrono>
 
@@ -26,6 +28,7 @@ class OrbiterConnect;
 class OrbiterServer;
 class OrbiterClient;
 class PlaybackEditor;
+class FRStream;
 class MemStat;
 class DDEServer;
 class ImageIO;
@@ -52,6 +55,7 @@ public:
 	Orbiter ();
 	~Orbiter ();
 
+    void LoadConfig ();
     HRESULT Create (HINSTANCE);
 	VOID Launch (const char *scenario);
 	void CloseApp (bool fast_shutdown = false);
@@ -74,6 +78,7 @@ public:
 	bool StickyFocus() const { return bKeepFocus; }
 	void OpenVideoTab() { bStartVideoTab = true; }
 	INT Run ();
+	INT RunBatch ();
 	void SingleFrame ();
     void Pause (bool bPause);
 	void Freeze (bool bFreeze);
@@ -131,8 +136,12 @@ public:
 	void InsertVessel (Vessel *vessel);
 	// Insert a newly created vessel into the simulation
 
+	void InsertVessels (const std::vector<Vessel*> &list);
+	// Insert a batch of newly created vessels into the simulation
+
 	bool KillVessels();
-	// Kill the vessels that have been marked for deletion in the last time step
+	// Kill the vessels that have been marked for deletion in the last time step.
+	// All pending vessels are removed as a single batch.
 
 	inline double ManCtrlLevel (THGROUP_TYPE thgt, DWORD device) const {
 		switch (device) {
@@ -170,6 +179,7 @@ public:
 	inline bool    IsRunning() const { return bRunning; }
 	inline bool    UseStencil() const { return bUseStencil; }
 	inline void    SetFastExit (bool fexit) { bFastExit = fexit; }
+	inline bool    BatchRun() const { return !pConfig->CfgCmdlinePrm.BatchScenario.empty(); }
 	inline bool    UseHtmlInline() { return (pConfig->CfgDebugPrm.bHtmlScnDesc == 1 || pConfig->CfgDebugPrm.bHtmlScnDesc == 2 && !bWINEenv); }
 
 	// DirectInput components
@@ -209,6 +219,7 @@ public:
 	// Flight recorder
 	char *FRsysname;             // system event playback name
 	std::ifstream *FRsys_stream; // system event playback file
+	FRStream *FRsys_ostream;     // system event recording stream
 	double frec_sys_simt;        // system event timer
 	PlaybackEditor *FReditor;    // playback editor instance
 	bool ToggleRecorder (bool force = false, bool append = false);
@@ -220,6 +231,8 @@ public:
 	// reset flight recorder status
 	bool FRecorder_PrepareDir (const char *fname, bool force);
 	// clear the flight recording directory
+	void FRecorder_Convert (const char *fname, bool binary);
+	// convert the position and attitude streams of recording fname to text or binary format
 	void FRecorder_Activate (bool active, const char *fname, bool append = false);
 	// activate the flight recorder
 	void FRecorder_SaveEvent (const char *event_type, const char *event);
@@ -265,6 +278,8 @@ public:
 	void UnregisterMenuCmd (int cmdId);
 
 	MeshManager     meshmanager;    // global mesh manager
+	VesselClassRegistry vclassreg;  // vessel class files and modules shared by vessel instances
+	ScenarioPreload preload;        // scenario load pipeline
 
 	// Load a mesh from file, and store it persistently in the mesh manager
 	const Mesh *LoadMeshGlobal (const char *fname);
@@ -345,6 +360,9 @@ protected:
 	void ModulePostStep ();
 	VOID UpdateWorld ();
 
+	void LogProfilerSummary () const;
+	// Write the frame profiler zone summary to the log
+
 	void IncWarpFactor ();
 	void DecWarpFactor ();
 	// Increment/decrement time acceleration factor to next power of 10
@@ -403,6 +421,7 @@ private:
 	bool            bPlayback;     // true if flight is being played back
 	bool            bCapture;      // capturing frame sequence is active
 	bool            bFastExit;     // terminate on simulation end?
+	int             nExitCode;     // process exit code on fast exit (batch runs: nonzero if the final state could not be saved)
 	bool            bSysClearType; // is cleartype enabled on the user's system?
 	bool            bRoughType;    // font-smoothing disabled?
 
@@ -419,6 +438,8 @@ private:
 		oapi::Module* pModule; // pointer to module instance, if the plugin registered one
 		std::string sName;     // DLL name
 		bool bLocalAlloc;      // locally allocated; should be freed by Orbiter core
+		int zonePreStep;       // frame profiler zone of the clbkPreStep call
+		int zonePostStep;      // frame profiler zone of the clbkPostStep call
 	};
 	std::list<DLLModule> m_Plugin;
 
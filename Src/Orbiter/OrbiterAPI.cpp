@@ -15,6 +15,7 @@
 #include "Select.h"
 #include "DlgMgr.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include "cmdline.h"
 #include "Script.h"
 #include "Util.h"
@@ -23,6 +24,7 @@
 #include "resource.h"
 #include "Mesh.h"
 #include "MenuInfoBar.h"
+#include "Profiler.h"
 #include <zlib.h>
 #include "DrawAPI.h"
 
@@ -107,8 +109,6 @@ DLLEXPORT DWORD oapiGetObjectCount ()
 
 DLLEXPORT int oapiGetObjectType (OBJHANDLE hObj)
 {
-	int i;
-
 	Body *body = (Body*)hObj;
 
 	// Try for celestial body
@@ -131,12 +131,10 @@ DLLEXPORT int oapiGetObjectType (OBJHANDLE hObj)
 	}
 	if (base) return body->Type();
 
-	// Try for vessel. Here we go through the list of current
+	// Try for vessel. Here we check the list of current
 	// vessels, to avoid deleted vessels (which may still cast ok)
-	for (i = 0; i < g_psys->nVessel(); i++) {
-		if (body == g_psys->GetVessel(i))
-			return body->Type();
-	}
+	if (g_psys->isVessel ((Vessel*)body))
+		return body->Type();
 
 	return OBJTP_INVALID;
 }
@@ -318,6 +316,28 @@ DLLEXPORT bool oapiDeleteVessel (OBJHANDLE hVessel, OBJHANDLE hAlternativeCamera
 	return true;
 }
 
+DLLEXPORT DWORD oapiCreateVessels (DWORD n, const char *const *name, const char *const *classname, const void *const *status, OBJHANDLE *hVessel)
+{
+	std::vector<Vessel*> list (n);
+	for (DWORD i = 0; i < n; i++) {
+		list[i] = new Vessel (g_psys, name[i], classname[i], status[i]); TRACENEW
+		hVessel[i] = (OBJHANDLE)list[i];
+	}
+	g_pOrbiter->InsertVessels (list);
+	return n;
+}
+
+DLLEXPORT DWORD oapiDeleteVessels (DWORD n, const OBJHANDLE *hVessel)
+{
+	DWORD ndel = 0;
+	for (DWORD i = 0; i < n; i++) {
+		if (!g_psys->isVessel ((Vessel*)hVessel[i])) continue;
+		((Vessel*)hVessel[i])->RequestDestruct();
+		ndel++;
+	}
+	return ndel;
+}
+
 DLLEXPORT double oapiGetSize (OBJHANDLE hObj)
 {
 	return ((Body*)hObj)->Size();
@@ -1011,6 +1031,24 @@ DLLEXPORT double oapiGetFrameRate ()
 	return td.FPS();
 }
 
+DLLEXPORT DWORD oapiGetProfilerSummary (PROFILERZONE *zone, DWORD nzone, DWORD nframe)
+{
+	std::vector<Profiler::ZoneSummary> zs;
+	g_profiler.Summary (zs, nframe);
+	for (DWORD i = 0; zone && i < nzone && i < zs.size(); i++) {
+		zone[i].name  = g_profiler.ZoneName (zs[i].id);
+		zone[i].t     = zs[i].t;
+		zone[i].tmax  = zs[i].tmax;
+		zone[i].count = zs[i].count;
+	}
+	return (DWORD)zs.size();
+}
+
+DLLEXPORT bool oapiProfilerCapture (const char *fname, DWORD nframe)
+{
+	return g_profiler.StartCapture (fname, nframe);
+}
+
 DLLEXPORT double oapiTime2MJD (double t)
 {
 	return td.MJD_ref + Day(t);
@@ -2126,16 +2164,19 @@ DLLEXPORT bool oapiAcceptDelayedKey (char key, double interval)
 
 DLLEXPORT LAUNCHPADITEM_HANDLE oapiRegisterLaunchpadItem (LaunchpadItem *item, LAUNCHPADITEM_HANDLE parent)
 {
+	if (!g_pOrbiter->Launchpad()) return NULL; // batch run
 	return (LAUNCHPADITEM_HANDLE)g_pOrbiter->Launchpad()->RegisterExtraParam (item, (HTREEITEM)parent);
 }
 
 DLLEXPORT bool oapiUnregisterLaunchpadItem (LaunchpadItem *item)
 {
+	if (!g_pOrbiter->Launchpad()) return false;
 	return g_pOrbiter->Launchpad()->UnregisterExtraParam (item);
 }
 
 DLLEXPORT LAUNCHPADITEM_HANDLE oapiFindLaunchpadItem (const char *name, LAUNCHPADITEM_HANDLE parent)
 {
+	if (!g_pOrbiter->Launchpad()) return NULL;
 	return g_pOrbiter->Launchpad()->FindExtraParam (name, (HTREEITEM)parent);
 }
 
@@ -2287,10 +2328,12 @@ DLLEXPORT FILEHANDLE oapiOpenFile (const char *fname, FileAccessMode mode, PathR
 	}
 
 	switch (mode) {
-	case FILE_IN:
-		return (FILEHANDLE)(new ifstream (cbuf));
+	case FILE_IN: {
+		CfgFile *ifs = new CfgFile (cbuf); TRACENEW
+		return (FILEHANDLE)ifs;
+		}
 	case FILE_IN_ZEROONFAIL: {
-		ifstream *ifs = new ifstream (cbuf);
+		CfgFile *ifs = new CfgFile (cbuf); TRACENEW
 		if (ifs->fail()) {
 			delete ifs;
 			ifs = 0;
@@ -2311,7 +2354,7 @@ DLLEXPORT void oapiCloseFile (FILEHANDLE file, FileAccessMode mode)
 		switch (mode) {
 		case FILE_IN:
 		case FILE_IN_ZEROONFAIL:
-			delete (ifstream*)file;
+			delete (CfgFile*)file;
 			break;
 		case FILE_OUT:
 		case FILE_APP:
@@ -23,6 +23,7 @@
 #define MSG_CREATEVESSEL  0x1002
 #define MSG_PAUSE         0x1003
 #define MSG_FOCUSVESSEL   0x1004
+#define MSG_KILLVESSELS   0x1005 // data: address-sorted std::vector<const Vessel*>
 
 // =======================================================================
 // forward declarations
@@ -24,7 +24,7 @@
 #include <cmath>
 #include "Vecmat.h"
 #include "PinesGrav.h"
-#include "Orbiter.h"
+#include <cstdio>
 
 PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 {
@@ -39,72 +39,125 @@ PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 	referenceLon = 0.0;
 	C = NULL;
 	S = NULL;
-	A = NULL;
-	R = NULL;
-	I = NULL;
+	ALPHA = NULL;
+	BETA = NULL;
+	DIAG = NULL;
+	OFFD = NULL;
+	GALPHA = NULL;
 	numCoeff = 0;
 	CoeffCutoff = 0;
-
-	r = 0.0;
-	s = 0.0;
-	t = 0.0;
-	u = 0.0;
-	rho = 0.0;
-	rhop = 0.0;
-
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
 }
 
 PinesGravProp::~PinesGravProp()
 {
 	delete[] C;
 	delete[] S;
-	delete[] A;
-	delete[] R;
-	delete[] I;
+	delete[] ALPHA;
+	delete[] BETA;
+	delete[] DIAG;
+	delete[] OFFD;
+	delete[] GALPHA;
 }
 
-inline void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree)
+void PinesGravProp::GenerateRecursionCoeffs(int maxDegree)
 {
-	A[0] = sqrt(2.0);
-
 	for (int m = 0; m <= (maxDegree + 2); m++) {
 
-		if (m != 0) {
-			A[NM(m, m)] = sqrt(1. + (1. / (2. * (double)m))) * A[NM(m - 1, m - 1)]; // diagonal terms
-		}
-
-		if (m != (maxDegree + 2)) {
-			A[NM(m + 1, m)] = sqrt(2. * (double)m + 3.) * u * A[NM(m, m)]; // off-diagonal terms
-		}
+		DIAG[m] = (m ? sqrt(1. + (1. / (2. * (double)m))) : 0.0);
+		OFFD[m] = sqrt(2. * (double)m + 3.);
 
-		if (m < maxDegree + 1) {
-			for (int n = m + 2; n <= (maxDegree + 2); n++) {
+		for (int n = m; n <= (maxDegree + 2); n++) {
+			if (n >= m + 2) {
 				double ALPHA_NUM = (2. * (double)n + 1.) * (2. * (double)n - 1.);
 				double ALPHA_DEN = ((double)n - (double)m) * ((double)n + (double)m);
-				double ALPHA = sqrt(ALPHA_NUM / ALPHA_DEN);
 				double BETA_NUM = (2. * (double)n + 1.) * ((double)n - (double)m - 1.) * ((double)n + (double)m - 1.);
 				double BETA_DEN = (2. * (double)n - 3.) * ((double)n + (double)m) * ((double)n - (double)m);
-				double BETA = sqrt(BETA_NUM / BETA_DEN);
-
-
-				A[NM(n, m)] = ALPHA * u * A[NM(n - 1, m)] - BETA * A[NM(n - 2, m)]; // remaining terms in the column
+				ALPHA[NM(n, m)] = sqrt(ALPHA_NUM / ALPHA_DEN);
+				BETA[NM(n, m)] = sqrt(BETA_NUM / BETA_DEN);
 			}
+			else {
+				ALPHA[NM(n, m)] = 0.0;
+				BETA[NM(n, m)] = 0.0;
+			}
+			double SM = (m == 0 ? 0.5 : 1.0);
+			GALPHA[NM(n, m)] = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
 		}
 	}
+}
+
+void PinesGravWorkspace::Reserve(unsigned int cutoff, unsigned int lanes)
+{
+	size_t nA = (((size_t)(cutoff + 3) * (cutoff + 3) + (cutoff + 3)) / 2 + cutoff + 3) * lanes;
+	if (A.size() < nA) {
+		A.resize(nA);
+		R.resize(((size_t)cutoff + 2) * lanes);
+		I.resize(((size_t)cutoff + 2) * lanes);
+	}
+}
+
+inline void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree, double u, double* __restrict A) const
+{
+	// Generated row by row: the remaining terms of row n only depend on
+	// rows n-1 and n-2, so the inner loop runs over contiguous memory.
+
+	const int nmax = maxDegree + 2;
+	A[0] = sqrt(2.0);
+
+	for (int n = 1; n <= nmax; n++) {
+		double* __restrict An = A + NM(n, 0);
+		const double* __restrict An1 = A + NM(n - 1, 0);
+		const double* __restrict An2 = A + NM(n - 2 >= 0 ? n - 2 : 0, 0);
+		const double* __restrict ALPHAn = ALPHA + NM(n, 0);
+		const double* __restrict BETAn = BETA + NM(n, 0);
+
+		for (int m = 0; m <= n - 2; m++)
+			An[m] = ALPHAn[m] * u * An1[m] - BETAn[m] * An2[m]; // remaining terms in the column
+
+		An[n - 1] = OFFD[n - 1] * u * An1[n - 1]; // off-diagonal terms
+		An[n] = DIAG[n] * An1[n - 1];             // diagonal terms
+	}
+
+	const double sqrt05 = sqrt(0.5);
+	for (int n = 0; n <= nmax; n++) {
+		A[NM(n, 0)] = A[NM(n, 0)] * sqrt05;
+	}
+
+}
+
+inline void PinesGravProp::GenerateAssocLegendreLanes(int maxDegree, const double* u, double* __restrict A) const
+{
+	// As GenerateAssocLegendreMatrix, for NLANE values of u at once. Each
+	// recursion coefficient is loaded once and applied to all lanes.
+
+	const int L = NLANE;
+	const int nmax = maxDegree + 2;
+	for (int k = 0; k < L; k++)
+		A[k] = sqrt(2.0);
+
+	for (int n = 1; n <= nmax; n++) {
+		double* __restrict An = A + NM(n, 0) * L;
+		const double* __restrict An1 = A + NM(n - 1, 0) * L;
+		const double* __restrict An2 = A + NM(n - 2 >= 0 ? n - 2 : 0, 0) * L;
+		const double* __restrict ALPHAn = ALPHA + NM(n, 0);
+		const double* __restrict BETAn = BETA + NM(n, 0);
+
+		for (int m = 0; m <= n - 2; m++) {
+			const double alpha = ALPHAn[m], beta = BETAn[m];
+			for (int k = 0; k < L; k++)
+				An[m * L + k] = alpha * u[k] * An1[m * L + k] - beta * An2[m * L + k];
+		}
 
-	for (int n = 0; n <= (maxDegree + 2); n++) {
-		A[NM(n, 0)] = A[NM(n, 0)] * sqrt(0.5);
+		const double offd = OFFD[n - 1], diag = DIAG[n];
+		for (int k = 0; k < L; k++) {
+			An[(n - 1) * L + k] = offd * u[k] * An1[(n - 1) * L + k];
+			An[n * L + k] = diag * An1[(n - 1) * L + k];
+		}
 	}
 
+	const double sqrt05 = sqrt(0.5);
+	for (int n = 0; n <= nmax; n++)
+		for (int k = 0; k < L; k++)
+			A[NM(n, 0) * L + k] = A[NM(n, 0) * L + k] * sqrt05;
 }
 
 int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTerms, int &maxModelTerms)
@@ -120,15 +173,19 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	try {
 		C = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
 		S = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
-		R = new double[(size_t)cutoff + 2];
-		I = new double[(size_t)cutoff + 2];
-		A = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		ALPHA = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		BETA = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		GALPHA = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		DIAG = new double[(size_t)cutoff + 3];
+		OFFD = new double[(size_t)cutoff + 3];
 	}
 	catch (std::bad_alloc) {
 		return 2; //Could not allocate space
 	}
 	numCoeff = 0;
 
+	GenerateRecursionCoeffs(cutoff);
+
 	C[0] = 0;	//This needs to be 0 unless you want the point-mass gravity as well.
 	S[0] = 0; 
 
@@ -182,15 +239,20 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	}
 }
 
-Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder)
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder, PinesGravWorkspace& ws) const
 {
-	r = rpos.length();
-	s = rpos.x / r;
-	t = rpos.y / r;
-	u = rpos.z / r;
+	ws.Reserve(CoeffCutoff);
+	double* __restrict A = ws.A.data();
+	double* __restrict R = ws.R.data();
+	double* __restrict I = ws.I.data();
 
-	rho = GM / (r * refRad);
-	rhop = refRad / r;
+	double r = rpos.length();
+	double s = rpos.x / r;
+	double t = rpos.y / r;
+	double u = rpos.z / r;
+
+	double rho = GM / (r * refRad);
+	double rhop = refRad / r;
 
 	R[0] = 0.0;
 	I[0] = 0.0;
@@ -202,48 +264,40 @@ Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const
 		I[m] = s * I[m - 1] + t * R[m - 1];
 	}
 
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
+	double g1 = 0.0;
+	double g2 = 0.0;
+	double g3 = 0.0;
+	double g4 = 0.0;
 
 	int nmodel = 0;
-	GenerateAssocLegendreMatrix(maxDegree);
+	GenerateAssocLegendreMatrix(maxDegree, u, A);
 	for (int n = 0; n <= maxDegree; n++) {
 
-		g1temp = 0.0;
-		g2temp = 0.0;
-		g3temp = 0.0;
-		g4temp = 0.0;
-
-		double SM = 0.5;
+		double g1temp = 0.0;
+		double g2temp = 0.0;
+		double g3temp = 0.0;
+		double g4temp = 0.0;
 
 		if (n > maxOrder)
 			nmodel = maxOrder;
 		else
 			nmodel = n;
 
+		const double* __restrict Cn = C + NM(n, 0);
+		const double* __restrict Sn = S + NM(n, 0);
+		const double* __restrict An = A + NM(n, 0);
+		const double* __restrict GALPHAn = GALPHA + NM(n, 0);
 
 		for (int m = 0; m <= nmodel; m++) {
 
-			double D = C[NM(n, m)] * R[m + 1] + S[NM(n, m)] * I[m + 1];
-			double E = C[NM(n, m)] * R[m] + S[NM(n, m)] * I[m];
-			double F = S[NM(n, m)] * R[m] - C[NM(n, m)] * I[m];
-
-
-			double ALPHA = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
-
-			g1temp = g1temp + A[NM(n, m)] * (double)m * E;
-			g2temp = g2temp + A[NM(n, m)] * (double)m * F;
-			g3temp = g3temp + ALPHA * A[NM(n, m + 1)] * D;
-			g4temp = g4temp + (((double)n + (double)m + 1) * A[NM(n, m)] + ALPHA * u * A[NM(n, m + 1)]) * D;
+			double D = Cn[m] * R[m + 1] + Sn[m] * I[m + 1];
+			double E = Cn[m] * R[m] + Sn[m] * I[m];
+			double F = Sn[m] * R[m] - Cn[m] * I[m];
 
-			if (m == 0) { SM = 1.0; ; }
+			g1temp = g1temp + An[m] * (double)m * E;
+			g2temp = g2temp + An[m] * (double)m * F;
+			g3temp = g3temp + GALPHAn[m] * An[m + 1] * D;
+			g4temp = g4temp + (((double)n + (double)m + 1) * An[m] + GALPHAn[m] * u * An[m + 1]) * D;
 		}
 		rho = rhop * rho;
 
@@ -261,4 +315,109 @@ Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const
 	gperturbed.z = (g3 - g4 * u);
 
 	return gperturbed;
-}
\ No newline at end of file
+}
+
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const
+{
+	static thread_local PinesGravWorkspace ws;
+	return GetPinesGrav(rpos, maxDegree, maxOrder, ws);
+}
+
+void PinesGravProp::GetPinesGrav(int npos, const Vector* rpos, Vector* gperturbed, const int maxDegree, const int maxOrder, PinesGravWorkspace& ws) const
+{
+	const int L = NLANE;
+	ws.Reserve(CoeffCutoff, L);
+	double* __restrict A = ws.A.data();
+	double* __restrict R = ws.R.data();
+	double* __restrict I = ws.I.data();
+
+	for (int i0 = 0; i0 < npos; i0 += L) {
+		const int nb = (npos - i0 < L ? npos - i0 : L);
+
+		double s[L], t[L], u[L], rho[L], rhop[L];
+		double g1[L], g2[L], g3[L], g4[L];
+
+		for (int k = 0; k < L; k++) {
+			const Vector& p = rpos[i0 + (k < nb ? k : nb - 1)]; // the last group is padded
+			double r = p.length();
+			s[k] = p.x / r;
+			t[k] = p.y / r;
+			u[k] = p.z / r;
+			rho[k] = GM / (r * refRad);
+			rhop[k] = refRad / r;
+			R[k] = 0.0;
+			I[k] = 0.0;
+			R[L + k] = 1.0;
+			I[L + k] = 0.0;
+			g1[k] = g2[k] = g3[k] = g4[k] = 0.0;
+		}
+
+		for (int m = 2; m <= maxOrder + 1; m++) {
+			double* __restrict Rm = R + m * L;
+			double* __restrict Im = I + m * L;
+			const double* __restrict Rm1 = Rm - L;
+			const double* __restrict Im1 = Im - L;
+			for (int k = 0; k < L; k++) {
+				Rm[k] = s[k] * Rm1[k] - t[k] * Im1[k];
+				Im[k] = s[k] * Im1[k] + t[k] * Rm1[k];
+			}
+		}
+
+		int nmodel = 0;
+		GenerateAssocLegendreLanes(maxDegree, u, A);
+		for (int n = 0; n <= maxDegree; n++) {
+
+			double g1temp[L], g2temp[L], g3temp[L], g4temp[L];
+			for (int k = 0; k < L; k++)
+				g1temp[k] = g2temp[k] = g3temp[k] = g4temp[k] = 0.0;
+
+			if (n > maxOrder)
+				nmodel = maxOrder;
+			else
+				nmodel = n;
+
+			const double* __restrict Cn = C + NM(n, 0);
+			const double* __restrict Sn = S + NM(n, 0);
+			const double* __restrict An = A + NM(n, 0) * L;
+			const double* __restrict GALPHAn = GALPHA + NM(n, 0);
+
+			for (int m = 0; m <= nmodel; m++) {
+				const double c = Cn[m], sn = Sn[m], galpha = GALPHAn[m];
+				const double dm = (double)m, nm1 = (double)n + (double)m + 1;
+				const double* __restrict Am = An + m * L;
+				const double* __restrict Am1 = Am + L;
+				const double* __restrict Rm = R + m * L;
+				const double* __restrict Im = I + m * L;
+				const double* __restrict Rm1 = Rm + L;
+				const double* __restrict Im1 = Im + L;
+
+				for (int k = 0; k < L; k++) {
+					double D = c * Rm1[k] + sn * Im1[k];
+					double E = c * Rm[k] + sn * Im[k];
+					double F = sn * Rm[k] - c * Im[k];
+
+					g1temp[k] = g1temp[k] + Am[k] * dm * E;
+					g2temp[k] = g2temp[k] + Am[k] * dm * F;
+					g3temp[k] = g3temp[k] + galpha * Am1[k] * D;
+					g4temp[k] = g4temp[k] + (nm1 * Am[k] + galpha * u[k] * Am1[k]) * D;
+				}
+			}
+
+			for (int k = 0; k < L; k++) {
+				rho[k] = rhop[k] * rho[k];
+
+				g1[k] = g1[k] + rho[k] * g1temp[k];
+				g2[k] = g2[k] + rho[k] * g2temp[k];
+				g3[k] = g3[k] + rho[k] * g3temp[k];
+				g4[k] = g4[k] + rho[k] * g4temp[k];
+			}
+		}
+
+		for (int k = 0; k < nb; k++) {
+			Vector& g = gperturbed[i0 + k];
+			g.x = (g1[k] - g4[k] * s[k]);
+			g.y = (g2[k] - g4[k] * t[k]);
+			g.z = (g3[k] - g4[k] * u[k]);
+		}
+	}
+}
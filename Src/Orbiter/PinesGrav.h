@@ -21,19 +21,54 @@
 
 #ifndef __PINESGRAV_H
 #define __PINESGRAV_H
+#include <vector>
 class CelestialBody;
 
+// Per-caller scratch memory for evaluating a PinesGravProp model. The model
+// itself is immutable after loading and can be shared between threads, as
+// long as each thread uses its own workspace.
+class PinesGravWorkspace
+{
+	friend class PinesGravProp;
+public:
+	PinesGravWorkspace() {}
+private:
+	void Reserve(unsigned int cutoff, unsigned int lanes = 1);
+	std::vector<double> A; // associated Legendre functions
+	std::vector<double> R; // real part of (s+it)^m
+	std::vector<double> I; // imaginary part of (s+it)^m
+	// For batch evaluations, each entry holds one value per lane, i.e.
+	// A[j*NLANE+k] is element j of lane k.
+};
+
 class PinesGravProp
 {
 public:
 	PinesGravProp(CelestialBody* celestialbody);
 	~PinesGravProp();
 	int readGravModel(char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms);
-	Vector GetPinesGrav(const Vector rposmax, const int maxDegree, const int maxOrder);
+
+	// Evaluate the field using the caller's workspace. Thread-safe.
+	Vector GetPinesGrav(const Vector rposmax, const int maxDegree, const int maxOrder, PinesGravWorkspace& ws) const;
+
+	// As above, using a workspace local to the calling thread.
+	Vector GetPinesGrav(const Vector rposmax, const int maxDegree, const int maxOrder) const;
+
+	// Evaluate the field at npos positions rpos, returning the results in
+	// gperturbed. The positions are processed in groups of NLANE, with the
+	// lanes interleaved through the Legendre recursion and the harmonic sum,
+	// so that each row of coefficients is loaded once per group. The
+	// operations per lane are those of the single-point call. Thread-safe.
+	void GetPinesGrav(int npos, const Vector* rpos, Vector* gperturbed, const int maxDegree, const int maxOrder, PinesGravWorkspace& ws) const;
+
+	static const int NLANE = 4; // positions per group in the batch evaluation
+
 	inline unsigned int GetCoeffCutoff() const { return CoeffCutoff; }
 private:
 	CelestialBody* parentBody;
-	inline void GenerateAssocLegendreMatrix(int maxDegree);
+	inline void GenerateAssocLegendreMatrix(int maxDegree, double u, double* __restrict A) const;
+	inline void GenerateAssocLegendreLanes(int maxDegree, const double* u, double* __restrict A) const;
+	void GenerateRecursionCoeffs(int maxDegree);
 
 	static inline unsigned int NM(unsigned int n, unsigned int m) { return (n * n + n) / 2 + m; }
 
@@ -47,23 +82,15 @@ private:
 	double referenceLon;
 	double* __restrict C;
 	double* __restrict S;
-	double* __restrict A;
-	double* __restrict R;
-	double* __restrict I;
 	unsigned long int numCoeff;
 
-	double r, s, t, u;
-	double rho, rhop;
-
-	double g1temp;
-	double g2temp;
-	double g3temp;
-	double g4temp;
-
-	double g1;
-	double g2;
-	double g3;
-	double g4;
+	// Recursion coefficients, depending only on degree and order. Tabulated
+	// once when the model is loaded, indexed like A.
+	double* __restrict ALPHA;  // column recursion: A(n,m) = ALPHA*u*A(n-1,m) - BETA*A(n-2,m)
+	double* __restrict BETA;
+	double* __restrict DIAG;   // diagonal terms: A(m,m) = DIAG[m]*A(m-1,m-1)
+	double* __restrict OFFD;   // off-diagonal terms: A(m+1,m) = OFFD[m]*u*A(m,m)
+	double* __restrict GALPHA; // acceleration sum factor sqrt(SM*(n-m)*(n+m+1))
 };
 
-#endif
\ No newline at end of file
+#endif
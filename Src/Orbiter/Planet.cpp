@@ -10,6 +10,7 @@
 #include <string.h>
 #include "Orbiter.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include "State.h"
 #include "Astro.h"
 #include "Element.h"
@@ -150,7 +151,7 @@ inline DWORD oapi_rand()
 bool Planet::bEnableWind = true;
 
 Planet::Planet (double _mass, double _mean_radius)
-: CelestialBody (_mass, _mean_radius)
+: CelestialBody (_mass, _mean_radius), baseindex(1e6)
 {
 	psys         = 0;
 	ncloudtex    = 0;
@@ -190,7 +191,7 @@ Planet::Planet (double _mass, double _mean_radius)
 }
 
 Planet::Planet (char *fname)
-: CelestialBody (fname)
+: CelestialBody (fname), baseindex(1e6)
 {
 	int i, n;
 	double d;
@@ -215,7 +216,8 @@ Planet::Planet (char *fname)
 	maxelev = 0.0;
 	labelLegend  = NULL;
 	nLabelLegend = 0;
-	ifstream ifs (g_pOrbiter->ConfigPath (fname));
+	CfgFile ifs;
+	g_pOrbiter->preload.OpenConfig (ifs, g_pOrbiter->ConfigPath (fname));
 	if (!ifs) return;
 
 	AtmInterface = 0;
@@ -521,9 +523,21 @@ bool Planet::AddBase (Base *base)
 	}
 	baselist = tmp;
 	baselist[nbase++] = base;
+	baseindex.Insert (base, base->LocalPos());
 	return true;
 }
 
+size_t Planet::BasesInRange (const Vector &gpos, double range, std::vector<Base*> &list) const
+{
+	static thread_local std::vector<const void*> obj;
+	obj.clear();
+	baseindex.Query (tmul (s0->R, gpos - s0->pos), range, obj);
+	list.clear();
+	for (auto it = obj.begin(); it != obj.end(); it++)
+		list.push_back ((Base*)*it);
+	return list.size();
+}
+
 void Planet::ScanLabelLists (ifstream &cfg)
 {
 	int i;
@@ -668,6 +682,11 @@ void Planet::Setup ()
 		emgr = new ElevationManager(this);
 	for (DWORD i = 0; i < nbase; i++)
 		baselist[i]->Setup();
+
+	// base positions include the surface elevation now
+	baseindex.Clear();
+	for (DWORD i = 0; i < nbase; i++)
+		baseindex.Insert (baselist[i], baselist[i]->LocalPos());
 }
 
 const void *Planet::GetParam (DWORD paramtype) const
@@ -19,6 +19,7 @@
 
 #include "Celbody.h"
 #include "Nav.h"
+#include "SpatialIndex.h"
 #include "GraphicsAPI.h"
 #include "Orbiter.h"
 #include <functional>
@@ -115,6 +116,10 @@ public:
 	const Base *GetBase (const char *_name, bool ignorecase = false) const;
 	// return base 'name' or 0 if doesn't exist
 
+	size_t BasesInRange (const Vector &gpos, double range, std::vector<Base*> &list) const;
+	// Fill list with the planet's surface bases within distance range of
+	// global position gpos. Returns the number of bases found.
+
 	void ScanBases (char *path);
 	// create surface bases by scanning config files in directory 'path'
 
@@ -269,6 +274,9 @@ private:
 	Base **baselist;
 	// list of surface bases
 
+	SpatialIndex baseindex;
+	// spatial index of the surface bases in the local planet frame
+
 	int nnav;
 	NavManager navlist;
 	// list of nav transmitters
@@ -0,0 +1,63 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// PosInterpolant.cpp
+// Interpolation of celestial body positions within a time step
+// =======================================================================
+
+#include "PosInterpolant.h"
+#include <math.h>
+
+// =======================================================================
+
+void PosInterpolant::Setup (const Vector &rp0, const Vector &rv0, const Vector &rp1, const Vector &rv1, double h)
+{
+	const double max_arc = 0.1; // max. angle swept per step for cubic interpolation [rad]
+
+	double r0 = rp0.length();
+	cubic = (h > 0.0 && r0 > 0.0 && rv0.length()*h < max_arc*r0);
+	if (cubic) {
+		Vector dp (rp1-rp0), v0 (rv0*h), v1 (rv1*h);
+		c[0] = rp0;
+		c[1] = v0;
+		c[2] = dp*3.0 - v0*2.0 - v1;
+		c[3] = v0 + v1 - dp*2.0;
+	}
+}
+
+// =======================================================================
+
+Vector PosInterpolant::Bisect (Vector rp0, Vector rp1, double n)
+{
+	const double eps = 1e-2;
+	double rd0 = rp0.length();         // radius at current step
+	double rd1 = rp1.length();         // radius at next step
+	double n0 = 0.0;                   // lower bound of search bracket
+	double n1 = 1.0;                   // upper bound of search bracket
+	double nm = 0.5, d = 0.5;          // current trial point
+	double rdm = (rd0+rd1)*0.5;        // trial radius
+	Vector rpm = (rp0+rp1).unit()*rdm; // trial position
+	while (fabs (nm-n) > eps && d > eps) { // interval too large - continue
+		d *= 0.5;                         // new interval width
+		if (nm < n) {                     // cut away lower half of interval
+			rp0 = rpm;
+			rd0 = rdm;
+			n0  = nm;
+			nm += d;
+		} else {                          // cut away upper half of interval
+			rp1 = rpm;
+			rd1 = rdm;
+			n1  = nm;
+			nm -= d;
+		}
+		rdm = (rd0+rd1)*0.5;              // new trial radius
+		rpm = (rp0+rp1).unit()*rdm;       // new trial position
+	}
+	if (fabs (nm-n) > 1e-10) {        // linear interpolation of remaining step
+		double scale = (n-n0)/(n1-n0);
+		rdm = rd0 + (rd1-rd0)*scale;
+		rpm = (rp0 + (rp1-rp0)*scale).unit() * rdm;
+	}
+	return rpm;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// PosInterpolant.h
+// Interpolation of a celestial body position relative to its element
+// reference within a time step, from the states at both ends of the step.
+// The cubic Hermite interpolant is set up once per step. For bodies that
+// sweep a large arc within the step, and before the interpolant has been
+// set up for the current step, positions are found by iterative bisection
+// of direction and radius.
+// =======================================================================
+
+#ifndef __POSINTERPOLANT_H
+#define __POSINTERPOLANT_H
+
+#include "Vecmat.h"
+
+class PosInterpolant {
+public:
+	PosInterpolant (): cubic(false) {}
+
+	void Setup (const Vector &rp0, const Vector &rv0, const Vector &rp1, const Vector &rv1, double h);
+	// Set up the cubic interpolant from the relative positions rp and
+	// velocities rv at the start (0) and end (1) of a step of length h [s].
+	// If the arc swept in the step is too large, the interpolant is left
+	// invalid.
+
+	inline void Invalidate () { cubic = false; }
+	// Discard the interpolant (the step states are about to change)
+
+	inline bool Cubic () const { return cubic; }
+	// Is the cubic interpolant valid for the current step?
+
+	inline const Vector *Coeffs () const { return c; }
+	// Coefficients c[0..3] of the cubic interpolant in powers of n
+
+	inline Vector Eval (double n) const { return c[0] + (c[1] + (c[2] + c[3]*n)*n)*n; }
+	// Evaluate the cubic interpolant at fractional step n [0..1]. Only
+	// valid if Cubic() is true.
+
+	static Vector Bisect (Vector rp0, Vector rp1, double n);
+	// Position at fractional step n [0..1] by iterative bisection between
+	// relative positions rp0 and rp1 at the start and end of the step.
+
+private:
+	Vector c[4]; // cubic Hermite coefficients
+	bool cubic;  // c is valid for the current step
+};
+
+#endif // !__POSINTERPOLANT_H
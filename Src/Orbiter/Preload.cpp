@@ -0,0 +1,364 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Preload.cpp
+// Scenario load pipeline
+// =======================================================================
+
+#include "Preload.h"
+#include "Config.h"
+#include "VesselClass.h"
+#include "TaskPool.h"
+#include "Log.h"
+#include <filesystem>
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+
+namespace fs = std::filesystem;
+
+static std::string Lower (const std::string &str)
+{
+	std::string s(str);
+	for (auto &c : s) c = (char)tolower ((unsigned char)c);
+	return s;
+}
+
+static std::string Trim (const std::string &str)
+{
+	size_t b = str.find_first_not_of (" \t\r");
+	if (b == std::string::npos) return std::string();
+	size_t e = str.find_last_not_of (" \t\r");
+	return str.substr (b, e-b+1);
+}
+
+// Value of item tag in a parsed configuration file, as GetItemString
+static bool Item (const CfgFile::IndexRef &index, const char *tag, std::string &val)
+{
+	if (!index) return false;
+	auto it = index->item.find (Lower (tag));
+	if (it == index->item.end() || !it->second.len) return false;
+	val.assign (index->text, it->second.val, it->second.len);
+	return true;
+}
+
+// Lines between the first line starting with 'begin' and the next line
+// starting with 'end' in a parsed configuration file, as FindLine
+static bool Section (const CfgFile::IndexRef &index, const char *begin, const char *end, std::vector<std::string> &line)
+{
+	if (!index) return false;
+	const std::vector<size_t> &linepos = index->linepos;
+	const std::string &text = index->text;
+	size_t i, nbegin = strlen (begin), nend = strlen (end);
+	for (i = 0; i < linepos.size(); i++)
+		if (!_strnicmp (text.c_str() + linepos[i], begin, nbegin)) break;
+	if (i == linepos.size()) return false;
+	for (i++; i < linepos.size(); i++) {
+		const char *s = text.c_str() + linepos[i];
+		if (!_strnicmp (s, end, nend)) break;
+		size_t len = (i+1 < linepos.size() ? linepos[i+1] : text.size()) - linepos[i];
+		line.push_back (Trim (std::string(s, len)));
+	}
+	return true;
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// =======================================================================
+
+ScenarioPreload::ScenarioPreload ()
+{
+	active = false;
+	nthread = 0;
+	vclassreg = 0;
+	nbase = 0;
+	twait = 0.0;
+}
+
+// =======================================================================
+
+ScenarioPreload::~ScenarioPreload ()
+{
+	if (loader.joinable()) loader.join();
+}
+
+// =======================================================================
+
+void ScenarioPreload::Start (const Config *config, VesselClassRegistry *_vclassreg, const char *_scnname, const char *_solsys)
+{
+	Finish ();
+	active = true;
+	nthread = std::max (0, config->CfgDebugPrm.nLoadThreads);
+	cfgdir = config->CfgDirPrm.ConfigDir;
+	mshdir = config->CfgDirPrm.MeshDir;
+	scnname = _scnname;
+	solsys = _solsys;
+	vclassreg = _vclassreg;
+	nbase = 0;
+	twait = 0.0;
+	mainstage.clear();
+	loadstage.clear();
+	tstage = Clock::now();
+	if (nthread) loader = std::thread (&ScenarioPreload::LoaderProc, this);
+}
+
+// =======================================================================
+
+void ScenarioPreload::OpenConfig (CfgFile &cfgfile, const char *path)
+{
+	if (!active) {
+		cfgfile.open (path);
+		return;
+	}
+	Clock::time_point t0 = Clock::now();
+	cfgfile.open (path, cfg.Get (path));
+	twait += Elapsed (t0);
+}
+
+// =======================================================================
+
+ScenarioPreload::MeshRef ScenarioPreload::Mesh (const char *path)
+{
+	if (!active) return MeshRef();
+	std::shared_future<MeshRef> result;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		auto it = mesh.find (Lower (path));
+		if (it == mesh.end()) return MeshRef();
+		result = it->second.future;
+	}
+	Clock::time_point t0 = Clock::now();
+	MeshRef ref = result.get();
+	twait += Elapsed (t0);
+	return ref;
+}
+
+// =======================================================================
+
+void ScenarioPreload::Stage (const char *name)
+{
+	if (!active) return;
+	mainstage.push_back (std::make_pair (std::string(name), Elapsed (tstage)));
+	tstage = Clock::now();
+}
+
+// =======================================================================
+
+void ScenarioPreload::Finish ()
+{
+	if (!active) return;
+	if (loader.joinable()) loader.join();
+
+	char cbuf[256];
+	std::string str;
+	double t = 0.0;
+	for (auto &s : mainstage) {
+		sprintf (cbuf, "%s%s %0.1f", str.empty() ? "" : ", ", s.first.c_str(), s.second*1e3);
+		str += cbuf;
+		t += s.second;
+	}
+	LOGOUT("Scenario load [ms]: %s (total %0.1f, file access %0.1f)", str.c_str(), t*1e3, twait*1e3);
+	if (nthread) {
+		str.clear();
+		for (auto &s : loadstage) {
+			sprintf (cbuf, "%s%s %0.1f", str.empty() ? "" : ", ", s.first.c_str(), s.second*1e3);
+			str += cbuf;
+		}
+		LOGOUT("Scenario preload [ms]: %s (%d threads, %zu config files, %zu base files, %zu meshes)",
+			str.c_str(), nthread, cfg.nFile(), nbase, meshqueue.size());
+	}
+
+	cfg.Clear();
+	mesh.clear();
+	meshqueue.clear();
+	active = false;
+}
+
+// =======================================================================
+
+void ScenarioPreload::LoaderProc ()
+{
+	TaskPool pool(nthread-1); // the loader thread processes tasks as well
+	std::vector<std::string> vclass, body, base;
+
+	// discovery: vessel classes and celestial bodies
+	Clock::time_point t0 = Clock::now();
+	ScanScenario (vclass);
+	ScanSystem (body);
+	loadstage.push_back (std::make_pair (std::string("scan"), Elapsed (t0)));
+
+	// celestial body and vessel class files. Discovers surface bases and meshes
+	t0 = Clock::now();
+	std::vector<std::vector<std::string>> bodybase(body.size());
+	pool.Run (body.size() + vclass.size(), [&](size_t i) {
+		if (i < body.size()) LoadBody (body[i], bodybase[i]);
+		else LoadClass (vclass[i-body.size()]);
+	});
+	for (auto &b : bodybase)
+		base.insert (base.end(), b.begin(), b.end());
+	loadstage.push_back (std::make_pair (std::string("configuration"), Elapsed (t0)));
+
+	// surface base files and meshes
+	t0 = Clock::now();
+	std::vector<MeshEntry*> queue;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		queue = meshqueue;
+	}
+	pool.Run (base.size() + queue.size(), [&](size_t i) {
+		if (i < base.size()) cfg.Get (base[i].c_str());
+		else LoadMesh (*queue[i-base.size()]);
+	});
+	nbase = base.size();
+	loadstage.push_back (std::make_pair (std::string("bases and meshes"), Elapsed (t0)));
+}
+
+// =======================================================================
+
+void ScenarioPreload::ScanScenario (std::vector<std::string> &vclass)
+{
+	// same syntax as PlanetarySystem::InitState and Vessel::ParseScenario
+	std::ifstream ifs (scnname);
+	std::string line;
+	bool ships = false, invessel = false;
+	while (std::getline (ifs, line)) {
+		line = Trim (line);
+		if (!ships) {
+			ships = !_strnicmp (line.c_str(), "BEGIN_SHIPS", 11);
+		} else if (invessel) {
+			if (!_stricmp (line.c_str(), "END")) invessel = false;
+		} else {
+			if (!_stricmp (line.c_str(), "END_SHIPS")) break;
+			size_t colon = line.find (':');
+			std::string name = (colon != std::string::npos ? line.substr (colon+1) : line);
+			if (std::find (vclass.begin(), vclass.end(), name) == vclass.end())
+				vclass.push_back (name);
+			invessel = true;
+		}
+	}
+}
+
+// =======================================================================
+
+void ScenarioPreload::ScanSystem (std::vector<std::string> &body)
+{
+	// same item names as PlanetarySystem::Read
+	CfgFile::IndexRef index = cfg.Get (CfgPath (solsys).c_str());
+	char label[256];
+	std::string name;
+	for (int i = 1; ; i++) {
+		sprintf (label, "Star%d", i);
+		if (!Item (index, label, name)) break;
+		body.push_back (name);
+	}
+	std::vector<std::string> id;
+	for (int i = 1; ; i++) {
+		sprintf (label, "Planet%d", i);
+		if (!Item (index, label, name)) break;
+		body.push_back (name);
+		id.push_back (name);
+	}
+	for (size_t k = 0; k < id.size(); k++) { // moons, recursively
+		for (int i = 1; ; i++) {
+			sprintf (label, "%s:Moon%d", id[k].c_str(), i);
+			if (!Item (index, label, name)) break;
+			body.push_back (name);
+			id.push_back (label);
+		}
+	}
+}
+
+// =======================================================================
+
+void ScenarioPreload::LoadBody (const std::string &name, std::vector<std::string> &base)
+{
+	// surface base definitions as in Planet::Planet and Planet::ScanBases.
+	// Time and context limiters are ignored, so that bases that are not
+	// created for this scenario may be read as well.
+	CfgFile::IndexRef index = cfg.Get (CfgPath (name).c_str());
+	if (!index) return;
+	std::vector<std::string> line, dir;
+	if (Section (index, "BEGIN_SURFBASE", "END_SURFBASE", line)) {
+		for (auto &l : line) {
+			if (!_strnicmp (l.c_str(), "DIR", 3)) {
+				std::string d = l.substr (3);
+				size_t cut = std::min (d.find ("PERIOD"), d.find ("CONTEXT"));
+				if (cut != std::string::npos) d.erase (cut);
+				dir.push_back (Trim (d));
+			} else if (l.size()) {
+				std::string nm = Trim (l.substr (0, l.find (':')));
+				if (nm.size()) base.push_back (CfgPath (nm));
+			}
+		}
+	} else {
+		dir.push_back (name + "/Base");
+	}
+	std::error_code ec;
+	for (auto &d : dir) {
+		for (const auto &entry : fs::directory_iterator (fs::path(cfgdir + d), ec)) {
+			if (entry.path().extension().string() == ".cfg")
+				base.push_back (CfgPath (d + "\\" + entry.path().stem().string()));
+		}
+	}
+}
+
+// =======================================================================
+
+void ScenarioPreload::LoadClass (const std::string &name)
+{
+	// class file search as in Vessel::OpenConfigFile and Vessel::ReadGenericCaps
+	std::string path = CfgPath ("Vessels\\" + name);
+	CfgFile::IndexRef index = vclassreg->Config (path.c_str());
+	if (!index) index = vclassreg->Config (CfgPath (name).c_str());
+	for (int level = 0; index && level < 16; level++) {
+		std::string val;
+		if (Item (index, "MeshName", val)) ScheduleMesh (val);
+		if (!Item (index, "BaseClass", val)) break;
+		index = vclassreg->Config (CfgPath (val).c_str());
+	}
+}
+
+// =======================================================================
+
+void ScenarioPreload::ScheduleMesh (const std::string &name)
+{
+	std::string path = mshdir + name + ".msh";
+	std::lock_guard<std::mutex> lock(mtx);
+	auto res = mesh.emplace (std::piecewise_construct, std::forward_as_tuple (Lower (path)), std::forward_as_tuple());
+	if (res.second) {
+		MeshEntry &entry = res.first->second;
+		entry.path = path;
+		entry.future = entry.result.get_future().share();
+		meshqueue.push_back (&entry);
+	}
+}
+
+// =======================================================================
+
+void ScenarioPreload::LoadMesh (MeshEntry &entry)
+{
+	MeshRef ref;
+	try {
+		MeshBinReader mbr;
+		if (!mbr.Open ((entry.path + 'b').c_str(), entry.path.c_str())) { // binary meshes are loaded directly
+			std::ifstream ifs (entry.path);
+			std::shared_ptr<MeshBinData> data = std::make_shared<MeshBinData>();
+			if (ifs && MeshBinParse (ifs, *data) && data->grp.size())
+				ref = data;
+		}
+	} catch (...) {
+		ref.reset(); // leave it to the main thread
+	}
+	entry.result.set_value (ref);
+}
+
+// =======================================================================
+
+std::string ScenarioPreload::CfgPath (const std::string &name) const
+{
+	return cfgdir + name + ".cfg";
+}
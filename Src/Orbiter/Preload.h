@@ -0,0 +1,110 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Preload.h
+// Scenario load pipeline. When a simulation session starts, a loader
+// thread scans the scenario for the resources it will need (planetary
+// system, celestial body and surface base configuration files, vessel
+// class files and their meshes) and reads and decodes them on a pool of
+// worker threads, while the main thread constructs the simulation
+// objects in the usual order. The main thread picks up the preloaded
+// files, or waits for them if they are still being processed.
+// The time spent in the load stages is written to the log.
+// =======================================================================
+
+#ifndef __PRELOAD_H
+#define __PRELOAD_H
+
+#include "CfgFile.h"
+#include "MeshBin.h"
+#include <thread>
+#include <chrono>
+
+class Config;
+class VesselClassRegistry;
+
+class ScenarioPreload {
+public:
+	typedef std::shared_ptr<const MeshBinData> MeshRef;
+
+	ScenarioPreload ();
+	~ScenarioPreload ();
+
+	void Start (const Config *cfg, VesselClassRegistry *vclassreg, const char *scnname, const char *solsys);
+	// Start loading the resources required by scenario file scnname for
+	// planetary system solsys, using cfg->CfgDebugPrm.nLoadThreads threads.
+	// With 0 threads, nothing is preloaded, but configuration files are
+	// still shared and stage timings are recorded.
+
+	void OpenConfig (CfgFile &cfgfile, const char *path);
+	// Open configuration file path. During the load, each file is parsed
+	// only once; after the load, the file is opened normally.
+
+	MeshRef Mesh (const char *path);
+	// Return text mesh file path decoded by the preloader, waiting for it
+	// if necessary. Returns an empty reference if the mesh wasn't
+	// scheduled for preloading, or if it has an up to date binary version.
+
+	void Stage (const char *name);
+	// Record the main thread time since the previous stage for stage name.
+
+	void Finish ();
+	// Wait for the loader, write the stage timings to the log, and release
+	// the preloaded data.
+
+	inline bool Active () const { return active; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct MeshEntry {
+		std::string path;
+		std::promise<MeshRef> result;
+		std::shared_future<MeshRef> future;
+	};
+
+	void LoaderProc ();
+	// Loader thread: discovery of resources and scheduling of the load stages
+
+	void ScanScenario (std::vector<std::string> &vclass);
+	// Collect the vessel class names of the scenario
+
+	void ScanSystem (std::vector<std::string> &body);
+	// Collect the celestial body names of the planetary system
+
+	void LoadBody (const std::string &name, std::vector<std::string> &base);
+	// Read a celestial body file and collect its surface base files
+
+	void LoadClass (const std::string &name);
+	// Read a vessel class file with its base classes, and schedule its meshes
+
+	void ScheduleMesh (const std::string &name);
+	// Schedule mesh name for decoding
+
+	void LoadMesh (MeshEntry &entry);
+	// Decode a scheduled mesh
+
+	std::string CfgPath (const std::string &name) const;
+	// Configuration file path, as Config::ConfigPath
+
+	bool active;                 // load in progress
+	int nthread;                 // number of loader threads (0: no preloading)
+	std::string cfgdir, mshdir;  // configuration and mesh directories
+	std::string scnname, solsys; // scenario file and planetary system
+	VesselClassRegistry *vclassreg;
+	CfgCache cfg;                // configuration files shared during the load
+	std::unordered_map<std::string, MeshEntry> mesh; // scheduled meshes, keyed by lower-case path
+	std::vector<MeshEntry*> meshqueue; // meshes in order of scheduling
+	size_t nbase;                // number of base files preloaded
+	std::mutex mtx;
+	std::thread loader;
+
+	// timing
+	Clock::time_point tstage;    // start of current main thread stage
+	std::vector<std::pair<std::string,double>> mainstage; // main thread stages [s]
+	std::vector<std::pair<std::string,double>> loadstage; // loader stages [s]
+	double twait;                // main thread time spent waiting for file access [s]
+};
+
+#endif // !__PRELOAD_H
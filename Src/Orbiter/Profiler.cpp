@@ -0,0 +1,205 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Profiler.cpp
+// Frame profiler: per-frame zone timing and Chrome trace export
+// =======================================================================
+
+#include "Profiler.h"
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+
+Profiler g_profiler;
+
+static std::atomic<int> g_nthread(0);
+static thread_local int tls_threadidx = -1;
+
+// =======================================================================
+
+Profiler::Profiler ()
+: frame(new Frame[NFRAME])
+{
+	enabled = false;
+	nzone = 0;
+	for (int i = 0; i < MAXZONE; i++) {
+		ztime[i] = 0;
+		zcount[i] = 0;
+	}
+	nframe = 0;
+	tframe = tepoch = Clock::now();
+	capture = false;
+	nevent = 0;
+	ncapture = 0;
+	framezone = RegisterZone ("Frame");
+}
+
+// =======================================================================
+
+int Profiler::RegisterZone (const char *_name)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	int i, n = nzone.load();
+	for (i = 0; i < n; i++)
+		if (name[i] == _name) return i;
+	if (n == MAXZONE) return -1;
+	name[n] = _name;
+	nzone.store (n+1); // publish the name
+	return n;
+}
+
+// =======================================================================
+
+const char *Profiler::ZoneName (int id) const
+{
+	return (id >= 0 && id < nzone.load() ? name[id].c_str() : "");
+}
+
+// =======================================================================
+
+void Profiler::Enable (bool enable)
+{
+	if (enable == Enabled()) return;
+	enabled.store (enable);
+	for (int i = 0; i < MAXZONE; i++) {
+		ztime[i] = 0;
+		zcount[i] = 0;
+	}
+	nframe = 0;
+	tframe = Clock::now();
+	if (!enable && Capturing()) FinishCapture();
+}
+
+// =======================================================================
+
+void Profiler::EndFrame ()
+{
+	if (!Enabled()) return;
+	Clock::time_point t = Clock::now();
+	if (Capturing()) AddEvent (framezone, tframe, t);
+
+	Frame &f = frame[nframe % NFRAME];
+	f.t = std::chrono::duration<double>(t - tframe).count();
+	int n = nzone.load();
+	for (int i = 0; i < n; i++) {
+		f.ztime[i] = ztime[i].exchange (0, std::memory_order_relaxed);
+		f.zcount[i] = zcount[i].exchange (0, std::memory_order_relaxed);
+	}
+	for (int i = n; i < MAXZONE; i++) {
+		f.ztime[i] = 0;
+		f.zcount[i] = 0;
+	}
+	f.ztime[framezone] = std::chrono::duration_cast<std::chrono::nanoseconds>(t - tframe).count();
+	f.zcount[framezone] = 1;
+	nframe++;
+	tframe = t;
+
+	if (Capturing() && !--ncapture) FinishCapture();
+}
+
+// =======================================================================
+
+size_t Profiler::Summary (std::vector<ZoneSummary> &zone, size_t n, double *tframe) const
+{
+	zone.clear();
+	size_t nf = std::min (nframe, (size_t)NFRAME);
+	if (n && n < nf) nf = n;
+	if (tframe) *tframe = 0.0;
+	if (!nf) return 0;
+
+	int nz = nzone.load();
+	std::vector<std::int64_t> tsum(nz, 0), tmax(nz, 0);
+	std::vector<std::uint64_t> csum(nz, 0);
+	double t = 0.0;
+	for (size_t k = nframe-nf; k < nframe; k++) {
+		const Frame &f = frame[k % NFRAME];
+		t += f.t;
+		for (int i = 0; i < nz; i++) {
+			tsum[i] += f.ztime[i];
+			tmax[i] = std::max (tmax[i], f.ztime[i]);
+			csum[i] += f.zcount[i];
+		}
+	}
+	for (int i = 0; i < nz; i++) {
+		if (!csum[i]) continue;
+		ZoneSummary zs;
+		zs.id = i;
+		zs.name = name[i];
+		zs.t = tsum[i]*1e-9/nf;
+		zs.tmax = tmax[i]*1e-9;
+		zs.count = (double)csum[i]/nf;
+		zone.push_back (zs);
+	}
+	if (tframe) *tframe = t/nf;
+	return nf;
+}
+
+// =======================================================================
+
+bool Profiler::StartCapture (const char *fname, size_t n)
+{
+	if (!Enabled() || Capturing() || !n) return false;
+	if (!event) event.reset (new Event[MAXEVENT]);
+	for (size_t i = 0; i < MAXEVENT; i++)
+		event[i].zone.store (-1, std::memory_order_relaxed);
+	nevent = 0;
+	ncapture = n;
+	capturefile = fname;
+	capture.store (true);
+	return true;
+}
+
+// =======================================================================
+
+void Profiler::AddEvent (int id, Clock::time_point t0, Clock::time_point t1)
+{
+	size_t i = nevent.fetch_add (1, std::memory_order_relaxed);
+	if (i >= MAXEVENT) return; // buffer full
+	Event &e = event[i];
+	e.tid = ThreadIndex();
+	e.t0 = t0;
+	e.t1 = t1;
+	e.zone.store (id, std::memory_order_release);
+}
+
+// =======================================================================
+
+void Profiler::FinishCapture ()
+{
+	capture.store (false);
+	std::ofstream ofs (capturefile);
+	if (ofs) WriteTrace (ofs);
+}
+
+// =======================================================================
+
+void Profiler::WriteTrace (std::ostream &os) const
+{
+	// zone names are written as given; they must not contain characters
+	// that need escaping in JSON strings
+	char cbuf[512];
+	size_t n = std::min (nevent.load(), MAXEVENT);
+	os << "{\"traceEvents\":[";
+	bool first = true;
+	for (size_t i = 0; i < n && event; i++) {
+		const Event &e = event[i];
+		int id = e.zone.load (std::memory_order_acquire);
+		if (id < 0) continue; // still being written
+		double ts = std::chrono::duration<double,std::micro>(e.t0 - tepoch).count();
+		double dur = std::chrono::duration<double,std::micro>(e.t1 - e.t0).count();
+		snprintf (cbuf, sizeof(cbuf), "%s\n{\"name\":\"%s\",\"cat\":\"orbiter\",\"ph\":\"X\",\"ts\":%0.3f,\"dur\":%0.3f,\"pid\":1,\"tid\":%d}",
+			first ? "" : ",", ZoneName (id), ts, dur, e.tid);
+		os << cbuf;
+		first = false;
+	}
+	os << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+// =======================================================================
+
+int Profiler::ThreadIndex ()
+{
+	if (tls_threadidx < 0) tls_threadidx = g_nthread.fetch_add (1);
+	return tls_threadidx;
+}
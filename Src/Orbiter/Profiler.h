@@ -0,0 +1,164 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Profiler.h
+// Frame profiler. Scoped timing zones in the simulation code add their
+// time to per-zone counters, from any thread and without locking. At
+// the end of each frame the counters are moved into a ring buffer of
+// recent frames, from which a rolling summary is available to plugins.
+// On request, the individual zone events of a number of frames are
+// captured and written as a Chrome trace file (chrome://tracing or
+// ui.perfetto.dev).
+// Zones are also reported to the Tracy profiler if it is enabled in the
+// build (ORBITER_TRACY_PROFILER).
+// =======================================================================
+
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <iostream>
+#include "Tracy.hpp"
+
+class Profiler {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	static const int MAXZONE = 128;           // max. number of zones
+	static const int NFRAME = 256;            // ring buffer size [frames]
+	static const size_t MAXEVENT = 1 << 19;  // capture buffer size [events]
+
+	struct ZoneSummary {
+		int id;           // zone id
+		std::string name; // zone name
+		double t;         // mean time per frame spent in the zone [s]
+		double tmax;      // max. time per frame spent in the zone [s]
+		double count;     // mean number of zone calls per frame
+	};
+
+	Profiler ();
+
+	int RegisterZone (const char *name);
+	// Return the id of zone name, registering it on first use.
+	// Returns -1 if the zone table is full.
+
+	const char *ZoneName (int id) const;
+
+	void Enable (bool enable);
+	// Enable or disable zone timing. A disabled zone costs a single flag
+	// test. Disabling also clears the frame buffer.
+
+	inline bool Enabled () const { return enabled.load (std::memory_order_relaxed); }
+
+	inline void AddZone (int id, Clock::time_point t0, Clock::time_point t1);
+	// Add the time interval of a zone call to the current frame
+
+	void EndFrame ();
+	// Close the current frame. Called once per frame by the simulation
+	// thread.
+
+	size_t Summary (std::vector<ZoneSummary> &zone, size_t nframe = 0, double *tframe = 0) const;
+	// Summary of the zones over the last nframe frames (0: all frames in
+	// the buffer). Zones that weren't called in the interval are skipped.
+	// Returns the number of frames evaluated. The mean frame length [s] is
+	// returned in tframe if provided. Must be called from the simulation
+	// thread.
+
+	bool StartCapture (const char *fname, size_t nframe);
+	// Record the zone events of the next nframe frames and write them to
+	// Chrome trace file fname. Returns false if a capture is in progress
+	// or the profiler is disabled.
+
+	inline bool Capturing () const { return capture.load (std::memory_order_relaxed); }
+
+	void WriteTrace (std::ostream &os) const;
+	// Write the captured events in Chrome trace format
+
+private:
+	struct Event {
+		std::atomic<int> zone; // zone id (-1: not written yet)
+		int tid;               // thread index
+		Clock::time_point t0, t1;
+	};
+	struct Frame {
+		double t;                     // frame length [s]
+		std::int64_t ztime[MAXZONE];  // zone time [ns]
+		std::uint32_t zcount[MAXZONE]; // zone calls
+	};
+
+	void AddEvent (int id, Clock::time_point t0, Clock::time_point t1);
+	void FinishCapture ();
+	static int ThreadIndex ();
+
+	std::atomic<bool> enabled;
+	std::string name[MAXZONE];
+	std::atomic<int> nzone;
+	std::mutex mtx;                            // zone registration
+	std::atomic<std::int64_t> ztime[MAXZONE];  // zone time in current frame [ns]
+	std::atomic<std::uint32_t> zcount[MAXZONE]; // zone calls in current frame
+
+	std::unique_ptr<Frame[]> frame;            // ring buffer of recent frames
+	size_t nframe;                             // number of frames written
+	Clock::time_point tframe;                  // start of current frame
+	Clock::time_point tepoch;                  // time origin of trace files
+	int framezone;                             // zone id of the frame events
+
+	std::atomic<bool> capture;                 // capture in progress
+	std::unique_ptr<Event[]> event;            // capture buffer
+	std::atomic<size_t> nevent;                // number of events captured
+	size_t ncapture;                           // remaining frames to capture
+	std::string capturefile;
+};
+
+extern Profiler g_profiler;
+
+// =======================================================================
+// Scoped zone timing
+
+class ProfileScope {
+public:
+	inline ProfileScope (int _id): id(_id)
+	{
+		if (id >= 0 && g_profiler.Enabled()) t0 = Profiler::Clock::now();
+		else id = -1;
+	}
+	inline ~ProfileScope ()
+	{
+		if (id >= 0) g_profiler.AddZone (id, t0, Profiler::Clock::now());
+	}
+
+private:
+	int id;
+	Profiler::Clock::time_point t0;
+};
+
+#define PROFILE_CONCAT_(a,b) a##b
+#define PROFILE_CONCAT(a,b) PROFILE_CONCAT_(a,b)
+
+// Time the rest of the enclosing scope as zone name (a string literal)
+#define PROFILE_ZONE(name) \
+	ZoneScopedN(name); \
+	static const int PROFILE_CONCAT(_profile_id,__LINE__) = g_profiler.RegisterZone (name); \
+	ProfileScope PROFILE_CONCAT(_profile_scope,__LINE__)(PROFILE_CONCAT(_profile_id,__LINE__))
+
+// Time the rest of the enclosing scope as a zone registered at runtime
+#define PROFILE_ZONE_ID(id) \
+	ZoneTransientN(PROFILE_CONCAT(_tracy_zone,__LINE__), g_profiler.ZoneName (id), true); \
+	ProfileScope PROFILE_CONCAT(_profile_scope,__LINE__)(id)
+
+// =======================================================================
+
+inline void Profiler::AddZone (int id, Clock::time_point t0, Clock::time_point t1)
+{
+	ztime[id].fetch_add (std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count(), std::memory_order_relaxed);
+	zcount[id].fetch_add (1, std::memory_order_relaxed);
+	if (capture.load (std::memory_order_relaxed)) AddEvent (id, t0, t1);
+}
+
+#endif // !__PROFILER_H
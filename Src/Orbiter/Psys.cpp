@@ -9,12 +9,15 @@
 #include <algorithm>
 
 #include "Config.h"
+#include "CfgFile.h"
 #include "Psys.h"
 #include "TimeData.h"
 #include "Element.h"
 #include "Vessel.h"
 #include "SuperVessel.h"
 #include "Log.h"
+#include "TaskPool.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -23,19 +26,28 @@ extern bool g_bForceUpdate;
 extern char DBG_MSG[256];
 
 PlanetarySystem::PlanetarySystem (char *fname, const Config* config, OutputLoadStatusCallback outputLoadStatus, void* callbackContext)
+: m_vesselIndex(1e5)
 {
+	int nthread = config->CfgPhysicsPrm.nUpdateThreads;
+	m_updatePool = (nthread > 0 ? new TaskPool (nthread) : NULL);
+	m_multiRate = config->CfgPhysicsPrm.bMultiRate;
+	m_mrOrbitStep = config->CfgPhysicsPrm.MultiRateOrbitStep;
+	m_mrMaxInterval = config->CfgPhysicsPrm.MultiRateMaxInterval;
 	Read (fname, config, outputLoadStatus, callbackContext);
 }
 
 PlanetarySystem::~PlanetarySystem ()
 {
 	Clear ();
+	if (m_updatePool) delete m_updatePool;
 }
 
 void PlanetarySystem::Clear ()
 {
 	DestroyDeviceObjects ();
 	m_Name.clear();
+	m_vesselIndex.Clear();
+	m_registry.Clear();
 
 	//Vessel destructor broadcasts messages to every other vessel in 'vessels'.
 	//We remove it from the collection as soon as we deleted it to prevent the next Vessel to broadcast to the free'd one.
@@ -54,6 +66,7 @@ void PlanetarySystem::Clear ()
 	stars     .clear();
 	planets   .clear();
 	celestials.clear();
+	m_gsrc.Resize (0);
 
 	g_bForceUpdate = true;
 
@@ -99,44 +112,32 @@ void PlanetarySystem::Write (ostream &os)
 
 Body *PlanetarySystem::GetObj (const char *name, bool ignorecase)
 {
-	for (DWORD i = 0; i < bodies.size(); i++)
-		if (!StrComp (bodies[i]->Name(), name, ignorecase)) return bodies[i];
-	return 0;
+	return (Body*)m_registry.Find (name, ignorecase);
 }
 
 CelestialBody *PlanetarySystem::GetGravObj (const char *name, bool ignorecase) const
 {
-	for (DWORD i = 0; i < celestials.size(); i++)
-		if (!StrComp (celestials[i]->Name(), name, ignorecase)) return celestials[i];
-	return 0;
+	return (CelestialBody*)(Body*)m_registry.Find (name, ignorecase, REG_GRAV);
 }
 
 Planet *PlanetarySystem::GetPlanet (const char *name, bool ignorecase)
 {
-	for (size_t i = 0; i < planets.size(); i++)
-		if (!StrComp (planets[i]->Name(), name, ignorecase)) return planets[i];
-	return 0;
+	return (Planet*)(Body*)m_registry.Find (name, ignorecase, REG_PLANET);
 }
 
 Vessel *PlanetarySystem::GetVessel (const char *name, bool ignorecase) const
 {
-	for (DWORD i = 0; i < vessels.size(); i++)
-		if (!StrComp (vessels[i]->Name(), name, ignorecase)) return vessels[i];
-	return 0;
+	return (Vessel*)(Body*)m_registry.Find (name, ignorecase, REG_VESSEL);
 }
 
 bool PlanetarySystem::isObject (const Body *obj) const
 {
-	for (DWORD i = 0; i < bodies.size(); i++)
-		if (bodies[i] == obj) return true;
-	return false;
+	return m_registry.Contains (obj);
 }
 
 bool PlanetarySystem::isVessel (const Vessel *v) const
 {
-	for (DWORD i = 0; i < vessels.size(); i++)
-		if (vessels[i] == v) return true;
-	return false;
+	return m_registry.Contains ((const Body*)v, REG_VESSEL);
 }
 
 Base *PlanetarySystem::GetBase (const Planet *planet, const char *name, bool ignorecase)
@@ -170,7 +171,7 @@ bool PlanetarySystem::Read (char *fname, const Config* config, OutputLoadStatusC
 	DWORD j;
 	char cbuf[256], label[128];
 	
-	ifstream ifs (config->ConfigPath(fname));
+	CfgFile ifs (config->ConfigPath(fname));
 	if (!ifs) return false;
 	Clear();
 	if (GetItemString (ifs, "Name", cbuf)) {
@@ -326,6 +327,14 @@ void PlanetarySystem::ActivatePlanetLabels(bool activate)
 void PlanetarySystem::AddBody (Body *_body)
 {
 	bodies.emplace_back(_body);
+
+	unsigned int flags = 0;
+	switch (_body->Type()) {
+	case OBJTP_VESSEL: flags = REG_VESSEL; break;
+	case OBJTP_STAR:   flags = REG_GRAV; break;
+	case OBJTP_PLANET: flags = REG_GRAV | REG_PLANET; break;
+	}
+	m_registry.Insert ((const Body*)_body, _body->Name(), flags);
 }
 
 bool PlanetarySystem::DelBody (Body *_body)
@@ -338,6 +347,8 @@ bool PlanetarySystem::DelBody (Body *_body)
 	if (i == bodies.size())
 		return false; // bodies not found in list
 
+	m_registry.Remove ((const Body*)_body);
+
 	//if (bodies[i]->s0) bodies[i]->s0 = NULL; // s0 is used in vessels destructor due to undocking of
 	//if (bodies[i]->s1) bodies[i]->s1 = NULL; // vessels before deletion.
 	
@@ -387,12 +398,14 @@ void PlanetarySystem::AddGrav (CelestialBody *newBody)
 	//And this is just so much more readable.
 	celestials.emplace_back(newBody);
 	std::sort(celestials.begin(), celestials.end(), [](CelestialBody* a, CelestialBody* b) { return a->Mass() > b->Mass(); });
+	m_gsrc.Resize (0); // invalidate the gravity source snapshot
 }
 
 size_t PlanetarySystem::AddVessel (Vessel *_vessel)
 {
 	vessels.emplace_back(_vessel);
 	AddBody (_vessel); // register in general list
+	m_vesselIndex.Insert (_vessel, _vessel->GPos(), _vessel->Size());
 	g_bForceUpdate = true;
 	return vessels.size();
 }
@@ -408,6 +421,7 @@ bool PlanetarySystem::DelVessel (Vessel *_vessel)
 	if (i == vessels.size())
 		return false; // vessels not found in list
 
+	m_vesselIndex.Remove (_vessel);
 	DelBody (_vessel); //DelBody takes care of freeing the vessel
 	std::iter_swap(vessels.begin() + i, vessels.end() - 1);
 	vessels.pop_back();
@@ -416,6 +430,51 @@ bool PlanetarySystem::DelVessel (Vessel *_vessel)
 	return true;
 }
 
+void PlanetarySystem::AddVessels (const std::vector<Vessel*> &list)
+{
+	if (list.empty()) return;
+	vessels.reserve (vessels.size() + list.size());
+	bodies.reserve (bodies.size() + list.size());
+	for (size_t i = 0; i < list.size(); i++) {
+		vessels.emplace_back (list[i]);
+		AddBody (list[i]);
+	}
+	std::vector<const void*> obj (list.begin(), list.end());
+	m_vesselIndex.Insert (obj, VesselIndexPos);
+	g_bForceUpdate = true;
+}
+
+size_t PlanetarySystem::DelVessels (const std::vector<Vessel*> &list)
+{
+	if (list.empty()) return 0;
+	std::vector<const void*> obj (list.begin(), list.end());
+	std::sort (obj.begin(), obj.end());
+	auto inbatch = [&obj](const void *p) { return std::binary_search (obj.begin(), obj.end(), p); };
+
+	// remove the vessels from all lists in a single pass each, before
+	// deleting any of them, since the Vessel destructor broadcasts to
+	// the vessels still in the list
+	size_t n = vessels.size();
+	vessels.erase (std::remove_if (vessels.begin(), vessels.end(), [&](Vessel *v) { return inbatch (v); }), vessels.end());
+	n -= vessels.size();
+	if (!n) return 0;
+	std::vector<Vessel*> del;
+	del.reserve (n);
+	bodies.erase (std::remove_if (bodies.begin(), bodies.end(), [&](Body *b) {
+		if (b->Type() != OBJTP_VESSEL || !inbatch ((Vessel*)b)) return false;
+		del.push_back ((Vessel*)b);
+		return true;
+	}), bodies.end());
+	m_vesselIndex.Remove (obj);
+	for (size_t i = 0; i < del.size(); i++) {
+		m_registry.Remove ((const Body*)del[i]);
+		delete del[i];
+	}
+
+	g_bForceUpdate = true;
+	return n;
+}
+
 void PlanetarySystem::AddSuperVessel (SuperVessel *sv)
 {
 	supervessels.emplace_back(sv);
@@ -458,6 +517,7 @@ void PlanetarySystem::DockVessels (Vessel *vessel1, Vessel *vessel2, int port1,
 	} else {                 // add vessel1 into sv2
 		sv2->Add (vessel2, port2, vessel1, port1, mixmoments);
 	}
+	SyncVesselUpdates ();
 }
 
 void PlanetarySystem::UndockVessel (SuperVessel *sv, Vessel *_vessel, int port, double vsep)
@@ -466,6 +526,7 @@ void PlanetarySystem::UndockVessel (SuperVessel *sv, Vessel *_vessel, int port,
 	if (!sv->nVessel()) {
 		DelSuperVessel(sv);
 	}
+	SyncVesselUpdates ();
 }
 
 void PlanetarySystem::ScanGFieldSources (const Vector *gpos, const Body *exclude, GFieldData *gfd) const
@@ -597,11 +658,7 @@ Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
 
 		unsigned int maxDegreeOrder = body->GetPinesCutoff();
 		//get aceleration vector from spherical harmonics
-		{
-			//Limit scope of the const cast. the internal state of body.PinesGravProp does need to change when this finction is called.
-			CelestialBody* unconstbody = const_cast<CelestialBody*>(body);
-			dg = unconstbody->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
-		}
+		dg = body->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
 
 		//Convert back to Orbiter's lefthandedness
 		temp_y = dg.y;
@@ -674,11 +731,92 @@ Vector SingleGacc (const Vector &rpos, const CelestialBody *body)
 	return rpos * (Ggrav * body->Mass() / (d*d*d)) + SingleGacc_perturbation (rpos, body);
 }
 
+void PlanetarySystem::UpdateGravitySources (bool step)
+{
+	int i, n = (int)celestials.size();
+	Vector c[3];
+	double p[3], coeff[9];
+	if (m_gsrc.Size() != n) m_gsrc.Resize (n);
+	for (i = 0; i < n; i++) {
+		const CelestialBody *cb = celestials[i];
+		bool nonspherical = cb->UseComplexGravity() && (cb->usePines() || cb->nJcoeff() > 0);
+		p[0] = cb->s0->pos.x, p[1] = cb->s0->pos.y, p[2] = cb->s0->pos.z;
+		m_gsrc.SetSource (i, Ggrav * cb->Mass(), p, nonspherical);
+		if (step) {
+			bool cubic = cb->InterpolationCoeffs (c);
+			for (int k = 0; k < 3; k++) {
+				coeff[3*k]   = c[k].x;
+				coeff[3*k+1] = c[k].y;
+				coeff[3*k+2] = c[k].z;
+			}
+			p[0] = cb->s1->pos.x, p[1] = cb->s1->pos.y, p[2] = cb->s1->pos.z;
+			m_gsrc.SetTrajectory (i, p, cubic ? coeff : NULL);
+		}
+	}
+}
+
+int PlanetarySystem::GravSourceIndex (const Body *body) const
+{
+	if (!body || body->Type() == OBJTP_VESSEL) return -1;
+	for (size_t i = 0; i < celestials.size(); i++)
+		if (celestials[i] == body) return (int)i;
+	return -1;
+}
+
+bool PlanetarySystem::GaccSnapshot (const Vector &gpos, double n, const Body *exclude, const GFieldData *gfd,
+	const CelestialBody *cbody, const Vector *relpos, Vector &acc) const
+{
+	if (m_gsrc.Size() != (int)celestials.size()) return false;              // no snapshot yet
+	if (n != 0.0 && n != 1.0 && !m_gsrc.Interpolated()) return false;      // needs bisection interpolation
+
+	int iexcl = GravSourceIndex (exclude);
+	int icb = GravSourceIndex (cbody);
+	if (icb >= 0 && iexcl >= 0 && icb != iexcl) return false; // only one source can be omitted
+	int iskip = (icb >= 0 ? icb : iexcl);
+	DWORD i, j;
+	double q[3] = {gpos.x, gpos.y, gpos.z}, a[3], p[3];
+
+	// point-mass terms
+	if (gfd) m_gsrc.Acc (n, q, gfd->gravidx, gfd->ngrav, iskip, a);
+	else     m_gsrc.Acc (n, q, iskip, a);
+	acc.Set (a[0], a[1], a[2]);
+
+	// nonspherical perturbations
+	if (gfd) {
+		for (j = 0; j < gfd->ngrav; j++) {
+			i = gfd->gravidx[j];
+			if ((int)i == iexcl || !m_gsrc.Nonspherical (i)) continue;
+			if ((int)i == icb) {
+				acc += SingleGacc_perturbation (-*relpos, cbody);
+			} else {
+				m_gsrc.Position (i, n, p);
+				acc += SingleGacc_perturbation (Vector (p[0], p[1], p[2]) - gpos, celestials[i]);
+			}
+		}
+	} else {
+		const std::vector<int> &ns = m_gsrc.NonsphericalList();
+		for (j = 0; j < ns.size(); j++) {
+			i = ns[j];
+			if ((int)i == iexcl) continue;
+			if ((int)i == icb) {
+				acc += SingleGacc_perturbation (-*relpos, cbody);
+			} else {
+				m_gsrc.Position (i, n, p);
+				acc += SingleGacc_perturbation (Vector (p[0], p[1], p[2]) - gpos, celestials[i]);
+			}
+		}
+	}
+	return true;
+}
+
 Vector PlanetarySystem::Gacc (const Vector &gpos, const Body *exclude, const GFieldData *gfd) const
 {
 	Vector acc;
 	DWORD i, j;
 
+	if (GaccSnapshot (gpos, 0.0, exclude, gfd, 0, 0, acc))
+		return acc;
+
 	if (gfd) {
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
@@ -698,7 +836,10 @@ Vector PlanetarySystem::Gacc_intermediate (const Vector &gpos, double n, const B
 {
 	Vector acc;
 	DWORD i, j;
-	
+
+	if (GaccSnapshot (gpos, n, exclude, gfd, 0, 0, acc))
+		return acc;
+
 	if (gfd) { // use body's source list
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
@@ -720,6 +861,9 @@ Vector PlanetarySystem::Gacc_intermediate_pert (const CelestialBody *cbody, cons
 	DWORD i, j;
 	Vector gpos = relpos + cbody->InterpolatePosition (n);
 
+	if (GaccSnapshot (gpos, n, exclude, gfd, cbody, &relpos, acc))
+		return acc;
+
 	if (gfd) { // use body's source list
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
@@ -748,6 +892,9 @@ Vector PlanetarySystem::GaccRel (const Vector &rpos, const CelestialBody *cbody,
 
 	Vector gpos (rpos + cbody->InterpolatePosition (n));
 
+	if (GaccSnapshot (gpos, n, exclude, gfd, 0, 0, acc))
+		return acc;
+
 	if (gfd) { // use bodies's source list
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
@@ -763,6 +910,37 @@ Vector PlanetarySystem::GaccRel (const Vector &rpos, const CelestialBody *cbody,
 	return acc;
 }
 
+void PlanetarySystem::GaccN (const Vector *gpos, Vector *acc, int nq, double n) const
+{
+	int k;
+	if (m_gsrc.Size() != (int)celestials.size() || (n != 0.0 && n != 1.0 && !m_gsrc.Interpolated())) {
+		for (k = 0; k < nq; k++) // no usable snapshot
+			acc[k] = Gacc_intermediate (gpos[k], n);
+		return;
+	}
+
+	// point-mass terms for all positions
+	static thread_local std::vector<double> buf;
+	buf.resize (6*nq);
+	double *qx = buf.data(), *qy = qx+nq, *qz = qy+nq;
+	double *ax = qz+nq, *ay = ax+nq, *az = ay+nq;
+	for (k = 0; k < nq; k++)
+		qx[k] = gpos[k].x, qy[k] = gpos[k].y, qz[k] = gpos[k].z;
+	m_gsrc.AccN (n, qx, qy, qz, nq, -1, ax, ay, az);
+	for (k = 0; k < nq; k++)
+		acc[k].Set (ax[k], ay[k], az[k]);
+
+	// nonspherical perturbations
+	const std::vector<int> &ns = m_gsrc.NonsphericalList();
+	for (size_t j = 0; j < ns.size(); j++) {
+		double p[3];
+		m_gsrc.Position (ns[j], n, p);
+		Vector spos (p[0], p[1], p[2]);
+		for (k = 0; k < nq; k++)
+			acc[k] += SingleGacc_perturbation (spos - gpos[k], celestials[ns[j]]);
+	}
+}
+
 Vector PlanetarySystem::GaccPn_perturbation (const Vector &gpos, double n, const CelestialBody *cbody) const
 {
 	return SingleGacc_perturbation (cbody->InterpolatePosition (n) - gpos, cbody);
@@ -815,19 +993,90 @@ Vector PlanetarySystem::GetMomentumFlux (const Vector &gpos) const
 void PlanetarySystem::Update (bool force)
 {
 	DWORD i;
-	for (i = 0; i < bodies      .size(); i++) bodies      [i]->BeginStateUpdate ();
-	for (i = 0; i < stars       .size(); i++) stars       [i]->RelTrueAndBaryState();
-	for (i = 0; i < stars       .size(); i++) stars       [i]->AbsTrueState();
-	for (i = 0; i < celestials  .size(); i++) celestials  [i]->Update (force);
-	for (i = 0; i < vessels     .size(); i++) vessels     [i]->UpdateBodyForces ();
-	for (i = 0; i < supervessels.size(); i++) supervessels[i]->Update (force);
-	for (i = 0; i < vessels     .size(); i++) vessels     [i]->Update (force);
+	{
+		PROFILE_ZONE("Psys: celestial bodies");
+		for (i = 0; i < bodies      .size(); i++) bodies      [i]->BeginStateUpdate ();
+		for (i = 0; i < stars       .size(); i++) stars       [i]->RelTrueAndBaryState();
+		for (i = 0; i < stars       .size(); i++) stars       [i]->AbsTrueState();
+		for (i = 0; i < celestials  .size(); i++) celestials  [i]->Update (force);
+		for (i = 0; i < celestials  .size(); i++) celestials  [i]->SetupInterpolation ();
+		UpdateGravitySources (true);
+	}
+	{
+		PROFILE_ZONE("Psys: vessel body forces");
+		for (i = 0; i < vessels     .size(); i++) vessels     [i]->UpdateBodyForces ();
+	}
+	if (m_multiRate) {
+		PROFILE_ZONE("Psys: vessel update schedule");
+		ScheduleVesselUpdates ();
+	}
+	if (m_updatePool) {
+		PROFILE_ZONE("Psys: concurrent propagation");
+		PropagateConcurrent (force);
+	}
+	{
+		PROFILE_ZONE("Psys: super-vessels");
+		for (i = 0; i < supervessels.size(); i++) supervessels[i]->Update (force);
+	}
+	{
+		PROFILE_ZONE("Psys: vessels");
+		for (i = 0; i < vessels     .size(); i++) vessels     [i]->Update (force);
+	}
+}
+
+void PlanetarySystem::ScheduleVesselUpdates ()
+{
+	// The intervals are re-evaluated at every step, so a vessel that starts
+	// thrusting or approaches the surface gets a full update immediately.
+	// Between full updates, vessels coast from their last full update
+	// (see RigidBody::Update)
+	for (DWORD i = 0; i < vessels.size(); i++)
+		vessels[i]->SetUpdateInterval (VesselUpdateInterval (vessels[i]));
+}
+
+double PlanetarySystem::VesselUpdateInterval (const Vessel *vessel) const
+{
+	if (!vessel->CanCoast()) return 0.0;
+
+	const CelestialBody *cbody = vessel->ElRef();
+	return OrbitCoast::Interval (vessel->GPos().dist (cbody->GPos()), vessel->GVel().dist (cbody->GVel()),
+		vessel->AngularVelocity().length(), m_mrOrbitStep, m_mrMaxInterval, td.SimDT);
+}
+
+void PlanetarySystem::SyncVesselUpdates ()
+{
+	for (DWORD i = 0; i < vessels.size(); i++)
+		vessels[i]->Resync ();
+}
+
+void PlanetarySystem::PropagateConcurrent (bool force)
+{
+	// The dynamic propagation of a free-flying vessel only reads the
+	// celestial body states, which are final at this point, and writes
+	// its own state. Everything that may call into vessel modules or touch
+	// shared state (surface contact, animations, playback, docking
+	// hierarchies) stays in the serial Update calls.
+	DWORD i;
+	m_propagateList.clear();
+	for (i = 0; i < supervessels.size(); i++)
+		if (supervessels[i]->CanPropagateConcurrently())
+			m_propagateList.push_back (supervessels[i]);
+	for (i = 0; i < vessels.size(); i++)
+		if (vessels[i]->CanPropagateConcurrently())
+			m_propagateList.push_back (vessels[i]);
+	if (m_propagateList.size() < 2) return; // nothing to gain
+
+	m_updatePool->Run (m_propagateList.size(), [this,force](size_t k) {
+		m_propagateList[k]->Propagate (force);
+	});
 }
 
 void PlanetarySystem::FinaliseUpdate ()
 {
 	DWORD i;
 	for (i = 0; i < bodies.size(); i++) bodies[i]->EndStateUpdate ();
+	UpdateGravitySources (false);
+	UpdateVesselIndex ();
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->PostUpdate ();
 	for (i = 0; i < vessels.size(); i++) vessels[i]->PostUpdate ();
 }
@@ -839,10 +1088,56 @@ void PlanetarySystem::Timejump (const TimeJumpData& jump)
 	for (i = 0; i < stars.size(); i++) stars[i]->RelTrueAndBaryState();
 	for (i = 0; i < stars.size(); i++) stars[i]->AbsTrueState();
 	for (i = 0; i < celestials.size(); i++) celestials[i]->Update (true);
+	for (i = 0; i < celestials.size(); i++) celestials[i]->SetupInterpolation ();
 	for (i = 0; i < bodies.size(); i++) bodies[i]->EndStateUpdate ();
+	UpdateGravitySources (false);
 
 	for (i = 0; i < vessels.size(); i++)
 		vessels[i]->Timejump(jump.dt, jump.mode);
+	UpdateVesselIndex ();
+	SyncVesselUpdates ();
+}
+
+void PlanetarySystem::UpdateVesselIndex ()
+{
+	PROFILE_ZONE("Psys: vessel index");
+	m_vesselIndex.Refresh (VesselIndexPos);
+}
+
+void PlanetarySystem::VesselIndexPos (const void *obj, Vector &pos, double &size)
+{
+	const Vessel *v = (const Vessel*)obj;
+	pos = v->GPos();
+	size = v->Size();
+}
+
+Vessel *PlanetarySystem::NearestVessel (const Vector &gpos, const Vessel *exclude, double *dist2) const
+{
+	return (Vessel*)m_vesselIndex.Nearest (gpos, exclude, dist2);
+}
+
+size_t PlanetarySystem::VesselsInRange (const Vector &gpos, double range, std::vector<Vessel*> &list, const Vessel *exclude) const
+{
+	static thread_local std::vector<const void*> obj;
+	obj.clear();
+	m_vesselIndex.Query (gpos, range, obj, exclude);
+	list.clear();
+	for (auto it = obj.begin(); it != obj.end(); it++)
+		list.push_back ((Vessel*)*it);
+	return list.size();
+}
+
+void PlanetarySystem::BuildEphemerisCache (double mjd0, double mjd1)
+{
+	for (DWORD i = 0; i < celestials.size(); i++) {
+		CelestialBody *cbody = celestials[i];
+		CELBODY *module = cbody->GetModuleInterface();
+		if (!module || !module->bEphemeris()) continue;
+		if (cbody->BuildEphemerisCache (mjd0, mjd1))
+			LOGOUT("Ephemeris cache for %s built (MJD %0.1f-%0.1f)", cbody->Name(), mjd0, mjd1);
+		else
+			LOGOUT_WARN("Ephemeris cache for %s could not be built", cbody->Name());
+	}
 }
 
 void PlanetarySystem::InitDeviceObjects ()
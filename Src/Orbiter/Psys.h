@@ -9,10 +9,14 @@
 #include "Base.h"
 #include "Star.h"
 #include "Planet.h"
+#include "SpatialIndex.h"
+#include "GravityKernel.h"
+#include "ObjectRegistry.h"
 #include <functional>
 
 class Vessel;
 class SuperVessel;
+class TaskPool;
 struct TimeJumpData;
 
 Vector SingleGacc (const Vector &rpos, const CelestialBody *body);
@@ -73,6 +77,17 @@ public:
 	bool isVessel (const Vessel *v) const;
 	// returns true if v is a registered vessel
 
+	Vessel *NearestVessel (const Vector &gpos, const Vessel *exclude = 0, double *dist2 = 0) const;
+	// Return the vessel closest to global position gpos, except exclude,
+	// or 0 if there is none. The squared distance is returned in dist2.
+
+	size_t VesselsInRange (const Vector &gpos, double range, std::vector<Vessel*> &list, const Vessel *exclude = 0) const;
+	// Fill list with the vessels within distance range of gpos, except
+	// exclude. Returns the number of vessels found.
+
+	inline double MaxVesselSize () const { return m_vesselIndex.MaxObjSize(); }
+	// Largest vessel size, as of the last index update
+
 	DWORD nBase(const Planet *planet) const { return planet->nBase(); }
 	Base *GetBase (const Planet *planet, DWORD i) { return planet->GetBase(i); }
 	Base *GetBase (const Planet *planet, const char *name, bool ignorecase = false);
@@ -109,6 +124,14 @@ public:
 	// if _vessel was camera target, then camera will switch to _alt_cam_tgt
 	// (or Sun, if no target provided)
 
+	void AddVessels (const std::vector<Vessel*> &list);
+	// add a batch of new vessels to the system
+
+	size_t DelVessels (const std::vector<Vessel*> &list);
+	// remove a batch of vessels from the system and free them. The vessels
+	// are removed from all lists before any of them is deleted.
+	// Returns the number of vessels removed.
+
 	void DockVessels (Vessel *vessel1, Vessel *vessel2, int port1 = 0, int port2 = 0, bool mixmoments = true);
 	// create a composite vessel by connecting two vessels (or vessel groups)
 	// at their respective docking ports port1 and port2
@@ -129,6 +152,16 @@ public:
 	void Timejump (const TimeJumpData& jump);
 	// Discontinuous step
 
+	void SyncVesselUpdates ();
+	// Synchronise all vessels to the global clock: the next step is a full
+	// dynamic update for every vessel. Called at event boundaries (focus
+	// change, docking, scenario save, time jumps) when multi-rate updates
+	// are enabled.
+
+	void BuildEphemerisCache (double mjd0, double mjd1);
+	// Write precompiled ephemerides over [mjd0,mjd1] for all celestial
+	// bodies with ephemeris modules
+
 	void ScanGFieldSources (const Vector *gpos, const Body *exclude, GFieldData *gfd) const;
 	// Build a list of significant gravity sources at point 'gpos',
 	// excluding body 'exclude', and return results in 'gfd'.
@@ -167,6 +200,11 @@ public:
 	// this version calculates the gravitational acceleration vector at fractional time n during
 	// current time step for position 'rpos' relative to 'cbody'
 
+	void GaccN (const Vector *gpos, Vector *acc, int nq, double n = 0.0) const;
+	// Acceleration vectors due to all gravity sources at nq global positions gpos
+	// at fractional time n during the current time step (0<=n<=1). Evaluates
+	// the point-mass terms for all positions in one pass over the source snapshot.
+
 	CelestialBody *GetDominantGravitySource (const Vector &gpos, double &gfrac);
 	// return the dominant object contributing to the gravity field
 	// at position pos. gfrac is the fractional contribution of the
@@ -248,6 +286,71 @@ private:
 	bool DelSuperVessel (SuperVessel *sv);
 	// remove a vessel superstructure from the list
 
+	void PropagateConcurrent (bool force);
+	// Propagate the dynamic state of all eligible vessels and superstructures
+	// on the update thread pool. Vessels processed here skip the propagation
+	// in their subsequent serial Update call.
+
+	TaskPool *m_updatePool;
+	// worker threads for concurrent vessel propagation (NULL if disabled)
+
+	void ScheduleVesselUpdates ();
+	// Assign each vessel the interval between its full dynamic updates for
+	// the current step (multi-rate updates)
+
+	double VesselUpdateInterval (const Vessel *vessel) const;
+	// Interval between full dynamic updates of a vessel, from its orbit
+	// period and angular velocity [s]. 0 if the vessel must be updated at
+	// every step.
+
+	bool m_multiRate;         // multi-rate vessel updates enabled
+	double m_mrOrbitStep;     // max. multi-rate update interval as fraction of the orbit period
+	double m_mrMaxInterval;   // max. multi-rate update interval [s]
+
+	ObjectRegistry m_registry;
+	// index of all objects in 'bodies' for handle validation and name
+	// lookup. Objects are added and removed with AddBody/DelBody.
+
+	enum { // object categories in m_registry
+		REG_VESSEL = 1,
+		REG_GRAV   = 2,
+		REG_PLANET = 4
+	};
+
+	SpatialIndex m_vesselIndex;
+	// spatial index of vessel positions for proximity queries. Vessels are
+	// added and removed with AddVessel(s)/DelVessel(s), and their positions are
+	// updated at the end of each time step.
+
+	void UpdateVesselIndex ();
+	// refresh the vessel positions in m_vesselIndex
+
+	static void VesselIndexPos (const void *obj, Vector &pos, double &size);
+	// position and size of a vessel in m_vesselIndex
+
+	GravitySources m_gsrc;
+	// snapshot of the gravitational parameters and positions of the
+	// celestial bodies in the order of 'celestials', used by the Gacc
+	// functions. Refreshed with UpdateGravitySources.
+
+	void UpdateGravitySources (bool step);
+	// refresh m_gsrc from the current celestial body states. If step is
+	// true, also store the end-of-step positions and trajectory interpolants
+	// (update phase, after SetupInterpolation)
+
+	int GravSourceIndex (const Body *body) const;
+	// index of 'body' in the celestial body list, or -1
+
+	bool GaccSnapshot (const Vector &gpos, double n, const Body *exclude, const GFieldData *gfd,
+		const CelestialBody *cbody, const Vector *relpos, Vector &acc) const;
+	// Gravitational acceleration at gpos at fractional step time n from the
+	// source snapshot. If cbody is set, its point-mass term is omitted and its
+	// perturbation is evaluated at -relpos. Returns false if the snapshot
+	// can't be used (not available, or sources without cubic interpolant for
+	// 0<n<1), in which case the caller falls back to the body interpolants.
+
+	std::vector<VesselBase*> m_propagateList;
+	// scratch list of vessels propagated concurrently in the current step
 };
 
 #endif // !__PSYS_H
\ No newline at end of file
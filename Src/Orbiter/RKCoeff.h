@@ -0,0 +1,162 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// RKCoeff.h
+// Runge-Kutta integration parameters used by the driver routines of the
+// RigidBody propagators (BodyIntegrator.cpp).
+// (Note that RK2 and RK4 are implemented directly without using the
+// driver routines)
+//
+// Tables for an n-stage method:
+//    alpha[n-1]:       stage time fractions of stages 1..n-1
+//    beta[(n-1)^2]:    stage weights, row i-1 for stage i
+//    gamma[n]:         solution weights
+//    egamma[n]:        (embedded pairs only) difference between the
+//                      weights of the solution and of the embedded lower
+//                      order solution, for local error estimates
+// =======================================================================
+
+#ifndef __RKCOEFF_H
+#define __RKCOEFF_H
+
+// ===========================================================================
+// Runge-Kutta integration parameters (RK5-RK8)
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// RK5 6-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK5_n = 6;
+static const double RK5_alpha[RK5_n-1] = {
+	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0
+};
+static const double RK5_beta[(RK5_n-1)*(RK5_n-1)] = {
+	1.0/5.0, 0, 0, 0, 0,
+	3.0/40.0, 9.0/40.0, 0, 0, 0,
+	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0,
+	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0,
+	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0
+};
+static const double RK5_gamma[RK5_n] = {
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
+};
+
+// ---------------------------------------------------------------------------
+// RK6 8-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK6_n = 8;
+static const double RK6_alpha[RK6_n-1] = {
+	1.0/6.0, 4.0/15.0, 2.0/3.0, 5.0/6.0, 1.0, 1.0/15.0, 1.0
+};
+static const double RK6_beta[(RK6_n-1)*(RK6_n-1)] = {
+	1.0/6.0, 0, 0, 0, 0, 0, 0,
+	4.0/75.0, 16.0/75.0, 0, 0, 0, 0, 0,
+	5.0/6.0, -8.0/3.0, 5.0/2.0, 0, 0, 0, 0,
+	-165.0/64.0, 55.0/6.0, -425.0/64.0, 85.0/96.0, 0, 0, 0,
+	12.0/5.0, -8.0, 4015.0/612.0, -11.0/36.0, 88.0/255.0, 0, 0,
+	-8263.0/15000.0, 124.0/75.0, -643.0/680.0, -81.0/250.0, 2484.0/10625.0, 0, 0,
+	3501.0/1720.0, -300.0/43.0, 297275.0/52632.0, -319.0/2322.0, 24068.0/84065.0, 0, 3850.0/26703.0
+};
+static const double RK6_gamma[RK6_n] = {
+	3.0/40.0, 0, 875.0/2244.0, 23.0/72.0, 264.0/1955.0, 0, 125.0/11592.0, 43.0/616.0
+};
+
+// ---------------------------------------------------------------------------
+// RK7 11-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK7_n = 11;
+static const double RK7_alpha[RK7_n-1] = {
+	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0
+};
+static const double RK7_beta[(RK7_n-1)*(RK7_n-1)] = {
+	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0,
+	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0,
+	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0,
+	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0,
+	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0,
+	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0,
+	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0,
+	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0
+};
+static const double RK7_gamma[RK7_n] = {
+	41.0/840.0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 41.0/840.0
+};
+
+// ---------------------------------------------------------------------------
+// RK8 13-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK8_n = 13;
+static const double RK8_alpha[RK8_n-1] = {
+	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0, 0, 1.0
+};
+static const double RK8_beta[(RK8_n-1)*(RK8_n-1)] = {
+	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0, 0, 0,
+	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0, 0, 0,
+	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0, 0, 0,
+	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0, 0, 0,
+	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0, 0, 0,
+	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0, 0, 0,
+	3.0/205.0, 0, 0, 0, 0, -6.0/41.0, -3.0/205.0, -3.0/41.0, 3.0/41.0, 6.0/41.0, 0, 0,
+	-1777.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -289.0/82.0, 2193.0/4100.0, 51.0/82.0, 33.0/164.0, 12.0/41.0, 0, 1.0
+};
+static const double RK8_gamma[RK8_n] = {
+	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
+};
+
+// ===========================================================================
+// Embedded Runge-Kutta pairs for adaptive step size control
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// Dormand-Prince 5(4) 7-stage parameters
+// Stages 0-5 are those of RK5, the last stage is evaluated at the 5th order
+// solution (FSAL: it is the first stage of the next step).
+// ---------------------------------------------------------------------------
+
+static const int RK45_n = 7;
+static const int RK45_order = 4; // order of the embedded error estimate
+static const double RK45_alpha[RK45_n-1] = {
+	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0, 1.0
+};
+static const double RK45_beta[(RK45_n-1)*(RK45_n-1)] = {
+	1.0/5.0, 0, 0, 0, 0, 0,
+	3.0/40.0, 9.0/40.0, 0, 0, 0, 0,
+	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0, 0,
+	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0, 0,
+	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0, 0,
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
+};
+static const double RK45_gamma[RK45_n] = {
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0, 0
+};
+static const double RK45_egamma[RK45_n] = {
+	71.0/57600.0, 0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0, 22.0/525.0, -1.0/40.0
+};
+
+// ---------------------------------------------------------------------------
+// Runge-Kutta-Fehlberg 7(8) 13-stage parameters
+// Uses the RK8 stages. The error estimate is the difference to the 7th
+// order solution of the first 11 stages (RK7).
+// ---------------------------------------------------------------------------
+
+static const int RK78_n = RK8_n;
+static const int RK78_order = 7; // order of the embedded error estimate
+static const double *const RK78_alpha = RK8_alpha;
+static const double *const RK78_beta  = RK8_beta;
+static const double *const RK78_gamma = RK8_gamma;
+static const double RK78_egamma[RK78_n] = {
+	-41.0/840.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -41.0/840.0, 41.0/840.0, 41.0/840.0
+};
+
+#endif // !__RKCOEFF_H
@@ -0,0 +1,77 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// RKStepControl.h
+// Step size control for the embedded Runge-Kutta pairs (RKCoeff.h) of the
+// adaptive RigidBody propagator (RigidBody::PropagateAdaptive).
+// An interval T is covered by steps whose normalised local error estimate
+// is <= 1. Steps down to T/submax are always accepted, which limits the
+// number of steps per interval. The proposed step length is carried over
+// to the next interval.
+// =======================================================================
+
+#ifndef __RKSTEPCONTROL_H
+#define __RKSTEPCONTROL_H
+
+#include <math.h>
+
+class RKStepControl {
+public:
+	RKStepControl (double _T, int submax, int order, double h0)
+		: T(_T), hmin(_T/submax), expo(-1.0/(order+1)), t(0.0), h(0.0), hprop(h0 > 0.0 ? h0 : _T), last(false) {}
+	// Control the steps over interval _T for a pair with error estimate of
+	// the given order, starting with step length h0 (<= 0: full interval)
+
+	inline bool Done () const { return t >= T; }
+	// interval completed?
+
+	inline double Time () const { return t; }
+	// start of the current step, relative to the start of the interval
+
+	inline bool Forced () const { return h <= hmin; }
+	// current step is accepted regardless of its error estimate?
+
+	inline double Proposal () const { return hprop; }
+	// proposed length of the next step
+
+	double Step ()
+	// Returns the length of the next step attempt
+	{
+		h = (hprop > hmin ? hprop : hmin);
+		last = (h >= (T-t)*(1.0-1e-10));
+		if (last) h = T-t;
+		return h;
+	}
+
+	bool Accept (double err)
+	// Update the proposal from the normalised error estimate of the current
+	// step. Returns true if the step is accepted, and advances the time.
+	{
+		double fac = (err > 0.0 ? 0.9*pow (err, expo) : 5.0);
+		if      (fac < 0.2) fac = 0.2;
+		else if (fac > 5.0) fac = 5.0;
+		if (err <= 1.0 || h <= hmin) {
+			t = (last ? T : t+h);
+			// a step truncated at the end of the interval doesn't limit the next proposal
+			if (h < hprop && fac >= 1.0) {
+				if (h*fac > hprop) hprop = h*fac;
+			} else hprop = h*fac;
+			return true;
+		} else {
+			hprop = h*fac; // rejected: retry with shorter step
+			return false;
+		}
+	}
+
+private:
+	const double T;    // interval length
+	const double hmin; // minimum step length
+	const double expo; // exponent for the step length update
+	double t;          // current time in the interval
+	double h;          // current step length
+	double hprop;      // proposed step length
+	bool last;         // current step ends the interval?
+};
+
+#endif // !__RKSTEPCONTROL_H
@@ -20,6 +20,10 @@
 #include "Element.h"
 #include "Astro.h"
 #include "Log.h"
+#include "CfgFile.h"
+#include "Profiler.h"
+#include "RKCoeff.h"
+#include "RKStepControl.h"
 
 using namespace std;
 
@@ -34,10 +38,24 @@ extern char DBG_MSG[256];
 bool       RigidBody::bDistmass = false;
 bool       RigidBody::bGPerturb = false;
 int        RigidBody::nPropLevel = 1;
-RigidBody::PROPMODE RigidBody::PropMode[MAX_PROP_LEVEL] = {&RigidBody::RK2_LinAng, 0, 0.0, 0.0, 0.0, 0.0};
+RigidBody::PROPMODE RigidBody::PropMode[MAX_PROP_LEVEL] = {&RigidBody::RK2_LinAng, 0, 0, 0, 0.0, 0.0, 0.0, 0.0};
+double     RigidBody::PropTol = 1e-9;
 
 const double gfielddata_updt_interval = 60.0;
 
+// frame profiler zone of a propagation method
+static int PropagatorZone (int idx)
+{
+	static struct Zones {
+		int id[NPROP_METHOD];
+		Zones () {
+			for (int i = 0; i < NPROP_METHOD; i++)
+				id[i] = g_profiler.RegisterZone ((std::string("Propagator ") + RigidBody::PropagatorStr (i, false)).c_str());
+		}
+	} zones;
+	return (idx >= 0 && idx < NPROP_METHOD ? zones.id[idx] : -1);
+}
+
 inline Vector Call_EulerInv_full (RigidBody *body, const Vector &tau, const Vector &omega)
 { return body->EulerInv_full (tau, omega); }
 inline Vector Call_EulerInv_simple (RigidBody *body, const Vector &tau, const Vector &omega)
@@ -62,7 +80,8 @@ RigidBody::RigidBody (double _mass, double _size, const Vector &_pmi): Body (_ma
 RigidBody::RigidBody (char *fname): Body (fname)
 {
 	SetDefaultCaps ();
-	ifstream ifs (g_pOrbiter->ConfigPath (fname));
+	CfgFile ifs;
+	g_pOrbiter->preload.OpenConfig (ifs, g_pOrbiter->ConfigPath (fname));
 	if (ifs) ReadGenericCaps (ifs);
 }
 
@@ -87,13 +106,20 @@ void RigidBody::SetDefaultCaps ()
 	bDistmass = g_pOrbiter->Cfg()->CfgPhysicsPrm.bDistributedMass;
 	bGPerturb = g_pOrbiter->Cfg()->CfgPhysicsPrm.bNonsphericalGrav;
 	bOrbitStabilised = false;
+	bOnRails = false;
+	railbody = 0;
+	bCoast = false;
+	update_h = 0.0;
+	coastbody = 0;
 	bIgnoreGravTorque = false;
 	tidaldamp = 0.0;
 	PropLevel = 0;
 	PropSubMax = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropSubMax;
 	nPropSubsteps = 1;
+	adapt_h = 0.0;
 	gfielddata.ngrav = 0;
 	gfielddata.updt = -1e10; // invalidate
+	gfielddata_updt_ofs = (gfielddata_updt_interval*rand())/RAND_MAX;
 }
 
 void RigidBody::ReadGenericCaps (ifstream &ifs)
@@ -136,12 +162,15 @@ void RigidBody::SetupPropagationModes ()
 {
 	int i;
 	nPropLevel = g_pOrbiter->Cfg()->CfgPhysicsPrm.nLPropLevel;
+	PropTol = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropTolerance;
 	for (i = 0; i < nPropLevel; i++) {
 		PropMode[i].ttgt = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropTTgt[i];
 		PropMode[i].atgt = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropATgt[i];
 		PropMode[i].tlim = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropTLim[i];
 		PropMode[i].alim = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropALim[i];
 		PropMode[i].propidx = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropMode[i];
+		PropMode[i].adaptive = 0;
+		PropMode[i].order = 0;
 		switch (PropMode[i].propidx) {
 		case PROP_RK2:  PropMode[i].propagator = &RigidBody::RK2_LinAng;  break;
 		case PROP_RK4:  PropMode[i].propagator = &RigidBody::RK4_LinAng;  break;
@@ -153,6 +182,12 @@ void RigidBody::SetupPropagationModes ()
 		case PROP_SY4:  PropMode[i].propagator = &RigidBody::SY4_LinAng;  break;
 		case PROP_SY6:  PropMode[i].propagator = &RigidBody::SY6_LinAng;  break;
 		case PROP_SY8:  PropMode[i].propagator = &RigidBody::SY8_LinAng;  break;
+		case PROP_RK45: PropMode[i].propagator = &RigidBody::RK5_LinAng;  // fixed-step fallback
+		                PropMode[i].adaptive = &RigidBody::RK45_LinAng_Adaptive;
+		                PropMode[i].order = RK45_order;  break;
+		case PROP_RK78: PropMode[i].propagator = &RigidBody::RK8_LinAng;  // fixed-step fallback
+		                PropMode[i].adaptive = &RigidBody::RK78_LinAng_Adaptive;
+		                PropMode[i].order = RK78_order;  break;
 		default:        PropMode[i].propagator = &RigidBody::RK4_LinAng;  break;
 		}
 	}
@@ -174,7 +209,37 @@ void RigidBody::SetPropagator (int &plevel, int &nstep) const
 		if (astep < PropMode[plevel].alim)
 			break;
 
-	nstep = min (PropSubMax, (int)ceil (max (td.SimDT / PropMode[plevel].ttgt, astep / PropMode[plevel].atgt)));
+	if (PropMode[plevel].adaptive)
+		nstep = 0; // step size control by the propagator
+	else
+		nstep = min (PropSubMax, (int)ceil (max (td.SimDT / PropMode[plevel].ttgt, astep / PropMode[plevel].atgt)));
+}
+
+// =======================================================================
+
+int RigidBody::PropagateAdaptive ()
+{
+	// Step size control for the embedded Runge-Kutta pairs. Steps are
+	// accepted if the estimated local error in position and velocity is
+	// below PropTol relative to the state w.r.t. the reference body.
+	// The number of steps is limited by PropSubMax: steps down to
+	// SimDT/PropSubMax are always accepted.
+	const PROPMODE &pm = PropMode[PropLevel];
+	const double T = td.SimDT;
+	const double pscale = PropTol * max (cpos.length(), 1.0);
+	const double vscale = PropTol * max (cvel.length(), 1.0);
+	RKStepControl sc (T, PropSubMax, pm.order, adapt_h);
+	double h, err;
+	int nstep = 0;
+
+	while (!sc.Done()) {
+		h = sc.Step ();
+		err = ((*this).*(pm.adaptive)) (sc.Time(), h, T, pscale, vscale, sc.Forced());
+		if (sc.Accept (err)) // the propagator has updated s1 and the moments
+			nstep++;
+	}
+	adapt_h = sc.Proposal();
+	return nstep;
 }
 
 // =======================================================================
@@ -204,15 +269,29 @@ void RigidBody::Update (bool force)
 		// Update the list of gravity field sources
 		if (force || !gfielddata.ngrav) {
 			ScanGFieldSources (g_psys);
-			gfielddata.updt = td.SimT0 + (gfielddata_updt_interval*rand())/RAND_MAX;
+			gfielddata.updt = td.SimT0 + gfielddata_updt_ofs;
 			// randomize update times
 		} else if (td.SimT0 > gfielddata.updt) {
 			UpdateGFieldSources (g_psys);
 			gfielddata.updt = td.SimT0 + gfielddata_updt_interval;
 		}
 
-		// First check if we should do a stabilised state update
-		if (bCanUpdateStabilised &&
+		// Propagate analytically if nothing but the reference body acts on us,
+		// or coast from the last full update if no full update is due yet;
+		// otherwise check if we should do a stabilised state update
+		bool coasting = coast.Covers (td.SimT1, update_h);
+		if (CanUpdateOnRails() && UpdateOnRails()) {
+
+			el_valid = bOrbitStabilised = false;
+			bCoast = false;
+
+		} else if (coasting && UpdateCoasting()) {
+
+			el_valid = bOrbitStabilised = false;
+			bOnRails = false;
+			bCoast = true;
+
+		} else if (bCanUpdateStabilised &&
 			ostep > g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_SLimit &&
 			g_psys->GetGravityContribution (cbody, cpos+cbody->GPos()) > 1-g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_PLimit) {
 
@@ -220,6 +299,7 @@ void RigidBody::Update (bool force)
 			double dt = td.SimDT/nPropSubsteps;
 
 			// Update linear state with Encke's method
+			PROFILE_ZONE("Propagator Encke");
 			s1->Set (*s0);
 			if (!bOrbitStabilised) {
 				FlushRPos();
@@ -237,6 +317,7 @@ void RigidBody::Update (bool force)
 			s1->R.Set (s1->Q);
 			GetIntermediateMoments (acc, tau, *s1, 1, dt);
 			el_valid = bOrbitStabilised = true;
+			bOnRails = bCoast = false;
 
 		} else { // do a dynamic state vector integration
 
@@ -245,19 +326,24 @@ void RigidBody::Update (bool force)
 			do {
 				// Select propagator
 				SetPropagator (PropLevel, nPropSubsteps);
-				double dt = td.SimDT/nPropSubsteps;
+				PROFILE_ZONE_ID(PropagatorZone (PropMode[PropLevel].propidx));
 
 				// Perform step propagation with sub-steps
 				s1->Set (*s0);
 				acc = acc0, arot = arot0;
 				rpos_add = rpos_add0, rvel_add = rvel_add0;
-				for (i = 0; i < nPropSubsteps; i++) {
-					((*this).*(PropMode[PropLevel].propagator)) (dt, nPropSubsteps, i);
-					s1->pos = rpos_base + rpos_add;
-					s1->vel = rvel_base + rvel_add;
-					s1->R.Set (s1->Q);
-					GetIntermediateMoments (acc, tau, *s1, (i+1.0)/nPropSubsteps, dt);
-					arot.Set (EulerInv_full (tau, s1->omega));
+				if (!nPropSubsteps) { // adaptive step size
+					nPropSubsteps = PropagateAdaptive ();
+				} else {
+					double dt = td.SimDT/nPropSubsteps;
+					for (i = 0; i < nPropSubsteps; i++) {
+						((*this).*(PropMode[PropLevel].propagator)) (dt, nPropSubsteps, i);
+						s1->pos = rpos_base + rpos_add;
+						s1->vel = rvel_base + rvel_add;
+						s1->R.Set (s1->Q);
+						GetIntermediateMoments (acc, tau, *s1, (i+1.0)/nPropSubsteps, dt);
+						arot.Set (EulerInv_full (tau, s1->omega));
+					}
 				}
 			} while (!ValidateStateUpdate (s1));
 			//s1->R.Set (s1->Q);
@@ -270,9 +356,14 @@ void RigidBody::Update (bool force)
 				updcount = 0;
 			}
 			el_valid = bOrbitStabilised = false;
+			bOnRails = bCoast = false;
 
 		}
 
+		// starting point for multi-rate coasting
+		if (bOnRails || update_h <= 0.0 || !cbody) coast.Invalidate ();
+		else if (!bCoast) SetCoastAnchor ();
+
 		// Limit angular velocity - this code is intended to prevent
 		// numerical instabilities in the angular integration to
 		// leading to a velocity explosion - a last resort
@@ -303,6 +394,101 @@ void RigidBody::Update (bool force)
 
 // =======================================================================
 
+bool RigidBody::UpdateOnRails ()
+{
+	PROFILE_ZONE("Propagator on-rails");
+	const double mu = Ggrav*cbody->Mass();
+
+	// (re)initialise the rail on entry, after a change of reference body, or
+	// if the state was modified by anything other than the rail itself
+	// (e.g. a state vector update through the API)
+	if (!bOnRails || railbody != cbody || !rail.Valid() ||
+		cpos.dist2 (railpos) > 1e-2 || cvel.dist2 (railvel) > 1e-6) {
+		double J2R2 = 0.0;
+		if (bGPerturb && cbody->nJcoeff())
+			J2R2 = cbody->Jcoeff(0) * cbody->Size() * cbody->Size();
+		if (!rail.Set (cpos, cvel, mu, td.SimT0, cbody->RotAxis(), J2R2)) {
+			bOnRails = false;
+			return false;
+		}
+		railbody = cbody;
+	}
+
+	// linear state
+	rail.PosVel (td.SimT1, railpos, railvel);
+	s1->Set (*s0);
+	s1->pos.Set (railpos + cbody->s1->pos);
+	s1->vel.Set (railvel + cbody->s1->vel);
+	FlushRPos();
+	FlushRVel();
+	double r = railpos.length();
+	acc.Set (cbody->Acceleration() - railpos*(mu/(r*r*r)));
+
+	RotateTorqueFree ();
+	nPropSubsteps = 1;
+
+	bOnRails = true;
+	return true;
+}
+
+// =======================================================================
+
+bool RigidBody::UpdateCoasting ()
+{
+	if (coastbody != cbody || cpos.dist2 (coastpos) > 1e-2 || cvel.dist2 (coastvel) > 1e-6)
+		return false; // reference body changed, or state modified since the last step
+
+	PROFILE_ZONE("Propagator multi-rate coast");
+	coast.PosVel (td.SimT1, coastpos, coastvel);
+	s1->Set (*s0);
+	s1->pos.Set (coastpos + cbody->s1->pos);
+	s1->vel.Set (coastvel + cbody->s1->vel);
+	FlushRPos();
+	FlushRVel();
+	double r = coastpos.length();
+	acc.Set (coastacc - coastpos*(coast.Mu()/(r*r*r)));
+
+	RotateTorqueFree ();
+	nPropSubsteps = 1;
+	return true;
+}
+
+// =======================================================================
+
+void RigidBody::SetCoastAnchor ()
+{
+	Vector r (s1->pos - cbody->s1->pos), v (s1->vel - cbody->s1->vel);
+	double mu = Ggrav*cbody->Mass(), r1 = r.length();
+	Vector pacc (acc + r*(mu/(r1*r1*r1)));
+	Vector pert (pacc - g_psys->Gacc_intermediate (cbody->s1->pos, 1.0, cbody));
+
+	if (coastbody != cbody) coast.Invalidate (); // no perturbation rate across a change of reference
+	if (!coast.Anchor (r, v, mu, td.SimT1, pert)) return; // open orbit
+	coastbody = cbody;
+	coastacc  = pacc;
+	coastpos  = r;
+	coastvel  = v;
+}
+
+// =======================================================================
+
+void RigidBody::RotateTorqueFree ()
+{
+	// midpoint rule, with substeps limiting the rotation angle per step
+	int i, nsub = (int)ceil (s1->omega.length()*td.SimDT/(0.1*Pi));
+	nsub = max (1, min (nsub, PropSubMax));
+	double h = td.SimDT/nsub;
+	for (i = 0; i < nsub; i++) {
+		Vector omega_h (s1->omega + EulerInv_full (Vector(0,0,0), s1->omega) * (0.5*h));
+		s1->Q.Rotate (omega_h * h);
+		s1->omega += EulerInv_full (Vector(0,0,0), omega_h) * h;
+	}
+	s1->R.Set (s1->Q);
+	arot.Set (0,0,0);
+}
+
+// =======================================================================
+
 void RigidBody::ScanGFieldSources (const PlanetarySystem *psys)
 {
 	psys->ScanGFieldSources (&s0->pos, this, &gfielddata);
@@ -525,12 +711,13 @@ void RigidBody::SetDynamicUpdate (bool dynamic)
 const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 	static const char *ShortPropModeStr[NPROP_METHOD] = {
 		"RK2", "RK4", "RK5", "RK6", "RK7", "RK8",
-		"SY2", "SY4", "SY6", "SY8"
+		"SY2", "SY4", "SY6", "SY8", "RK45", "RK78"
 	};
 	static const char *LongPropModeStr[NPROP_METHOD] = {
 		"Runge-Kutta, 2nd order (RK2)", "Runge-Kutta, 4th order (RK4)", "Runge-Kutta, 5th order (RK5)", "Runge-Kutta, 6th order (RK6)",
 		"Runge-Kutta, 7th order (RK7)", "Runge-Kutta, 8th order (RK8)",
-		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)"
+		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)",
+		"Dormand-Prince 5(4), adaptive (RK45)", "Runge-Kutta-Fehlberg 7(8), adaptive (RK78)"
 	};
 	return (idx < NPROP_METHOD ? (verbose ? LongPropModeStr[idx] : ShortPropModeStr[idx]) : "unknown");
 }
@@ -538,6 +725,8 @@ const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 const char *RigidBody::CurPropagatorStr (bool verbose) const
 {
 	if (!bDynamicPosVel) return "none";
+	else if (bOnRails) return (verbose ? "Analytic orbit (on rails)" : "Rails");
+	else if (bCoast) return (verbose ? "Multi-rate coasting" : "Coast");
 	else return PropagatorStr (PropMode[PropLevel].propidx, verbose);
 }
 
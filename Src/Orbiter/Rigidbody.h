@@ -17,6 +17,7 @@
 #define __RIGIDBODY_H
 
 #include "Body.h"
+#include "OrbitRail.h"
 
 class RigidBody;
 
@@ -53,6 +54,9 @@ typedef void (*AngPropagator)(RigidBody*,const AngIntData&); // angular time pro
 typedef void (RigidBody::*LinAngPropagator)(double, int, int);
 // state propagator function template
 
+typedef double (RigidBody::*LinAngAdaptivePropagator)(double, double, double, double, double, bool);
+// adaptive state propagator function template
+
 // =======================================================================
 
 class RigidBody: public Body {
@@ -88,7 +92,8 @@ public:
 	virtual void SetPropagator (int &plevel, int &nstep) const;
 	// return propagator level (0..nPropLevel-1) and substep number (1..PropSubMax)
 	// for current step. Note that nstep > PropSubMax is valid, but should only be
-	// used for immediate collision treatment
+	// used for immediate collision treatment. nstep = 0 selects the adaptive
+	// step size control of the level's propagator, if it supports it.
 
 	virtual void GetIntermediateMoments (Vector &acc, Vector &tau,
 		const StateVectors &state, double tfrac, double dt);
@@ -167,6 +172,26 @@ public:
 	virtual bool isOrbitStabilised () const { return bOrbitStabilised; }
 	// return true if body uses orbit stabilisation for the current step
 
+	virtual bool isOnRails () const { return bOnRails; }
+	// return true if body was propagated analytically ("on rails") for the current step
+
+	virtual bool isCoasting () const { return bCoast; }
+	// return true if body coasted from its last full update for the current
+	// step (multi-rate update)
+
+	inline void SetUpdateInterval (double h) { update_h = h; }
+	// Set by the vessel update scheduler before each step: interval between
+	// full dynamic updates [s]. Between full updates, the body coasts along
+	// the two-body orbit of its last full update, with the perturbations
+	// extrapolated. 0: full update at every step
+
+	inline double UpdateInterval () const { return update_h; }
+	// interval between full dynamic updates [s] (0: every step)
+
+	inline void Resync () { coast.Invalidate(); }
+	// Discard the state of the last full update, so that the next step is
+	// a full dynamic update
+
 	inline bool canDynamicPosVel () const { return bDynamicPosVel; }
 	// return true if body can update its position by state vector integration
 
@@ -196,6 +221,13 @@ protected:
 	void ReadGenericCaps (std::ifstream &ifs);
 	// Read parameters from a config file
 
+	virtual bool CanUpdateOnRails () const { return false; }
+	// Return true if the body can be propagated analytically ("on rails")
+	// for the current step, i.e. no forces other than the gravity of the
+	// reference body act on it, and nothing requires the full dynamic model.
+	// Evaluated at each step, so the body returns to dynamic propagation as
+	// soon as this returns false.
+
 	inline int NumPropLevel() const { return nPropLevel; } // number of defined propagator levels
 	inline int MaxSubStep() const { return PropSubMax; }   // max number of substeps per step update
 
@@ -213,6 +245,14 @@ protected:
 	// Indicates if the current step was updated by "orbit stabilisation",
 	// i.e. Encke's method.
 
+	bool bOnRails;
+	// Indicates if the current step was updated analytically from the
+	// orbit rail, rather than by state vector integration.
+
+	bool bCoast;
+	// Indicates if the current step was advanced from the last full update
+	// (multi-rate update), rather than by a full dynamic update.
+
 	bool bIgnoreGravTorque;
 	// flag for suppressing gravity-gradient torque (to avoid numerical instability)
 
@@ -232,11 +272,16 @@ protected:
 	static bool bGPerturb;    // nonspherical gravity effects
 
 	GFieldData gfielddata;  // used for dynamic grav updates
+	double gfielddata_updt_ofs; // per-body offset of first gfield update time (spreads updates over steps)
 
 private:
 	static void SetupPropagationModes ();
 	// set up the dynamic time propagation modes
 
+	int PropagateAdaptive ();
+	// propagate the state over the current time step with the adaptive
+	// propagator of the current level. Returns the number of steps taken.
+
 	// -----------------------------------------------------------------------
 	// Dynamic integrators for linear and angular state vectors
 	// Implemented in BodyIntegrator.cpp
@@ -253,6 +298,12 @@ private:
 	void SY6_LinAng (double h, int nsub, int isub);  // symplectic, order 6, linear+angular
 	void SY8_LinAng (double h, int nsub, int isub);  // symplectic, order 8, linear+angular
 
+	// Adaptive integrators with embedded error estimates for linear and angular state vectors
+	double RKdrv_LinAng_Embedded (double t, double h, double T, double pscale, double vscale, bool force,
+		int n, const double *alpha, const double *beta, const double *gamma, const double *egamma, bool fsal); // RK engine for embedded pairs, linear+angular
+	double RK45_LinAng_Adaptive (double t, double h, double T, double pscale, double vscale, bool force); // Dormand-Prince 5(4), linear+angular
+	double RK78_LinAng_Adaptive (double t, double h, double T, double pscale, double vscale, bool force); // Runge-Kutta-Fehlberg 7(8), linear+angular
+
 	// Propagators for 2-body orbit perturbations
 	//void RK2_LinAng_Encke (double h, int nsub, int isub);
 
@@ -263,10 +314,30 @@ private:
 
 	void Encke ();
 
+	bool UpdateOnRails ();
+	// Update the state analytically from the orbit rail (Kepler orbit with
+	// optional secular J2 drift) and propagate the attitude torque-free.
+	// Returns false without updating the state if the orbit is not closed.
+
+	bool UpdateCoasting ();
+	// Advance the state from the last full update: two-body orbit plus the
+	// extrapolated perturbing acceleration, torque-free attitude. Returns
+	// false without updating the state if the reference body or the state
+	// were changed since the last step.
+
+	void SetCoastAnchor ();
+	// Store the state at the end of a full dynamic update as the starting
+	// point for the following coasting steps
+
+	void RotateTorqueFree ();
+	// Propagate the attitude over the current step without torque
+
 	// -----------------------------------------------------------------------
 
 	static struct PROPMODE {
 		LinAngPropagator propagator;
+		LinAngAdaptivePropagator adaptive; // adaptive propagator (NULL if not supported)
+		int order;    // order of the adaptive propagator's error estimate
 		int propidx;  // propagator method index
 		double ttgt;  // time step target [s]
 		double atgt;  // angular step target [rad]
@@ -277,6 +348,16 @@ private:
 	int PropLevel;         // current propagator stage
 	int PropSubMax;        // upper limit for number of subsamples
 	int nPropSubsteps;     // current number of subsamples
+	static double PropTol; // relative error tolerance of the adaptive propagators
+	double adapt_h;        // step length proposed by the adaptive propagator for the next step [s]
+	OrbitRail rail;        // analytic orbit for on-rails propagation
+	const Body *railbody;  // reference body of the orbit rail
+	Vector railpos, railvel; // reference body-relative state expected at the start of the next on-rails step
+	double update_h;       // interval between full updates assigned by the update scheduler [s]
+	OrbitCoast coast;      // two-body orbit and perturbations from the last full update
+	const Body *coastbody; // reference body of the last full update
+	Vector coastacc;       // acceleration at the last full update, excluding the point-mass gravity of the reference body
+	Vector coastpos, coastvel; // reference body-relative state expected at the start of the next coasting step
 };
 
 #endif // !__RIGIDBODY_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #define OAPI_IMPLEMENTATION
 
 #include "Script.h"
+#include "Profiler.h"
 
 const char *path = ".";
 const char *libname = "LuaInline";
@@ -17,6 +18,10 @@ ScriptInterface::ScriptInterface (Orbiter *pOrbiter)
 HINSTANCE ScriptInterface::LoadInterpreterLib ()
 {
 	hLib = orbiter->LoadModule (path, libname);
+	if (hLib) {
+		void(*proc)(bool) = (void(*)(bool))GetProcAddress (hLib, "opcSetCoroutineMode");
+		if (proc) proc (orbiter->Cfg()->CfgDebugPrm.bLuaCoroutines);
+	}
 	return hLib;
 }
 
@@ -50,6 +55,7 @@ INTERPRETERHANDLE ScriptInterface::RunInterpreter (const char *cmd)
 
 bool ScriptInterface::ExecScriptCmd (INTERPRETERHANDLE hInterp, const char *cmd)
 {
+	PROFILE_ZONE("Lua");
 	if (!hLib && !LoadInterpreterLib()) return false;
 	bool(*proc)(INTERPRETERHANDLE,const char*) = (bool(*)(INTERPRETERHANDLE,const char*))GetProcAddress (hLib, "opcExecScriptCmd");
 	if (proc) return proc(hInterp, cmd);
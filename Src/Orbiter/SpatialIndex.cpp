@@ -0,0 +1,211 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// SpatialIndex.cpp
+// Sorted-grid spatial index for proximity queries between objects.
+// =======================================================================
+
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+static const int MAXCELL = 0x3fffffff; // cell coordinate limit
+
+static int CellCoord (double x)
+{
+	x = floor (x);
+	return (x < -MAXCELL ? -MAXCELL : x > MAXCELL ? MAXCELL : (int)x);
+}
+
+// =======================================================================
+
+SpatialIndex::SpatialIndex (double _cellsize)
+{
+	cellsize = _cellsize;
+	icellsize = 1.0/cellsize;
+	maxsize = 0.0;
+}
+
+// =======================================================================
+
+bool SpatialIndex::Less (const Entry &a, const Entry &b)
+{
+	if (a.ix != b.ix) return a.ix < b.ix;
+	if (a.iy != b.iy) return a.iy < b.iy;
+	return a.iz < b.iz;
+}
+
+// =======================================================================
+
+void SpatialIndex::SetCell (Entry &e) const
+{
+	e.ix = CellCoord (e.pos.x*icellsize);
+	e.iy = CellCoord (e.pos.y*icellsize);
+	e.iz = CellCoord (e.pos.z*icellsize);
+}
+
+// =======================================================================
+
+void SpatialIndex::Clear ()
+{
+	entry.clear();
+	maxsize = 0.0;
+}
+
+// =======================================================================
+
+void SpatialIndex::Insert (const void *obj, const Vector &pos, double size)
+{
+	Entry e;
+	e.obj = obj;
+	e.pos = pos;
+	SetCell (e);
+	if (size > maxsize) maxsize = size;
+	entry.insert (std::upper_bound (entry.begin(), entry.end(), e, Less), e);
+}
+
+// =======================================================================
+
+void SpatialIndex::Insert (const std::vector<const void*> &objs, PositionCallback getpos)
+{
+	// append the new entries, sort them and merge them into the list
+	size_t n = entry.size();
+	double size;
+	entry.resize (n + objs.size());
+	for (size_t i = 0; i < objs.size(); i++) {
+		Entry &e = entry[n+i];
+		e.obj = objs[i];
+		getpos (e.obj, e.pos, size);
+		if (size > maxsize) maxsize = size;
+		SetCell (e);
+	}
+	std::stable_sort (entry.begin() + n, entry.end(), Less);
+	std::inplace_merge (entry.begin(), entry.begin() + n, entry.end(), Less);
+}
+
+// =======================================================================
+
+bool SpatialIndex::Remove (const void *obj)
+{
+	for (auto it = entry.begin(); it != entry.end(); it++)
+		if (it->obj == obj) {
+			entry.erase (it);
+			return true;
+		}
+	return false;
+}
+
+// =======================================================================
+
+size_t SpatialIndex::Remove (const std::vector<const void*> &objs)
+{
+	size_t n = entry.size();
+	entry.erase (std::remove_if (entry.begin(), entry.end(), [&](const Entry &e) {
+		return std::binary_search (objs.begin(), objs.end(), e.obj);
+	}), entry.end());
+	return n - entry.size();
+}
+
+// =======================================================================
+
+void SpatialIndex::Refresh (PositionCallback getpos)
+{
+	size_t i, nmoved = 0;
+	double size;
+	maxsize = 0.0;
+	for (i = 0; i < entry.size(); i++) {
+		Entry &e = entry[i];
+		int ix = e.ix, iy = e.iy, iz = e.iz;
+		getpos (e.obj, e.pos, size);
+		if (size > maxsize) maxsize = size;
+		SetCell (e);
+		if (e.ix != ix || e.iy != iy || e.iz != iz) nmoved++;
+	}
+	if (!nmoved) return;
+
+	if (nmoved > 16) { // many cell changes (e.g. after a time jump): full sort
+		std::sort (entry.begin(), entry.end(), Less);
+	} else {            // few cell changes: insertion sort of the almost ordered list
+		for (i = 1; i < entry.size(); i++) {
+			if (!Less (entry[i], entry[i-1])) continue;
+			Entry e = entry[i];
+			size_t j = i;
+			do {
+				entry[j] = entry[j-1];
+			} while (--j > 0 && Less (e, entry[j-1]));
+			entry[j] = e;
+		}
+	}
+}
+
+// =======================================================================
+
+template<class F> void SpatialIndex::Visit (const Vector &pos, double range, F f) const
+{
+	double r2 = range*range;
+	double ncol = (floor ((pos.x+range)*icellsize) - floor ((pos.x-range)*icellsize) + 1.0) *
+	              (floor ((pos.y+range)*icellsize) - floor ((pos.y-range)*icellsize) + 1.0);
+
+	if (!(ncol < (double)entry.size())) {
+		// the search box covers more cell columns than there are objects
+		for (auto it = entry.begin(); it != entry.end(); it++) {
+			double d2 = pos.dist2 (it->pos);
+			if (d2 <= r2) f (*it, d2);
+		}
+		return;
+	}
+
+	int ix0 = CellCoord ((pos.x-range)*icellsize), ix1 = CellCoord ((pos.x+range)*icellsize);
+	int iy0 = CellCoord ((pos.y-range)*icellsize), iy1 = CellCoord ((pos.y+range)*icellsize);
+	int iz0 = CellCoord ((pos.z-range)*icellsize), iz1 = CellCoord ((pos.z+range)*icellsize);
+	Entry key;
+	key.iz = iz0;
+	for (key.ix = ix0; key.ix <= ix1; key.ix++) {
+		for (key.iy = iy0; key.iy <= iy1; key.iy++) {
+			auto it = std::lower_bound (entry.begin(), entry.end(), key, Less);
+			for (; it != entry.end() && it->ix == key.ix && it->iy == key.iy && it->iz <= iz1; it++) {
+				double d2 = pos.dist2 (it->pos);
+				if (d2 <= r2) f (*it, d2);
+			}
+		}
+	}
+}
+
+// =======================================================================
+
+size_t SpatialIndex::Query (const Vector &pos, double range, std::vector<const void*> &list, const void *exclude) const
+{
+	size_t n = list.size();
+	Visit (pos, range, [&](const Entry &e, double) {
+		if (e.obj != exclude) list.push_back (e.obj);
+	});
+	return list.size() - n;
+}
+
+// =======================================================================
+
+const void *SpatialIndex::Nearest (const Vector &pos, const void *exclude, double *dist2) const
+{
+	const void *obj = 0;
+	double d2min = std::numeric_limits<double>::infinity();
+	auto nearest = [&](const Entry &e, double d2) {
+		if (e.obj != exclude && d2 < d2min) {
+			d2min = d2;
+			obj = e.obj;
+		}
+	};
+
+	// search in expanding spheres until an object is found. Objects
+	// outside the sphere are farther away than any object inside.
+	for (double range = cellsize; !entry.empty(); range *= 4.0) {
+		double ncol = (2.0*range*icellsize + 1.0);
+		bool all = (ncol*ncol >= (double)entry.size());
+		if (all) range = std::numeric_limits<double>::infinity(); // last pass: scan all
+		Visit (pos, range, nearest);
+		if (obj || all) break;
+	}
+	if (dist2) *dist2 = d2min;
+	return obj;
+}
@@ -0,0 +1,80 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// SpatialIndex.h
+// Sorted-grid spatial index for proximity queries between objects.
+// Objects are sorted by the integer coordinates of the cubic grid cell
+// containing them, so that all objects of a cell column are stored
+// contiguously and can be located with a binary search. The index is
+// refreshed once per time step. Since objects rarely change cells
+// between steps, the refresh re-sorts an almost ordered list.
+// =======================================================================
+
+#ifndef __SPATIALINDEX_H
+#define __SPATIALINDEX_H
+
+#include <vector>
+#include "Vecmat.h"
+
+class SpatialIndex {
+public:
+	typedef void (*PositionCallback)(const void *obj, Vector &pos, double &size);
+
+	SpatialIndex (double cellsize);
+	// Create an empty index with the given grid cell edge length [m].
+	// Queries are most efficient for ranges of the order of the cell size.
+
+	inline size_t Size () const { return entry.size(); }
+
+	inline double MaxObjSize () const { return maxsize; }
+	// Largest object size registered with Insert or Refresh
+
+	void Clear ();
+
+	void Insert (const void *obj, const Vector &pos, double size = 0.0);
+	// Add object obj at position pos
+
+	void Insert (const std::vector<const void*> &objs, PositionCallback getpos);
+	// Add a batch of objects, with positions and sizes from getpos
+
+	bool Remove (const void *obj);
+	// Remove object obj. Returns false if obj is not in the index.
+
+	size_t Remove (const std::vector<const void*> &objs);
+	// Remove a batch of objects. objs must be sorted by address.
+	// Returns the number of objects removed.
+
+	void Refresh (PositionCallback getpos);
+	// Update the positions and sizes of all objects from getpos
+
+	size_t Query (const Vector &pos, double range, std::vector<const void*> &list, const void *exclude = 0) const;
+	// Append all objects within distance range of pos, except exclude,
+	// to list. Returns the number of objects appended.
+
+	const void *Nearest (const Vector &pos, const void *exclude = 0, double *dist2 = 0) const;
+	// Return the object closest to pos, except exclude (NULL if the index
+	// contains no other object). The squared distance is returned in
+	// dist2 if provided.
+
+private:
+	struct Entry {
+		int ix, iy, iz;   // grid cell
+		const void *obj;  // object
+		Vector pos;       // object position at last update
+	};
+	static bool Less (const Entry &a, const Entry &b);
+
+	void SetCell (Entry &e) const;
+	// set the grid cell of e from its position
+
+	template<class F> void Visit (const Vector &pos, double range, F f) const;
+	// call f(e, dist2) for all entries e within distance range of pos
+
+	std::vector<Entry> entry; // objects sorted by grid cell
+	double cellsize;          // grid cell edge length [m]
+	double icellsize;         // 1/cellsize
+	double maxsize;           // max. object size
+};
+
+#endif // !__SPATIALINDEX_H
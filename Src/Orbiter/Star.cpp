@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include "Orbiter.h"
 #include "Config.h"
+#include "CfgFile.h"
 #include "Star.h"
 #include "Camera.h"
 #include "Log.h"
@@ -27,7 +28,8 @@ Star::Star (double _mass, double _mean_radius)
 Star::Star (char *fname)
 : CelestialBody (fname)
 {
-	ifstream ifs (g_pOrbiter->ConfigPath (fname));
+	CfgFile ifs;
+	g_pOrbiter->preload.OpenConfig (ifs, g_pOrbiter->ConfigPath (fname));
 	if (!ifs) return;
 	bDynamicPosVel = false;
 	// read star-specific parameters here
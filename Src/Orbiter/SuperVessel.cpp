@@ -759,8 +759,9 @@ void SuperVessel::Update (bool force)
 	bool grot_changed = false;
 	bool el_updated = false;;
 
-	// centre of gravity and total mass
-	ResetMassAndCG();
+	// centre of gravity and total mass (free-flight propagation does its own)
+	if (vlist[0].vessel->bFRplayback || fstatus != FLIGHTSTATUS_FREEFLIGHT)
+		ResetMassAndCG();
 
 	if (vlist[0].vessel->bFRplayback) {
 
@@ -776,25 +777,8 @@ void SuperVessel::Update (bool force)
 
 	} else if (fstatus == FLIGHTSTATUS_FREEFLIGHT) {
 
-		// Collect vessel thrust and atmospheric forces
-		Flin.Set (0,0,0);
-		Amom.Set (0,0,0);
-		for (i = 0; i < nv; i++) {
-			Vessel *v = vlist[i].vessel;
-			Vector vAmom (mul (vlist[i].rrot, v->Amom_add));
-			Vector vFlin (mul (vlist[i].rrot, v->Flin_add));
-			Amom += vAmom + crossp (vFlin, vlist[i].rpos-cg);
-			Flin += vFlin;
-		}
-
-		RigidBody::Update (force);
-
-		// update state parameters for all sub-vessels
-		for (i = 0; i < nv; i++) {
-			ComponentStateVectors (s1, vlist[i].vessel->s1, i);
-			vlist[i].vessel->arot.Set (tmul (vlist[i].rrot, arot));
-			vlist[i].vessel->el_valid = false;
-		}
+		if (!bPropagated) Propagate (force); // otherwise already propagated concurrently
+		bPropagated = false;
 
 	} else if (fstatus == FLIGHTSTATUS_LANDED) {
 
@@ -840,6 +824,45 @@ void SuperVessel::PostUpdate ()
 
 // =======================================================================
 
+bool SuperVessel::CanPropagateConcurrently () const
+{
+	if (vlist[0].vessel->bFRplayback) return false;
+	return VesselBase::CanPropagateConcurrently ();
+}
+
+// =======================================================================
+
+void SuperVessel::Propagate (bool force)
+{
+	DWORD i;
+
+	// centre of gravity and total mass
+	ResetMassAndCG();
+
+	// Collect vessel thrust and atmospheric forces
+	Flin.Set (0,0,0);
+	Amom.Set (0,0,0);
+	for (i = 0; i < nv; i++) {
+		Vessel *v = vlist[i].vessel;
+		Vector vAmom (mul (vlist[i].rrot, v->Amom_add));
+		Vector vFlin (mul (vlist[i].rrot, v->Flin_add));
+		Amom += vAmom + crossp (vFlin, vlist[i].rpos-cg);
+		Flin += vFlin;
+	}
+
+	RigidBody::Update (force);
+
+	// update state parameters for all sub-vessels
+	for (i = 0; i < nv; i++) {
+		ComponentStateVectors (s1, vlist[i].vessel->s1, i);
+		vlist[i].vessel->arot.Set (tmul (vlist[i].rrot, arot));
+		vlist[i].vessel->el_valid = false;
+	}
+	bPropagated = true;
+}
+
+// =======================================================================
+
 void SuperVessel::UpdateProxies ()
 {
 	VesselBase::UpdateProxies ();
@@ -124,6 +124,12 @@ public:
 	void Update (bool force);
 	// per-frame update of supervessel parameters
 
+	bool CanPropagateConcurrently () const;
+	// the superstructure is propagated as a single unit, including all its components
+
+	void Propagate (bool force = false);
+	// dynamic state propagation of the superstructure and its components
+
 	void PostUpdate ();
 
 	bool AddSurfaceForces (Vector *F, Vector *M,
@@ -0,0 +1,141 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// TaskPool.cpp
+// A small work-stealing thread pool for running independent tasks
+// of a simulation step concurrently.
+// =======================================================================
+
+#include "TaskPool.h"
+
+static thread_local int tls_threadidx = -1;
+
+// =======================================================================
+
+TaskPool::TaskPool (int nthread)
+: queue(nthread+1)
+{
+	job = 0;
+	generation = 0;
+	nbusy = 0;
+	bQuit = false;
+	for (int i = 0; i < nthread; i++)
+		worker.emplace_back (&TaskPool::WorkerProc, this, i+1);
+}
+
+// =======================================================================
+
+TaskPool::~TaskPool ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bQuit = true;
+	}
+	cv_start.notify_all();
+	for (auto &w: worker)
+		w.join();
+}
+
+// =======================================================================
+
+int TaskPool::ThreadIndex ()
+{
+	return tls_threadidx;
+}
+
+// =======================================================================
+
+void TaskPool::Run (size_t ntask, const std::function<void(size_t)> &task)
+{
+	if (!ntask) return;
+
+	if (worker.empty() || ntask == 1) { // not worth waking the workers
+		tls_threadidx = 0;
+		for (size_t i = 0; i < ntask; i++)
+			task(i);
+		tls_threadidx = -1;
+		return;
+	}
+
+	// The workers are idle at this point, so the queues can be filled
+	// without locking. Publishing the job under the pool mutex makes the
+	// queue contents visible to the workers.
+	size_t nq = queue.size();
+	for (size_t i = 0; i < ntask; i++)
+		queue[i % nq].idx.push_back (i);
+
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		job = &task;
+		nbusy = (int)worker.size();
+		generation++;
+	}
+	cv_start.notify_all();
+
+	Process (0);
+
+	std::unique_lock<std::mutex> lock(mtx);
+	cv_done.wait (lock, [this]{ return nbusy == 0; });
+	job = 0;
+}
+
+// =======================================================================
+
+void TaskPool::WorkerProc (int id)
+{
+	unsigned int seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			cv_start.wait (lock, [&]{ return bQuit || generation != seen; });
+			if (bQuit) return;
+			seen = generation;
+		}
+		Process (id);
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (--nbusy == 0) cv_done.notify_one();
+		}
+	}
+}
+
+// =======================================================================
+
+void TaskPool::Process (int id)
+{
+	size_t i;
+	tls_threadidx = id;
+	while (Pop (id, i) || Steal (id, i))
+		(*job)(i);
+	tls_threadidx = -1;
+}
+
+// =======================================================================
+
+bool TaskPool::Pop (int id, size_t &i)
+{
+	Queue &q = queue[id];
+	std::lock_guard<std::mutex> lock(q.mtx);
+	if (q.idx.empty()) return false;
+	i = q.idx.back();
+	q.idx.pop_back();
+	return true;
+}
+
+// =======================================================================
+
+bool TaskPool::Steal (int id, size_t &i)
+{
+	size_t nq = queue.size();
+	for (size_t k = 1; k < nq; k++) {
+		Queue &q = queue[(id+k) % nq];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		if (!q.idx.empty()) {
+			i = q.idx.front();
+			q.idx.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// TaskPool.h
+// A small work-stealing thread pool for running independent tasks
+// of a simulation step concurrently.
+// =======================================================================
+
+#ifndef __TASKPOOL_H
+#define __TASKPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class TaskPool {
+public:
+	TaskPool (int nthread);
+	// Create a pool with nthread worker threads. The thread calling Run
+	// also processes tasks, so the total concurrency is nthread+1.
+
+	~TaskPool ();
+
+	inline int nThread () const { return (int)worker.size(); }
+
+	void Run (size_t ntask, const std::function<void(size_t)> &task);
+	// Execute task(i) for i = 0..ntask-1 and return when all tasks have
+	// completed. Tasks are distributed round-robin over per-thread queues;
+	// a thread whose queue runs empty steals from the others.
+	// Run is not reentrant: tasks must not call Run themselves.
+
+	static int ThreadIndex ();
+	// Index of the calling thread while it executes a task (0 for the
+	// thread that called Run, 1..nThread() for the workers), or -1 if
+	// called outside a task.
+
+private:
+	struct Queue {
+		std::mutex mtx;
+		std::deque<size_t> idx;
+	};
+
+	void WorkerProc (int id);
+	// worker thread main loop
+
+	void Process (int id);
+	// process tasks from queue id, then steal from the other queues
+	// until all are empty
+
+	bool Pop (int id, size_t &i);
+	// take a task from the back of our own queue
+
+	bool Steal (int id, size_t &i);
+	// take a task from the front of any other queue
+
+	std::vector<std::thread> worker;
+	std::vector<Queue> queue;          // one queue per thread (index 0: caller)
+	const std::function<void(size_t)> *job;
+
+	std::mutex mtx;
+	std::condition_variable cv_start;  // signals workers that a new job is available
+	std::condition_variable cv_done;   // signals caller that all workers are idle
+	unsigned int generation;           // job counter
+	int nbusy;                         // number of workers still processing current job
+	bool bQuit;                        // signals workers to terminate
+};
+
+#endif // !__TASKPOOL_H
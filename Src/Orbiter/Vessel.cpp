@@ -24,6 +24,8 @@
 #include "Vessel.h"
 #include "Supervessel.h"
 #include "Config.h"
+#include "CfgFile.h"
+#include "VesselClass.h"
 #include "Camera.h"
 #include "Pane.h"
 #include "Panel2D.h"
@@ -37,6 +39,9 @@
 #include "State.h"
 #include "Util.h"
 #include "elevmgr.h"
+#include "Profiler.h"
+#include "BlockPool.h"
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <stdio.h>
@@ -74,6 +79,24 @@ static Vector DefAttExhaustDir[12] = {
 // class Vessel
 // ==============================================================
 
+static BlockPool &VesselPool ()
+{
+	static BlockPool pool (sizeof(Vessel), 32);
+	return pool;
+}
+
+void *Vessel::operator new (size_t size)
+{
+	return VesselPool().Alloc (size);
+}
+
+void Vessel::operator delete (void *p, size_t size)
+{
+	VesselPool().Free (p, size);
+}
+
+// ==============================================================
+
 Vessel::Vessel (const PlanetarySystem *psys, const char *_name, const char *_classname, const VESSELSTATUS &status)
 : VesselBase()
 {
@@ -83,7 +106,7 @@ Vessel::Vessel (const PlanetarySystem *psys, const char *_name, const char *_cla
 	classname = new char[strlen(_classname)+1]; TRACENEW
 	strcpy (classname, _classname);
 
-	ifstream classf;
+	CfgFile classf;
 	if (!OpenConfigFile (classf))
 		g_pOrbiter->TerminateOnError(); // PANIC!
 
@@ -117,7 +140,7 @@ Vessel::Vessel (const PlanetarySystem *psys, const char *_name, const char *_cla
 	classname = new char[strlen(_classname)+1]; TRACENEW
 	strcpy (classname, _classname);
 
-	ifstream classf;
+	CfgFile classf;
 	if (!OpenConfigFile (classf))
 		g_pOrbiter->TerminateOnError(); // PANIC!
 
@@ -159,7 +182,7 @@ Vessel::Vessel (const PlanetarySystem *psys, const char *_name, const char *_cla
 	classname = new char[strlen(_classname)+1]; TRACENEW
 	strcpy (classname, _classname);
 
-	ifstream classf;
+	CfgFile classf;
 	if (!OpenConfigFile (classf))
 		g_pOrbiter->TerminateOnError(); // PANIC!
 
@@ -233,18 +256,26 @@ Vessel::~Vessel ()
 
 // ==============================================================
 
-bool Vessel::OpenConfigFile (ifstream &cfgfile) const
+bool Vessel::OpenConfigFile (CfgFile &cfgfile) const
 {
 	char cbuf[256];
 	strcpy (cbuf, "Vessels\\");
 	strcat (cbuf, classname ? classname : name.c_str());
+	// class files are parsed once and shared by all vessels of the class
+	VesselClassRegistry &reg = g_pOrbiter->vclassreg;
 	// first search in $CONFIGDIR\Vessels
-	cfgfile.open (g_pOrbiter->ConfigPath (cbuf));
-	if (cfgfile.good()) return true;
-	else cfgfile.clear();
+	const char *path = g_pOrbiter->ConfigPath (cbuf);
+	CfgFile::IndexRef index = reg.Config (path);
+	if (index) {
+		cfgfile.open (path, index);
+		if (cfgfile.good()) return true;
+		else cfgfile.clear();
+	}
 	// next search in $CONFIGDIR
-	cfgfile.open (g_pOrbiter->ConfigPath (cbuf+8));
-	if (cfgfile.good()) return true;
+	path = g_pOrbiter->ConfigPath (cbuf+8);
+	index = reg.Config (path);
+	if (index) cfgfile.open (path, index);
+	if (index && cfgfile.good()) return true;
 	else {
 		cfgfile.clear();
 		LOGOUT_ERR_FILENOTFOUND_MSG(g_pOrbiter->ConfigPath(cbuf + 8), "No vessel class configuration file found for: %s", classname ? classname : name);
@@ -296,7 +327,6 @@ void Vessel::SetDefaultState ()
 	undock_t            = -1000;
 	proxyvessel         = 0;
 	supervessel         = 0;
-	scanvessel          = 0;
 	attmode             = 1;
 	ctrlsurfmode        = 0;
 	for (i = 0; i < 6; i++)
@@ -435,7 +465,9 @@ void Vessel::ReadGenericCaps (ifstream &ifs)
 
 	// recursively read base class specs
 	if (GetItemString (ifs, "BaseClass", cbuf)) {
-		ifstream basef (g_pOrbiter->ConfigPath (cbuf));
+		const char *path = g_pOrbiter->ConfigPath (cbuf);
+		CfgFile basef;
+		basef.open (path, g_pOrbiter->vclassreg.Config (path));
 		if (basef) ReadGenericCaps (basef);
 	}
 
@@ -791,6 +823,9 @@ void Vessel::ProcessMessage (DWORD msg, void *ptr)
 	case MSG_KILLVESSEL:
 		Destroying ((Vessel*)ptr);
 		break;
+	case MSG_KILLVESSELS:
+		Destroying (*(const std::vector<const Vessel*>*)ptr);
+		break;
 	case MSG_KILLNAVSENDER:
 		for (i = 0; i < nnav; i++)
 			if (nav[i].sender == (const Nav*)ptr)
@@ -833,6 +868,20 @@ void Vessel::Destroying (const Vessel *vessel)
 
 // ==============================================================
 
+void Vessel::Destroying (const std::vector<const Vessel*> &list)
+{
+	if (std::binary_search (list.begin(), list.end(), this)) {
+		Destroying (this);
+	} else {
+		if (proxyvessel && std::binary_search (list.begin(), list.end(), proxyvessel))
+			Destroying (proxyvessel);
+		if (closedock.vessel && std::binary_search (list.begin(), list.end(), closedock.vessel))
+			Destroying (closedock.vessel);
+	}
+}
+
+// ==============================================================
+
 const VesselBase *Vessel::GetSuperStructure () const
 {
 	return supervessel;
@@ -941,7 +990,7 @@ void Vessel::GetIntermediateMoments_pert (Vector &acc, Vector &tau,
 
 Vector Vessel::GetTorque () const
 {
-	static Vector F(0,0,0);
+	static thread_local Vector F(0,0,0);
 	Vector M(Amom);
 	AddSurfaceForces (&F, &M, s0, 0, 0);
 	return RigidBody::GetTorque() + M/mass;
@@ -4283,19 +4332,20 @@ void Vessel::UpdateAerodynamicForces_OLD ()
 
 bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, double tfrac, double dt, bool allow_groundcontact) const
 {
+	PROFILE_ZONE("Surface contact");
 	nforcevec = 0; // should move higher up
 	E_comp = 0.0;  // compression energy
 
 	int i, j;
 	double alt = 0, tdymin = 0;
-	static int *tidx = new int[3];
-	static double *tdy = new double[3];
-	static double *fn = new double[3];
-	static double *flng = new double[3];
-	static double *flat = new double[3];
-	static DWORD ntdy = 3;
-
-	static StateVectors ls; // local state
+	static thread_local int *tidx = new int[3];
+	static thread_local double *tdy = new double[3];
+	static thread_local double *fn = new double[3];
+	static thread_local double *flng = new double[3];
+	static thread_local double *flat = new double[3];
+	static thread_local DWORD ntdy = 3;
+
+	static thread_local StateVectors ls; // local state
 	if (!proxybody) return false;
 	StateVectors ps = proxybody->InterpolateState (tfrac); // intermediate planet state; should probably be passed in as function argument
 	SurfParam surfp; // intermediate surface parameters; should probably be passed in as function argument
@@ -4568,7 +4618,7 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 		// limit the change in angle over the current time step induced by impact forces
 		Vector dA = EulerInv_full (M_surf/mass, s->omega)*dt*dt;
 		double da = dA.length();
-		static double da_max = 0.0;
+		static thread_local double da_max = 0.0;
 		if (da > da_max) da_max = da;
 		if (da > 10.0*RAD) {
 			double scale = 10.0*RAD/da;
@@ -4721,7 +4771,9 @@ void Vessel::Update (bool force)
 	if (fstatus == FLIGHTSTATUS_FREEFLIGHT) {
 
 		if (!supervessel) {
-			if (bFRplayback) {
+			if (bPropagated) {
+				bPropagated = false;       // already propagated concurrently
+			} else if (bFRplayback) {
 				FRecorder_Play();          // update from playback stream
 			} else {
 				RigidBody::Update (force); // standard dynamic update
@@ -4930,6 +4982,75 @@ void Vessel::Update (bool force)
 	UpdateAttachments();
 }
 
+bool Vessel::CanPropagateConcurrently () const
+{
+	// docked and attached vessels are propagated by their superstructure or parent
+	if (supervessel || attach || bFRplayback) return false;
+	return VesselBase::CanPropagateConcurrently ();
+}
+
+// Min. altitude above body for propagation without full force model
+// updates: the configured limit, or the top of the atmosphere if higher
+static double MinFreeFlightAlt (const CelestialBody *body)
+{
+	double altmin = g_pOrbiter->Cfg()->CfgPhysicsPrm.OrbitRailsMinAlt;
+	if (body->Type() == OBJTP_PLANET && ((Planet*)body)->HasAtmosphere())
+		altmin = max (altmin, ((Planet*)body)->AtmAltLimit());
+	return altmin;
+}
+
+bool Vessel::CanUpdateOnRails () const
+{
+	const CFG_PHYSICSPRM &prm = g_pOrbiter->Cfg()->CfgPhysicsPrm;
+	if (!prm.bOrbitRails) return false;
+
+	// at short steps (low time acceleration), integrating the state is both
+	// cheaper and more accurate than evaluating the rail
+	if (td.SimDT < prm.OrbitRailsMinStep) return false;
+
+	// only idle free-flight vessels without any forces acting on them
+	if (fstatus != FLIGHTSTATUS_FREEFLIGHT || supervessel || attach || bFRplayback) return false;
+	if (bForceActive || sp.is_in_atm) return false;
+
+	// the user may be looking at us
+	if (this == g_focusobj || (g_camera && g_camera->Target() == this)) return false;
+	double r2 = prm.OrbitRailsRange*prm.OrbitRailsRange;
+	if (g_focusobj && s0->pos.dist2 (g_focusobj->GPos()) < r2) return false;
+	if (g_camera && s0->pos.dist2 (g_camera->GPos()) < r2) return false;
+
+	// proximity to other vessels (docking, collisions)
+	double d2;
+	if (g_psys->NearestVessel (s0->pos, this, &d2) && d2 < 1e8) return false;
+
+	// other gravity sources perturb the orbit (sphere of influence)
+	if (g_psys->GetGravityContribution (cbody, s0->pos) < 1.0-prm.Stabilise_PLimit) return false;
+
+	// the orbit must stay clear of the surface and the atmosphere
+	double pe = OrbitRail::PeDist (cpos, cvel, Ggrav*cbody->Mass());
+	if (pe < 0.0) return false; // open orbit
+	return pe - cbody->Size() > MinFreeFlightAlt (cbody);
+}
+
+bool Vessel::CanCoast () const
+{
+	// Vessels that may be updated at a lower rate than the frame rate by
+	// the multi-rate update scheduler: idle free-flight vessels away from
+	// the surface, other than the focus vessel
+	if (fstatus != FLIGHTSTATUS_FREEFLIGHT || supervessel || attach || bFRplayback) return false;
+	if (bForceActive || sp.is_in_atm || this == g_focusobj || !cbody) return false;
+	if (!proxybody) return true;
+
+	// the ground contact and atmosphere models need full updates
+	double vrel = (s0->vel - proxybody->s0->vel).length();
+	return sp.alt0 - vrel*g_pOrbiter->Cfg()->CfgPhysicsPrm.MultiRateMaxInterval > MinFreeFlightAlt (proxybody);
+}
+
+void Vessel::Propagate (bool force)
+{
+	RigidBody::Update (force);
+	bPropagated = true;
+}
+
 void Vessel::UpdatePassive ()
 {
 	StateVectors *s = (s1 ? s1:s0); // hack - this should really only be called during update phase
@@ -4990,65 +5111,66 @@ void Vessel::PostUpdate ()
 
 	if (fstatus == FLIGHTSTATUS_FREEFLIGHT && td.SimT1 > undock_t+1.0) {
 
-		// check for vessel-vessel docking
-		// check one vessel per frame (this may not be enough if universe is densely
-		// populated. Instead there should be a list of vessels, sorted into 2 or 3 distance
-		// bins (eg < 10km, <1000km, rest) and 1 vessel per *bin* should be checked)
+		// check for vessel-vessel docking with all vessels in range
 
 		if (ndock) {
-			if (++scanvessel >= g_psys->nVessel()) scanvessel = 0;
-			Vessel *v = g_psys->GetVessel(scanvessel);
-			if (v != this && v->ndock && v->proxybody == proxybody) {
-				double dst = s0->pos.dist (v->GPos());
-
-				if ((dst < 1.5 * (size + v->Size()) || (dst < size + v->Size() + 1e3))) { // valid candidate
-					Vector dref, gref, vref;
-					for (j = 0; j < ndock; j++) { // loop over my own docks
-						if (dock[j]->mate) continue; // dock already busy
-						if (dockmode == 0) { // legacy docking mode
-							if (dotp (s0->vel - v->GVel(), mul (s0->R, dock[j]->dir)) < -0.01) continue; // moving away from dock
-							for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
-								if (v->dock[k]->mate) continue; // dock already busy
-								dref.Set (tmul (v->GRot(), mul (s0->R, dock[j]->ref) + s0->pos - v->GPos()));
-								double d = dref.dist (v->dock[k]->ref);
-								if (d < MIN_DOCK_DIST) {
-									if (dock[j]->autodock && v->dock[k]->autodock)
-										Dock (v, j, k);
-								}
-							}
-						} else { // new docking mode
-							for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
-								if (v->dock[k]->mate) continue; // dock already busy
-								gref.Set (mul (s0->R, dock[j]->ref) + s0->pos);            // my dock in global frame
-								vref.Set (mul (v->GRot(), v->dock[k]->ref) + v->GPos()); // target dock in global frame
-								//dref.Set (tmul (v->GRot(), mul (*grot, dock[j]->ref) + *gpos - v->GPos())); // my dock in the target's frame
-								double d = gref.dist(vref); //dref.dist (v->dock[k]->ref);
-								if (d < MIN_DOCK_DIST) {
-									if (dotp (s0->vel - v->GVel(), vref-gref) >= 0) { // on approach
-										dock[j]->pending = v;
-									} else if (dock[j]->pending == v) {
+			static thread_local std::vector<Vessel*> vlist;
+			double vsize = size + g_psys->MaxVesselSize();
+			g_psys->VesselsInRange (s0->pos, max (1.5*vsize, vsize + 1e3), vlist, this);
+			for (auto it = vlist.begin(); it != vlist.end(); it++) {
+				Vessel *v = *it;
+				if (v->ndock && v->proxybody == proxybody) {
+					double dst = s0->pos.dist (v->GPos());
+
+					if ((dst < 1.5 * (size + v->Size()) || (dst < size + v->Size() + 1e3))) { // valid candidate
+						Vector dref, gref, vref;
+						for (j = 0; j < ndock; j++) { // loop over my own docks
+							if (dock[j]->mate) continue; // dock already busy
+							if (dockmode == 0) { // legacy docking mode
+								if (dotp (s0->vel - v->GVel(), mul (s0->R, dock[j]->dir)) < -0.01) continue; // moving away from dock
+								for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
+									if (v->dock[k]->mate) continue; // dock already busy
+									dref.Set (tmul (v->GRot(), mul (s0->R, dock[j]->ref) + s0->pos - v->GPos()));
+									double d = dref.dist (v->dock[k]->ref);
+									if (d < MIN_DOCK_DIST) {
 										if (dock[j]->autodock && v->dock[k]->autodock)
 											Dock (v, j, k);
 									}
 								}
+							} else { // new docking mode
+								for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
+									if (v->dock[k]->mate) continue; // dock already busy
+									gref.Set (mul (s0->R, dock[j]->ref) + s0->pos);            // my dock in global frame
+									vref.Set (mul (v->GRot(), v->dock[k]->ref) + v->GPos()); // target dock in global frame
+									//dref.Set (tmul (v->GRot(), mul (*grot, dock[j]->ref) + *gpos - v->GPos())); // my dock in the target's frame
+									double d = gref.dist(vref); //dref.dist (v->dock[k]->ref);
+									if (d < MIN_DOCK_DIST) {
+										if (dotp (s0->vel - v->GVel(), vref-gref) >= 0) { // on approach
+											dock[j]->pending = v;
+										} else if (dock[j]->pending == v) {
+											if (dock[j]->autodock && v->dock[k]->autodock)
+												Dock (v, j, k);
+										}
+									}
+								}
 							}
 						}
-					}
-					// update information about closest dock in range of our dock 0
-					if (closedock.vessel && closedock.vessel->ndock && closedock.dock < closedock.vessel->ndock) {
-						dref.Set (tmul (closedock.vessel->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - closedock.vessel->GPos()));
-						closedock.dist = dref.dist (closedock.vessel->dock[closedock.dock]->ref);
-					} else {
-						closedock.dist = 1e50;
-					}
-					for (k = 0; k < v->ndock; k++) {
-						if (v->dock[k]->mate) continue;
-						dref.Set (tmul (v->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - v->GPos()));
-						double d = dref.dist (v->dock[k]->ref);
-						if (d < closedock.dist) {
-							closedock.dist = d;
-							closedock.vessel = v;
-							closedock.dock = k;
+						// update information about closest dock in range of our dock 0
+						if (closedock.vessel && closedock.vessel->ndock && closedock.dock < closedock.vessel->ndock) {
+							dref.Set (tmul (closedock.vessel->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - closedock.vessel->GPos()));
+							closedock.dist = dref.dist (closedock.vessel->dock[closedock.dock]->ref);
+						} else {
+							closedock.dist = 1e50;
+						}
+						for (k = 0; k < v->ndock; k++) {
+							if (v->dock[k]->mate) continue;
+							dref.Set (tmul (v->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - v->GPos()));
+							double d = dref.dist (v->dock[k]->ref);
+							if (d < closedock.dist) {
+								closedock.dist = d;
+								closedock.vessel = v;
+								closedock.dock = k;
+							}
 						}
 					}
 				}
@@ -5197,19 +5319,8 @@ void Vessel::UpdateProxies ()
 {
 	VesselBase::UpdateProxies ();
 
-	int i;
-	double dist2, proxydist2;
-
 	// check for closest vessel
-	proxyvessel = 0;
-	for (i = g_psys->nVessel()-1, proxydist2 = 1e100; i >= 0; i--) {
-		Vessel *vessel = g_psys->GetVessel(i);
-		if (vessel == this) continue;
-		if ((dist2 = s0->pos.dist2 (vessel->GPos())) < proxydist2) {
-			proxydist2 = dist2;
-			proxyvessel = vessel;
-		}
-	}
+	proxyvessel = g_psys->NearestVessel (s0->pos, this);
 }
 
 void Vessel::UpdateReceiverStatus (DWORD idx)
@@ -5220,8 +5331,10 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 	DWORD m, n, n0, n1, nn, r0, r1, rm, step;
 	double dist2, sig;
 
-	static DWORD nscan = 1;
-	static double *navsig = new double[nscan];
+	static thread_local DWORD nscan = 1;
+	static thread_local double *navsig = new double[nscan];
+	static thread_local std::vector<Base*> blist;
+	static thread_local std::vector<Vessel*> vlist;
 	if (nnav > nscan) {
 		delete []navsig;
 		navsig = new double[nscan = nnav]; TRACENEW
@@ -5259,8 +5372,9 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 	}
 
 	// scan surface-base related signal transmitters
-	for (i = 0; i < proxyplanet->nBase(); i++) {
-		Base *base = proxyplanet->GetBase(i);
+	proxyplanet->BasesInRange (s0->pos, 1e6, blist);
+	for (i = 0; i < (int)blist.size(); i++) {
+		Base *base = blist[i];
 		if ((s0->pos.dist2 (base->GPos()) < 1e12) && (nn = base->nNav())) {
 			for (n = 0; n < nn; n++) {
 				const Nav *navsend = base->NavMgr().GetNav (n);
@@ -5278,9 +5392,9 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 	}
 
 	// scan for vessel-mounted XPDR and IDS transmitters
-	for (i = g_psys->nVessel()-1; i >= 0; i--) {
-		Vessel *vessel = g_psys->GetVessel(i);
-		if (vessel == this) continue;
+	g_psys->VesselsInRange (s0->pos, 1e6, vlist, this);
+	for (i = 0; i < (int)vlist.size(); i++) {
+		Vessel *vessel = vlist[i];
 		if ((dist2 = s0->pos.dist2 (vessel->GPos())) < 1e12) { // max XPDR range 1000 km
 
 			for (n = n0; n < n1; n++) {
@@ -5964,18 +6078,16 @@ bool Vessel::LoadModule (ifstream &classf)
 
 bool Vessel::RegisterModule (const char *dllname)
 {
-	char cbuf[256];
-	sprintf (cbuf, "Modules\\%s.dll", dllname);
-	hMod = LoadLibrary (cbuf);
-	if (!hMod)
+	// the module is loaded and its entry points resolved once per class
+	const VesselModule *mod = g_pOrbiter->vclassreg.Module (dllname);
+	hMod = VesselClassRegistry::Acquire (mod);
+	if (!hMod) {
+		SetLastError (mod->err);
 		return false;
-
-	// retrieve module version
-	int (*fversion)() = (int(*)())GetProcAddress (hMod, "GetModuleVersion");
-	modIntf.version = (fversion ? fversion() : 0);
-
-	modIntf.ovcInit = (VESSEL_Init)GetProcAddress (hMod, "ovcInit");
-	modIntf.ovcExit = (VESSEL_Exit)GetProcAddress (hMod, "ovcExit");
+	}
+	modIntf.version = mod->version;
+	modIntf.ovcInit = (VESSEL_Init)mod->ovcInit;
+	modIntf.ovcExit = (VESSEL_Exit)mod->ovcExit;
 	return true;
 }
 
@@ -6059,7 +6171,7 @@ bool Vessel::Read (ifstream &scn)
 
 bool Vessel::EditorModule (char *cbuf) const
 {
-	ifstream classf;
+	CfgFile classf;
 	if (!OpenConfigFile (classf)) return false;
 	return GetItemString (classf, "EditorModule", cbuf);
 }
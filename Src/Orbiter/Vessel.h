@@ -41,6 +41,9 @@ class Nav_XPDR;
 class ExhaustStream;
 class oapi::Sketchpad;
 class LightEmitter;
+class FRStream;
+class FRTrack;
+class CfgFile;
 class Select;
 class InputBox;
 struct MFDMODE;
@@ -237,6 +240,11 @@ public:
 
 	~Vessel();
 
+	static void *operator new (size_t size);
+	static void operator delete (void *p, size_t size);
+	// Vessel instances are allocated from a block pool, to make spawning
+	// and destroying many vessels (e.g. debris) cheap
+
 	inline int Type () const { return OBJTP_VESSEL; }
 	inline const char *ClassName () const { return classname; }
 	inline const char *HelpContext () const { return onlinehelp; }
@@ -271,6 +279,11 @@ public:
 	// Notification that 'vessel' is about to be destroyed. This is sent to all
 	// vessels, including the one being destroyed. Used for cleanup and de-referencing
 
+	void Destroying (const std::vector<const Vessel*> &list);
+	// Notification that all vessels in 'list' (sorted by address) are about
+	// to be destroyed. Equivalent to calling Destroying for each vessel in
+	// the list, but with a single pass over the vessels of the system.
+
 	/**
 	 * \brief Called when the user interactively changes a simulation option
 	 * \param cat option category (see \ref optcat)
@@ -1128,6 +1141,10 @@ public:
 	// Keyboard handler for buffered keys
 
 	void Update (bool force = false);
+	bool CanPropagateConcurrently () const;
+	bool CanUpdateOnRails () const;
+	bool CanCoast () const;
+	void Propagate (bool force = false);
 	void UpdatePassive ();
 	void UpdateAttachments();
 	void UpdateBodyForces ();
@@ -1285,7 +1302,7 @@ public:
 	// read/write vessel status from/to stream
 
 protected:
-	bool OpenConfigFile (std::ifstream &cfgfile) const;
+	bool OpenConfigFile (CfgFile &cfgfile) const;
 	// returns configuration file for the vessel
 	// This first looks in Config\Vessels, then in Config
 
@@ -1640,7 +1657,6 @@ private:
 	Base    *landtgt;         // landing target (base)
 	int   lstatus;            // landing/docking comms status (0=no contact, 1=contact,
 	DWORD nport;              // allocated landing pad/docking port no (>=0, (DWORD)-1=none)
-	UINT  scanvessel;         // next vessel to check for docking event
 
 	mutable bool surfprm_valid;
 	bool pyp_valid;
@@ -1732,6 +1748,9 @@ private:
 private:
 	std::ifstream *FRatc_stream;
 
+	FRStream *FRpos_ostream, *FRatt_ostream, *FRatc_ostream;
+	// Record streams (position, attitude, articulation)
+
 	bool bRequestPlayback;
 	bool bFRplayback;
 	// True if vessel is currently played back
@@ -1745,15 +1764,14 @@ private:
 	char *FRfname;
 	// flight record file name
 
-	FRecord *frec;
-	int nfrec;
-	int cfrec;
-	// Playback sample list, list length, current sample
+	FRTrack *FRpos_track, *FRatt_track;
+	// Playback position and attitude streams
+
+	std::vector<const CelestialBody*> FRpos_ref, FRatt_ref;
+	// Reference objects of the playback stream contexts
 
-	FRecord_att *frec_att, frec_att_last;
-	int nfrec_att;
-	int cfrec_att;
-	// Playback attitude sample list
+	FRecord_att frec_att_last;
+	// Last saved attitude status
 
 	double frec_last_syst;
 	double frec_att_last_syst;
@@ -1770,6 +1788,9 @@ private:
 	void FRecorder_Activate (bool active, const char *fname, bool append = false);
 	// switch recorder on/off
 
+	void FRecorder_CloseStreams ();
+	// flush and close the record streams
+
 	void FRecorder_Save (bool force = false);
 	// save current status to flight record streams
 
@@ -1782,7 +1803,17 @@ private:
 	// Delete playback sample list
 
 	bool FRecorder_Read (const char *fname);
-	// read playback sample list from file
+	// open playback streams
+
+	void FRecorder_MapContexts (const FRTrack *track, std::vector<const CelestialBody*> &ref);
+	// resolve the reference objects of the contexts of a playback stream
+
+	void FRecorder_GetPosSample (int i, FRecord &rec);
+	void FRecorder_GetAttSample (int i, FRecord_att &rec);
+	// return playback sample i in cartesian coordinates/quaternion format
+
+	void FRecorder_CloseTracks ();
+	// close the playback streams
 
 	void FRecorder_Play ();
 	// set vessel status from playback sample list
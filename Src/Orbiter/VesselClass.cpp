@@ -0,0 +1,95 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// VesselClass.cpp
+// Registry of shared vessel class resources
+// =======================================================================
+
+#include "VesselClass.h"
+#include <stdio.h>
+#include <ctype.h>
+
+// =======================================================================
+
+VesselClassRegistry::VesselClassRegistry ()
+{
+	memset (&stats, 0, sizeof(Stats));
+}
+
+// =======================================================================
+
+VesselClassRegistry::~VesselClassRegistry ()
+{
+	Flush ();
+}
+
+// =======================================================================
+
+CfgFile::IndexRef VesselClassRegistry::Config (const char *fname)
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stats.ncfgrequest++;
+	}
+	return cfg.Get (fname);
+}
+
+// =======================================================================
+
+const VesselModule *VesselClassRegistry::Module (const char *dllname)
+{
+	std::string key(dllname);
+	for (auto &c : key) c = (char)tolower ((unsigned char)c);
+
+	std::lock_guard<std::mutex> lock(mtx);
+	stats.nmodrequest++;
+	auto it = module.find (key);
+	if (it != module.end())
+		return &it->second;
+
+	char cbuf[256];
+	VesselModule mod;
+	memset (&mod, 0, sizeof(VesselModule));
+	sprintf (cbuf, "Modules\\%s.dll", dllname);
+	mod.hMod = LoadLibrary (cbuf);
+	if (mod.hMod) {
+		int (*fversion)() = (int(*)())GetProcAddress (mod.hMod, "GetModuleVersion");
+		mod.version = (fversion ? fversion() : 0);
+		mod.ovcInit = GetProcAddress (mod.hMod, "ovcInit");
+		mod.ovcExit = GetProcAddress (mod.hMod, "ovcExit");
+	} else {
+		mod.err = GetLastError();
+	}
+	return &module.emplace (key, mod).first->second;
+}
+
+// =======================================================================
+
+HINSTANCE VesselClassRegistry::Acquire (const VesselModule *mod)
+{
+	HMODULE hMod = NULL;
+	if (mod->hMod) // increments the module reference count without a search by name
+		GetModuleHandleEx (GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)mod->hMod, &hMod);
+	return hMod;
+}
+
+// =======================================================================
+
+void VesselClassRegistry::Flush ()
+{
+	cfg.Clear();
+	std::lock_guard<std::mutex> lock(mtx);
+	for (auto &m : module)
+		if (m.second.hMod) FreeLibrary (m.second.hMod);
+	module.clear();
+	memset (&stats, 0, sizeof(Stats));
+}
+
+// =======================================================================
+
+VesselClassRegistry::Stats VesselClassRegistry::GetStats () const
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return stats;
+}
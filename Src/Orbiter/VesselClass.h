@@ -0,0 +1,68 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// VesselClass.h
+// Registry of vessel class resources shared by all vessel instances of a
+// class: parsed class configuration files (including base class files)
+// and vessel modules with their resolved entry points. Each class file
+// and module is loaded once per simulation session, however many vessels
+// of the class are created.
+// =======================================================================
+
+#ifndef __VESSELCLASS_H
+#define __VESSELCLASS_H
+
+#include "CfgFile.h"
+
+// =======================================================================
+// A vessel module, loaded by the registry
+
+struct VesselModule {
+	HINSTANCE hMod;      // module handle (NULL: module couldn't be loaded)
+	DWORD err;           // error code if the module couldn't be loaded
+	int version;         // value returned by GetModuleVersion, or 0
+	FARPROC ovcInit;     // vessel instance initialisation callback
+	FARPROC ovcExit;     // vessel instance exit callback
+};
+
+// =======================================================================
+
+class VesselClassRegistry {
+public:
+	struct Stats {
+		size_t ncfgrequest;  // class file requests
+		size_t nmodrequest;  // module requests
+	};
+
+	VesselClassRegistry ();
+	~VesselClassRegistry ();
+
+	CfgFile::IndexRef Config (const char *fname);
+	// Return the parsed class configuration file fname, reading it on the
+	// first request. Returns an empty reference if the file can't be read.
+
+	const VesselModule *Module (const char *dllname);
+	// Return module Modules\<dllname>.dll, loading it on the first request.
+	// The registry keeps a reference to the module until Flush is called;
+	// vessels take their own references with Acquire.
+	// The returned pointer is valid until Flush.
+
+	static HINSTANCE Acquire (const VesselModule *mod);
+	// Add a reference to a registry module for a vessel instance. The
+	// returned handle must be released with FreeLibrary.
+
+	void Flush ();
+	// Release all class files and module references. Called at the end of
+	// a simulation session.
+
+	Stats GetStats () const;
+
+private:
+	CfgCache cfg;
+	std::unordered_map<std::string, VesselModule> module; // keyed by lower-case module name
+	Stats stats;
+	mutable std::mutex mtx;
+};
+
+#endif // !__VESSELCLASS_H
@@ -33,11 +33,13 @@ void SurfParam::Set (const StateVectors &s, const StateVectors &s_ref, const Cel
 	alt0 = alt = rad - ref->Size();
 	elev = 0.0;
 	surfnml.Set(0,1,0);
+	ElevationManager *emgr = 0;
+	int reslvl = 0;
 	if (etilecache && alt < alt_max) {
 		if (ref->Type() == OBJTP_PLANET) {
-			ElevationManager *emgr = ((Planet*)ref)->ElevMgr();
+			emgr = ((Planet*)ref)->ElevMgr();
 			if (emgr) {
-				int reslvl = (int)(32.0-log(max(alt0,100.0))*LOG2);
+				reslvl = (int)(32.0-log(max(alt0,100.0))*LOG2);
 				elev = emgr->Elevation (lat, lng, reslvl, etilecache, &surfnml, &elev_lvl);
 				alt -= elev;
 			}
@@ -59,6 +61,14 @@ void SurfParam::Set (const StateVectors &s, const StateVectors &s_ref, const Cel
 	groundvel_ship.Set (tmul (s.R, groundvel_glob));  // ground velocity in ship frame
 	groundspd = groundvel_glob.length();
 
+	// request the elevation tiles along the ground track ahead
+	if (emgr && groundspd > 1.0) {
+		Vector vloc (tmul (s_ref.R, groundvel_glob)); // ground velocity in planet frame
+		double vlng = (vloc.z*clng - vloc.x*slng) / (rad*max(clat, 1e-6));
+		double vlat = (vloc.y*clat - (vloc.x*clng + vloc.z*slng)*slat) / rad;
+		emgr->Prefetch (lat, lng, reslvl, vlat, vlng);
+	}
+
 	// vertical velocity
 	vspd = dotp(vrel, Prel.unit());
 
@@ -197,6 +207,7 @@ void VesselBase::SetDefaultState ()
 	proxyplanet = 0;
 	proxybase = 0;
 	bDynamicGroundContact = true;
+	bPropagated = false;
 	bSurfaceContact = false;
 	LandingTest.testing = false;
 	proxyT    = -(double)rand()*100.0/(double)RAND_MAX - 1.0;
@@ -241,6 +252,22 @@ void VesselBase::PostUpdate ()
 
 // =======================================================================
 
+bool VesselBase::CanPropagateConcurrently () const
+{
+	if (fstatus != FLIGHTSTATUS_FREEFLIGHT || !bDynamicPosVel) return false;
+	if (!proxybody) return true;
+
+	// Surface parameters and ground contact forces query the planet's
+	// elevation data below 100 km altitude, which is shared between vessels.
+	// Only allow concurrent propagation if the vessel can't get there within
+	// the current step.
+	const double alt_min = 1.1e5;
+	double vrel = (s0->vel - proxybody->s0->vel).length();
+	return sp.alt0 - vrel*td.SimDT > alt_min;
+}
+
+// =======================================================================
+
 void VesselBase::UpdateSurfParams ()
 {
 	if (proxybody) sp.Set (s1 ? *s1 : *s0, proxybody->s1 ? *proxybody->s1 : *proxybody->s0, proxybody, &etile, &windp);
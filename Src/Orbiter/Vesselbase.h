@@ -89,6 +89,17 @@ public:
 
 	virtual void PostUpdate ();
 
+	virtual bool CanPropagateConcurrently () const;
+	// Returns true if the dynamic state propagation for the current step is
+	// independent of all other vessels and of shared surface data, so that it
+	// can be performed on a worker thread ahead of the serial Update call.
+
+	virtual void Propagate (bool force = false) {}
+	// Dynamic state propagation for the current step. Only called for vessels
+	// that returned true from CanPropagateConcurrently. The subsequent Update
+	// call then skips the propagation and only performs the remaining
+	// (serial) state update tasks.
+
 	inline CelestialBody *ProxyBody() { return proxybody; }
 	inline Planet *ProxyPlanet() { return proxyplanet; }
 	inline const Planet *ProxyPlanet() const { return proxyplanet; }
@@ -188,6 +199,7 @@ protected:
 
 	// Behaviour flags
 	bool bDynamicGroundContact;  // use dynamic model for ground contact forces
+	bool bPropagated;            // dynamic state for current step already propagated by Propagate()
 
 	mutable bool update_with_collision;   // include surface contact forces in dynamic update
 	mutable bool collision_during_update; // surface contact during current step update?
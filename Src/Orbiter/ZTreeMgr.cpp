@@ -3,7 +3,9 @@
 
 #include "ZTreeMgr.h"
 #include "zlib.h"
-#include "util.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
 
 // =======================================================================
 // File header for compressed tree files
@@ -50,6 +52,20 @@ bool TreeFileHeader::fread(FILE *f)
 	return true;
 }
 
+// -----------------------------------------------------------------------
+
+bool TreeFileHeader::mread(const BYTE *data, size_t size)
+{
+	TreeFileHeader tfh;
+	if (size < sizeof(TreeFileHeader))
+		return false;
+	memcpy(&tfh, data, sizeof(TreeFileHeader));
+	if (memcmp(tfh.magic, magic, 4) || tfh.size != this->size)
+		return false;
+	*this = tfh;
+	return true;
+}
+
 // =======================================================================
 // Tree table of contents
 
@@ -84,12 +100,26 @@ size_t TreeTOC::fread(DWORD size, FILE *f)
 	return ::fread(tree, sizeof(TreeNode), size, f);
 }
 
+// -----------------------------------------------------------------------
+
+size_t TreeTOC::mread(DWORD size, const BYTE *data)
+{
+	if (ntreebuf != size) {
+		TreeNode *tmp = new TreeNode[size];
+		if (ntreebuf) delete []tree;
+		tree = tmp;
+		ntree = ntreebuf = size;
+	}
+	memcpy(tree, data, size*sizeof(TreeNode));
+	return size;
+}
+
 // =======================================================================
 // ZTreeMgr class: manage a single layer tree for a planet
 
-ZTreeMgr *ZTreeMgr::CreateFromFile(const char *PlanetPath, Layer _layer)
+ZTreeMgr *ZTreeMgr::CreateFromFile(const char *PlanetPath, Layer _layer, bool mapped)
 {
-	ZTreeMgr *mgr = new ZTreeMgr(PlanetPath, _layer);
+	ZTreeMgr *mgr = new ZTreeMgr(PlanetPath, _layer, mapped);
 	if (!mgr->TOC().size()) {
 		delete mgr;
 		mgr = 0;
@@ -99,13 +129,13 @@ ZTreeMgr *ZTreeMgr::CreateFromFile(const char *PlanetPath, Layer _layer)
 
 // -----------------------------------------------------------------------
 
-ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer)
+ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer, bool mapped)
 {
 	path = new char[strlen(PlanetPath)+1];
 	strcpy(path, PlanetPath);
 	layer = _layer;
 	treef = 0;
-	OpenArchive();
+	OpenArchive(mapped);
 }
 
 // -----------------------------------------------------------------------
@@ -119,11 +149,14 @@ ZTreeMgr::~ZTreeMgr()
 
 // -----------------------------------------------------------------------
 
-bool ZTreeMgr::OpenArchive()
+bool ZTreeMgr::OpenArchive(bool mapped)
 {
 	const char *name[6] = { "Surf", "Mask", "Elev", "Elev_mod", "Label", "Cloud" };
 	char fname[256];
 	sprintf (fname, "%s\\Archive\\%s.tree", path, name[layer]);
+	if (mapped && OpenMapped(fname))
+		return true;
+
 	treef = fopen(fname, "rb");
 	if (!treef) return false;
 
@@ -152,19 +185,54 @@ bool ZTreeMgr::OpenArchive()
 
 // -----------------------------------------------------------------------
 
-DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng)
+bool ZTreeMgr::OpenMapped(const char *fname)
+{
+	if (!mapf.Open(fname))
+		return false;
+
+	const BYTE *data = mapf.Data();
+	size_t size = mapf.Size();
+	TreeFileHeader tfh;
+	if (!tfh.mread(data, size) ||
+		size < tfh.size + (size_t)tfh.nodeCount*sizeof(TreeNode) ||
+		size < tfh.dataOfs + (size_t)tfh.dataLength) {
+		mapf.Close();
+		return false;
+	}
+	rootPos1 = tfh.rootPos1;
+	rootPos2 = tfh.rootPos2;
+	rootPos3 = tfh.rootPos3;
+	for (int i = 0; i < 2; i++)
+		rootPos4[i] = tfh.rootPos4[i];
+	dofs = (__int64)tfh.dataOfs;
+
+	toc.mread(tfh.nodeCount, data + tfh.size);
+	toc.totlength = tfh.dataLength;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng) const
 {
 	if (lvl <= 4) {
+		if (lvl == 4 && (ilat || ilng < 0 || ilng > 1))
+			return (DWORD)-1;
 		return (lvl == 1 ? rootPos1 : lvl == 2 ? rootPos2 : lvl == 3 ? rootPos3 : rootPos4[ilng]);
 	} else {
-		int plvl = lvl-1;
-		int pilat = ilat/2;
-		int pilng = ilng/2;
-		DWORD pidx = Idx(plvl, pilat, pilng);
-		if (pidx == (DWORD)-1)
-			return pidx;
-		int cidx = ((ilat&1) << 1) + (ilng&1);
-		return toc[pidx].child[cidx];
+		// descend from the level-4 root, picking the child quadrant
+		// from successive bits of the tile indices
+		int shift = lvl-4;
+		int root = ilng >> shift;
+		if (root < 0 || root > 1 || (ilat >> shift))
+			return (DWORD)-1;
+		DWORD idx = rootPos4[root];
+		while (shift-- && idx != (DWORD)-1) {
+			int cidx = (((ilat >> shift)&1) << 1) + ((ilng >> shift)&1);
+			idx = toc[idx].child[cidx];
+		}
+		return idx;
 	}
 }
 
@@ -178,18 +246,9 @@ DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp)
 	if (!esize) // node doesn't have data, but has descendants with data
 		return 0;
 
-	if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET))
-		return 0;
-
-	DWORD zsize = NodeSizeDeflated(idx);
-	BYTE *zbuf = new BYTE[zsize];	
-	fread(zbuf, 1, zsize, treef);
-
 	BYTE *ebuf = new BYTE[esize];
 
-	DWORD ndata = Inflate(zbuf, zsize, ebuf, esize);
-	delete []zbuf;
-	zbuf = NULL;
+	DWORD ndata = ReadData(idx, ebuf, esize);
 
 	if (!ndata) {
 		delete []ebuf;
@@ -201,6 +260,39 @@ DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp)
 
 // -----------------------------------------------------------------------
 
+DWORD ZTreeMgr::ReadData(DWORD idx, BYTE *buf, DWORD bufsize) const
+{
+	if (idx == (DWORD)-1 || idx >= toc.size()) return 0; // sanity check
+
+	DWORD esize = NodeSizeInflated(idx);
+	if (!esize || esize > bufsize) // no data, or buffer too small
+		return 0;
+
+	DWORD zsize = NodeSizeDeflated(idx);
+	__int64 ofs = toc[idx].pos+dofs;
+
+	if (mapf.IsOpen()) { // inflate directly from the mapped archive
+		if (ofs + zsize > (__int64)mapf.Size())
+			return 0;
+		return Inflate(mapf.Data()+ofs, zsize, buf, esize);
+	}
+
+	if (!treef) return 0;
+
+	static thread_local std::vector<BYTE> zbuf; // per-thread staging buffer for deflated data
+	if (zbuf.size() < zsize)
+		zbuf.resize(zsize);
+	{
+		std::lock_guard<std::mutex> lock(readMtx);
+		if (_fseeki64(treef, ofs, SEEK_SET) ||
+			fread(zbuf.data(), 1, zsize, treef) != zsize)
+			return 0;
+	}
+	return Inflate(zbuf.data(), zsize, buf, esize);
+}
+
+// -----------------------------------------------------------------------
+
 DWORD ZTreeMgr::Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
 {
 	DWORD ndata = noutp;
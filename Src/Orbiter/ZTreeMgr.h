@@ -10,7 +10,9 @@
 #define __ZTREEMGR_H
 
 #include <iostream>
+#include <mutex>
 #include <windows.h>
+#include "MappedFile.h"
 
 // =======================================================================
 // Tree node structure
@@ -37,6 +39,7 @@ public:
 	TreeFileHeader();
 	size_t fwrite(FILE *f);
 	bool fread(FILE *f);
+	bool mread(const BYTE *data, size_t size);
 
 private:
 	BYTE magic[4];      // file ID and version
@@ -61,6 +64,7 @@ public:
 	TreeTOC();
 	~TreeTOC();
 	size_t fread(DWORD size, FILE *f);
+	size_t mread(DWORD size, const BYTE *data);
 	inline DWORD size() const { return ntree; }
 	inline const TreeNode &operator[](int idx) const { return tree[idx]; }
 
@@ -83,12 +87,18 @@ private:
 class ZTreeMgr {
 public:
 	enum Layer { LAYER_SURF, LAYER_MASK, LAYER_ELEV, LAYER_ELEVMOD, LAYER_LABEL, LAYER_CLOUD };
-	static ZTreeMgr *CreateFromFile(const char *PlanetPath, Layer _layer);
-	ZTreeMgr(const char *PlanetPath, Layer _layer);
+	static ZTreeMgr *CreateFromFile(const char *PlanetPath, Layer _layer, bool mapped = true);
+	ZTreeMgr(const char *PlanetPath, Layer _layer, bool mapped = true);
+	// If mapped is true, the archive is memory-mapped, and tile reads are
+	// served from the mapped region without locking. If the archive can't be
+	// mapped (e.g. address space exhausted on 32-bit builds), or mapped is
+	// false, tiles are read via a shared file handle.
 	~ZTreeMgr();
 	const TreeTOC &TOC() const { return toc; }
 
-	DWORD Idx(int lvl, int ilat, int ilng);
+	inline bool IsMapped() const { return mapf.IsOpen(); }
+
+	DWORD Idx(int lvl, int ilat, int ilng) const;
 	// return the array index of an arbitrary tile ((DWORD)-1: not present)
 
 	DWORD ReadData(DWORD idx, BYTE **outp);
@@ -96,19 +106,30 @@ public:
 	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE **outp)
 	{ return (ilat < 0 || ilng < 0) ? 0 : ReadData(Idx(lvl, ilat, ilng), outp); }
 
+	DWORD ReadData(DWORD idx, BYTE *buf, DWORD bufsize) const;
+	// Inflate the data of node idx into buf, which must hold at least
+	// NodeSizeInflated(idx) bytes. Returns the number of bytes written, or 0
+	// if the node has no data. Can be called concurrently from multiple threads.
+
+	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE *buf, DWORD bufsize) const
+	{ return (ilat < 0 || ilng < 0) ? 0 : ReadData(Idx(lvl, ilat, ilng), buf, bufsize); }
+
 	void ReleaseData(BYTE *data);
 
 	inline DWORD NodeSizeDeflated(DWORD idx) const { return toc.NodeSizeDeflated(idx); }
 	inline DWORD NodeSizeInflated(DWORD idx) const { return toc.NodeSizeInflated(idx); }
 
 protected:
-	bool OpenArchive();
-	DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
+	bool OpenArchive(bool mapped);
+	bool OpenMapped(const char *fname);
+	static DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
 
 private:
 	char *path;
 	Layer layer;
 	FILE *treef;
+	MappedFile mapf;   // archive mapping (if mapped backend is used)
+	mutable std::mutex readMtx; // serialises reads from treef
 	TreeTOC toc;
 	DWORD rootPos1;    // index of level-1 tile ((DWORD)-1 for not present)
 	DWORD rootPos2;    // index of level-2 tile ((DWORD)-1 for not present)
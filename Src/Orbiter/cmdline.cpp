@@ -175,7 +175,10 @@ std::vector<::CommandLine::Key>& orbiter::CommandLine::KeyList() const
 		{ KEY_MAXSYSTIME, "maxsystime", 'T', true},
 		{ KEY_MAXSIMTIME, "maxsimtime", 't', true},
 		{ KEY_FRAMECOUNT, "maxframes", '_', true},
-		{ KEY_PLUGIN, "plugin", 'p', true}
+		{ KEY_PLUGIN, "plugin", 'p', true},
+		{ KEY_BUILDEPHEM, "buildephem", '_', true},
+		{ KEY_FRCONVERT, "frconvert", '_', true},
+		{ KEY_BATCH, "batch", 'b', true}
 	};
 	return keyList;
 }
@@ -230,6 +233,23 @@ void orbiter::CommandLine::ApplyOption(const Key* key, const std::string& value)
 	case KEY_PLUGIN:
 		cfg.LoadPlugins.push_back(value);
 		break;
+	case KEY_BUILDEPHEM: {
+		double mjd0, mjd1;
+		res = sscanf(value.c_str(), "%lf,%lf", &mjd0, &mjd1);
+		if (res == 2 && mjd1 > mjd0) {
+			cfg.EphemBuildMJD0 = mjd0;
+			cfg.EphemBuildMJD1 = mjd1;
+		}
+		} break;
+	case KEY_FRCONVERT: {
+		size_t sep = value.find(',');
+		cfg.FRConvert = value.substr(0, sep);
+		cfg.bFRConvertBinary = (sep != std::string::npos && !_stricmp(value.c_str() + sep + 1, "binary"));
+		} break;
+	case KEY_BATCH:
+		cfg.BatchScenario = value;
+		cfg.bFastExit = true;
+		break;
 	}
 }
 
@@ -254,6 +274,9 @@ void orbiter::CommandLine::PrintHelpAndExit() const
 	std::cout << "  --maxsimtime=<t>, -t <t>: Terminate session at simulation time <t>\n";
 	std::cout << "  --maxframes=<f>: Terminate session after <f> time frames\n";
 	std::cout << "  --plugin=<pg>, -p <pg>: Load plugin <pg> (from Modules\\Plugin\\<pg>.dll)\n";
+	std::cout << "  --buildephem=<mjd0>,<mjd1>: Build the ephemeris cache for dates <mjd0> to <mjd1>\n";
+	std::cout << "  --frconvert=<rec>[,text|binary]: Convert the streams of flight recording <rec> (default: text)\n";
+	std::cout << "  --batch=<scn>, -b <scn>: Run the --scenario scenario without user interface, save the final state to <scn> and exit\n";
 	std::cout << std::endl;
 
 	exit(0);
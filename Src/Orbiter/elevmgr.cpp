@@ -5,7 +5,9 @@
 #include "Celbody.h"
 #include "Planet.h"
 #include "Orbiter.h"
+#include "Profiler.h"
 #include <filesystem>
+#include <mutex>
 
 using std::min;
 using std::max;
@@ -14,6 +16,20 @@ static int elev_grid = 256;
 static int elev_stride = elev_grid+3;
 static int MAXLVL_LIMIT = SURF_MAX_PATCHLEVEL2 - 7;
 
+// Read a tile from an archive into a per-thread buffer which is reused for
+// subsequent reads, rather than allocating a new buffer for each tile
+static DWORD ReadArchiveTile (const ZTreeMgr *mgr, int lvl, int ilat, int ilng, BYTE **buf)
+{
+	static thread_local std::vector<BYTE> tilebuf;
+	if (ilat < 0 || ilng < 0) return 0;
+	DWORD idx = mgr->Idx(lvl, ilat, ilng);
+	if (idx == (DWORD)-1) return 0;
+	DWORD size = mgr->NodeSizeInflated(idx);
+	if (tilebuf.size() < size) tilebuf.resize(size);
+	*buf = tilebuf.data();
+	return mgr->ReadData(idx, *buf, size);
+}
+
 extern Orbiter *g_pOrbiter;
 extern TimeData td;
 extern char DBG_MSG[256];
@@ -68,10 +84,14 @@ ElevationManager::ElevationManager (const CelestialBody *_cbody)
 	g_pOrbiter->Cfg()->PTexPath(path, fname);
 	auto y = std::filesystem::status(path);
 	bModExists = std::filesystem::is_directory(y);
+
+	if (mode)
+		sharedCache = ElevTileCache::Acquire();
 }
 
 ElevationManager::~ElevationManager ()
 {
+	if (sharedCache) sharedCache->Purge (this);
 	if (local_cache) delete local_cache;
 	for (int i = 0; i < 2; i++)
 		if (treeMgr[i])
@@ -118,6 +138,26 @@ bool ElevationManager::HasElevationTile(int lvl, int ilat, int ilng) const
 	return false;
 }
 
+ElevTileRef ElevationManager::LoadTile (int lvl, int ilat, int ilng) const
+{
+	PROFILE_ZONE("Elevation tile load");
+	ElevTileRef tile = std::make_shared<ElevTileData>();
+	tile->elev = LoadElevationTile (lvl+4, ilat, ilng, elev_res);
+	if (tile->elev) {
+		LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, tile->elev); // load modifications
+		if (lvl < maxlvl) {
+			// Check if higher lvl data exists for any of the quadrants,
+			// set flag bit to mark it dirty (un-usable)
+			int qlat = ilat * 2, qlng = ilng * 2, qlvl = lvl + 1;
+			tile->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 0)) << 0; // NW
+			tile->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 1)) << 1; // NE
+			tile->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 0)) << 2; // SW
+			tile->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 1)) << 3; // SE
+		}
+	}
+	return tile;
+}
+
 INT16 *ElevationManager::LoadElevationTile (int lvl, int ilat, int ilng, double tgt_res) const
 {
 	INT16 *elev = 0;
@@ -163,7 +203,7 @@ INT16 *ElevationManager::LoadElevationTile (int lvl, int ilat, int ilng, double
 		}
 		if (!elev && treeMgr[0]) {
 			BYTE *buf;
-			DWORD ndata = treeMgr[0]->ReadData(lvl, ilat, ilng, &buf);
+			DWORD ndata = ReadArchiveTile(treeMgr[0], lvl, ilat, ilng, &buf);
 			if (ndata) {
 				BYTE *p = buf;
 				elev = new INT16[ndat];
@@ -184,7 +224,6 @@ INT16 *ElevationManager::LoadElevationTile (int lvl, int ilat, int ilng, double
 					p += ndat*sizeof(INT16);
 					break;
 				}
-				treeMgr[0]->ReleaseData(buf);
 			}
 		}
 		if (elev) {
@@ -264,7 +303,7 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 		}
 		if (treeMgr[1]) {
 			BYTE *buf;
-			DWORD ndata = treeMgr[1]->ReadData(lvl, ilat, ilng, &buf);
+			DWORD ndata = ReadArchiveTile(treeMgr[1], lvl, ilat, ilng, &buf);
 			if (ndata) {
 				BYTE *p = buf;
 				ELEVFILEHEADER *phdr = (ELEVFILEHEADER*)p;
@@ -296,7 +335,6 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 					}
 					} break;
 				}
-				treeMgr[1]->ReleaseData(buf);
 				return true;
 			}
 		}
@@ -369,9 +407,15 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 
 			for (lvl = reqlvl; lvl >= 0; lvl--) {
 				TileIdx (lat, lng, lvl, &ilat, &ilng);
-				t->data = LoadElevationTile (lvl+4, ilat, ilng, elev_res);
-				if (t->data) {
-					LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, t->data); // load modifications
+				ElevTileRef tile = sharedCache->Get (this, lvl, ilat, ilng);
+				if (tile->elev) {
+					// still need to store emin and emax
+					std::call_once (tile->filtered, [&]() {
+						auto gc = g_pOrbiter->GetGraphicsClient();
+						if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, tile->elev);
+					});
+					t->ref = tile;
+					t->data = tile->elev;
 					int nlat = 1 << lvl;
 					int nlng = 2 << lvl;
 					t->mgr = this;
@@ -383,25 +427,10 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 					t->latmax = (0.5-(double)ilat/double(nlat))*Pi;
 					t->lngmin = (double)ilng/(double)nlng*Pi2 - Pi;
 					t->lngmax = (double)(ilng+1)/(double)nlng*Pi2 - Pi;
-					t->quadrants = 0;
-
-					if (reqlvl > lvl) 
-					{
-						// Check if higher lvl data exists for any of the quadrants, 
-						// set flag bit to mark it dirty (un-usable)
-						int qlat = ilat * 2, qlng = ilng * 2, qlvl = lvl + 1;
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 0)) << 0; // NW
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 1)) << 1;	// NE
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 0)) << 2; // SW
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 1)) << 3;	// SE
-					}
+					t->quadrants = (reqlvl > lvl ? tile->quadrants : 0);
 
 					//int q = Quadrant(lat, lng, lvl);
 					//oapiWriteLogV("LoadTile[0x%X]: lvl=%d, flags=0x%X, q=%d, i(%d, %d)", t, lvl, t->quadrants, q, ilng, ilat);
-
-					// still need to store emin and emax
-					auto gc = g_pOrbiter->GetGraphicsClient();
-					if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, t->data);
 					break;
 				}
 			}
@@ -508,6 +537,28 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 	return e*elev_res;
 }
 
+void ElevationManager::Prefetch (double lat, double lng, int reqlvl, double vlat, double vlng) const
+{
+	if (!mode) return;
+	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+
+	// look ahead by a few time steps, but at least by the typical tile load time
+	const double dt = max (1.0, 4.0*td.SimDT);
+	int nlat = 1 << reqlvl;
+	int nlng = 2 << reqlvl;
+	int ilat0, ilng0, ilat, ilng;
+	TileIdx (lat, lng, reqlvl, &ilat0, &ilng0);
+	for (int i = 1; i <= 2; i++) {
+		double plat = min (Pi05, max (-Pi05, lat + vlat*dt*i));
+		double plng = lng + vlng*dt*i;
+		TileIdx (plat, plng, reqlvl, &ilat, &ilng);
+		ilat = min (ilat, nlat-1);
+		ilng = ((ilng % nlng) + nlng) % nlng;
+		if (ilat != ilat0 || ilng != ilng0)
+			sharedCache->Prefetch (this, reqlvl, ilat, ilng);
+	}
+}
+
 void ElevationManager::ElevationGrid (int ilat, int ilng, int lvl, int pilat, int pilng, int plvl, INT16 *pelev, float *elev, double *emean) const
 {
 	int i, j, nmean;
@@ -7,6 +7,7 @@
 #include "windows.h"
 #include "vecmat.h"
 #include "ZTreeMgr.h"
+#include "ElevTileCache.h"
 #include <vector>
 
 class CelestialBody;
@@ -16,10 +17,9 @@ struct ElevationTile {
 		data = nullptr;
 		Clear();
 	}
-	~ElevationTile() { if (data) delete []data; }
 
 	void Clear() { 
-		if (data) delete[]data; 
+		ref.reset();
 		data = nullptr;
 		mgr = nullptr;
 		lvl = tgtlvl = 0;
@@ -35,6 +35,7 @@ struct ElevationTile {
 	}
 
 	INT16 *data;
+	ElevTileRef ref; // shared tile owning data
 	int lvl, tgtlvl;
 	double latmin, latmax;
 	double lngmin, lngmax;
@@ -49,10 +50,23 @@ struct ElevationTile {
 };
 
 class ElevationManager {
+	friend class ElevTileCache;
+
 public:
 	ElevationManager (const CelestialBody *_cbody);
 	~ElevationManager();
 	double Elevation (double lat, double lng, int reqlvl=0, std::vector<ElevationTile> *tilecache = 0, Vector *normal=0, int *lvl=0) const;
+
+	/**
+	* \brief Queue the tiles ahead of a moving surface point for background loading
+	* \param lat current latitude [rad]
+	* \param lng current longitude [rad]
+	* \param reqlvl requested resolution level, as for Elevation()
+	* \param vlat latitude rate [rad/s]
+	* \param vlng longitude rate [rad/s]
+	*/
+	void Prefetch (double lat, double lng, int reqlvl, double vlat, double vlng) const;
+
 	/**
 	* \brief Synthesize an elevation tile by interpolating from the parent
 	* \param ilat latitude index of target tile
@@ -75,6 +89,7 @@ protected:
 	INT16 *LoadElevationTile (int lvl, int ilat, int ilng, double tgt_res) const;
 	bool LoadElevationTile_mod (int lvl, int ilat, int ilng, double tgt_res, INT16 *elev) const;
 	bool HasElevationTile(int lvl, int ilat, int ilng) const;
+	ElevTileRef LoadTile (int lvl, int ilat, int ilng) const;
 
 private:
 	const CelestialBody *cbody;
@@ -85,6 +100,7 @@ private:
 	ZTreeMgr *treeMgr[5];
 	bool bDirExists, bModExists;
 	mutable std::vector<ElevationTile> *local_cache = nullptr;
+	std::shared_ptr<ElevTileCache> sharedCache; // process-wide tile cache
 };
 
 #endif // !__ELEVMGR_H
\ No newline at end of file
@@ -104,8 +104,22 @@ DLLCLBK void ExitModule (HINSTANCE hDLL)
 {
 }
 
+// Vectors are VECTOR3 userdata in interpreters that provide the type (see
+// Interpreter::lua_pushvector), tables otherwise
+static VECTOR3* lua_tovectorud(lua_State* L, int idx)
+{
+	if (lua_type(L, idx) != LUA_TUSERDATA || !lua_getmetatable(L, idx)) return NULL;
+	lua_getfield(L, LUA_REGISTRYINDEX, "VECTOR3");
+	bool isvec = lua_rawequal(L, -1, -2);
+	lua_pop(L, 2);
+	return isvec ? (VECTOR3*)lua_touserdata(L, idx) : NULL;
+}
+
 static VECTOR3 lua_tovector(lua_State* L, int idx)
 {
+	VECTOR3* v = lua_tovectorud(L, idx);
+	if (v) return *v;
+
 	VECTOR3 vec;
 	lua_getfield(L, idx, "x");
 	vec.x = lua_tonumber(L, -1); lua_pop(L, 1);
@@ -118,6 +132,15 @@ static VECTOR3 lua_tovector(lua_State* L, int idx)
 
 static void lua_pushvector(lua_State* L, const VECTOR3& vec)
 {
+	luaL_getmetatable(L, "VECTOR3");
+	if (!lua_isnil(L, -1)) {
+		VECTOR3* v = (VECTOR3*)lua_newuserdata(L, sizeof(VECTOR3));
+		*v = vec;
+		lua_insert(L, -2);
+		lua_setmetatable(L, -2);
+		return;
+	}
+	lua_pop(L, 1);
 	lua_createtable(L, 0, 3);
 	lua_pushnumber(L, vec.x);
 	lua_setfield(L, -2, "x");
@@ -129,6 +152,7 @@ static void lua_pushvector(lua_State* L, const VECTOR3& vec)
 
 static int lua_isvector(lua_State* L, int idx)
 {
+	if (lua_tovectorud(L, idx)) return 1;
 	if (!lua_istable(L, idx)) return 0;
 	static char fieldname[3] = { 'x','y','z' };
 	static char field[2] = "x";
@@ -746,6 +770,7 @@ static int lua_crosscall(lua_State* L) {
 			lua_pushnil(Ltgt);
 			break;
 		case LUA_TTABLE:
+		case LUA_TUSERDATA:
 		{
 			if (lua_isvector(L, i)) {
 				VECTOR3 v = lua_tovector(L, i);
@@ -803,6 +828,7 @@ static int lua_crosscall(lua_State* L) {
 			lua_pushnil(L);
 			break;
 		case LUA_TTABLE:
+		case LUA_TUSERDATA:
 			if (lua_isvector(Ltgt, -i)) {
 				VECTOR3 v = lua_tovector(Ltgt, -i);
 				lua_pushvector(L, v);
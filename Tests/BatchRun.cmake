@@ -0,0 +1,16 @@
+# Batch run check: step a scenario in batch mode and verify that the
+# process reports success and the final state was written.
+# Expects ORBITER (server executable), SCENARIO (input) and OUTPUT (absolute
+# path of the output scenario, including the .scn extension).
+
+file(REMOVE ${OUTPUT})
+execute_process(
+	COMMAND ${ORBITER} "--scenario=${SCENARIO}" "--batch=${OUTPUT}" "--fixedstep=0.02" "--maxframes=100"
+	RESULT_VARIABLE result
+)
+if (NOT result EQUAL 0)
+	message(FATAL_ERROR "Batch run failed with exit code ${result}")
+endif()
+if (NOT EXISTS ${OUTPUT})
+	message(FATAL_ERROR "Batch run did not write ${OUTPUT}")
+endif()
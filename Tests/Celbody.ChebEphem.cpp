@@ -0,0 +1,85 @@
+#include "ChebEphem.h"
+#include "OrbiterAPI.h"
+#include "CelbodyAPI.h"
+
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <math.h>
+
+#include "catch2/catch_all.hpp"
+
+static std::string TestFile (const char *name)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "Celbody.ChebEphem";
+	std::filesystem::create_directories (dir);
+	return (dir / name).string();
+}
+
+static void WriteFile (const std::string &fname, const char *data)
+{
+	std::ofstream ofs (fname, std::ios::binary);
+	ofs << data;
+}
+
+// Reference ephemeris: Kepler orbit (true state), with the barycentre
+// offset by a short-period wobble
+static int Ephem (double mjd, double *res)
+{
+	const double a = 1.496e11, e = 0.2, T = 365.25, mu = 4.0*PI*PI*a*a*a/(T*T*86400.0*86400.0);
+	const double aw = 4.7e6, Tw = 27.3;
+	double M = 2.0*PI*(mjd-51544.5)/T, E = M;
+	for (int i = 0; i < 30; i++) E -= (E - e*sin(E) - M)/(1.0 - e*cos(E));
+	double b = sqrt (1.0-e*e), r = a*(1.0-e*cos(E)), vf = sqrt (mu*a)/r;
+	res[0] = a*(cos(E)-e), res[1] = 0.0, res[2] = a*b*sin(E);
+	res[3] = -vf*sin(E),   res[4] = 0.0, res[5] = vf*b*cos(E);
+	double w = 2.0*PI*(mjd-51544.5)/Tw, dw = 2.0*PI/(Tw*86400.0);
+	res[6] = res[0] + aw*cos(w), res[7] = 0.0, res[8]  = res[2] + aw*sin(w);
+	res[9] = res[3] - aw*dw*sin(w), res[10] = 0.0, res[11] = res[5] + aw*dw*cos(w);
+	return EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL;
+}
+
+static double RelErr (const double *a, const double *b)
+{
+	double d2 = 0.0, r2 = 0.0;
+	for (int i = 0; i < 3; i++) {
+		d2 += (a[i]-b[i])*(a[i]-b[i]);
+		r2 += b[i]*b[i];
+	}
+	return sqrt (d2/r2);
+}
+
+TEST_CASE("Chebyshev ephemeris fit and evaluation", "[ChebEphem]")
+{
+	const double mjd0 = 51544.0, mjd1 = 51544.0 + 400.0;
+	std::string cache = TestFile ("Body.chb"), module = TestFile ("Body.dll");
+	WriteFile (module, "module v1");
+	REQUIRE(ChebEphemeris::Build (cache.c_str(), module.c_str(), Ephem, mjd0, mjd1, 1e-11));
+
+	SECTION("Round trip") {
+		ChebEphemeris ce;
+		REQUIRE(ce.Open (cache.c_str(), module.c_str()));
+		REQUIRE(ce.MJD0() == mjd0);
+		REQUIRE(ce.MJD1() >= mjd1);
+		double res[12], ref[12];
+		for (int i = 0; i <= 1000; i++) {
+			double mjd = mjd0 + (mjd1-mjd0)*i/1000.0;
+			REQUIRE(ce.Eval (mjd, res) == Ephem (mjd, ref));
+			for (int g = 0; g < 4; g++)
+				REQUIRE(RelErr (res+g*3, ref+g*3) < 1e-10);
+		}
+		REQUIRE(ce.Eval (mjd0-1.0, res) == 0);
+		REQUIRE(ce.Eval (ce.MJD1()+1.0, res) == 0);
+	}
+
+	SECTION("Source identity") {
+		ChebEphemeris ce;
+		REQUIRE(ce.Open (cache.c_str()));        // no source check
+		std::string other = TestFile ("Other.dll");
+		WriteFile (other, "module v1");
+		REQUIRE(!ce.Open (cache.c_str(), other.c_str())); // different module
+		WriteFile (module, "module v2, rebuilt");
+		REQUIRE(!ce.Open (cache.c_str(), module.c_str())); // module modified
+		REQUIRE(!ce.IsOpen());
+	}
+}
@@ -0,0 +1,96 @@
+#include "Vecmat.h"
+#include "PinesGrav.h"
+
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <math.h>
+
+#include "catch2/catch_all.hpp"
+
+// Batch evaluation of a spherical harmonics gravity model against single
+// point evaluations. The model is a synthetic field with coefficients
+// decaying like a lunar model.
+
+static std::string WriteModel (int nmax)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "Celbody.PinesGrav";
+	std::filesystem::create_directories (dir);
+	std::string fname = (dir / ("model" + std::to_string (nmax) + ".sha")).string();
+	std::ofstream ofs (fname);
+	ofs.precision (16);
+	ofs << "1738000.0, 4.902800066e12, 0.0, " << nmax << ", " << nmax << ", 1, 0.0, 0.0\n";
+	std::mt19937 rng(7);
+	std::normal_distribution<double> coeff(0.0, 1.0);
+	for (int n = 1; n <= nmax; n++)
+		for (int m = 0; m <= n; m++) {
+			double c = (n > 1 ? coeff(rng)*1e-4/(n*n) : 0.0);
+			double s = (n > 1 && m > 0 ? coeff(rng)*1e-4/(n*n) : 0.0);
+			ofs << n << ", " << m << ", " << c << ", " << s << ", 0.0, 0.0\n";
+		}
+	return fname;
+}
+
+static std::vector<Vector> Positions (int npos)
+{
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> alt(1e4, 5e5), phi(0.0, Pi2), z(-1.0, 1.0);
+	std::vector<Vector> pos(npos);
+	for (auto &p : pos) {
+		double r = 1738000.0 + alt(rng), cz = z(rng), sz = sqrt (1.0-cz*cz), ph = phi(rng);
+		p = Vector (r*sz*cos (ph), r*sz*sin (ph), r*cz);
+	}
+	return pos;
+}
+
+TEST_CASE("Batch evaluation matches single-point evaluation", "[PinesGrav]")
+{
+	const int cutoff = 40;
+	std::string fname = WriteModel (50);
+	PinesGravProp prop (nullptr);
+	int nloaded, nmodel;
+	REQUIRE(prop.readGravModel ((char*)fname.c_str(), cutoff, nloaded, nmodel) == 0);
+
+	for (int npos : { 1, 4, 13 }) {
+		std::vector<Vector> pos = Positions (npos), g(npos);
+		PinesGravWorkspace ws, wsb;
+		for (int order : { cutoff, 10 }) {
+			prop.GetPinesGrav (npos, pos.data(), g.data(), cutoff, order, wsb);
+			for (int i = 0; i < npos; i++) {
+				Vector g1 = prop.GetPinesGrav (pos[i], cutoff, order, ws);
+				REQUIRE(g1.length() > 0.0);
+				REQUIRE((g[i]-g1).length() <= 1e-13*g1.length());
+			}
+		}
+	}
+}
+
+// Celbody.PinesGrav [benchmark]
+TEST_CASE("Batch vs. single-point evaluation", "[.][benchmark]")
+{
+	const int cutoff = 100, npos = 1000;
+	std::string fname = WriteModel (cutoff);
+	PinesGravProp prop (nullptr);
+	int nloaded, nmodel;
+	REQUIRE(prop.readGravModel ((char*)fname.c_str(), cutoff, nloaded, nmodel) == 0);
+	std::vector<Vector> pos = Positions (npos), g(npos);
+	PinesGravWorkspace ws;
+
+	for (int degree : { 10, 30, 100 }) {
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < npos; i++)
+			g[i] = prop.GetPinesGrav (pos[i], degree, degree, ws);
+		double t_single = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		t0 = std::chrono::steady_clock::now();
+		prop.GetPinesGrav (npos, pos.data(), g.data(), degree, degree, ws);
+		double t_batch = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		std::cout << "degree " << degree << ", " << npos << " positions: single " << t_single*1e3
+			<< " ms, batch " << t_batch*1e3 << " ms" << std::endl;
+	}
+}
@@ -0,0 +1,228 @@
+#include "CfgFile.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <string.h>
+
+#include "catch2/catch_all.hpp"
+
+static std::string TestFile (const char *name)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "Config.FileIndex";
+	std::filesystem::create_directories (dir);
+	return (dir / name).string();
+}
+
+// Reference implementation: the sequential scan used for streams without index
+static bool ScanItem (std::istream &is, const char *label, char *val)
+{
+	char cbuf[512], *cl, *cv;
+	int i;
+
+	is.clear();
+	is.seekg (0, std::ios::beg);
+	while (is.getline (cbuf, 512)) {
+		if ((cl = strchr (cbuf, '\r'))) *cl = '\0'; // as in text mode on Windows
+		for (cl = cbuf; *cl && *cl != ';'; cl++);
+		for (*cl-- = '\0'; cl >= cbuf && (*cl == ' ' || *cl == '\t'); cl--) *cl = '\0';
+		for (cl = cbuf; *cl == ' ' || *cl == '\t'; cl++);
+		if (!_stricmp(cl, "END_PARSE")) return false;
+
+		for (i = 0; cl[i] && cl[i] != '='; i++);
+		cv = (cl[i] ? cl+(i+1) : cl+i);
+		for (cl[i--] = '\0'; i >= 0 && (cl[i] == ' ' || cl[i] == '\t'); i--)
+			cl[i] = '\0';
+		if (!_stricmp (cl, label)) {
+			while (*cv == ' ' || *cv == '\t') cv++;
+			if (*cv) {
+				strcpy (val, cv);
+				return true;
+			} else {
+				return false;
+			}
+		}
+	}
+	is.clear();
+	return false;
+}
+
+// Item tags appearing in a file, in order
+static std::vector<std::string> ItemTags (const std::string &fname)
+{
+	std::vector<std::string> tag;
+	std::ifstream ifs (fname);
+	std::string line;
+	while (std::getline (ifs, line)) {
+		if (line.size() && line.back() == '\r') line.pop_back();
+		size_t eq = line.find ('=');
+		if (eq == std::string::npos || line.find (';') < eq) continue;
+		size_t b = line.find_first_not_of (" \t");
+		size_t e = line.find_last_not_of (" \t", eq-1);
+		if (b < eq && e != std::string::npos && e >= b)
+			tag.push_back (line.substr (b, e-b+1));
+	}
+	return tag;
+}
+
+static std::vector<std::string> ConfigFiles ()
+{
+	std::vector<std::string> file;
+	std::error_code ec;
+	for (auto &entry : std::filesystem::recursive_directory_iterator (CONFIG_DIR, ec))
+		if (entry.is_regular_file() && entry.path().extension() == ".cfg")
+			file.push_back (entry.path().string());
+	return file;
+}
+
+TEST_CASE("Item lookup", "[CfgFile]")
+{
+	std::string fname = TestFile ("items.cfg");
+	{
+		std::ofstream ofs (fname);
+		ofs << "; comment line\n";
+		ofs << "Name = Test body  ; trailing comment\n";
+		ofs << "\tMass=5.97e24\n";
+		ofs << "SIZE = 6.371e6\n";
+		ofs << "Mass = 1.0\n";
+		ofs << "Empty =\n";
+		ofs << "Flag\n";
+		ofs << "BEGIN_LIST\n";
+		ofs << "  item1\n";
+		ofs << "  item2\n";
+		ofs << "END_LIST\n";
+		ofs << "END_PARSE\n";
+		ofs << "Hidden = 1\n";
+	}
+	const char *label[] = {"Name", "MASS", "Size", "Empty", "Flag", "Hidden", "Missing", "BEGIN_LIST", "item1"};
+	const char *value[] = {"Test body", "5.97e24", "6.371e6", 0, 0, 0, 0, 0, 0};
+
+	CfgFile cfg (fname.c_str());
+	REQUIRE(cfg.Indexed());
+	std::ifstream ifs (fname);
+	char cbuf[256], ref[256];
+	for (size_t i = 0; i < sizeof(label)/sizeof(label[0]); i++) {
+		INFO(label[i]);
+		bool found = cfg.GetItem (label[i], cbuf);
+		CHECK(found == (value[i] != 0));
+		if (found) CHECK(std::string(cbuf) == value[i]);
+		CHECK(ScanItem (ifs, label[i], ref) == found);
+	}
+
+	// the stream is positioned after the item, as after a sequential scan
+	REQUIRE(cfg.GetItem ("size", cbuf));
+	std::string line;
+	std::getline (cfg, line);
+	CHECK(line == "Mass = 1.0");
+
+	// sections are read sequentially after FindLine
+	REQUIRE(cfg.FindLine ("begin_list"));
+	std::getline (cfg, line);
+	CHECK(line == "  item1");
+	CHECK(!cfg.FindLine ("BEGIN_NOTHING"));
+	std::getline (cfg, line);
+	CHECK(line == "; comment line");
+
+	// reopening discards the index
+	cfg.close();
+	CHECK(!cfg.Indexed());
+	cfg.open (fname.c_str());
+	REQUIRE(cfg.Indexed());
+	CHECK(cfg.nItem() == 9);
+}
+
+TEST_CASE("Shipped configuration files", "[CfgFile]")
+{
+	std::vector<std::string> file = ConfigFiles();
+	if (file.empty()) {
+		WARN("No configuration files found in " CONFIG_DIR);
+		return;
+	}
+	char cbuf[1024], ref[1024];
+	int nerr = 0;
+	for (auto &fname : file) {
+		CfgFile cfg (fname.c_str());
+		REQUIRE(cfg.Indexed());
+		std::ifstream ifs (fname);
+		for (auto &tag : ItemTags (fname)) {
+			bool found = cfg.GetItem (tag.c_str(), cbuf);
+			if (found != ScanItem (ifs, tag.c_str(), ref) || (found && strcmp (cbuf, ref))) {
+				UNSCOPED_INFO(fname << ": " << tag);
+				nerr++;
+			}
+		}
+	}
+	CHECK(nerr == 0);
+}
+
+TEST_CASE("Concurrent cache requests", "[CfgFile]")
+{
+	std::string fname = TestFile ("Shared.cfg");
+	{
+		std::ofstream ofs (fname);
+		for (int i = 0; i < 10000; i++)
+			ofs << "Item" << i << " = " << i << '\n';
+	}
+	// threads requesting the same file share a single parse
+	CfgCache cache;
+	std::vector<CfgFile::IndexRef> index(8);
+	std::vector<std::thread> thread;
+	for (size_t i = 0; i < index.size(); i++)
+		thread.emplace_back ([&, i]{ index[i] = cache.Get (fname.c_str()); });
+	for (auto &t : thread) t.join();
+	REQUIRE(index[0]);
+	CHECK(index[0]->item.size() == 10000);
+	for (auto &idx : index)
+		CHECK(idx == index[0]);
+	CHECK(cache.nFile() == 1);
+
+	std::string missing = TestFile ("Missing.cfg");
+	CHECK(!cache.Get (missing.c_str()));
+	CHECK(cache.nFile() == 2);
+	cache.Clear();
+	CHECK(cache.nFile() == 0);
+}
+
+// Load all configuration files and look up all of their items, plus a set
+// of items that don't exist (loaders probe many optional items, e.g. ~37 in
+// Planet.cpp), with and without index. Hidden from the default run:
+// Config.FileIndex [benchmark]
+TEST_CASE("Configuration load time", "[.][benchmark]")
+{
+	std::vector<std::string> file = ConfigFiles();
+	REQUIRE(!file.empty());
+	std::vector<std::vector<std::string>> tag;
+	size_t nlookup = 0;
+	for (auto &fname : file) {
+		tag.push_back (ItemTags (fname));
+		for (int i = 0; i < 30; i++)
+			tag.back().push_back ("OptionalItem" + std::to_string(i));
+		nlookup += tag.back().size();
+	}
+	char cbuf[1024];
+	const int nrep = 20;
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (int rep = 0; rep < nrep; rep++)
+		for (size_t i = 0; i < file.size(); i++) {
+			std::ifstream ifs (file[i]);
+			for (auto &t : tag[i]) ScanItem (ifs, t.c_str(), cbuf);
+		}
+	double dt0 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / nrep;
+
+	t0 = std::chrono::steady_clock::now();
+	for (int rep = 0; rep < nrep; rep++)
+		for (size_t i = 0; i < file.size(); i++) {
+			CfgFile cfg (file[i].c_str());
+			if (cfg.Indexed())
+				for (auto &t : tag[i]) cfg.GetItem (t.c_str(), cbuf);
+		}
+	double dt1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / nrep;
+
+	std::cout << file.size() << " files, " << nlookup << " lookups: "
+		<< 1e3*dt0 << " ms (scan), " << 1e3*dt1 << " ms (indexed)" << std::endl;
+}
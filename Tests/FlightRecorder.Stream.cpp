@@ -0,0 +1,311 @@
+#include "FRStream.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <string.h>
+#include <math.h>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+static std::string TestFile (const char *name)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "FlightRecorder.Stream";
+	std::filesystem::create_directories (dir);
+	return (dir / name).string();
+}
+
+static FRStreamRecord Directive (int tag, int ival, double t = 0.0, const char *name = 0)
+{
+	FRStreamRecord rec;
+	memset (&rec, 0, sizeof(FRStreamRecord));
+	rec.tag = tag;
+	rec.ival = ival;
+	rec.t = t;
+	if (name) strncpy (rec.name, name, 47);
+	return rec;
+}
+
+static FRStreamRecord Sample (double t, double v0, double v1, double v2, double v3 = 0, double v4 = 0, double v5 = 0)
+{
+	FRStreamRecord rec = Directive (FRTAG_SAMPLE, 0, t);
+	double v[6] = {v0, v1, v2, v3, v4, v5};
+	memcpy (rec.v, v, sizeof(v));
+	return rec;
+}
+
+// A position stream in the layout written by the recorder
+static std::vector<FRStreamRecord> PosStream (int nsample)
+{
+	std::vector<FRStreamRecord> rec;
+	rec.push_back (Directive (FRTAG_STARTMJD, 0, 51981.5231));
+	rec.push_back (Directive (FRTAG_REF, 0, 0.0, "Earth"));
+	rec.push_back (Directive (FRTAG_FRM, 1));
+	rec.push_back (Directive (FRTAG_CRD, 1));
+	for (int i = 0; i < nsample; i++)
+		rec.push_back (Sample (i*2.0+0.125, 6.471e6+i, 1.0+i*1e-4, -0.5+i*1e-5, 12.5, 1.1e-3, -2.3e-5));
+	return rec;
+}
+
+static std::vector<FRStreamRecord> ReadAll (const std::string &fname, int type, bool *binary = 0)
+{
+	std::vector<FRStreamRecord> rec;
+	FRStreamReader reader;
+	if (reader.Open (fname.c_str(), type)) {
+		FRStreamRecord r;
+		while (reader.Next (r))
+			rec.push_back (r);
+		if (binary) *binary = reader.IsBinary();
+	}
+	return rec;
+}
+
+static bool Equal (const FRStreamRecord &a, const FRStreamRecord &b, double reltol)
+{
+	if (a.tag != b.tag) return false;
+	switch (a.tag) {
+	case FRTAG_REF:
+		return !strcmp (a.name, b.name);
+	case FRTAG_FRM:
+	case FRTAG_CRD:
+		return a.ival == b.ival;
+	case FRTAG_STARTMJD:
+		return fabs (a.t-b.t) <= reltol*fabs(b.t);
+	default:
+		if (fabs (a.t-b.t) > reltol*fabs(b.t)) return false;
+		for (int i = 0; i < 6; i++)
+			if (fabs (a.v[i]-b.v[i]) > reltol*fabs(b.v[i])) return false;
+		return true;
+	}
+}
+
+TEST_CASE("Binary and text streams", "[FRStream]")
+{
+	std::vector<FRStreamRecord> ref = PosStream (5000);
+
+	for (int bin = 0; bin < 2; bin++) {
+		std::string fname = TestFile (bin ? "bin.pos" : "text.pos");
+		FRStream stream;
+		REQUIRE(stream.Open (fname.c_str(), FRSTREAM_POS, false, bin != 0));
+		CHECK(stream.IsBinary() == (bin != 0));
+		for (auto &r : ref)
+			stream.Put (r);
+		stream.Close();
+
+		bool binary;
+		std::vector<FRStreamRecord> rec = ReadAll (fname, FRSTREAM_POS, &binary);
+		CHECK(binary == (bin != 0));
+		REQUIRE(rec.size() == ref.size());
+		double tol = (bin ? 0.0 : 1e-9);
+		int nerr = 0;
+		for (size_t i = 0; i < rec.size(); i++)
+			if (!Equal (rec[i], ref[i], tol)) nerr++;
+		CHECK(nerr == 0);
+	}
+	// binary records are compact
+	CHECK(std::filesystem::file_size (TestFile ("bin.pos")) == 16 + ref.size()*sizeof(FRStreamRecord));
+}
+
+TEST_CASE("Legacy text streams", "[FRStream]")
+{
+	std::string fname = TestFile ("legacy.att");
+	{
+		std::ofstream ofs (fname);
+		ofs << "STARTMJD 51981.5231\n";
+		ofs << "REF Earth\n";
+		ofs << "FRM HORIZON\n";
+		ofs << "10.5 0.1 -0.2 3.1\n";
+		ofs << "garbage\n";
+		ofs << "FRM ECLIPTIC\n";
+		ofs << "12 0.25 -0.5 1\n";
+	}
+	std::vector<FRStreamRecord> rec = ReadAll (fname, FRSTREAM_ATT);
+	REQUIRE(rec.size() == 6);
+	CHECK(rec[0].tag == FRTAG_STARTMJD);
+	CHECK(rec[0].t == 51981.5231);
+	CHECK(rec[1].tag == FRTAG_REF);
+	CHECK(std::string(rec[1].name) == "Earth");
+	CHECK(rec[2].tag == FRTAG_FRM);
+	CHECK(rec[2].ival == 1);
+	CHECK(Equal (rec[3], Sample (10.5, 0.1, -0.2, 3.1), 0.0));
+	CHECK(rec[4].ival == 0);
+	CHECK(Equal (rec[5], Sample (12, 0.25, -0.5, 1), 0.0));
+
+	// text output reproduces the recorder format
+	char cbuf[256];
+	FRFormatRecord (rec[1], FRSTREAM_ATT, cbuf, 256);
+	CHECK(std::string(cbuf) == "REF Earth\n");
+	FRFormatRecord (rec[2], FRSTREAM_ATT, cbuf, 256);
+	CHECK(std::string(cbuf) == "FRM HORIZON\n");
+	FRFormatRecord (rec[3], FRSTREAM_ATT, cbuf, 256);
+	CHECK(std::string(cbuf) == "10.5 0.1 -0.2 3.1\n");
+}
+
+TEST_CASE("Stream conversion", "[FRStream]")
+{
+	std::vector<FRStreamRecord> ref = PosStream (100);
+	std::string fname = TestFile ("convert.pos");
+	FRStream stream;
+	REQUIRE(stream.Open (fname.c_str(), FRSTREAM_POS, false, true));
+	for (auto &r : ref)
+		stream.Put (r);
+	stream.Close();
+
+	bool binary;
+	REQUIRE(FRStreamConvert (fname.c_str(), FRSTREAM_POS, false));
+	std::vector<FRStreamRecord> rec = ReadAll (fname, FRSTREAM_POS, &binary);
+	CHECK(!binary);
+	REQUIRE(rec.size() == ref.size());
+	REQUIRE(FRStreamConvert (fname.c_str(), FRSTREAM_POS, true));
+	rec = ReadAll (fname, FRSTREAM_POS, &binary);
+	CHECK(binary);
+	REQUIRE(rec.size() == ref.size());
+	for (size_t i = 0; i < rec.size(); i++)
+		CHECK(Equal (rec[i], ref[i], 1e-9));
+
+	// appending retains the existing format
+	REQUIRE(stream.Open (fname.c_str(), FRSTREAM_POS, true, false));
+	CHECK(stream.IsBinary());
+	stream.Put (Sample (1000.0, 1, 2, 3, 4, 5, 6));
+	stream.Close();
+	rec = ReadAll (fname, FRSTREAM_POS);
+	REQUIRE(rec.size() == ref.size()+1);
+	CHECK(Equal (rec.back(), Sample (1000.0, 1, 2, 3, 4, 5, 6), 0.0));
+}
+
+TEST_CASE("Concurrent streams", "[FRStream]")
+{
+	// many streams, written from several threads, sharing the writer
+	const int nthread = 4, nstream = 8, nline = 20000;
+	std::vector<std::thread> thread;
+	for (int i = 0; i < nthread; i++)
+		thread.emplace_back ([=]() {
+			std::vector<FRStream> stream(nstream);
+			for (int j = 0; j < nstream; j++) {
+				std::string fname = TestFile (("events" + std::to_string(i*nstream+j) + ".atc").c_str());
+				stream[j].Open (fname.c_str(), FRSTREAM_TEXT);
+			}
+			for (int k = 0; k < nline; k++)
+				for (int j = 0; j < nstream; j++)
+					stream[j].Printf ("%d EVENT %d\n", k, j);
+		});
+	for (auto &t : thread) t.join(); // streams are closed by their destructors
+
+	int nerr = 0;
+	for (int s = 0; s < nthread*nstream; s++) {
+		std::ifstream ifs (TestFile (("events" + std::to_string(s) + ".atc").c_str()));
+		int k, j, n = 0;
+		std::string tag;
+		while (ifs >> k >> tag >> j) {
+			if (k != n || j != s%nstream || tag != "EVENT") nerr++;
+			n++;
+		}
+		if (n != nline) nerr++;
+	}
+	CHECK(nerr == 0);
+}
+
+TEST_CASE("Idle streams are flushed", "[FRStream]")
+{
+	// data written before the stream goes idle reach the file without
+	// further writes or an explicit flush
+	std::string fname = TestFile ("idle.atc");
+	FRStream stream;
+	REQUIRE(stream.Open (fname.c_str(), FRSTREAM_TEXT));
+	stream.Printf ("0 EVENT 0\n");
+	std::error_code ec;
+	int i;
+	for (i = 0; i < 30; i++) { // up to 3 s (flush interval: 1 s)
+		std::this_thread::sleep_for (std::chrono::milliseconds(100));
+		if (std::filesystem::file_size (fname, ec) == 10) break;
+	}
+	CHECK(i < 30);
+	stream.Close();
+}
+
+// Reference for FRTrack::Locate: last sample before t, clamped to [0,n-2]
+static int LocateRef (const std::vector<FRStreamRecord> &rec, double t)
+{
+	int i = -1, n = 0;
+	for (auto &r : rec)
+		if (r.tag == FRTAG_SAMPLE) {
+			if (r.t < t) i = n;
+			n++;
+		}
+	return std::max (0, std::min (i, n-2));
+}
+
+TEST_CASE("Indexed playback tracks", "[FRTrack]")
+{
+	// a long stream with a reference body change in the middle
+	std::vector<FRStreamRecord> ref = PosStream (3000);
+	std::vector<FRStreamRecord> tail = PosStream (3000);
+	strcpy (tail[1].name, "Moon");
+	for (size_t i = 4; i < tail.size(); i++)
+		tail[i].t += 6000.0;
+	ref.insert (ref.end(), tail.begin(), tail.end());
+	const int nsample = 6000;
+
+	for (int bin = 0; bin < 2; bin++) {
+		std::string fname = TestFile (bin ? "track.bin.pos" : "track.text.pos");
+		std::string idxname = fname + ".idx";
+		std::filesystem::remove (idxname);
+		FRStream stream;
+		REQUIRE(stream.Open (fname.c_str(), FRSTREAM_POS, false, bin != 0));
+		for (auto &r : ref)
+			stream.Put (r);
+		stream.Close();
+
+		for (int pass = 0; pass < 2; pass++) { // build index, then reuse it
+			INFO((bin ? "binary" : "text") << " pass " << pass);
+			FRTrack track;
+			REQUIRE(track.Open (fname.c_str(), FRSTREAM_POS));
+			CHECK(std::filesystem::exists (idxname));
+			REQUIRE(track.nSample() == nsample);
+			CHECK(track.TEnd() == ref.back().t);
+			CHECK(track.StartMJD() == 51981.5231);
+
+			// sample contents and contexts
+			FRTrack::Sample s;
+			REQUIRE(track.Get (2999, s));
+			CHECK(std::string(track.Contexts()[s.ctx].ref) == "Earth");
+			CHECK(track.Contexts()[s.ctx].crd == 1);
+			REQUIRE(track.Get (3000, s));
+			CHECK(std::string(track.Contexts()[s.ctx].ref) == "Moon");
+			CHECK(s.t == tail[4].t);
+			CHECK(fabs (s.v[0]-tail[4].v[0]) <= 1e-9*tail[4].v[0]);
+			CHECK(!track.Get (nsample, s));
+
+			// sequential playback
+			int nerr = 0;
+			for (double t = -10.0; t < track.TEnd()+10.0; t += 1.7)
+				if (track.Locate (t) != LocateRef (ref, t)) nerr++;
+			CHECK(nerr == 0);
+
+			// random seeks
+			srand (1234);
+			for (int k = 0; k < 500; k++) {
+				double t = (rand() / (double)RAND_MAX) * 12100.0 - 50.0;
+				if (track.Locate (t) != LocateRef (ref, t)) nerr++;
+			}
+			CHECK(nerr == 0);
+		}
+	}
+
+	// a modified stream invalidates the stored index
+	std::string fname = TestFile ("track.bin.pos");
+	FRStream stream;
+	REQUIRE(stream.Open (fname.c_str(), FRSTREAM_POS, true));
+	stream.Put (Sample (20000.0, 1, 2, 3, 4, 5, 6));
+	stream.Close();
+	FRTrack track;
+	REQUIRE(track.Open (fname.c_str(), FRSTREAM_POS));
+	CHECK(track.nSample() == nsample+1);
+	CHECK(track.TEnd() == 20000.0);
+}
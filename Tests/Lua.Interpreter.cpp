@@ -1,6 +1,11 @@
 #include "Interpreter.h"
 
 #include <memory>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <string.h>
 
 // these collide with std::min/max
 #undef min
@@ -27,3 +32,239 @@ TEST_CASE("Create and test Lua interpreter", "[LuaInterpreter]" )
 	lua_getglobal(L, "a");
 	REQUIRE(lua_tointeger(L, -1) == 4);
 };
+
+static int RunLua(lua_State *L, const char *chunk)
+{
+	int res = luaL_dostring(L, chunk);
+	if (res) {
+		INFO(lua_tostring(L, -1));
+		CHECK(res == 0);
+		lua_pop(L, 1);
+	}
+	return res;
+}
+
+TEST_CASE("Vector and matrix types", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	auto L = interp->GetState();
+
+	// API results are userdata with field access and arithmetic
+	REQUIRE(RunLua(L,
+		"v = vec.set(1,2,3)\n"
+		"assert(type(v) == 'userdata')\n"
+		"assert(v.x == 1 and v.y == 2 and v.z == 3 and v.w == nil)\n"
+		"v.z = 4\n"
+		"assert(v.z == 4)\n"
+		"w = v + vec.set(1,1,1)\n"
+		"assert(w.x == 2 and w.y == 3 and w.z == 5)\n"
+		"assert(-v == vec.set(-1,-2,-4))\n"
+		"assert(v*2 == vec.set(2,4,8) and 2*v == v*2 and v/2 == vec.set(0.5,1,2))\n"
+		"assert(v - 1 == vec.set(0,1,3))\n"
+		"assert(v ~= w)\n"
+		"assert(tostring(v) == '[1 2 4]')\n"
+		"M = mat.rotm(vec.set(0,0,1), math.pi/2)\n"
+		"assert(type(M) == 'userdata' and M.m33 == 1)\n"
+		"u = M * vec.set(1,0,0)\n"
+		"assert(math.abs(u.x) < 1e-15 and u.y == 1)\n"
+		"assert(mat.identity() * M == M and (M*2).m33 == 2)\n"
+		"M.m11 = 5\n"
+		"assert(M.m11 == 5 and M.m12 == -1)\n"
+	) == 0);
+
+	// tables are accepted wherever vectors and matrices are, also mixed with userdata
+	REQUIRE(RunLua(L,
+		"a = vec.add({x=1,y=2,z=3}, vec.set(1,1,1))\n"
+		"assert(a == vec.set(2,3,4))\n"
+		"assert(vec.dotp(a, {x=1,y=0,z=0}) == 2)\n"
+		"assert(vec.add({x=1,y=2,z=3}, 1) == vec.set(2,3,4))\n"
+		"assert(mat.mul({m11=1,m12=0,m13=0,m21=0,m22=1,m23=0,m31=0,m32=0,m33=1}, a) == a)\n"
+		"assert(mat.mmul(mat.identity(), {m11=1,m12=2,m13=3,m21=4,m22=5,m23=6,m31=7,m32=8,m33=9}).m23 == 6)\n"
+	) == 0);
+
+	// invalid fields and operands are reported as errors
+	CHECK(luaL_dostring(L, "v = vec.set(1,2,3); v.w = 1") != 0);
+	lua_settop(L, 0);
+	CHECK(luaL_dostring(L, "v = vec.set(1,2,3); v.x = 'a'") != 0);
+	lua_settop(L, 0);
+	CHECK(luaL_dostring(L, "v = vec.set(1,2,3) + 'a'") != 0);
+	lua_settop(L, 0);
+}
+
+// Per-frame vector script of a simple autopilot: calls per second, memory
+// allocated by the vector results, and time spent collecting it.
+// Hidden from the default run:
+// Lua.Interpreter [benchmark]
+TEST_CASE("Vector script throughput", "[.][benchmark]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	auto L = interp->GetState();
+
+	// 11 vector/matrix library calls per frame
+	REQUIRE(RunLua(L,
+		"pos = vec.set(6.7e6, 1.2e5, -3.4e4)\n"
+		"vel = vec.set(-120, 7.6e3, 15)\n"
+		"function frame()\n"
+		"  local r = vec.length(pos)\n"
+		"  local h = vec.crossp(pos, vel)\n"
+		"  local n = vec.unit(h)\n"
+		"  local up = vec.mul(pos, 1/r)\n"
+		"  local R = mat.rotm(n, 1e-3)\n"
+		"  local tgt = mat.mul(R, up)\n"
+		"  local err = vec.sub(tgt, up)\n"
+		"  local cmd = vec.add(vec.mul(err, 0.5), vec.mul(n, vec.dotp(err, n)))\n"
+		"  return cmd.x\n"
+		"end\n"
+		"function run(nframe)\n"
+		"  for i = 1, nframe do frame() end\n"
+		"end\n"
+	) == 0);
+
+	const int nframe = 100000, ncall = 11;
+	auto run = [&]() {
+		lua_getglobal(L, "run");
+		lua_pushinteger(L, nframe);
+		REQUIRE(lua_pcall(L, 1, 0, 0) == 0);
+	};
+	typedef std::chrono::steady_clock Clock;
+	auto seconds = [](Clock::time_point t0) {
+		return std::chrono::duration<double>(Clock::now() - t0).count();
+	};
+
+	// collector stopped: call time and allocated memory, then collection time
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	lua_gc(L, LUA_GCSTOP, 0);
+	int kb0 = lua_gc(L, LUA_GCCOUNT, 0);
+	auto t0 = Clock::now();
+	run();
+	double tcall = seconds(t0);
+	int kb = lua_gc(L, LUA_GCCOUNT, 0) - kb0;
+	t0 = Clock::now();
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	double tgc = seconds(t0);
+	lua_gc(L, LUA_GCRESTART, 0);
+
+	// incremental collector running, as in the simulation
+	t0 = Clock::now();
+	run();
+	double ttotal = seconds(t0);
+
+	std::cout << nframe << " frames, " << ncall << " calls/frame: "
+		<< nframe*ncall/tcall*1e-6 << " M calls/s, "
+		<< kb*1024.0/nframe << " bytes/frame allocated, GC "
+		<< tgc/nframe*1e9 << " ns/frame; with incremental GC "
+		<< ttotal/nframe*1e9 << " ns/frame" << std::endl;
+}
+
+TEST_CASE("Coroutine execution mode", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->SetCoroutineMode(true);
+	interp->Initialise();
+	auto L = interp->GetState();
+
+	// a command that skips frames returns after each cycle and is
+	// continued by running an empty chunk
+	string script = "n = 0 for i = 1,3 do n = n+1 proc.skip() end";
+	CHECK(interp->RunChunk(script.data(), script.size()) == 0);
+	for (int i = 1; i <= 3; i++) {
+		lua_getglobal(L, "n");
+		CHECK(lua_tointeger(L, -1) == i);
+		lua_pop(L, 1);
+		REQUIRE(interp->IsBusy());
+		interp->RunChunk("", 0);
+	}
+	CHECK(!interp->IsBusy());
+
+	// background jobs advance with the trunk while it skips frames,
+	// and in the idle loop when it has finished
+	script =
+		"m = 0\n"
+		"proc.bg(function() while true do m = m+1 proc.skip() end end)\n"
+		"proc.skip()";
+	CHECK(interp->RunChunk(script.data(), script.size()) == 0);
+	REQUIRE(interp->IsBusy());
+	CHECK(interp->nJobs() == 0); // counted when the command finishes
+	interp->RunChunk("", 0);
+	CHECK(!interp->IsBusy());
+	CHECK(interp->nJobs() == 1);
+	interp->RunChunk("", 0);
+	lua_getglobal(L, "m");
+	CHECK(lua_tointeger(L, -1) == 3);
+	lua_pop(L, 1);
+
+	// commands run in the same global environment
+	script = "k = n*2";
+	CHECK(interp->RunChunk(script.data(), script.size()) == 0);
+	lua_getglobal(L, "k");
+	CHECK(lua_tointeger(L, -1) == 6);
+	lua_pop(L, 1);
+}
+
+// Per-frame cost of handing control to scripts that wait for the next
+// frame, with one thread per interpreter (mutex handoff, as LuaInline in
+// threaded mode) and with coroutines resumed on the simulation thread.
+// Hidden from the default run:
+// Lua.Interpreter [benchmark]
+TEST_CASE("Script scheduling overhead", "[.][benchmark]")
+{
+	const int nscript = 16, nframe = 2000;
+	const char *cmd = "while true do proc.skip() end";
+	typedef std::chrono::steady_clock Clock;
+	auto seconds = [](Clock::time_point t0) {
+		return std::chrono::duration<double>(Clock::now() - t0).count();
+	};
+
+	// threaded mode: the interpreters are created on this thread, which
+	// owns their execution mutex, as the simulation thread does
+	std::vector<std::unique_ptr<Interpreter>> interp;
+	std::vector<std::thread> thread;
+	for (int i = 0; i < nscript; i++) {
+		interp.push_back(make_unique<Interpreter>());
+		interp[i]->Initialise();
+		thread.push_back(std::thread([cmd](Interpreter *interp) {
+			interp->WaitExec();
+			interp->RunChunk(cmd, strlen(cmd)); // returns when terminated
+			interp->EndExec();
+		}, interp[i].get()));
+	}
+	for (auto &it : interp) { // run the scripts up to their first frame skip
+		it->EndExec();
+		it->WaitExec();
+	}
+	auto t0 = Clock::now();
+	for (int frame = 0; frame < nframe; frame++) {
+		for (auto &it : interp) {
+			it->EndExec();
+			it->WaitExec();
+		}
+	}
+	double tthread = seconds(t0);
+	for (int i = 0; i < nscript; i++) {
+		interp[i]->Terminate();
+		interp[i]->EndExec();
+		thread[i].join();
+	}
+	interp.clear();
+
+	// coroutine mode
+	for (int i = 0; i < nscript; i++) {
+		interp.push_back(make_unique<Interpreter>());
+		interp[i]->SetCoroutineMode(true);
+		interp[i]->Initialise();
+		interp[i]->RunChunk(cmd, strlen(cmd));
+	}
+	t0 = Clock::now();
+	for (int frame = 0; frame < nframe; frame++) {
+		for (auto &it : interp)
+			it->RunChunk("", 0);
+	}
+	double tcoroutine = seconds(t0);
+	interp.clear();
+
+	std::cout << nscript << " scripts, " << nframe << " frames: "
+		<< tthread/nframe*1e6 << " us/frame (threads), "
+		<< tcoroutine/nframe*1e6 << " us/frame (coroutines)" << std::endl;
+}
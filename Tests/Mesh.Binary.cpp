@@ -0,0 +1,220 @@
+#include "MeshBin.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+#include "catch2/catch_all.hpp"
+
+static std::string TestFile (const char *name)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "Mesh.Binary";
+	std::filesystem::create_directories (dir);
+	return (dir / name).string();
+}
+
+static std::vector<std::string> MeshFiles ()
+{
+	std::vector<std::string> file;
+	std::error_code ec;
+	for (auto &entry : std::filesystem::recursive_directory_iterator (MESH_DIR, ec))
+		if (entry.path().extension() == ".msh" && entry.file_size (ec) > 0) // skip placeholders
+			file.push_back (entry.path().string());
+	return file;
+}
+
+// Compare a binary mesh with the parsed text mesh
+static void CheckMesh (const MeshBinReader &mbr, const MeshBinData &mesh)
+{
+	REQUIRE(mbr.nGroup() == mesh.grp.size());
+	REQUIRE(mbr.nMaterial() == mesh.mtrl.size());
+	REQUIRE(mbr.nTexture() == mesh.tex.size());
+	for (UINT32 g = 0; g < mbr.nGroup(); g++) {
+		const MeshBinGroup &gs = mbr.Group (g);
+		const MeshBinData::Group &grp = mesh.grp[g];
+		CHECK(gs.nvtx == grp.vtx.size());
+		CHECK(gs.nidx == grp.idx.size());
+		CHECK(gs.mtrl == grp.spec.mtrl);
+		CHECK(gs.tex == grp.spec.tex);
+		CHECK(gs.usrflag == grp.spec.usrflag);
+		CHECK(gs.zbias == grp.spec.zbias);
+		CHECK(gs.flags == grp.spec.flags);
+		CHECK(gs.opts == grp.spec.opts);
+		CHECK(!memcmp (mbr.Vtx (g), grp.vtx.data(), grp.vtx.size()*sizeof(MeshBinVertex)));
+		CHECK(!memcmp (mbr.Idx (g), grp.idx.data(), grp.idx.size()*sizeof(UINT16)));
+	}
+	for (UINT32 i = 0; i < mbr.nMaterial(); i++)
+		CHECK(!memcmp (&mbr.Material (i), &mesh.mtrl[i], sizeof(MeshBinMaterial)));
+	for (UINT32 i = 0; i < mbr.nTexture(); i++) {
+		CHECK(std::string(mbr.Texture (i).name) == mesh.tex[i].name);
+		CHECK(mbr.Texture (i).flags == mesh.tex[i].flags);
+	}
+}
+
+static const char *testmesh =
+	"MSHX1\n"
+	"GROUPS 3\n"
+	"LABEL Hull\n"
+	"MATERIAL 1\n"
+	"TEXTURE 1\n"
+	"TEXWRAP UV\n"
+	"FLAG 3\n"
+	"GEOM 3 1\n"
+	"0 0 0 0 0 -1 0 0\n"
+	"1 0 0 0 0 -1 1 0\n"
+	"0 1 0 0 0 -1 0 1\n"
+	"0 1 2\n"
+	"ZBIAS 2\n"
+	"NONORMAL\n"
+	"FLIP\n"
+	"GEOM 4 2\n"
+	"0 0 1 0 0\n"
+	"1 0 1 1 0\n"
+	"1 1 1 1 1\n"
+	"0 1 1 0 1\n"
+	"0 1 2\n"
+	"0 2 3\n"
+	"MATERIAL 2\n"
+	"TEXTURE 0\n"
+	"STATIC\n"
+	"GEOM 3 1\n"
+	"0 0 2\n"
+	"1 0 2\n"
+	"0 1 2\n"
+	"0 2 1\n"
+	"MATERIALS 2\n"
+	"hull\n"
+	"glass\n"
+	"MATERIAL hull\n"
+	"1 1 1 1\n"
+	"0.5 0.5 0.5 1\n"
+	"0.2 0.2 0.2 1 20\n"
+	"0 0 0 1\n"
+	"MATERIAL glass\n"
+	"0.1 0.2 0.3 0.4\n"
+	"0.1 0.2 0.3 0.4\n"
+	"0 0 0 1\n"
+	"0 0 0 1\n"
+	"TEXTURES 2\n"
+	"Vessel\\hull.dds\n"
+	"Vessel\\decal.dds D\n";
+
+TEST_CASE("Text mesh conversion", "[MeshBin]")
+{
+	std::string src = TestFile ("Test.msh"), bin = TestFile ("Test.mshb");
+	{
+		std::ofstream ofs (src, std::ios::binary);
+		ofs << testmesh;
+	}
+	MeshBinData mesh;
+	std::ifstream ifs (src);
+	REQUIRE(MeshBinParse (ifs, mesh));
+	REQUIRE(mesh.grp.size() == 3);
+	CHECK(mesh.grp[0].spec.mtrl == 0);
+	CHECK(mesh.grp[0].spec.tex == 0);
+	CHECK(mesh.grp[0].spec.flags == 0x03);
+	CHECK(mesh.grp[0].spec.usrflag == 3);
+	CHECK(mesh.grp[0].spec.opts == 0);
+	CHECK(mesh.grp[1].spec.mtrl == (UINT32)-2); // SPEC_INHERIT
+	CHECK(mesh.grp[1].spec.zbias == 2);
+	CHECK(mesh.grp[1].spec.opts == MESHBIN_CALCNORMALS);
+	CHECK(mesh.grp[1].vtx[2].tu == 1.0f);
+	CHECK(mesh.grp[1].idx == std::vector<UINT16>({0,2,1,0,3,2}));
+	CHECK(mesh.grp[2].spec.tex == (UINT32)-1); // "TEXTURE 0": SPEC_DEFAULT
+	CHECK(mesh.grp[2].spec.flags == 0x04);
+	CHECK(mesh.grp[2].spec.opts == MESHBIN_CALCNORMALS); // normals missing
+	REQUIRE(mesh.mtrl.size() == 2);
+	CHECK(mesh.mtrl[0].power == 20.0f);
+	CHECK(mesh.mtrl[1].diffuse[2] == 0.3f);
+	REQUIRE(mesh.tex.size() == 2);
+	CHECK(std::string(mesh.tex[1].name) == "Vessel\\decal.dds");
+	CHECK(mesh.tex[0].flags == 0);
+	CHECK(mesh.tex[1].flags == MESHBIN_TEX_UNCOMPRESS);
+
+	REQUIRE(MeshBinWrite (bin.c_str(), mesh, src.c_str()));
+	MeshBinReader mbr;
+	REQUIRE(mbr.Open (bin.c_str(), src.c_str()));
+	CheckMesh (mbr, mesh);
+	mbr.Close();
+
+	// binary mesh is outdated when the text mesh changes
+	{
+		std::ofstream ofs (src, std::ios::binary | std::ios::app);
+		ofs << "\n";
+	}
+	CHECK(!mbr.Open (bin.c_str(), src.c_str()));
+	CHECK(mbr.Open (bin.c_str()));
+	mbr.Close();
+
+	// truncated files are rejected
+	std::filesystem::resize_file (bin, std::filesystem::file_size (bin) - 4);
+	CHECK(!mbr.Open (bin.c_str()));
+
+	// not a text mesh
+	std::istringstream iss ("MSHX2\nGROUPS 1\n");
+	CHECK(!MeshBinParse (iss, mesh));
+}
+
+TEST_CASE("Shipped meshes", "[MeshBin]")
+{
+	std::vector<std::string> file = MeshFiles();
+	REQUIRE(!file.empty());
+	std::string bin = TestFile ("Shipped.mshb");
+	for (auto &fname : file) {
+		INFO(fname);
+		MeshBinData mesh;
+		std::ifstream ifs (fname);
+		REQUIRE(MeshBinParse (ifs, mesh));
+		REQUIRE(MeshBinWrite (bin.c_str(), mesh, fname.c_str()));
+		MeshBinReader mbr;
+		REQUIRE(mbr.Open (bin.c_str(), fname.c_str()));
+		CheckMesh (mbr, mesh);
+	}
+}
+
+// Load all shipped meshes from text and from binary files, including
+// copying the data out of the mapped file as the mesh loader does.
+// Hidden from the default run:
+// Mesh.Binary [benchmark]
+TEST_CASE("Mesh load time", "[.][benchmark]")
+{
+	std::vector<std::string> file = MeshFiles();
+	REQUIRE(!file.empty());
+	std::vector<std::string> bin;
+	size_t nvtx = 0;
+	for (size_t i = 0; i < file.size(); i++) {
+		MeshBinData mesh;
+		std::ifstream ifs (file[i]);
+		REQUIRE(MeshBinParse (ifs, mesh));
+		bin.push_back (TestFile ((std::to_string (i) + ".mshb").c_str()));
+		REQUIRE(MeshBinWrite (bin.back().c_str(), mesh, file[i].c_str()));
+		for (auto &grp : mesh.grp) nvtx += grp.vtx.size();
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (auto &fname : file) {
+		MeshBinData mesh;
+		std::ifstream ifs (fname);
+		MeshBinParse (ifs, mesh);
+	}
+	double dt0 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	t0 = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < file.size(); i++) {
+		MeshBinReader mbr;
+		mbr.Open (bin[i].c_str(), file[i].c_str());
+		for (UINT32 g = 0; g < mbr.nGroup(); g++) {
+			const MeshBinGroup &gs = mbr.Group (g);
+			std::vector<MeshBinVertex> vtx (mbr.Vtx (g), mbr.Vtx (g) + gs.nvtx);
+			std::vector<UINT16> idx (mbr.Idx (g), mbr.Idx (g) + gs.nidx);
+		}
+	}
+	double dt1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	std::cout << file.size() << " meshes (" << nvtx << " vertices): "
+		<< 1e3*dt0 << " ms (text), " << 1e3*dt1 << " ms (binary)" << std::endl;
+}
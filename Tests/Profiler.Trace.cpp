@@ -0,0 +1,138 @@
+#include "Profiler.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+static std::string TestFile (const char *name)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "Profiler.Trace";
+	std::filesystem::create_directories (dir);
+	return (dir / name).string();
+}
+
+static const Profiler::ZoneSummary *FindZone (const std::vector<Profiler::ZoneSummary> &zone, const char *name)
+{
+	for (auto it = zone.begin(); it != zone.end(); it++)
+		if (it->name == name) return &*it;
+	return 0;
+}
+
+static size_t CountEvents (const std::string &trace, const char *name)
+{
+	std::string key = std::string("\"name\":\"") + name + "\"";
+	size_t n = 0;
+	for (size_t pos = trace.find (key); pos != std::string::npos; pos = trace.find (key, pos+1))
+		n++;
+	return n;
+}
+
+TEST_CASE("Zone registration", "[Profiler]")
+{
+	int id = g_profiler.RegisterZone ("Test: registration");
+	REQUIRE(id >= 0);
+	REQUIRE(g_profiler.RegisterZone ("Test: registration") == id);
+	REQUIRE(std::string(g_profiler.ZoneName (id)) == "Test: registration");
+	REQUIRE(std::string(g_profiler.ZoneName (-1)).empty());
+}
+
+TEST_CASE("Frame summary", "[Profiler]")
+{
+	std::vector<Profiler::ZoneSummary> zone;
+
+	SECTION("Disabled profiler records nothing") {
+		g_profiler.Enable (false);
+		for (int i = 0; i < 4; i++) {
+			PROFILE_ZONE("Test: disabled");
+			g_profiler.EndFrame();
+		}
+		REQUIRE(g_profiler.Summary (zone) == 0);
+		REQUIRE(zone.empty());
+	}
+
+	SECTION("Zone times and call counts") {
+		g_profiler.Enable (true);
+		const int nframe = 10;
+		for (int i = 0; i < nframe; i++) {
+			for (int j = 0; j < 3; j++) {
+				PROFILE_ZONE("Test: sleep");
+				std::this_thread::sleep_for (std::chrono::milliseconds(1));
+			}
+			g_profiler.EndFrame();
+		}
+		double tframe;
+		REQUIRE(g_profiler.Summary (zone, 0, &tframe) == nframe);
+		const Profiler::ZoneSummary *z = FindZone (zone, "Test: sleep");
+		REQUIRE(z);
+		REQUIRE(z->count == 3.0);
+		REQUIRE(z->t >= 3e-3);
+		REQUIRE(z->tmax >= z->t);
+		REQUIRE(tframe >= z->t);
+		const Profiler::ZoneSummary *f = FindZone (zone, "Frame");
+		REQUIRE(f);
+		REQUIRE(f->count == 1.0);
+
+		// restrict to the last frames
+		REQUIRE(g_profiler.Summary (zone, 4) == 4);
+		g_profiler.Enable (false);
+	}
+
+	SECTION("Zones from several threads") {
+		g_profiler.Enable (true);
+		const int nthread = 4, ncall = 1000;
+		std::vector<std::thread> thread;
+		for (int i = 0; i < nthread; i++)
+			thread.emplace_back ([]() {
+				for (int j = 0; j < ncall; j++) {
+					PROFILE_ZONE("Test: threads");
+				}
+			});
+		for (auto &t : thread) t.join();
+		g_profiler.EndFrame();
+		REQUIRE(g_profiler.Summary (zone) == 1);
+		const Profiler::ZoneSummary *z = FindZone (zone, "Test: threads");
+		REQUIRE(z);
+		REQUIRE(z->count == nthread*ncall);
+		g_profiler.Enable (false);
+	}
+}
+
+TEST_CASE("Trace capture", "[Profiler]")
+{
+	std::string fname = TestFile ("capture.json");
+	std::filesystem::remove (fname);
+
+	REQUIRE(!g_profiler.StartCapture (fname.c_str(), 2)); // profiler disabled
+	g_profiler.Enable (true);
+	REQUIRE(g_profiler.StartCapture (fname.c_str(), 2));
+	REQUIRE(g_profiler.Capturing());
+	REQUIRE(!g_profiler.StartCapture (fname.c_str(), 2)); // already capturing
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 5; j++) {
+			PROFILE_ZONE("Test: capture");
+		}
+		g_profiler.EndFrame();
+	}
+	REQUIRE(!g_profiler.Capturing());
+	g_profiler.Enable (false);
+
+	std::ifstream ifs (fname);
+	REQUIRE(ifs);
+	std::stringstream ss;
+	ss << ifs.rdbuf();
+	std::string trace = ss.str();
+	REQUIRE(trace.find ("{\"traceEvents\":[") == 0);
+	REQUIRE(CountEvents (trace, "Test: capture") == 10); // only the captured frames
+	REQUIRE(CountEvents (trace, "Frame") == 2);
+	REQUIRE(trace.find ("\"ph\":\"X\"") != std::string::npos);
+}
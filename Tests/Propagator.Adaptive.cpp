@@ -0,0 +1,338 @@
+#include "RKCoeff.h"
+#include "RKStepControl.h"
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <math.h>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// Point-mass two-body model for comparing the vessel propagation schemes
+// on reference Kepler orbits. The drivers below follow the stage layout of
+// the RigidBody propagators in BodyIntegrator.cpp (linear state only), and
+// count the acceleration evaluations including the one at the end of each
+// substep that RigidBody::Update performs.
+
+static const double mu = 3.986004418e14; // Earth [m^3/s^2]
+static const double Pi2 = 6.283185307179586476925286766559;
+
+struct V3 {
+	double x, y, z;
+	V3 (): x(0), y(0), z(0) {}
+	V3 (double _x, double _y, double _z): x(_x), y(_y), z(_z) {}
+	V3 operator+ (const V3 &v) const { return V3 (x+v.x, y+v.y, z+v.z); }
+	V3 operator- (const V3 &v) const { return V3 (x-v.x, y-v.y, z-v.z); }
+	V3 operator* (double f) const { return V3 (x*f, y*f, z*f); }
+	V3 &operator+= (const V3 &v) { x += v.x, y += v.y, z += v.z; return *this; }
+	double length () const { return sqrt (x*x + y*y + z*z); }
+};
+
+struct Body {
+	V3 pos, vel, acc; // state and acceleration at pos
+	long neval;       // number of acceleration evaluations
+	double adapt_h;   // proposed step length of the adaptive propagator
+	Body (const V3 &p, const V3 &v): pos(p), vel(v), neval(0), adapt_h(0) { acc = Acc (pos); }
+	V3 Acc (const V3 &p) { neval++; double r = p.length(); return p * (-mu/(r*r*r)); }
+};
+
+struct Orbit {
+	const char *name;
+	double a, e; // semi-major axis [m], eccentricity
+	double Period () const { return Pi2*sqrt (a*a*a/mu); }
+	V3 Pos0 () const { return V3 (a*(1.0-e), 0, 0); } // start at periapsis
+	V3 Vel0 () const { return V3 (0, sqrt (mu/a*(1.0+e)/(1.0-e)), 0); }
+	V3 Pos (double t) const // exact position at time t from Kepler's equation
+	{
+		double M = Pi2*t/Period(), E = M;
+		for (int i = 0; i < 50; i++) {
+			double dE = (E - e*sin(E) - M) / (1.0 - e*cos(E));
+			E -= dE;
+			if (fabs (dE) < 1e-15) break;
+		}
+		return V3 (a*(cos(E)-e), a*sqrt(1.0-e*e)*sin(E), 0);
+	}
+};
+
+static const Orbit LEO = {"circular LEO", 6.771e6, 0.0};
+static const Orbit HEO = {"eccentric e=0.9", 6.6e7, 0.9};
+
+// ---------------------------------------------------------------------------
+// Fixed-step schemes
+
+static void RK4Step (Body &b, double h)
+{
+	V3 p1 = b.pos + b.vel*(0.5*h), v1 = b.vel + b.acc*(0.5*h), a1 = b.Acc (p1);
+	V3 p2 = b.pos + v1*(0.5*h),    v2 = b.vel + a1*(0.5*h),    a2 = b.Acc (p2);
+	V3 p3 = b.pos + v2*h,          v3 = b.vel + a2*h,          a3 = b.Acc (p3);
+	b.pos += (b.vel + (v1+v2)*2.0 + v3) * (h/6.0);
+	b.vel += (b.acc + (a1+a2)*2.0 + a3) * (h/6.0);
+}
+
+static void RKStep (Body &b, double h, int n, const double *beta, const double *gamma)
+{
+	std::vector<V3> p(n), v(n), a(n);
+	p[0] = b.pos, v[0] = b.vel, a[0] = b.acc;
+	for (int i = 1; i < n; i++, beta += n-1) {
+		p[i] = b.pos, v[i] = b.vel;
+		for (int j = 0; j < i; j++) {
+			p[i] += v[j] * (beta[j]*h);
+			v[i] += a[j] * (beta[j]*h);
+		}
+		a[i] = b.Acc (p[i]);
+	}
+	for (int i = 0; i < n; i++) {
+		b.pos += v[i] * (gamma[i]*h);
+		b.vel += a[i] * (gamma[i]*h);
+	}
+}
+
+static void SYStep (Body &b, double h, int n, const double *c, const double *d)
+{
+	for (int i = 0; i < n; i++) {
+		b.pos += b.vel * (c[i]*h);
+		if (i != n-1) b.vel += b.Acc (b.pos) * (d[i]*h);
+	}
+}
+
+static void SY4Step (Body &b, double h)
+{
+	static const double w = 1.25992104989487319066654436028; // 2^1/3
+	static const double x1 = 1.0/(2.0-w), x0 = -w/(2.0-w);
+	static const double d[3] = {x1, x0, x1};
+	static const double c[4] = {x1/2, (x0+x1)/2, (x0+x1)/2, x1/2};
+	SYStep (b, h, 4, c, d);
+}
+
+static void SY8Step (Body &b, double h)
+{
+	// set 3 from Yoshida's Table 2, as in RigidBody::SY8_LinAng
+	static const double W1 =  0.311790812418427e0;
+	static const double W2 = -0.155946803821447e1;
+	static const double W3 = -0.167896928259640e1;
+	static const double W4 =  0.166335809963315e1;
+	static const double W5 = -0.106458714789183e1;
+	static const double W6 =  0.136934946416871e1;
+	static const double W7 =  0.629030650210433e0;
+	static const double W[8] = {1-2*(W1+W2+W3+W4+W5+W6+W7), W1, W2, W3, W4, W5, W6, W7};
+	double c[16], d[15];
+	for (int i = 0; i < 8; i++) {
+		d[i] = d[14-i] = W[7-i];
+		c[i] = c[15-i] = 0.5*(W[7-i] + (i ? W[8-i] : 0.0));
+	}
+	SYStep (b, h, 16, c, d);
+}
+
+enum Scheme { RK4, RK5, RK8, SY4, SY8, RK45, RK78 };
+static const char *SchemeName[] = {"RK4", "RK5", "RK8", "SY4", "SY8", "RK45", "RK78"};
+
+static void FixedStep (Scheme scheme, Body &b, double h)
+{
+	switch (scheme) {
+	case RK4: RK4Step (b, h); break;
+	case RK5: RKStep (b, h, RK5_n, RK5_beta, RK5_gamma); break;
+	case RK8: RKStep (b, h, RK8_n, RK8_beta, RK8_gamma); break;
+	case SY4: SY4Step (b, h); break;
+	case SY8: SY8Step (b, h); break;
+	default: break;
+	}
+	b.acc = b.Acc (b.pos);
+}
+
+// ---------------------------------------------------------------------------
+// Adaptive schemes: embedded step and the step size control of
+// RigidBody::PropagateAdaptive
+
+static double EmbeddedStep (Body &b, double h, double pscale, double vscale, bool force,
+	int n, const double *beta, const double *gamma, const double *egamma, bool fsal)
+{
+	std::vector<V3> p(n), v(n), a(n);
+	p[0] = b.pos, v[0] = b.vel, a[0] = b.acc;
+	for (int i = 1; i < n; i++, beta += n-1) {
+		p[i] = b.pos, v[i] = b.vel;
+		for (int j = 0; j < i; j++) {
+			p[i] += v[j] * (beta[j]*h);
+			v[i] += a[j] * (beta[j]*h);
+		}
+		a[i] = b.Acc (p[i]);
+	}
+	V3 epos, evel;
+	for (int i = 0; i < n; i++) {
+		epos += v[i] * (egamma[i]*h);
+		evel += a[i] * (egamma[i]*h);
+	}
+	double err = std::max (epos.length()/pscale, evel.length()/vscale);
+	if (err > 1.0 && !force) return err;
+	for (int i = 0; i < n; i++) {
+		b.pos += v[i] * (gamma[i]*h);
+		b.vel += a[i] * (gamma[i]*h);
+	}
+	b.acc = (fsal ? a[n-1] : b.Acc (b.pos));
+	return err;
+}
+
+static int AdaptiveInterval (Scheme scheme, Body &b, double T, double tol, int submax)
+{
+	const double pscale = tol * std::max (b.pos.length(), 1.0);
+	const double vscale = tol * std::max (b.vel.length(), 1.0);
+	RKStepControl sc (T, submax, scheme == RK45 ? RK45_order : RK78_order, b.adapt_h);
+	double h, err;
+	int nstep = 0;
+
+	while (!sc.Done()) {
+		h = sc.Step ();
+		if (scheme == RK45)
+			err = EmbeddedStep (b, h, pscale, vscale, sc.Forced(), RK45_n, RK45_beta, RK45_gamma, RK45_egamma, true);
+		else
+			err = EmbeddedStep (b, h, pscale, vscale, sc.Forced(), RK78_n, RK78_beta, RK78_gamma, RK78_egamma, false);
+		if (sc.Accept (err))
+			nstep++;
+	}
+	b.adapt_h = sc.Proposal();
+	return nstep;
+}
+
+// ---------------------------------------------------------------------------
+
+struct RunResult {
+	double err;  // final position error [m]
+	long neval;  // acceleration evaluations
+	long nstep;  // substeps taken
+};
+
+// Propagate over one orbit in simulation frames of length T. Fixed schemes
+// take nsub substeps per frame, adaptive schemes run the step size control
+// for tolerance tol with at most submax steps per frame.
+static RunResult Run (const Orbit &orbit, Scheme scheme, double T, int nsub, double tol = 0.0, int submax = 1000)
+{
+	Body b(orbit.Pos0(), orbit.Vel0());
+	double tend = orbit.Period();
+	int nframe = (int)ceil (tend/T);
+	double dt = tend/nframe;
+	RunResult res = {0.0, 0, 0};
+	for (int i = 0; i < nframe; i++) {
+		if (scheme == RK45 || scheme == RK78) {
+			res.nstep += AdaptiveInterval (scheme, b, dt, tol, submax);
+		} else {
+			for (int j = 0; j < nsub; j++)
+				FixedStep (scheme, b, dt/nsub);
+			res.nstep += nsub;
+		}
+	}
+	res.err = (b.pos - orbit.Pos (nframe*dt)).length();
+	res.neval = b.neval;
+	return res;
+}
+
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Embedded pair coefficients", "[Propagator]")
+{
+	auto check = [](int n, const double *alpha, const double *beta, const double *gamma, const double *egamma) {
+		double gsum = 0.0, esum = 0.0;
+		for (int i = 0; i < n; i++) {
+			gsum += gamma[i];
+			esum += egamma[i];
+		}
+		REQUIRE(gsum == Catch::Approx (1.0).epsilon (1e-14));
+		REQUIRE(fabs (esum) < 1e-14);
+		for (int i = 0; i < n-1; i++) { // row sums of beta are the stage times
+			double bsum = 0.0;
+			for (int j = 0; j < n-1; j++)
+				bsum += beta[i*(n-1)+j];
+			REQUIRE(bsum == Catch::Approx (alpha[i]).epsilon (1e-13));
+		}
+	};
+	check (RK45_n, RK45_alpha, RK45_beta, RK45_gamma, RK45_egamma);
+	check (RK78_n, RK78_alpha, RK78_beta, RK78_gamma, RK78_egamma);
+
+	// Dormand-Prince is FSAL: the last stage is evaluated at the solution
+	for (int j = 0; j < RK45_n-1; j++)
+		REQUIRE(RK45_beta[(RK45_n-2)*(RK45_n-1)+j] == RK45_gamma[j]);
+	REQUIRE(RK45_gamma[RK45_n-1] == 0.0);
+}
+
+TEST_CASE("Adaptive propagation of reference orbits", "[Propagator]")
+{
+	SECTION("Error follows the tolerance") {
+		for (Scheme scheme : {RK45, RK78}) {
+			RunResult loose = Run (HEO, scheme, 600.0, 0, 1e-7);
+			RunResult tight = Run (HEO, scheme, 600.0, 0, 1e-11);
+			INFO(SchemeName[scheme]);
+			REQUIRE(tight.err < loose.err);
+			REQUIRE(tight.neval > loose.neval);
+			REQUIRE(tight.err < 10.0);
+		}
+	}
+
+	SECTION("Substeps follow the orbit") {
+		// circular orbit at moderate frame length: a single step per frame
+		RunResult leo = Run (LEO, RK78, 10.0, 0, 1e-9);
+		int nframe = (int)ceil (LEO.Period()/10.0);
+		REQUIRE(leo.nstep == nframe);
+		REQUIRE(leo.err < 1.0);
+
+		// eccentric orbit: substeps are concentrated near periapsis
+		RunResult heo = Run (HEO, RK78, 600.0, 0, 1e-9);
+		nframe = (int)ceil (HEO.Period()/600.0);
+		REQUIRE(heo.nstep > nframe);
+		REQUIRE(heo.err < 100.0);
+	}
+
+	SECTION("Step limit") {
+		// the step count is limited even if the tolerance can't be met
+		RunResult r = Run (HEO, RK45, 3600.0, 0, 1e-14, 4);
+		int nframe = (int)ceil (HEO.Period()/3600.0);
+		REQUIRE(r.nstep <= nframe*5);
+	}
+
+	SECTION("FSAL reuse") {
+		// RK45 costs 6 evaluations per accepted step without rejections
+		RunResult r = Run (LEO, RK45, 10.0, 0, 1e-7);
+		REQUIRE(r.neval <= 6*r.nstep + 1 + (r.nstep/10));
+	}
+
+	SECTION("Adaptive is cheaper than fixed at equal accuracy") {
+		// fixed RK8 needs 5 substeps per frame for sub-metre accuracy, but
+		// only near periapsis
+		RunResult fixed = Run (HEO, RK8, 600.0, 5);
+		RunResult adapt = Run (HEO, RK78, 600.0, 0, 1e-11);
+		REQUIRE(fixed.err < 1.0);
+		REQUIRE(adapt.err < fixed.err);
+		REQUIRE(adapt.neval < fixed.neval/2);
+	}
+}
+
+// Accuracy (position error after one orbit) vs. cost (acceleration
+// evaluations) of the fixed-step and adaptive schemes. Hidden from the
+// default run:
+// Propagator.Adaptive [benchmark]
+TEST_CASE("Propagator accuracy vs. cost", "[.][benchmark]")
+{
+	std::cout << std::setprecision (3);
+	for (const Orbit *orbit : {&LEO, &HEO}) for (double T : {60.0, 600.0}) {
+		std::cout << orbit->name << ", frame length " << T << " s" << std::endl;
+		std::cout << "  scheme  substeps/tol   steps      evals    error [m]" << std::endl;
+		for (Scheme scheme : {RK4, RK5, RK8, SY4, SY8}) {
+			for (int nsub : {1, 2, 5, 10}) {
+				RunResult r = Run (*orbit, scheme, T, nsub);
+				std::cout << "  " << std::setw(6) << std::left << SchemeName[scheme] << std::right
+					<< std::setw(14) << nsub << std::setw(8) << r.nstep << std::setw(11) << r.neval
+					<< std::setw(13) << r.err << std::endl;
+			}
+		}
+		for (Scheme scheme : {RK45, RK78}) {
+			for (double tol : {1e-7, 1e-9, 1e-11, 1e-13}) {
+				RunResult r = Run (*orbit, scheme, T, 0, tol);
+				std::cout << "  " << std::setw(6) << std::left << SchemeName[scheme] << std::right
+					<< std::setw(14) << tol << std::setw(8) << r.nstep << std::setw(11) << r.neval
+					<< std::setw(13) << r.err << std::endl;
+			}
+		}
+	}
+}
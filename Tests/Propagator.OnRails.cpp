@@ -0,0 +1,191 @@
+#include "OrbitRail.h"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <math.h>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// Earth parameters for comparing the on-rails propagation with a direct
+// integration of the point mass + J2 gravity field
+
+static const double mu = 3.986004418e14; // [m^3/s^2]
+static const double R  = 6.378137e6;     // [m]
+static const double J2 = 1.08263e-3;
+static const double RAD = Pi/180.0;
+static const double eps = 23.44*RAD;
+static const Vector pole (0, cos (eps), sin (eps)); // tilted rotation axis
+
+struct Sat {
+	Vector pos, vel;
+};
+
+static Vector Acc (const Vector &p, double j2)
+{
+	double r2 = p.length2(), r = sqrt (r2);
+	Vector a (p * (-mu/(r2*r)));
+	if (j2) {
+		double s = dotp (p, pole)/r;
+		double f = -1.5*j2*mu*R*R/(r2*r2);
+		a += (p*((1.0 - 5.0*s*s)/r) + pole*(2.0*s)) * f;
+	}
+	return a;
+}
+
+static void RK4Step (Sat &b, double h, double j2)
+{
+	Vector a0 = Acc (b.pos, j2);
+	Vector p1 = b.pos + b.vel*(0.5*h), v1 = b.vel + a0*(0.5*h), a1 = Acc (p1, j2);
+	Vector p2 = b.pos + v1*(0.5*h),    v2 = b.vel + a1*(0.5*h), a2 = Acc (p2, j2);
+	Vector p3 = b.pos + v2*h,          v3 = b.vel + a2*h,       a3 = Acc (p3, j2);
+	b.pos += (b.vel + (v1+v2)*2.0 + v3) * (h/6.0);
+	b.vel += (a0 + (a1+a2)*2.0 + a3) * (h/6.0);
+}
+
+static void Integrate (Sat &b, double T, double h, double j2)
+{
+	int n = (int)ceil (T/h);
+	for (int i = 0; i < n; i++)
+		RK4Step (b, T/n, j2);
+}
+
+// orbit with semi-major axis a, eccentricity e and inclination i against
+// the equator of the tilted pole, starting at periapsis
+static Sat MakeOrbit (double a, double e, double i, double node = 0.0)
+{
+	Vector ex (1,0,0);
+	Vector ez (crossp (pole, ex));                  // second equatorial axis
+	Vector n (ex*cos (node) + ez*sin (node));      // ascending node
+	Vector m (crossp (n, pole)*cos (i) + pole*sin (i)); // 90 deg ahead of the node in the orbit plane
+	double rp = a*(1.0-e), vp = sqrt (mu/a*(1.0+e)/(1.0-e));
+	Sat s;
+	s.pos = n*rp;
+	s.vel = m*vp;
+	return s;
+}
+
+TEST_CASE("On-rails Kepler orbits", "[Propagator]")
+{
+	struct { double a, e, i; } orbit[3] = {
+		{6.771e6, 0.0, 51.6*RAD}, {2.0e7, 0.3, 10.0*RAD}, {6.6e7, 0.9, 120.0*RAD}
+	};
+	for (int k = 0; k < 3; k++) {
+		Sat s = MakeOrbit (orbit[k].a, orbit[k].e, orbit[k].i);
+		OrbitRail rail;
+		REQUIRE(rail.Set (s.pos, s.vel, mu, 100.0));
+		REQUIRE(fabs (rail.PeDist() - orbit[k].a*(1.0-orbit[k].e)) < 1e-6*orbit[k].a);
+		REQUIRE(fabs (OrbitRail::PeDist (s.pos, s.vel, mu) - rail.PeDist()) < 1e-6*orbit[k].a);
+
+		// continuous with the state at the epoch
+		Vector r, v;
+		rail.PosVel (100.0, r, v);
+		REQUIRE(r.dist (s.pos) < 1e-8*orbit[k].a);
+		REQUIRE(v.dist (s.vel) < 1e-8*s.vel.length());
+
+		// agrees with the integrated orbit after several revolutions
+		double T = Pi2*sqrt (pow (orbit[k].a, 3)/mu);
+		Integrate (s, 2.3*T, T*(orbit[k].e > 0.5 ? 2e-6 : 2e-4), 0.0);
+		rail.PosVel (100.0 + 2.3*T, r, v);
+		REQUIRE(r.dist (s.pos) < 1e-6*orbit[k].a);
+		REQUIRE(v.dist (s.vel) < 1e-5*s.vel.length());
+	}
+
+	// open orbits are rejected
+	Sat s = MakeOrbit (6.771e6, 0.0, 0.0);
+	OrbitRail rail;
+	REQUIRE(!rail.Set (s.pos, s.vel*1.5, mu, 0.0));
+	REQUIRE(!rail.Valid());
+	REQUIRE(OrbitRail::PeDist (s.pos, s.vel*1.5, mu) < 0.0);
+}
+
+TEST_CASE("On-rails J2 drift", "[Propagator]")
+{
+	// ISS-like orbit over one day
+	const double T = 86400.0;
+	Sat s0 = MakeOrbit (6.78e6, 0.001, 51.6*RAD, 1.0), s = s0;
+	Integrate (s, T, 2.0, J2);
+
+	OrbitRail kepler, secular;
+	REQUIRE(kepler.Set (s0.pos, s0.vel, mu, 0.0));
+	REQUIRE(secular.Set (s0.pos, s0.vel, mu, 0.0, pole, J2*R*R));
+	Vector r1, v1, r2, v2;
+	kepler.PosVel (T, r1, v1);
+	secular.PosVel (T, r2, v2);
+	double err_kepler = r1.dist (s.pos), err_secular = r2.dist (s.pos);
+	REQUIRE(err_secular < 0.05*err_kepler);
+	REQUIRE(err_secular < 2e4);
+
+	// the node of a prograde orbit regresses
+	Vector h0 (crossp (s0.vel, s0.pos).unit()), h1 (crossp (v2, r2).unit());
+	REQUIRE(fabs (dotp (h1, pole) - dotp (h0, pole)) < 1e-6);  // inclination preserved
+	Vector n0 (crossp (pole, h0).unit()), n1 (crossp (pole, h1).unit()); // node directions
+	REQUIRE(dotp (crossp (n0, n1), pole) > 0.0);
+	double dnode = acos (dotp (n0, n1));
+	REQUIRE(dnode > 4.5*RAD);                                  // approx. 5 deg/day
+	REQUIRE(dnode < 5.5*RAD);
+}
+
+// Propagator.OnRails [benchmark]
+TEST_CASE("On-rails vs. integrated propagation", "[.][benchmark]")
+{
+	// satellites on random orbits between LEO and GEO, propagated over one
+	// day with frame length dt, by RK4 integration with a 2 s substep
+	// target (point mass + J2), or on rails with secular J2 drift
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> alt(3e5, 3.6e7), ecc(0.0, 0.2), inc(0.0, Pi), lan(0.0, Pi2);
+	const int nsat = 1000, nerr = 20;
+	std::vector<Sat> sat(nsat);
+	for (int k = 0; k < nsat; k++) {
+		double a = R + alt(rng), e = ecc(rng);
+		if (a*(1.0-e) < R + 3e5) e = 1.0 - (R + 3e5)/a;
+		sat[k] = MakeOrbit (a, e, inc(rng), lan(rng));
+	}
+
+	// reference: fine-step integration of a subset over one day
+	const double Tday = 86400.0;
+	std::vector<Sat> ref (sat.begin(), sat.begin() + nerr);
+	for (int k = 0; k < nerr; k++)
+		Integrate (ref[k], Tday, 0.5, J2);
+
+	for (double dt : { 1.0, 20.0 }) {
+		const int nframe = (int)(Tday/dt);
+		const int nsub = (int)ceil (dt/2.0);
+
+		// integrated
+		std::vector<Sat> s (sat);
+		auto t0 = std::chrono::steady_clock::now();
+		for (int f = 0; f < nframe; f++)
+			for (int k = 0; k < nsat; k++)
+				for (int i = 0; i < nsub; i++)
+					RK4Step (s[k], dt/nsub, J2);
+		double dt_int = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		double err_int = 0.0;
+		for (int k = 0; k < nerr; k++)
+			err_int = std::max (err_int, s[k].pos.dist (ref[k].pos));
+
+		// on rails
+		std::vector<OrbitRail> rail (nsat);
+		for (int k = 0; k < nsat; k++)
+			rail[k].Set (sat[k].pos, sat[k].vel, mu, 0.0, pole, J2*R*R);
+		Vector r, v;
+		t0 = std::chrono::steady_clock::now();
+		for (int f = 0; f < nframe; f++)
+			for (int k = 0; k < nsat; k++) {
+				rail[k].PosVel ((f+1)*dt, r, v);
+				s[k].pos = r, s[k].vel = v;
+			}
+		double dt_rail = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		double err_rail = 0.0;
+		for (int k = 0; k < nerr; k++)
+			err_rail = std::max (err_rail, s[k].pos.dist (ref[k].pos));
+
+		std::cout << nsat << " satellites, frame " << dt << " s: integrated " << dt_int/nframe*1e3 << " ms/frame, max. error "
+			<< err_int << " m; on rails " << dt_rail/nframe*1e3 << " ms/frame, max. error " << err_rail << " m (after 1 day)" << std::endl;
+	}
+}
@@ -0,0 +1,323 @@
+#include "GravityKernel.h"
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// Gravity sources of the Sol system (Sol.cfg), with gravitational parameters
+// [m^3/s^2] and mean orbit radii [m] relative to the parent (-1: sun)
+struct SolBody {
+	const char *name;
+	double gm;
+	int parent;
+	double rad;
+};
+
+static const SolBody sol[] = {
+	{"Sun",       1.32712440018e20, -1, 0.0      },
+	{"Mercury",   2.2032e13,         0, 5.791e10 },
+	{"Venus",     3.24859e14,        0, 1.0821e11},
+	{"Earth",     3.986004418e14,    0, 1.496e11 },
+	{"Moon",      4.9048695e12,      3, 3.844e8  },
+	{"Mars",      4.282837e13,       0, 2.2794e11},
+	{"Phobos",    7.087e5,           5, 9.376e6  },
+	{"Deimos",    9.62e4,            5, 2.3463e7 },
+	{"Vesta",     1.728e10,          0, 3.5337e11},
+	{"Jupiter",   1.26686534e17,     0, 7.7857e11},
+	{"Io",        5.959916e12,       9, 4.217e8  },
+	{"Europa",    3.202739e12,       9, 6.709e8  },
+	{"Ganymede",  9.887834e12,       9, 1.0704e9 },
+	{"Callisto",  7.179289e12,       9, 1.8827e9 },
+	{"Saturn",    3.7931187e16,      0, 1.43353e12},
+	{"Mimas",     2.503e9,          14, 1.855e8  },
+	{"Enceladus", 7.211e9,          14, 2.38e8   },
+	{"Tethys",    4.121e10,         14, 2.947e8  },
+	{"Dione",     7.312e10,         14, 3.774e8  },
+	{"Rhea",      1.539e11,         14, 5.27e8   },
+	{"Titan",     8.978e12,         14, 1.2219e9 },
+	{"Hyperion",  3.7e8,            14, 1.4811e9 },
+	{"Iapetus",   1.205e11,         14, 3.5613e9 },
+	{"Uranus",    5.793939e15,       0, 2.87246e12},
+	{"Miranda",   4.4e9,            23, 1.299e8  },
+	{"Ariel",     8.35e10,          23, 1.909e8  },
+	{"Umbriel",   8.51e10,          23, 2.66e8   },
+	{"Titania",   2.269e11,         23, 4.363e8  },
+	{"Oberon",    2.053e11,         23, 5.835e8  },
+	{"Neptune",   6.836529e15,       0, 4.49506e12},
+	{"Triton",    1.428e12,         29, 3.548e8  },
+	{"Proteus",   3.4e9,            29, 1.176e8  },
+	{"Nereid",    2.06e9,           29, 5.5134e9 }
+};
+static const int nsol = sizeof(sol)/sizeof(SolBody);
+
+// Place the bodies on circular orbits in the ecliptic (x-z) plane and set up
+// the snapshot with a step of dt seconds. Earth, Jupiter and Saturn are
+// flagged as nonspherical.
+static void SetupSol (GravitySources &src, double dt)
+{
+	std::vector<double> pos(3*nsol), vel(3*nsol);
+	src.Resize (nsol);
+	for (int i = 0; i < nsol; i++) {
+		double ph = 0.7*i, p[3] = {0,0,0}, v[3] = {0,0,0};
+		if (sol[i].parent >= 0) {
+			int k = sol[i].parent;
+			double vc = sqrt (sol[k].gm/sol[i].rad);
+			p[0] = pos[3*k]   + sol[i].rad*cos(ph);
+			p[2] = pos[3*k+2] + sol[i].rad*sin(ph);
+			v[0] = vel[3*k]   - vc*sin(ph);
+			v[2] = vel[3*k+2] + vc*cos(ph);
+		}
+		for (int j = 0; j < 3; j++) {
+			pos[3*i+j] = p[j];
+			vel[3*i+j] = v[j];
+		}
+		bool nonsph = (i == 3 || i == 9 || i == 14);
+		src.SetSource (i, sol[i].gm, p, nonsph);
+
+		// linear motion plus a small cubic deviation over the step
+		double p1[3], c[9];
+		for (int j = 0; j < 3; j++) {
+			c[j]   = v[j]*dt;
+			c[3+j] = 1e-3*v[j]*dt;
+			c[6+j] = -1e-3*v[j]*dt;
+			p1[j]  = p[j] + c[j] + c[3+j] + c[6+j];
+		}
+		src.SetTrajectory (i, p1, c);
+	}
+}
+
+// Query points in low Earth orbit and cislunar space
+static void QueryPoints (const GravitySources &src, int nq, std::vector<double> &qx, std::vector<double> &qy, std::vector<double> &qz)
+{
+	double pe[3];
+	src.Position (3, 0.0, pe);
+	qx.resize (nq); qy.resize (nq); qz.resize (nq);
+	for (int k = 0; k < nq; k++) {
+		double r = 6.6e6 + 4e8*(double)k/(nq+1);
+		double lng = 2.39996*k, lat = 0.3*sin(1.7*k);
+		qx[k] = pe[0] + r*cos(lat)*cos(lng);
+		qy[k] = pe[1] + r*sin(lat);
+		qz[k] = pe[2] + r*cos(lat)*sin(lng);
+	}
+}
+
+// Straightforward per-source summation as in PlanetarySystem::Gacc
+static void ReferenceAcc (const GravitySources &src, double n, const double *q, int exclude, double *acc)
+{
+	acc[0] = acc[1] = acc[2] = 0.0;
+	for (int i = 0; i < src.Size(); i++) {
+		if (i == exclude) continue;
+		double p[3];
+		src.Position (i, n, p);
+		double dx = p[0]-q[0], dy = p[1]-q[1], dz = p[2]-q[2];
+		double d = sqrt (dx*dx + dy*dy + dz*dz);
+		double f = sol[i].gm/(d*d*d);
+		acc[0] += dx*f, acc[1] += dy*f, acc[2] += dz*f;
+	}
+}
+
+static double RelErr (const double *a, const double *b)
+{
+	double dx = a[0]-b[0], dy = a[1]-b[1], dz = a[2]-b[2];
+	return sqrt ((dx*dx + dy*dy + dz*dz)/(b[0]*b[0] + b[1]*b[1] + b[2]*b[2]));
+}
+
+TEST_CASE("Gravity summation kernels", "[GravityKernel]")
+{
+	INFO("vectorised: " << GravitySumVectorised());
+
+	SECTION("Vectorised sum matches scalar sum") {
+		std::vector<double> gm, x, y, z;
+		for (int n = 0; n <= 37; n++) {
+			double q[3] = {1e3, -2e3, 5e2}, a[3], a_s[3];
+			GravitySum (gm.data(), x.data(), y.data(), z.data(), n, q, a);
+			GravitySum_Scalar (gm.data(), x.data(), y.data(), z.data(), n, q, a_s);
+			if (n) REQUIRE(RelErr (a, a_s) < 1e-14);
+			else   REQUIRE((a[0] == 0.0 && a[1] == 0.0 && a[2] == 0.0));
+			gm.push_back (1e10*(n+1));
+			x.push_back (1e6*cos(1.3*n));
+			y.push_back (1e6*sin(0.4*n));
+			z.push_back (1e6*sin(1.3*n));
+		}
+	}
+
+	SECTION("Sources at the query point are skipped") {
+		double gm[5] = {1e12, 2e12, 3e12, 4e12, 5e12};
+		double x[5] = {0, 1e6, 0, 0, 1e3}, y[5] = {0, 0, 1e6, 0, 0}, z[5] = {0, 0, 0, 1e6, 0};
+		double q[3] = {1e3, 0, 0}, a[3], a_s[3];
+		GravitySum (gm, x, y, z, 5, q, a);
+		GravitySum_Scalar (gm, x, y, z, 5, q, a_s);
+		REQUIRE(std::isfinite (a[0]));
+		REQUIRE(std::isfinite (a[1]));
+		REQUIRE(std::isfinite (a[2]));
+		REQUIRE(RelErr (a, a_s) < 1e-14);
+	}
+
+	SECTION("Batch sum matches single-point sum") {
+		GravitySources src;
+		SetupSol (src, 60.0);
+		std::vector<double> qx, qy, qz, ax(13), ay(13), az(13);
+		QueryPoints (src, 13, qx, qy, qz);
+		std::vector<double> gm(nsol), x(nsol), y(nsol), z(nsol);
+		for (int i = 0; i < nsol; i++) {
+			double p[3];
+			src.Position (i, 0.0, p);
+			gm[i] = sol[i].gm, x[i] = p[0], y[i] = p[1], z[i] = p[2];
+		}
+		GravitySumN (gm.data(), x.data(), y.data(), z.data(), nsol, qx.data(), qy.data(), qz.data(), 13, ax.data(), ay.data(), az.data());
+		for (int k = 0; k < 13; k++) {
+			double q[3] = {qx[k], qy[k], qz[k]}, a[3], a_n[3] = {ax[k], ay[k], az[k]};
+			GravitySum_Scalar (gm.data(), x.data(), y.data(), z.data(), nsol, q, a);
+			REQUIRE(RelErr (a_n, a) < 1e-14);
+		}
+	}
+}
+
+TEST_CASE("Gravity source snapshot", "[GravityKernel]")
+{
+	GravitySources src;
+	SetupSol (src, 60.0);
+	REQUIRE(src.Size() == nsol);
+	REQUIRE(src.Interpolated());
+	REQUIRE(src.NonsphericalList().size() == 3);
+	REQUIRE(src.Nonspherical (3));
+	REQUIRE(!src.Nonspherical (4));
+
+	std::vector<double> qx, qy, qz;
+	QueryPoints (src, 50, qx, qy, qz);
+
+	SECTION("Start and end of step") {
+		double p0[3], p1[3], p[3];
+		src.Position (4, 0.0, p0);
+		src.Position (4, 1.0, p1);
+		src.Position (4, 1.0-1e-12, p);
+		REQUIRE(fabs (p[0]-p1[0]) < 1e-2);
+		REQUIRE(fabs (p[2]-p1[2]) < 1e-2);
+		src.Position (4, 1e-12, p);
+		REQUIRE(fabs (p[0]-p0[0]) < 1e-2);
+		REQUIRE(fabs (p[2]-p0[2]) < 1e-2);
+	}
+
+	SECTION("All sources") {
+		const double nn[3] = {0.0, 0.37, 1.0};
+		for (int j = 0; j < 3; j++)
+			for (int k = 0; k < 50; k++) {
+				double q[3] = {qx[k], qy[k], qz[k]}, a[3], a_ref[3];
+				src.Acc (nn[j], q, -1, a);
+				ReferenceAcc (src, nn[j], q, -1, a_ref);
+				REQUIRE(RelErr (a, a_ref) < 1e-12);
+			}
+	}
+
+	SECTION("Excluded source") {
+		for (int k = 0; k < 50; k++) {
+			double q[3] = {qx[k], qy[k], qz[k]}, a[3], a_ref[3];
+			src.Acc (0.0, q, 3, a);
+			ReferenceAcc (src, 0.0, q, 3, a_ref);
+			REQUIRE(RelErr (a, a_ref) < 1e-12);
+		}
+	}
+
+	SECTION("Source index list") {
+		const unsigned long idx[4] = {0, 3, 4, 9};
+		for (int k = 0; k < 50; k++) {
+			double q[3] = {qx[k], qy[k], qz[k]}, a[3], a_ref[3] = {0,0,0};
+			src.Acc (0.5, q, idx, 4, 9, a);
+			for (int j = 0; j < 3; j++) {
+				double ai[3];
+				GravitySources one;
+				double p[3];
+				src.Position ((int)idx[j], 0.5, p);
+				one.Resize (1);
+				one.SetSource (0, sol[idx[j]].gm, p, false);
+				one.Acc (0.0, q, -1, ai);
+				a_ref[0] += ai[0], a_ref[1] += ai[1], a_ref[2] += ai[2];
+			}
+			REQUIRE(RelErr (a, a_ref) < 1e-12);
+		}
+	}
+
+	SECTION("Batch queries") {
+		std::vector<double> ax(50), ay(50), az(50);
+		for (int ex = -1; ex < 1; ex++) {
+			src.AccN (0.37, qx.data(), qy.data(), qz.data(), 50, ex, ax.data(), ay.data(), az.data());
+			for (int k = 0; k < 50; k++) {
+				double q[3] = {qx[k], qy[k], qz[k]}, a[3], a_n[3] = {ax[k], ay[k], az[k]};
+				src.Acc (0.37, q, ex, a);
+				REQUIRE(RelErr (a_n, a) < 1e-14);
+			}
+		}
+	}
+
+	SECTION("Positions without trajectory") {
+		double p[3] = {1, 2, 3};
+		src.SetSource (5, sol[5].gm, p, false);
+		REQUIRE(!src.Interpolated());
+		double p1[3];
+		src.Position (5, 1.0, p1);
+		REQUIRE((p1[0] == 1.0 && p1[1] == 2.0 && p1[2] == 3.0));
+	}
+}
+
+// Psys.GravityKernel [benchmark]
+TEST_CASE("Gravity summation over the Sol system", "[.][benchmark]")
+{
+	GravitySources src;
+	SetupSol (src, 60.0);
+	std::cout << "Sol: " << nsol << " sources, vectorised: " << GravitySumVectorised() << std::endl;
+
+	// source arrays at the start of the step, for the raw kernels
+	std::vector<double> gm(nsol), x(nsol), y(nsol), z(nsol);
+	for (int i = 0; i < nsol; i++) {
+		double p[3];
+		src.Position (i, 0.0, p);
+		gm[i] = sol[i].gm, x[i] = p[0], y[i] = p[1], z[i] = p[2];
+	}
+
+	static const char *label[5] = {
+		"per-source loop", "scalar kernel  ", "vector kernel  ", "snapshot Acc   ", "snapshot AccN  "
+	};
+	const int nqs[3] = {1, 100, 10000};
+	for (int m = 0; m < 3; m++) {
+		int nq = nqs[m];
+		int nrep = std::max (1, 2000000/nq);
+		std::vector<double> qx, qy, qz, ax(nq), ay(nq), az(nq);
+		QueryPoints (src, nq, qx, qy, qz);
+
+		for (int mode = 0; mode < 5; mode++) {
+			for (int ip = 0; ip < 2; ip++) {
+				if ((mode == 1 || mode == 2) && ip) continue; // raw kernels: stored positions only
+				double n = (ip ? 0.37 : 0.0), chk = 0.0;
+				auto t0 = std::chrono::steady_clock::now();
+				for (int r = 0; r < nrep; r++) {
+					if (mode == 4) {
+						src.AccN (n, qx.data(), qy.data(), qz.data(), nq, -1, ax.data(), ay.data(), az.data());
+						chk += ax[0];
+						continue;
+					}
+					for (int k = 0; k < nq; k++) {
+						double q[3] = {qx[k], qy[k], qz[k]}, a[3];
+						switch (mode) {
+						case 0: ReferenceAcc (src, n, q, -1, a); break;
+						case 1: GravitySum_Scalar (gm.data(), x.data(), y.data(), z.data(), nsol, q, a); break;
+						case 2: GravitySum (gm.data(), x.data(), y.data(), z.data(), nsol, q, a); break;
+						case 3: src.Acc (n, q, -1, a); break;
+						}
+						chk += a[0];
+					}
+				}
+				double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+				std::cout << nq << " points, " << label[mode] << (ip ? " (interpolated): " : " (stored):       ")
+				          << dt/((double)nrep*nq)*1e9 << " ns/point (" << chk << ")" << std::endl;
+			}
+		}
+	}
+}
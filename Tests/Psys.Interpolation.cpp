@@ -0,0 +1,154 @@
+#include "PosInterpolant.h"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <math.h>
+
+#include "catch2/catch_all.hpp"
+
+// Interpolation of gravity source positions within a time step (see
+// CelestialBody::InterpolatePosition). Sources move on circular orbits
+// around the origin; the states at both ends of the step are exact.
+
+static const double mu = 3.986004418e14; // source reference body [m^3/s^2]
+
+struct Source {
+	double a, T;               // orbit radius, period
+	Vector p0, v0, p1, v1;     // states at start and end of the step
+	PosInterpolant ipol;
+
+	Vector Pos (double t) const { double w = Pi2/T; return Vector (a*cos (w*t), 0.0, a*sin (w*t)); }
+	Vector Vel (double t) const { double w = Pi2/T; return Vector (-a*w*sin (w*t), 0.0, a*w*cos (w*t)); }
+
+	void BeginStep (double t0, double h)
+	// states of the new step, as in Body::BeginStateUpdate + Update
+	{
+		p0 = Pos (t0), v0 = Vel (t0);
+		p1 = Pos (t0+h), v1 = Vel (t0+h);
+		ipol.Invalidate ();
+	}
+	void Setup (double h) { ipol.Setup (p0, v0, p1, v1, h); }
+	Vector Interpolate (double n) const
+	{
+		if (n == 0.0) return p0;
+		if (n == 1.0) return p1;
+		return ipol.Cubic() ? ipol.Eval (n) : PosInterpolant::Bisect (p0, p1, n);
+	}
+};
+
+static Vector Gacc (const Vector &p, const Vector &src, double m)
+{
+	Vector d (src-p);
+	double d2 = d.length2();
+	return d*(m/(d2*sqrt (d2)));
+}
+
+TEST_CASE("Source positions before and after interpolant setup", "[PosInterpolant]")
+{
+	const double h = 600.0;
+	Source src;
+	src.a = 3.844e8, src.T = 27.321661*86400.0;
+	double t = 0.0;
+
+	// previous step: interpolant set up
+	src.BeginStep (t, h);
+	src.Setup (h);
+	REQUIRE(src.ipol.Cubic());
+	t += h;
+
+	SECTION("Dynamic body updated before the setup") {
+		// a dynamic celestial body integrates its own state in the new step,
+		// evaluating the source at intermediate stages before its interpolant
+		// has been set up
+		src.BeginStep (t, h);
+		REQUIRE(!src.ipol.Cubic());
+		Vector body = Vector (1.5e8, 2e7, -3e7);
+		for (double n : { 0.25, 0.5, 0.75 }) {
+			Vector g  = Gacc (body, src.Interpolate (n), 4.9e12);
+			Vector gb = Gacc (body, PosInterpolant::Bisect (src.p0, src.p1, n), 4.9e12);
+			REQUIRE(g.x == gb.x);
+			REQUIRE(g.y == gb.y);
+			REQUIRE(g.z == gb.z);
+		}
+	}
+
+	SECTION("Cubic after the setup") {
+		src.BeginStep (t, h);
+		src.Setup (h);
+		REQUIRE(src.ipol.Cubic());
+		for (int i = 1; i < 10; i++) {
+			double n = i*0.1;
+			Vector exact = src.Pos (t + n*h);
+			double ec = (src.Interpolate (n) - exact).length();
+			double eb = (PosInterpolant::Bisect (src.p0, src.p1, n) - exact).length();
+			REQUIRE(ec < 1e-6*src.a);
+			REQUIRE(ec <= eb + 1e-3);
+		}
+	}
+
+	SECTION("Large arcs fall back to bisection") {
+		src.BeginStep (t, src.T*0.05);
+		src.Setup (src.T*0.05);
+		REQUIRE(!src.ipol.Cubic());
+		Vector p = src.Interpolate (0.3);
+		Vector pb = PosInterpolant::Bisect (src.p0, src.p1, 0.3);
+		REQUIRE((p-pb).length() == 0.0);
+	}
+}
+
+// Psys.Interpolation [benchmark]
+TEST_CASE("Frame time vs. vessel count, cubic vs. bisection", "[.][benchmark]")
+{
+	// vessels in low orbit, RK4 steps at 50 fps, with the Moon and Sun as
+	// perturbing sources interpolated at every stage
+	const double h = 0.02, R = 6.378e6;
+	const int nframe = 500;
+	Source src[2];
+	src[0].a = 3.844e8, src[0].T = 27.321661*86400.0;
+	src[1].a = 1.496e11, src[1].T = 365.25636*86400.0;
+	const double msrc[2] = { 4.9048695e12, 1.32712440018e20 };
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<double> alt(3e5, 2e6), phi(0.0, Pi2);
+
+	for (int nves : { 10, 100, 1000, 10000 }) {
+		std::vector<Vector> pos0(nves), vel0(nves);
+		for (int k = 0; k < nves; k++) {
+			double r = R + alt(rng), p = phi(rng), v = sqrt (mu/r);
+			pos0[k] = Vector (r*cos (p), 0.0, r*sin (p));
+			vel0[k] = Vector (-v*sin (p), 0.0, v*cos (p));
+		}
+		double tframe[2];
+		for (int cubic = 0; cubic < 2; cubic++) {
+			std::vector<Vector> pos (pos0), vel (vel0);
+			auto Acc = [&](const Vector &p, double n) {
+				double r2 = p.length2();
+				Vector a (p * (-mu/(r2*sqrt (r2))));
+				for (int j = 0; j < 2; j++)
+					a += Gacc (p, src[j].Interpolate (n), msrc[j]);
+				return a;
+			};
+			auto t0 = std::chrono::steady_clock::now();
+			for (int f = 0; f < nframe; f++) {
+				for (int j = 0; j < 2; j++) {
+					src[j].BeginStep (f*h, h);
+					if (cubic) src[j].Setup (h);
+				}
+				for (int k = 0; k < nves; k++) {
+					Vector &p = pos[k], &v = vel[k];
+					Vector a0 = Acc (p, 0.0);
+					Vector p1 = p + v*(0.5*h), v1 = v + a0*(0.5*h), a1 = Acc (p1, 0.5);
+					Vector p2 = p + v1*(0.5*h), v2 = v + a1*(0.5*h), a2 = Acc (p2, 0.5);
+					Vector p3 = p + v2*h, v3 = v + a2*h, a3 = Acc (p3, 1.0);
+					p += (v + v1*2.0 + v2*2.0 + v3)*(h/6.0);
+					v += (a0 + a1*2.0 + a2*2.0 + a3)*(h/6.0);
+				}
+			}
+			tframe[cubic] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count()*1e3/nframe;
+		}
+		std::cout << nves << " vessels: bisection " << tframe[0] << " ms/frame, cubic "
+			<< tframe[1] << " ms/frame" << std::endl;
+	}
+}
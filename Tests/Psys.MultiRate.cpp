@@ -0,0 +1,187 @@
+#include "OrbitRail.h"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <math.h>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// Multi-rate vessel updates: full dynamic updates at a per-vessel interval,
+// with the vessel coasting on a two-body orbit plus the perturbing
+// acceleration extrapolated from the last full updates in between (see
+// OrbitCoast). The force model (Earth point mass + J2, lunar and solar
+// third-body terms) stands in for the gravity field evaluation of a full
+// vessel update.
+
+static const double mu   = 3.986004418e14; // Earth [m^3/s^2]
+static const double R    = 6.378137e6;     // [m]
+static const double J2   = 1.08263e-3;
+static const double muM  = 4.9048695e12;   // Moon
+static const double aM   = 3.844e8;
+static const double TM   = 27.321661*86400.0;
+static const double muS  = 1.32712440018e20; // Sun
+static const double aS   = 1.495978707e11;
+static const double TS   = 365.25636*86400.0;
+static const Vector pole (0, 0.917, 0.398);
+
+struct Sat {
+	Vector pos, vel;
+};
+
+static Vector ThirdBody (const Vector &p, double m, double a, double T, double t)
+{
+	double phi = Pi2*t/T;
+	Vector s (a*cos (phi), 0.0, a*sin (phi));
+	Vector d (s-p);
+	double d3 = pow (d.length2(), 1.5), s3 = a*a*a;
+	return d*(m/d3) - s*(m/s3); // direct and indirect terms
+}
+
+static Vector Acc (const Vector &p, double t)
+{
+	double r2 = p.length2(), r = sqrt (r2);
+	double s = dotp (p, pole)/r;
+	Vector a (p * (-mu/(r2*r)));
+	a += (p*((1.0 - 5.0*s*s)/r) + pole*(2.0*s)) * (-1.5*J2*mu*R*R/(r2*r2));
+	a += ThirdBody (p, muM, aM, TM, t);
+	a += ThirdBody (p, muS, aS, TS, t);
+	return a;
+}
+
+static void RK4Step (Sat &b, double t, double h)
+{
+	Vector a0 = Acc (b.pos, t);
+	Vector p1 = b.pos + b.vel*(0.5*h), v1 = b.vel + a0*(0.5*h), a1 = Acc (p1, t+0.5*h);
+	Vector p2 = b.pos + v1*(0.5*h),    v2 = b.vel + a1*(0.5*h), a2 = Acc (p2, t+0.5*h);
+	Vector p3 = b.pos + v2*h,          v3 = b.vel + a2*h,       a3 = Acc (p3, t+h);
+	b.pos += (b.vel + (v1+v2)*2.0 + v3) * (h/6.0);
+	b.vel += (a0 + (a1+a2)*2.0 + a3) * (h/6.0);
+}
+
+static Sat MakeOrbit (double a, double e, double i, double node = 0.0)
+{
+	Vector ex (1,0,0);
+	Vector ez (crossp (pole, ex).unit());
+	Vector n (ex*cos (node) + ez*sin (node));
+	Vector m (crossp (n, pole)*cos (i) + pole*sin (i));
+	double rp = a*(1.0-e), vp = sqrt (mu/a*(1.0+e)/(1.0-e));
+	Sat s;
+	s.pos = n*rp;
+	s.vel = m*vp;
+	return s;
+}
+
+// Vessel propagated at frame length dt, either fully at every frame or
+// with multi-rate updates at orbit fraction 'orbstep', limited to 'tmax',
+// following RigidBody::Update and PlanetarySystem::VesselUpdateInterval
+struct MultiRateSat {
+	Sat s;
+	OrbitCoast coast;
+	int nfull;
+
+	MultiRateSat (const Sat &s0): s(s0), nfull(0) {}
+
+	void Step (double t0, double dt, double orbstep, double tmax)
+	{
+		double t1 = t0+dt;
+		double h = OrbitCoast::Interval (s.pos.length(), s.vel.length(), 0.0, orbstep, tmax, dt);
+		if (coast.Covers (t1, h)) {
+			coast.PosVel (t1, s.pos, s.vel);
+		} else {
+			RK4Step (s, t0, dt);
+			nfull++;
+			if (h) {
+				double r = s.pos.length();
+				coast.Anchor (s.pos, s.vel, mu, t1, Acc (s.pos, t1) + s.pos*(mu/(r*r*r)));
+			} else coast.Invalidate ();
+		}
+	}
+};
+
+TEST_CASE("Coasting between full updates", "[MultiRate]")
+{
+	// ISS-like and eccentric transfer orbits over 6 hours at 50 fps, full
+	// updates every 1/2000 orbit
+	const double dt = 0.02, T = 6.0*3600.0;
+	const int nframe = (int)(T/dt);
+	Sat orbit[2] = { MakeOrbit (6.78e6, 0.001, 51.6*Pi/180.0, 1.0), MakeOrbit (2.44e7, 0.73, 28.5*Pi/180.0, 2.0) };
+	for (int k = 0; k < 2; k++) {
+		Sat ref (orbit[k]);
+		MultiRateSat mr (orbit[k]);
+		double errmax = 0.0;
+		for (int f = 0; f < nframe; f++) {
+			RK4Step (ref, f*dt, dt);
+			mr.Step (f*dt, dt, 5e-4, 10.0);
+			errmax = std::max (errmax, ref.pos.dist (mr.s.pos));
+		}
+		REQUIRE(mr.nfull < nframe/100);
+		REQUIRE(errmax < 10.0);
+	}
+
+	// no coasting if the interval is not longer than two frames
+	MultiRateSat mr (orbit[0]);
+	for (int f = 0; f < 100; f++)
+		mr.Step (f*10.0, 10.0, 5e-4, 10.0);
+	REQUIRE(mr.nfull == 100);
+
+	// update interval: orbit fraction, upper limit, rotation
+	double r = orbit[0].pos.length(), v = orbit[0].vel.length();
+	double horb = 5e-4*Pi2*r/v;
+	REQUIRE(OrbitCoast::Interval (r, v, 0.0, 5e-4, 10.0, 0.02) == Catch::Approx (horb));
+	REQUIRE(OrbitCoast::Interval (r, v, 0.0, 5e-4, 1.0, 0.02) == 1.0);
+	REQUIRE(OrbitCoast::Interval (r, v, 0.1*Pi, 5e-4, 10.0, 0.02) == Catch::Approx (1.0));
+	REQUIRE(OrbitCoast::Interval (r, v, 0.0, 5e-4, 10.0, 0.6*horb) == 0.0);
+}
+
+// Psys.MultiRate [benchmark]
+TEST_CASE("Multi-rate vs. single-rate vessel updates", "[.][benchmark]")
+{
+	// satellites on random orbits between LEO and GEO, updated at 50 fps
+	// at different time warp factors, either fully at every frame or with
+	// multi-rate updates
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> alt(3e5, 3.6e7), ecc(0.0, 0.2), inc(0.0, Pi), lan(0.0, Pi2);
+	const int nsat = 100;
+	const double T = 1200.0;
+	std::vector<Sat> sat(nsat);
+	for (int k = 0; k < nsat; k++) {
+		double a = R + alt(rng), e = ecc(rng);
+		if (a*(1.0-e) < R + 3e5) e = 1.0 - (R + 3e5)/a;
+		sat[k] = MakeOrbit (a, e, inc(rng), lan(rng));
+	}
+
+	for (double warp : { 1.0, 10.0, 100.0 }) {
+		const double dt = 0.02*warp;
+		const int nframe = (int)(T/dt);
+
+		std::vector<Sat> ref (sat);
+		auto t0 = std::chrono::steady_clock::now();
+		for (int f = 0; f < nframe; f++)
+			for (int k = 0; k < nsat; k++)
+				RK4Step (ref[k], f*dt, dt);
+		double dt_full = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		std::vector<MultiRateSat> mr (sat.begin(), sat.end());
+		t0 = std::chrono::steady_clock::now();
+		for (int f = 0; f < nframe; f++)
+			for (int k = 0; k < nsat; k++)
+				mr[k].Step (f*dt, dt, 5e-4, 10.0);
+		double dt_mr = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		double err = 0.0;
+		int nfull = 0;
+		for (int k = 0; k < nsat; k++) {
+			err = std::max (err, mr[k].s.pos.dist (ref[k].pos));
+			nfull += mr[k].nfull;
+		}
+		std::cout << nsat << " satellites, warp " << warp << ": full " << dt_full/nframe*1e3 << " ms/frame, multi-rate "
+			<< dt_mr/nframe*1e3 << " ms/frame (" << 100.0*nfull/((double)nframe*nsat) << "% full updates), max. error "
+			<< err << " m after " << T << " s" << std::endl;
+	}
+}
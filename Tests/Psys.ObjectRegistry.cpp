@@ -0,0 +1,177 @@
+#include "ObjectRegistry.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+#include <ctype.h>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+struct TestObj {
+	std::string name;
+	unsigned int flags;
+};
+
+static const unsigned int VESSEL = 1, PLANET = 2;
+
+static int StrICmp (const char *a, const char *b)
+{
+	for (; *a && tolower ((unsigned char)*a) == tolower ((unsigned char)*b); a++, b++);
+	return tolower ((unsigned char)*a) - tolower ((unsigned char)*b);
+}
+
+// Linear scans as in the former PlanetarySystem lookups
+static const void *ScanName (const std::vector<TestObj*> &list, const char *name, bool ignorecase, unsigned int flags)
+{
+	for (size_t i = 0; i < list.size(); i++) {
+		if (flags && !(list[i]->flags & flags)) continue;
+		if (!(ignorecase ? StrICmp (list[i]->name.c_str(), name) : strcmp (list[i]->name.c_str(), name))) return list[i];
+	}
+	return 0;
+}
+
+static bool ScanObj (const std::vector<TestObj*> &list, const void *obj)
+{
+	for (size_t i = 0; i < list.size(); i++)
+		if (list[i] == obj) return true;
+	return false;
+}
+
+TEST_CASE("Object registry", "[ObjectRegistry]")
+{
+	ObjectRegistry reg;
+	TestObj earth = {"Earth", PLANET}, moon = {"Moon", PLANET};
+	TestObj gl1 = {"GL-01", VESSEL}, gl2 = {"gl-01", VESSEL}, iss = {"ISS", VESSEL};
+
+	ObjectRegistry::Handle hEarth = reg.Insert (&earth, earth.name.c_str(), earth.flags);
+	ObjectRegistry::Handle hMoon  = reg.Insert (&moon, moon.name.c_str(), moon.flags);
+	ObjectRegistry::Handle hGL1   = reg.Insert (&gl1, gl1.name.c_str(), gl1.flags);
+	ObjectRegistry::Handle hGL2   = reg.Insert (&gl2, gl2.name.c_str(), gl2.flags);
+	ObjectRegistry::Handle hISS   = reg.Insert (&iss, iss.name.c_str(), iss.flags);
+	REQUIRE(reg.Size() == 5);
+
+	SECTION("Handles") {
+		REQUIRE(hEarth != 0);
+		REQUIRE(hEarth != hMoon);
+		REQUIRE(reg.Get (hEarth) == &earth);
+		REQUIRE(reg.Get (hISS) == &iss);
+		REQUIRE(reg.Get (hGL1) == &gl1);
+		REQUIRE(reg.GetHandle (&gl2) == hGL2);
+		REQUIRE(reg.Insert (&gl2, "other", VESSEL) == hGL2); // already registered
+		REQUIRE(reg.Size() == 5);
+		REQUIRE(reg.Get (0) == 0);
+	}
+
+	SECTION("Validity") {
+		REQUIRE(reg.Contains (&earth));
+		REQUIRE(reg.Contains (&iss, VESSEL));
+		REQUIRE(!reg.Contains (&earth, VESSEL));
+		REQUIRE(reg.Contains (&earth, VESSEL | PLANET));
+		TestObj other = {"ISS", VESSEL};
+		REQUIRE(!reg.Contains (&other));
+	}
+
+	SECTION("Stale handles") {
+		REQUIRE(reg.Remove (&iss));
+		REQUIRE(!reg.Remove (&iss));
+		REQUIRE(!reg.Contains (&iss));
+		REQUIRE(reg.Get (hISS) == 0);
+		REQUIRE(reg.GetHandle (&iss) == 0);
+		REQUIRE(reg.Find ("ISS") == 0);
+
+		// the slot is reused with a new generation
+		ObjectRegistry::Handle h = reg.Insert (&iss, iss.name.c_str(), iss.flags);
+		REQUIRE(h != hISS);
+		REQUIRE((h & 0xffffffff) == (hISS & 0xffffffff));
+		REQUIRE(reg.Get (hISS) == 0);
+		REQUIRE(reg.Get (h) == &iss);
+
+		reg.Clear();
+		REQUIRE(reg.Size() == 0);
+		REQUIRE(reg.Get (h) == 0);
+		REQUIRE(reg.Get (hEarth) == 0);
+		REQUIRE(!reg.Contains (&earth));
+		REQUIRE(reg.Find ("Earth", true) == 0);
+	}
+
+	SECTION("Name lookup") {
+		REQUIRE(reg.Find ("Earth") == &earth);
+		REQUIRE(reg.Find ("earth") == 0);
+		REQUIRE(reg.Find ("EARTH", true) == &earth);
+		REQUIRE(reg.Find ("Mars", true) == 0);
+		REQUIRE(reg.Find ("Moon", true, VESSEL) == 0);
+		REQUIRE(reg.Find ("Moon", true, PLANET) == &moon);
+
+		// names differing only in case: exact match, or earliest registered
+		REQUIRE(reg.Find ("gl-01") == &gl2);
+		REQUIRE(reg.Find ("GL-01") == &gl1);
+		REQUIRE(reg.Find ("Gl-01", true) == &gl1);
+		REQUIRE(reg.Remove (&gl1));
+		REQUIRE(reg.Find ("GL-01", true) == &gl2);
+		REQUIRE(reg.Find ("GL-01") == 0);
+	}
+
+	SECTION("Rename") {
+		REQUIRE(reg.Rename (&gl2, "GL-02"));
+		REQUIRE(reg.Find ("gl-01") == 0);
+		REQUIRE(reg.Find ("GL-02") == &gl2);
+		REQUIRE(reg.Get (hGL2) == &gl2);
+
+		// renamed object keeps its registration order
+		REQUIRE(reg.Rename (&gl2, "GL-01"));
+		REQUIRE(reg.Rename (&gl1, "gl-01"));
+		REQUIRE(reg.Find ("GL-01", true) == &gl1);
+		REQUIRE(reg.Find ("GL-01") == &gl2);
+
+		TestObj other = {"X", VESSEL};
+		REQUIRE(!reg.Rename (&other, "Y"));
+	}
+}
+
+// Psys.ObjectRegistry [benchmark]
+TEST_CASE("Object registry lookup with many vessels", "[.][benchmark]")
+{
+	const int nobj[3] = {20, 200, 2000};
+	for (int m = 0; m < 3; m++) {
+		int n = nobj[m];
+		std::vector<TestObj> obj(n);
+		std::vector<TestObj*> list(n);
+		ObjectRegistry reg;
+		for (int i = 0; i < n; i++) {
+			obj[i].name = "Vessel-" + std::to_string (i);
+			obj[i].flags = VESSEL;
+			list[i] = &obj[i];
+			reg.Insert (&obj[i], obj[i].name.c_str(), obj[i].flags);
+		}
+		std::vector<std::string> query(64);
+		for (int k = 0; k < 64; k++)
+			query[k] = "VESSEL-" + std::to_string ((k*7919) % n);
+
+		const int nrep = 20000;
+		for (int mode = 0; mode < 2; mode++) {
+			size_t chk = 0;
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < nrep; r++) {
+				const void *o = &obj[(r*7919) % n];
+				chk += (mode ? reg.Contains (o, VESSEL) : ScanObj (list, o));
+			}
+			double dt_valid = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+			t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < nrep; r++) {
+				const char *name = query[r & 63].c_str();
+				chk += (mode ? reg.Find (name, true, VESSEL) : ScanName (list, name, true, VESSEL)) != 0;
+			}
+			double dt_name = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+			std::cout << n << " objects, " << (mode ? "registry:    " : "linear scan: ")
+			          << "validity " << dt_valid/nrep*1e9 << " ns, name " << dt_name/nrep*1e9 << " ns (" << chk << ")" << std::endl;
+		}
+	}
+}
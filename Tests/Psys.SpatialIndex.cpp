@@ -0,0 +1,135 @@
+#include "SpatialIndex.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <limits>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+struct TestObj {
+	Vector pos;
+	double size;
+};
+
+static void GetPos (const void *obj, Vector &pos, double &size)
+{
+	const TestObj *o = (const TestObj*)obj;
+	pos = o->pos;
+	size = o->size;
+}
+
+static std::vector<const void*> BruteForceQuery (const std::vector<TestObj> &obj, const Vector &pos, double range, const void *exclude)
+{
+	std::vector<const void*> list;
+	for (size_t i = 0; i < obj.size(); i++)
+		if (&obj[i] != exclude && pos.dist2 (obj[i].pos) <= range*range)
+			list.push_back (&obj[i]);
+	std::sort (list.begin(), list.end());
+	return list;
+}
+
+static const void *BruteForceNearest (const std::vector<TestObj> &obj, const Vector &pos, const void *exclude)
+{
+	const void *nearest = 0;
+	double d2min = std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < obj.size(); i++) {
+		double d2 = pos.dist2 (obj[i].pos);
+		if (&obj[i] != exclude && d2 < d2min) {
+			d2min = d2;
+			nearest = &obj[i];
+		}
+	}
+	return nearest;
+}
+
+// a cluster of objects around a point far from the origin, like vessels
+// around a planet, plus a few objects scattered over the whole system
+static std::vector<TestObj> MakeObjects (size_t n, std::mt19937 &rng)
+{
+	std::normal_distribution<double> cluster(0.0, 2e5);
+	std::uniform_real_distribution<double> scatter(-1e12, 1e12);
+	std::uniform_real_distribution<double> size(1.0, 100.0);
+	Vector centre(1.496e11, -3e7, 2e9);
+	std::vector<TestObj> obj(n);
+	for (size_t i = 0; i < n; i++) {
+		if (i % 10) obj[i].pos = centre + Vector (cluster(rng), cluster(rng), cluster(rng));
+		else        obj[i].pos = Vector (scatter(rng), scatter(rng), scatter(rng));
+		obj[i].size = size(rng);
+	}
+	return obj;
+}
+
+TEST_CASE("Range and nearest queries", "[SpatialIndex]")
+{
+	std::mt19937 rng(1234);
+	std::vector<TestObj> obj = MakeObjects (500, rng);
+	SpatialIndex index(1e5);
+	for (size_t i = 0; i < obj.size(); i++)
+		index.Insert (&obj[i], obj[i].pos, obj[i].size);
+	REQUIRE(index.Size() == obj.size());
+
+	for (size_t i = 0; i < obj.size(); i += 7) {
+		for (double range : { 1e3, 1e5, 1e6, 1e13 }) {
+			std::vector<const void*> list;
+			index.Query (obj[i].pos, range, list, &obj[i]);
+			std::sort (list.begin(), list.end());
+			REQUIRE(list == BruteForceQuery (obj, obj[i].pos, range, &obj[i]));
+		}
+		double d2;
+		REQUIRE(index.Nearest (obj[i].pos, &obj[i], &d2) == BruteForceNearest (obj, obj[i].pos, &obj[i]));
+	}
+
+	SECTION("Removal") {
+		for (size_t i = 0; i < obj.size(); i += 2)
+			REQUIRE(index.Remove (&obj[i]));
+		REQUIRE(!index.Remove (&obj[0]));
+		REQUIRE(index.Size() == obj.size()/2);
+		Vector pos = obj[0].pos;
+		const void *nearest = index.Nearest (pos);
+		REQUIRE(nearest);
+		REQUIRE(((const TestObj*)nearest - &obj[0]) % 2 == 1);
+	}
+
+	SECTION("Single and no objects") {
+		SpatialIndex single(1e5);
+		REQUIRE(single.Nearest (Vector (0,0,0)) == 0);
+		single.Insert (&obj[0], obj[0].pos);
+		REQUIRE(single.Nearest (Vector (0,0,0)) == &obj[0]);
+		REQUIRE(single.Nearest (Vector (0,0,0), &obj[0]) == 0);
+	}
+}
+
+TEST_CASE("Refresh after motion", "[SpatialIndex]")
+{
+	std::mt19937 rng(5678);
+	std::vector<TestObj> obj = MakeObjects (300, rng);
+	SpatialIndex index(1e5);
+	for (size_t i = 0; i < obj.size(); i++)
+		index.Insert (&obj[i], obj[i].pos, obj[i].size);
+
+	std::normal_distribution<double> step(0.0, 1e4);
+	for (int frame = 0; frame < 20; frame++) {
+		// small steps: few objects change cells. Every 5th frame, a large jump
+		double scale = (frame % 5 == 4 ? 100.0 : 1.0);
+		for (size_t i = 0; i < obj.size(); i++)
+			obj[i].pos += Vector (step(rng), step(rng), step(rng)) * scale;
+		index.Refresh (GetPos);
+
+		for (size_t i = 0; i < obj.size(); i += 11) {
+			std::vector<const void*> list;
+			index.Query (obj[i].pos, 1e6, list, &obj[i]);
+			std::sort (list.begin(), list.end());
+			REQUIRE(list == BruteForceQuery (obj, obj[i].pos, 1e6, &obj[i]));
+			REQUIRE(index.Nearest (obj[i].pos, &obj[i]) == BruteForceNearest (obj, obj[i].pos, &obj[i]));
+		}
+	}
+	double maxsize = 0.0;
+	for (size_t i = 0; i < obj.size(); i++)
+		maxsize = std::max (maxsize, obj[i].size);
+	REQUIRE(index.MaxObjSize() == maxsize);
+}
@@ -0,0 +1,201 @@
+#include "BlockPool.h"
+#include "SpatialIndex.h"
+#include "ObjectRegistry.h"
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <string.h>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// Stand-in for a vessel: position and size for the spatial index, name for
+// the registry, and a payload of the order of the size of a Vessel instance
+struct Debris {
+	Vector pos;
+	double size;
+	std::string name;
+	char payload[4096];
+};
+
+static void GetPos (const void *obj, Vector &pos, double &size)
+{
+	const Debris *d = (const Debris*)obj;
+	pos = d->pos;
+	size = d->size;
+}
+
+static void MakeDebris (Debris *d, int id, std::mt19937 &rng)
+{
+	std::normal_distribution<double> cloud(0.0, 5e4);
+	std::uniform_real_distribution<double> size(0.1, 10.0);
+	d->pos = Vector (6.8e6 + cloud(rng), cloud(rng), cloud(rng));
+	d->size = size(rng);
+	d->name = "Debris-" + std::to_string (id);
+}
+
+TEST_CASE("Block pool", "[VesselBatch]")
+{
+	BlockPool pool (100, 4);
+	REQUIRE(pool.BlockSize() >= 100);
+	REQUIRE(pool.BlockSize() % 16 == 0);
+
+	std::vector<void*> p;
+	for (int i = 0; i < 10; i++) {
+		p.push_back (pool.Alloc (100));
+		memset (p.back(), i, 100);
+	}
+	REQUIRE(pool.nUsed() == 10);
+	REQUIRE(pool.nBlocks() == 12);
+	for (int i = 0; i < 10; i++) {
+		REQUIRE((size_t)p[i] % 16 == 0);
+		REQUIRE(((unsigned char*)p[i])[99] == i); // blocks don't overlap
+	}
+
+	// released blocks are reused before new chunks are allocated
+	pool.Free (p[3], 100);
+	pool.Free (p[7], 100);
+	REQUIRE(pool.nUsed() == 8);
+	void *q1 = pool.Alloc (100), *q2 = pool.Alloc (100);
+	REQUIRE(((q1 == p[3] && q2 == p[7]) || (q1 == p[7] && q2 == p[3])));
+	REQUIRE(pool.nBlocks() == 12);
+
+	// oversized requests go to the heap
+	void *big = pool.Alloc (1000);
+	REQUIRE(pool.nUsed() == 10);
+	pool.Free (big, 1000);
+	REQUIRE(pool.nUsed() == 10);
+}
+
+TEST_CASE("Batch insertion and removal", "[VesselBatch]")
+{
+	std::mt19937 rng(42);
+	std::vector<Debris> obj(400);
+	for (size_t i = 0; i < obj.size(); i++)
+		MakeDebris (&obj[i], (int)i, rng);
+
+	SpatialIndex single(1e4), batch(1e4);
+	std::vector<const void*> list;
+	for (size_t i = 0; i < obj.size(); i++) {
+		single.Insert (&obj[i], obj[i].pos, obj[i].size);
+		list.push_back (&obj[i]);
+	}
+	batch.Insert (std::vector<const void*> (list.begin(), list.begin()+100), GetPos);
+	batch.Insert (std::vector<const void*> (list.begin()+100, list.end()), GetPos);
+	REQUIRE(batch.Size() == obj.size());
+	REQUIRE(batch.MaxObjSize() == single.MaxObjSize());
+
+	// remove every third object in one batch
+	std::vector<const void*> del;
+	for (size_t i = 0; i < obj.size(); i += 3) {
+		del.push_back (&obj[i]);
+		single.Remove (&obj[i]);
+	}
+	Debris other;
+	del.push_back (&other); // not in the index
+	std::sort (del.begin(), del.end());
+	REQUIRE(batch.Remove (del) == (obj.size()+2)/3);
+	REQUIRE(batch.Size() == single.Size());
+
+	for (size_t i = 0; i < obj.size(); i += 5) {
+		std::vector<const void*> l1, l2;
+		single.Query (obj[i].pos, 2e4, l1);
+		batch.Query (obj[i].pos, 2e4, l2);
+		std::sort (l1.begin(), l1.end());
+		std::sort (l2.begin(), l2.end());
+		REQUIRE(l1 == l2);
+		REQUIRE(batch.Nearest (obj[i].pos, &obj[i]) == single.Nearest (obj[i].pos, &obj[i]));
+	}
+}
+
+// Psys.VesselBatch [benchmark]
+TEST_CASE("Vessel spawn/destroy throughput", "[.][benchmark]")
+{
+	// A system of nbase vessels, in which nbatch debris objects are spawned
+	// and destroyed again in a single frame, either one at a time (heap
+	// allocation, sorted insertion into the index, linear search on removal)
+	// or as a batch (pool allocation, merged insertion, single-pass removal)
+	const int nbase = 200, nrep = 20;
+	const int nspawn[3] = {100, 1000, 2000};
+	BlockPool pool (sizeof(Debris), 32);
+	std::mt19937 rng(7);
+
+	for (int m = 0; m < 3; m++) {
+		int nbatch = nspawn[m];
+		for (int mode = 0; mode < 2; mode++) {
+			std::vector<Debris> base(nbase);
+			std::vector<Debris*> vessels;
+			SpatialIndex index(1e4);
+			ObjectRegistry reg;
+			for (int i = 0; i < nbase; i++) {
+				MakeDebris (&base[i], i, rng);
+				vessels.push_back (&base[i]);
+				index.Insert (&base[i], base[i].pos, base[i].size);
+				reg.Insert (&base[i], base[i].name.c_str());
+			}
+
+			double dt_spawn = 0.0, dt_kill = 0.0;
+			for (int r = 0; r < nrep; r++) {
+				std::vector<Debris*> spawn(nbatch);
+				auto t0 = std::chrono::steady_clock::now();
+				if (!mode) {
+					for (int i = 0; i < nbatch; i++) {
+						Debris *d = spawn[i] = new Debris;
+						MakeDebris (d, nbase+i, rng);
+						vessels.push_back (d);
+						index.Insert (d, d->pos, d->size);
+						reg.Insert (d, d->name.c_str());
+					}
+				} else {
+					vessels.reserve (vessels.size() + nbatch);
+					for (int i = 0; i < nbatch; i++) {
+						Debris *d = spawn[i] = new (pool.Alloc (sizeof(Debris))) Debris;
+						MakeDebris (d, nbase+i, rng);
+						vessels.push_back (d);
+						reg.Insert (d, d->name.c_str());
+					}
+					index.Insert (std::vector<const void*> (spawn.begin(), spawn.end()), GetPos);
+				}
+				auto t1 = std::chrono::steady_clock::now();
+				if (!mode) {
+					for (int i = nbatch-1; i >= 0; i--) {
+						Debris *d = spawn[i];
+						auto it = std::find (vessels.begin(), vessels.end(), d);
+						std::iter_swap (it, vessels.end()-1);
+						vessels.pop_back();
+						index.Remove (d);
+						reg.Remove (d);
+						delete d;
+					}
+				} else {
+					std::vector<const void*> del (spawn.begin(), spawn.end());
+					std::sort (del.begin(), del.end());
+					vessels.erase (std::remove_if (vessels.begin(), vessels.end(), [&](Debris *d) {
+						return std::binary_search (del.begin(), del.end(), (const void*)d);
+					}), vessels.end());
+					index.Remove (del);
+					for (int i = 0; i < nbatch; i++) {
+						reg.Remove (spawn[i]);
+						spawn[i]->~Debris();
+						pool.Free (spawn[i], sizeof(Debris));
+					}
+				}
+				auto t2 = std::chrono::steady_clock::now();
+				dt_spawn += std::chrono::duration<double>(t1-t0).count();
+				dt_kill  += std::chrono::duration<double>(t2-t1).count();
+			}
+			REQUIRE(vessels.size() == (size_t)nbase);
+			REQUIRE(index.Size() == (size_t)nbase);
+			std::cout << nbatch << " vessels per frame, " << (mode ? "batch:      " : "one by one: ")
+			          << "spawn " << dt_spawn/nrep*1e3 << " ms, destroy " << dt_kill/nrep*1e3 << " ms" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,122 @@
+#include "VesselClass.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+#include "catch2/catch_all.hpp"
+
+static std::string TestFile (const char *name)
+{
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "Vessel.ClassRegistry";
+	std::filesystem::create_directories (dir);
+	return (dir / name).string();
+}
+
+// Items queried by Vessel::ReadGenericCaps and RigidBody::ReadGenericCaps
+static const char *classitem[] = {
+	"BaseClass", "Module", "MeshName", "CollisionHull", "Help", "EnableFocus", "Size", "ClipRadius",
+	"Mass", "AlbedoRGB", "EnableXPDR", "XPDR", "PropellantResource1", "MaxFuel", "Isp",
+	"MaxMainThrust", "MaxRetroThrust", "MaxHoverThrust", "MaxAttitudeThrust", "TouchdownPoints",
+	"COG_OverGround", "CW", "WingAspect", "WingEffectiveness", "CrossSections", "RotResistance",
+	"CameraOffset", "DockRef", "DockDir", "DockRot", "MEngineRef1", "REngineRef1", "HEngineRef1",
+	"AttRefX00", "AttRefX01", "AttRefX10", "AttRefX11", "AttRefY00", "AttRefY01", "AttRefY10",
+	"AttRefY11", "AttRefZ00", "AttRefZ01", "AttRefZ10", "AttRefZ11", "Inertia", "GravityGradientDamping",
+	"Damping", "EditorModule"
+};
+
+TEST_CASE("Shared class files", "[VesselClass]")
+{
+	std::string fname = TestFile ("Satellite.cfg");
+	{
+		std::ofstream ofs (fname);
+		ofs << "ClassName = Satellite\n";
+		ofs << "Mass = 1500\n";
+		ofs << "Size = 3.5\n";
+	}
+	VesselClassRegistry reg;
+	CfgFile::IndexRef index = reg.Config (fname.c_str());
+	REQUIRE(index);
+	CHECK(reg.Config (fname.c_str()) == index);
+
+	// vessel instances share the parsed file
+	char cbuf[256];
+	for (int i = 0; i < 3; i++) {
+		CfgFile classf;
+		classf.open (fname.c_str(), index);
+		REQUIRE(classf.good());
+		REQUIRE(classf.Indexed());
+		REQUIRE(classf.GetItem ("mass", cbuf));
+		CHECK(std::string(cbuf) == "1500");
+		CHECK(!classf.GetItem ("Module", cbuf));
+	}
+
+	// missing files are cached as well
+	std::string missing = TestFile ("Missing.cfg");
+	CHECK(!reg.Config (missing.c_str()));
+	CHECK(!reg.Config (missing.c_str()));
+	CHECK(reg.GetStats().ncfgrequest == 4);
+
+	// a new session rereads the file
+	reg.Flush();
+	CHECK(reg.GetStats().ncfgrequest == 0);
+	CfgFile::IndexRef index2 = reg.Config (fname.c_str());
+	REQUIRE(index2);
+	CHECK(index2 != index);
+}
+
+TEST_CASE("Missing modules", "[VesselClass]")
+{
+	VesselClassRegistry reg;
+	const VesselModule *mod = reg.Module ("NonexistentVesselModule");
+	REQUIRE(mod);
+	CHECK(!mod->hMod);
+	CHECK(mod->err != 0);
+	CHECK(reg.Module ("nonexistentvesselmodule") == mod);
+	CHECK(!VesselClassRegistry::Acquire (mod));
+	CHECK(reg.GetStats().nmodrequest == 2);
+}
+
+// Create a scenario's worth of vessels of each class found in the
+// configuration directory, reading the class items for each instance,
+// with and without the registry. Hidden from the default run:
+// Vessel.ClassRegistry [benchmark]
+TEST_CASE("Scenario class loading", "[.][benchmark]")
+{
+	std::vector<std::string> file;
+	std::error_code ec;
+	for (auto &entry : std::filesystem::directory_iterator (std::filesystem::path(CONFIG_DIR) / "Vessels", ec))
+		if (entry.path().extension() == ".cfg")
+			file.push_back (entry.path().string());
+	REQUIRE(!file.empty());
+	char cbuf[1024];
+
+	for (int nvessel = 10; nvessel <= 10000; nvessel *= 10) {
+		// each instance opens and parses its class file
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < nvessel; i++) {
+			CfgFile classf (file[i % file.size()].c_str());
+			if (classf.Indexed())
+				for (auto item : classitem) classf.GetItem (item, cbuf);
+		}
+		double dt0 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		// instances share the class files of a registry
+		t0 = std::chrono::steady_clock::now();
+		VesselClassRegistry reg;
+		for (int i = 0; i < nvessel; i++) {
+			const char *path = file[i % file.size()].c_str();
+			CfgFile classf;
+			classf.open (path, reg.Config (path));
+			if (classf.Indexed())
+				for (auto item : classitem) classf.GetItem (item, cbuf);
+		}
+		double dt1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		std::cout << nvessel << " vessels (" << file.size() << " classes): "
+			<< 1e3*dt0 << " ms (per instance), " << 1e3*dt1 << " ms (registry)" << std::endl;
+	}
+}
@@ -0,0 +1,119 @@
+#include "VsopSeries.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <iostream>
+#include <cmath>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// VSOP87 term blocks as stored in the data files: for each coordinate and
+// power of time, a list of (A, B, C) triples
+struct VsopData {
+	int nalpha;
+	std::vector<double> A, B, C;
+	std::vector<int> idx, len; // block start and length, ordered by (coordinate, alpha)
+};
+
+static bool ReadVsopData (const char *fname, VsopData &data)
+{
+	std::ifstream ifs (std::string(VSOP87_DATA_DIR) + "/" + fname);
+	if (!ifs) return false;
+	ifs >> data.nalpha;
+	for (int blk = 0; blk < 3*(data.nalpha+1); blk++) {
+		int nterm;
+		ifs >> nterm;
+		data.idx.push_back ((int)data.A.size());
+		data.len.push_back (nterm);
+		for (int i = 0; i < nterm; i++) {
+			double a, b, c;
+			ifs >> a >> b >> c;
+			data.A.push_back (a);
+			data.B.push_back (b);
+			data.C.push_back (c);
+		}
+	}
+	return true;
+}
+
+// Full series evaluation as in VSOPOBJ::VsopEphem, without unit conversion
+static void Ephem (const VsopData &data, double t1, double *ret, bool scalar)
+{
+	double t[6] = {1.0, t1};
+	for (int i = 2; i < 6; i++) t[i] = t[i-1]*t1;
+	for (int i = 0; i < 6; i++) ret[i] = 0.0;
+
+	for (int cooidx = 0; cooidx < 3; cooidx++) {
+		for (int alpha = 0; alpha <= data.nalpha; alpha++) {
+			int blk = cooidx*(data.nalpha+1) + alpha;
+			const double *A = data.A.data() + data.idx[blk];
+			const double *B = data.B.data() + data.idx[blk];
+			const double *C = data.C.data() + data.idx[blk];
+			double tm, termdot;
+			if (scalar) VsopSeriesSum_Scalar (A, B, C, data.len[blk], t1, tm, termdot);
+			else        VsopSeriesSum (A, B, C, data.len[blk], t1, tm, termdot);
+			ret[cooidx] += t[alpha] * tm;
+			ret[cooidx+3] += t[alpha] * termdot + (alpha > 0 ? alpha * t[alpha-1] * tm : 0.0);
+		}
+	}
+}
+
+static const char *datafiles[] = {
+	"Vsop87B_mer.dat", "Vsop87B_ven.dat", "Vsop87B_ear.dat", "Vsop87B_mar.dat",
+	"Vsop87B_jup.dat", "Vsop87B_sat.dat", "Vsop87B_ura.dat", "Vsop87B_nep.dat"
+};
+
+// Vectorised summation must reproduce the scalar series to 1e-12 relative
+TEST_CASE("VSOP87 vectorised series summation", "[Vsop87]")
+{
+	INFO("vectorised kernel: " << (VsopSeriesVectorised() ? "yes" : "no"));
+
+	for (auto fname : datafiles) {
+		VsopData data;
+		REQUIRE(ReadVsopData (fname, data));
+
+		double maxerr = 0.0;
+		for (double t = -1.0; t <= 1.0; t += 0.00731) { // +- 1000 years around J2000
+			double r0[6], r1[6];
+			Ephem (data, t, r0, true);
+			Ephem (data, t, r1, false);
+			for (int i = 0; i < 6; i++)
+				maxerr = std::max (maxerr, fabs(r1[i]-r0[i]) / std::max (1.0, fabs(r0[i])));
+		}
+		INFO(fname);
+		REQUIRE(maxerr < 1e-12);
+	}
+}
+
+// Throughput of both kernels. Hidden from the default run:
+// Vsop87.Series [benchmark]
+TEST_CASE("VSOP87 series summation throughput", "[.][benchmark]")
+{
+	VsopData data;
+	REQUIRE(ReadVsopData ("Vsop87B_mer.dat", data));
+	int nterm = (int)data.A.size();
+	const int nrep = 2000;
+
+	for (int scalar = 1; scalar >= 0; scalar--) {
+		double ret[6], chk = 0.0;
+		auto t0 = std::chrono::steady_clock::now();
+		for (int k = 0; k < nrep; k++) {
+			Ephem (data, 0.01*k/nrep, ret, scalar != 0);
+			chk += ret[0];
+		}
+		double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		std::cout << (scalar ? "scalar:     " : "vectorised: ") << (double)nterm*nrep/dt << " terms/s (" << chk << ")" << std::endl;
+	}
+
+	BENCHMARK("Mercury VsopSeriesSum") {
+		double ret[6];
+		Ephem (data, 0.005, ret, false);
+		return ret[0];
+	};
+}
@@ -0,0 +1,213 @@
+#include "ZTreeMgr.h"
+#include "zlib.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#include "catch2/catch_all.hpp"
+
+// Synthetic tile archive: complete quadtree from the two level-4 roots down
+// to maxlvl, with a tile payload that identifies the tile
+static const int maxlvl = 10;
+static const DWORD tilesize = 4096;
+
+static void TilePattern (int lvl, int ilat, int ilng, BYTE *buf)
+{
+	DWORD seed = (DWORD)(lvl*7919 + ilat*104729 + ilng*1299709);
+	for (DWORD i = 0; i < tilesize; i++)
+		buf[i] = (BYTE)((seed >> ((i/64)%4)*8) + i/256);
+}
+
+struct ArchiveBuilder {
+	std::vector<TreeNode> node;
+	std::vector<BYTE> data;
+
+	DWORD AddTile (int lvl, int ilat, int ilng)
+	{
+		BYTE ebuf[tilesize];
+		TilePattern (lvl, ilat, ilng, ebuf);
+		uLongf zsize = compressBound (tilesize);
+		std::vector<BYTE> zbuf(zsize);
+		compress (zbuf.data(), &zsize, ebuf, tilesize);
+
+		DWORD idx = (DWORD)node.size();
+		node.emplace_back();
+		node[idx].pos = (__int64)data.size();
+		node[idx].size = tilesize;
+		data.insert (data.end(), zbuf.begin(), zbuf.begin() + zsize);
+
+		if (lvl < maxlvl) {
+			for (int i = 0; i < 4; i++) {
+				DWORD cidx = AddTile (lvl+1, ilat*2 + i/2, ilng*2 + i%2);
+				node[idx].child[i] = cidx;
+			}
+		}
+		return idx;
+	}
+
+	bool Write (const std::filesystem::path &fname)
+	{
+		DWORD root[2];
+		for (int i = 0; i < 2; i++)
+			root[i] = AddTile (4, 0, i);
+
+		FILE *f = fopen (fname.string().c_str(), "wb");
+		if (!f) return false;
+		// file header, as written by TreeFileHeader::fwrite
+		const BYTE magic[4] = {'T', 'X', 1, 0};
+		DWORD hsize = 48, flags = 0, nodeCount = (DWORD)node.size(), none = (DWORD)-1;
+		DWORD dataOfs = hsize + nodeCount*sizeof(TreeNode);
+		__int64 dataLength = (__int64)data.size();
+		fwrite (magic, 1, 4, f);
+		fwrite (&hsize, sizeof(DWORD), 1, f);
+		fwrite (&flags, sizeof(DWORD), 1, f);
+		fwrite (&dataOfs, sizeof(DWORD), 1, f);
+		fwrite (&dataLength, sizeof(__int64), 1, f);
+		fwrite (&nodeCount, sizeof(DWORD), 1, f);
+		for (int i = 0; i < 3; i++)
+			fwrite (&none, sizeof(DWORD), 1, f);
+		fwrite (root, sizeof(DWORD), 2, f);
+		fwrite (node.data(), sizeof(TreeNode), node.size(), f);
+		fwrite (data.data(), 1, data.size(), f);
+		fclose (f);
+		return true;
+	}
+};
+
+static std::string ArchiveRoot ()
+{
+	static std::string root;
+	if (root.empty()) {
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "ZTreeMgr.Archive";
+		std::filesystem::create_directories (path / "Archive");
+		ArchiveBuilder builder;
+		if (builder.Write (path / "Archive" / "Elev.tree"))
+			root = path.string();
+	}
+	return root;
+}
+
+// Read all tiles of level lvl in [ilat0,ilat1) rows and optionally check
+// their contents. Returns the number of failed reads or mismatches.
+static int ReadRows (const ZTreeMgr *mgr, int lvl, int ilat0, int ilat1, bool verify = true)
+{
+	int nerr = 0;
+	std::vector<BYTE> buf(tilesize), ref(tilesize);
+	int nlng = 2 << (lvl-4);
+	for (int ilat = ilat0; ilat < ilat1; ilat++)
+		for (int ilng = 0; ilng < nlng; ilng++) {
+			DWORD ndata = mgr->ReadData (lvl, ilat, ilng, buf.data(), tilesize);
+			if (ndata != tilesize) nerr++;
+			else if (verify) {
+				TilePattern (lvl, ilat, ilng, ref.data());
+				if (memcmp (buf.data(), ref.data(), tilesize)) nerr++;
+			}
+		}
+	return nerr;
+}
+
+TEST_CASE("ZTreeMgr mapped and file backends", "[ZTreeMgr]")
+{
+	std::string root = ArchiveRoot();
+	REQUIRE(!root.empty());
+
+	ZTreeMgr *mapped = ZTreeMgr::CreateFromFile (root.c_str(), ZTreeMgr::LAYER_ELEV, true);
+	ZTreeMgr *stream = ZTreeMgr::CreateFromFile (root.c_str(), ZTreeMgr::LAYER_ELEV, false);
+	REQUIRE(mapped);
+	REQUIRE(stream);
+	CHECK(mapped->IsMapped());
+	CHECK(!stream->IsMapped());
+	REQUIRE(mapped->TOC().size() == stream->TOC().size());
+
+	for (int lvl = 4; lvl <= maxlvl; lvl++) {
+		int nlat = 1 << (lvl-4);
+		INFO("level " << lvl);
+		CHECK(ReadRows (mapped, lvl, 0, nlat) == 0);
+		CHECK(ReadRows (stream, lvl, 0, nlat) == 0);
+		// out of range
+		CHECK(mapped->Idx (lvl, nlat, 0) == (DWORD)-1);
+		CHECK(mapped->Idx (lvl, 0, 2*nlat) == (DWORD)-1);
+	}
+
+	// allocating interface
+	BYTE *buf;
+	std::vector<BYTE> ref(tilesize);
+	TilePattern (maxlvl, 5, 17, ref.data());
+	DWORD ndata = mapped->ReadData (maxlvl, 5, 17, &buf);
+	REQUIRE(ndata == tilesize);
+	CHECK(!memcmp (buf, ref.data(), tilesize));
+	mapped->ReleaseData (buf);
+
+	delete mapped;
+	delete stream;
+}
+
+TEST_CASE("ZTreeMgr concurrent reads", "[ZTreeMgr]")
+{
+	std::string root = ArchiveRoot();
+	REQUIRE(!root.empty());
+	const int nthread = 8;
+	const int nlat = 1 << (maxlvl-4);
+
+	for (int map = 0; map < 2; map++) {
+		ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (root.c_str(), ZTreeMgr::LAYER_ELEV, map != 0);
+		REQUIRE(mgr);
+		std::atomic<int> nerr(0);
+		std::vector<std::thread> thread;
+		for (int i = 0; i < nthread; i++)
+			thread.emplace_back ([&, i]() { nerr += ReadRows (mgr, maxlvl, i*nlat/nthread, (i+1)*nlat/nthread); });
+		for (auto &t : thread) t.join();
+		INFO((map ? "mapped" : "file"));
+		CHECK(nerr == 0);
+		delete mgr;
+	}
+}
+
+// Read a full level of tiles with both backends, serially and from multiple
+// threads. Hidden from the default run:
+// ZTreeMgr.Archive [benchmark]
+TEST_CASE("ZTreeMgr tile read throughput", "[.][benchmark]")
+{
+	std::string root = ArchiveRoot();
+	REQUIRE(!root.empty());
+	const int nlat = 1 << (maxlvl-4);
+	const int ntile = nlat * 2*nlat;
+	const int nthread = std::max (1u, std::thread::hardware_concurrency());
+
+	for (int map = 0; map < 2; map++) {
+		ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (root.c_str(), ZTreeMgr::LAYER_ELEV, map != 0);
+		REQUIRE(mgr);
+
+		// legacy interface: one allocation per tile
+		auto t0 = std::chrono::steady_clock::now();
+		for (int ilat = 0; ilat < nlat; ilat++)
+			for (int ilng = 0; ilng < 2*nlat; ilng++) {
+				BYTE *buf;
+				if (mgr->ReadData (maxlvl, ilat, ilng, &buf))
+					mgr->ReleaseData (buf);
+			}
+		double dt0 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		// caller-provided buffers, all threads
+		t0 = std::chrono::steady_clock::now();
+		std::vector<std::thread> thread;
+		for (int i = 0; i < nthread; i++)
+			thread.emplace_back ([&, i]() { ReadRows (mgr, maxlvl, i*nlat/nthread, (i+1)*nlat/nthread, false); });
+		for (auto &t : thread) t.join();
+		double dt1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		std::cout << (map ? "mapped: " : "file:   ")
+			<< ntile/dt0 << " tiles/s (serial), "
+			<< ntile/dt1 << " tiles/s (" << nthread << " threads)" << std::endl;
+		delete mgr;
+	}
+}
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <time.h>
 #include "Mesh.h"
+#include "MeshBin.h"
 
 using namespace std;
 
@@ -13,19 +14,23 @@ struct Param {
 	char meshname[1024];
 	char outname[1024];
 	char suffix[256];
+	char binname[1024];
 	bool outlua;
 };
 
 void PrintUsage()
 {
 	std::cout << "Scans a mesh file and generates a header file containing mesh group\n";
-	std::cout << "identifiers.\n\n";
+	std::cout << "identifiers, and optionally converts the mesh into binary format.\n\n";
 	std::cout << "Usage: meshc /I <meshfile> /O <header file> /P <suffix> [/L]\n";
+	std::cout << "       meshc /I <meshfile> /B <binary mesh file>\n";
 	std::cout << "  <meshfile>:    Orbiter mesh file to be scanned\n";
 	std::cout << "  <header file>: Output header file name\n";
 	std::cout << "  <suffix>:      Variable name suffix\n";
-	std::cout << "  /L:            Optional argument, output a Lua file when provided\n\n";
-	std::cout << "Any mandatory parameters not provided on the command line are queried interactively.\n\n";
+	std::cout << "  /L:            Optional argument, output a Lua file when provided\n";
+	std::cout << "  <binary mesh file>: Output binary mesh file name (usually <meshfile>b)\n\n";
+	std::cout << "Any mandatory parameters not provided on the command line are queried interactively.\n";
+	std::cout << "If /B is given, the header file is only generated if /O is given as well.\n\n";
 }
 
 void ParseError()
@@ -40,6 +45,7 @@ void ParseArgs(int argc, char *argv[], Param *param)
 	param->meshname[0] = '\0';
 	param->outname[0] = '\0';
 	param->suffix[0] = '\0';
+	param->binname[0] = '\0';
 	param->outlua = false;
 
 	for (int i = 1; i < argc; i++) {
@@ -66,6 +72,11 @@ void ParseArgs(int argc, char *argv[], Param *param)
 		case 'L':
 			param->outlua = true;
 			break;
+		case 'B':
+			if (i == argc - 1)
+				ParseError();
+			strcpy(param->binname, argv[++i]);
+			break;
 		case 'H':
 			PrintUsage();
 			exit(0);
@@ -178,6 +189,24 @@ int main (int argc, char *argv[])
 		cout << endl;
 	}
 
+	if (param.binname[0]) {
+		cout << "Converting mesh " << param.meshname << endl;
+		MeshBinData bmesh;
+		ifstream ifs(param.meshname);
+		if (!MeshBinParse(ifs, bmesh)) {
+			cout << "Error reading mesh file." << endl;
+			exit(1);
+		}
+		ifs.close();
+		if (!MeshBinWrite(param.binname, bmesh, param.meshname)) {
+			cout << "Error writing binary mesh file." << endl;
+			exit(1);
+		}
+		cout << "Wrote binary mesh to " << param.binname << endl << endl;
+		if (!param.outname[0])
+			return 0;
+	}
+
 	if (!param.suffix[0]) {
 		cout << "Variable suffix ('-' for none):\n>> ";
 		cin >> param.suffix;